@@ -5,6 +5,7 @@ extern "C" {
 #endif
 #define MAX_AUTHOR_NAME 128
 
+// Names stay inline (see DbAuthorRecord): short, and never removed
 typedef struct {
     int id;
     char name[MAX_AUTHOR_NAME];
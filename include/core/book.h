@@ -8,27 +8,50 @@ extern "C" {
 #define MAX_TITLE 128
 #define ISBN_SIZE 18
 #define MAX_DESCRIPTION 512
+#define BOOK_INLINE_IDS 4
 
 typedef struct {
     int id;
 
+    // Inline on purpose, unlike the description: callers fill a book in
+    // place before adding it, and the title is a fixed-width field of the
+    // snapshot record (DbBookRecord) that checkpoints rewrite in place
     char title[MAX_TITLE];
     char isbn[ISBN_SIZE];
 
+    // Id lists: inline buffer while the pointer is NULL, owned heap buffer
+    // while capacity > 0, or a read-only view of a library id pool when
+    // capacity is 0 (copied out on the first change)
     int *genre_ids;
     int genre_count;
     int genre_capacity;
+    int genre_inline[BOOK_INLINE_IDS];
     
     int publication_year;
 
     int *author_ids;
     int author_count;
     int author_capacity;
+    int author_inline[BOOK_INLINE_IDS];
 
-    char description[MAX_DESCRIPTION];
+    // Owned heap buffer when description_capacity > 0, otherwise NULL or
+    // a view into the string arena of the Library holding the book. A
+    // negative capacity is a reference to a text left in a file (see
+    // book_set_description_ref), read through lb_get_book_description.
+    char *description;
+    int description_capacity;
 
 } Book;
 
+/// @brief Function to initialize an empty book
+/// @param book Book to be initialized
+/// @return 0 if Success | 1 if False
+int book_init(Book *book);
+
+/// @brief Function to free the memory owned by a book (not added to a library)
+/// @param book Book to get freed
+void book_free(Book *book);
+
 /// @brief Function to update a book ID
 /// @param book Book to be updated
 /// @param new_id New ID to be assigned
@@ -59,6 +82,17 @@ int book_update_publication_year(Book *book, const int new_year);
 /// @return 0 if Success | 1 if False
 int book_update_description(Book *book, const char *description); 
 
+/// @brief Function to make the description a reference to a text of the
+/// description store of the library the book is added to
+/// @param book Book to be updated
+/// @param ref Reference given by description_store_add
+void book_set_description_ref(Book *book, int ref);
+
+/// @brief Function to get the description reference of a book
+/// @param book Book to search
+/// @return Reference if the description is left in a file | -1 if not
+int book_description_ref(const Book *book);
+
 /// @brief Function to add a genre to a book
 /// @param book Book to be updated
 /// @param genre_id Genre ID do be added 
@@ -93,6 +127,15 @@ int book_reserve_genre(Book *book);
 /// @return 0 if Success | 1 if False
 int book_reserve_author(Book *book);
 
+/// @brief Function to move short id lists inline and copy borrowed ones out
+/// @param book Book to be updated
+/// @return 0 if Success | 1 if False
+int book_pack_ids(Book *book);
+
+/// @brief Function to free the id lists owned by a book
+/// @param book Book to be updated
+void book_free_ids(Book *book);
+
 /// @brief Function to get all genres ID's of a book
 /// @param book Book to get genre ID's 
 /// @return 0 if Success | 1 if False
@@ -0,0 +1,100 @@
+#ifndef DESCRIPTION_STORE_H
+#define DESCRIPTION_STORE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <pthread.h>
+
+#define DESCRIPTION_STORE_MIN_ENTRIES 4
+
+/// @brief Callback reading size bytes at offset of the file holding the texts
+/// @param ctx Context given to description_store_init
+/// @param offset First byte to read
+/// @param buffer Filled with the bytes
+/// @param size Number of bytes
+/// @return 0 if Success | 1 if False
+typedef int (*DescriptionReadFn)(void *ctx, uint64_t offset, char *buffer, size_t size);
+
+/// Description left in a file: where it is and, while cached, its entry
+typedef struct {
+    uint64_t offset;
+    uint32_t length;    // Without the NUL
+    int entry;          // Cache entry holding the text, -1 if none
+} DescriptionRef;
+
+typedef struct {
+    char *text;
+    size_t capacity;
+    int ref;            // Reference cached here, -1 if free
+    int prev;           // Towards the most recently used entry
+    int next;           // Towards the least recently used entry
+} DescriptionEntry;
+
+/// Descriptions read on demand from a file into a small LRU cache. Books
+/// hold a reference (see book_set_description_ref) instead of the text.
+typedef struct {
+    DescriptionRef *refs;
+    int ref_count;
+    int ref_capacity;
+
+    DescriptionEntry *entries;
+    int entry_count;
+    int head;           // Most recently used entry
+    int tail;           // Least recently used entry
+
+    DescriptionReadFn read;
+    void (*release)(void *ctx);
+    void *ctx;
+
+    pthread_mutex_t lock;
+    uint64_t hits;
+    uint64_t misses;
+} DescriptionStore;
+
+/// @brief Function to initialize an empty store reading texts through read
+/// @param store Store to be initialized
+/// @param entries Number of texts kept in memory
+/// @param read Callback reading the file
+/// @param release Callback run on ctx by description_store_free (may be NULL)
+/// @param ctx Context passed to the callbacks
+/// @return 0 if Success | 1 if False
+int description_store_init(DescriptionStore *store, int entries, DescriptionReadFn read,
+                           void (*release)(void *ctx), void *ctx);
+
+/// @brief Function to free the store and release its file
+/// @param store Store to get freed
+void description_store_free(DescriptionStore *store);
+
+/// @brief Function to register a text of the file
+/// @param store Store to be updated
+/// @param offset First byte of the text
+/// @param length Length of the text (a NUL must follow it in the file)
+/// @param ref Filled with the reference of the text
+/// @return 0 if Success | 1 if False
+int description_store_add(DescriptionStore *store, uint64_t offset, uint32_t length, int *ref);
+
+/// @brief Function to get a text, reading it when it is not cached. The
+/// text stays valid until as many other texts as the cache holds are read.
+/// @param store Store to search
+/// @param ref Reference of the text
+/// @return Text if Success | NULL if False
+const char *description_store_get(DescriptionStore *store, int ref);
+
+/// @brief Function to copy a text into a caller buffer, safe to call from
+/// several threads at once
+/// @param store Store to search
+/// @param ref Reference of the text
+/// @param buffer Buffer grown as needed (freed by the caller)
+/// @param capacity Size of the buffer
+/// @return Text in the buffer if Success | NULL if False
+const char *description_store_copy(DescriptionStore *store, int ref, char **buffer, size_t *capacity);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,49 @@
+#ifndef DIRTY_SET_H
+#define DIRTY_SET_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// Set of record positions (book slots, author or genre indexes) changed
+/// since the last checkpoint. A mark per position keeps inserts O(1) and
+/// the list of marked positions lets a checkpoint walk only the churn.
+typedef struct {
+    unsigned char *marks;
+    int mark_capacity;
+
+    int *items;
+    int count;
+    int capacity;
+} DirtySet;
+
+/// @brief Function to initialize an empty dirty set
+/// @param set Dirty set to be initialized
+/// @return 0 if Success | 1 if False
+int dirty_set_init(DirtySet *set);
+
+/// @brief Function to free dirty set memory
+/// @param set Dirty set to get freed
+void dirty_set_free(DirtySet *set);
+
+/// @brief Function to unmark every position keeping capacity
+/// @param set Dirty set to get cleared
+void dirty_set_clear(DirtySet *set);
+
+/// @brief Function to mark a position (marking it again does nothing)
+/// @param set Dirty set to change
+/// @param index Position (>= 0)
+/// @return 0 if Success | 1 if False
+int dirty_set_mark(DirtySet *set, int index);
+
+/// @brief Function to check if a position is marked
+/// @param set Dirty set to search
+/// @param index Position
+/// @return 1 if Marked | 0 if not
+int dirty_set_contains(const DirtySet *set, int index);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
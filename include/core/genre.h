@@ -5,6 +5,7 @@ extern "C" {
 #endif
 #define MAX_GENRE 64
 
+// Names stay inline (see DbGenreRecord): short, and never removed
 typedef struct {
     int id;
     char name[MAX_GENRE];
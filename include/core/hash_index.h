@@ -0,0 +1,102 @@
+#ifndef HASH_INDEX_H
+#define HASH_INDEX_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define HASH_INDEX_EMPTY -1
+#define HASH_INDEX_TOMBSTONE -2
+
+/// @brief Callback that returns the key stored for a value
+/// @param ctx Owner of the indexed records (usually the Library)
+/// @param value Value stored in the index
+/// @return Key of the record referenced by value
+typedef const char *(*HashIndexKeyFn)(const void *ctx, int value);
+
+typedef struct {
+    unsigned int hash;
+    int value;
+} HashEntry;
+
+/// Open addressing (linear probing) index from a string key to an int.
+/// Keys are not copied: the index keeps the hash and asks key_of for the
+/// key only when two hashes collide.
+typedef struct {
+    HashEntry *entries;
+    int capacity;
+    int count;
+    int tombstones;
+
+    HashIndexKeyFn key_of;
+} HashIndex;
+
+/// @brief Function to initialize an empty index
+/// @param index Index to be initialized
+/// @param key_of Callback used to compare keys
+/// @return 0 if Success | 1 if False
+int hash_index_init(HashIndex *index, HashIndexKeyFn key_of);
+
+/// @brief Function to free index memory
+/// @param index Index to get freed
+void hash_index_free(HashIndex *index);
+
+/// @brief Function to remove every entry maintaining capacity
+/// @param index Index to get cleared
+void hash_index_clear(HashIndex *index);
+
+/// @brief Function to expand the index to hold at least count keys
+/// @param index Index to expand
+/// @param count Number of keys to hold without rehashing
+/// @return 0 if Success | 1 if False
+int hash_index_reserve(HashIndex *index, int count);
+
+/// @brief Function to find the value stored for a key
+/// @param index Index to search
+/// @param ctx Context passed to key_of
+/// @param key Key to search
+/// @return Value if found | HASH_INDEX_EMPTY if not found
+int hash_index_find(const HashIndex *index, const void *ctx, const char *key);
+
+/// @brief Function to insert a new key
+/// @param index Index to be updated
+/// @param ctx Context passed to key_of
+/// @param key Key to insert
+/// @param value Value to store (must be >= 0)
+/// @return 0 if Success | 1 if False (duplicated key or allocation)
+int hash_index_insert(HashIndex *index, const void *ctx, const char *key, int value);
+
+/// @brief Function to change the value stored for an existing key
+/// @param index Index to be updated
+/// @param ctx Context passed to key_of
+/// @param key Key to update
+/// @param value New value
+/// @return 0 if Success | 1 if False
+int hash_index_update(HashIndex *index, const void *ctx, const char *key, int value);
+
+/// @brief Function to remove a key
+/// @param index Index to be updated
+/// @param ctx Context passed to key_of
+/// @param key Key to remove
+/// @return 0 if Success | 1 if False
+int hash_index_remove(HashIndex *index, const void *ctx, const char *key);
+
+/// @brief Function to replace the entries with a copy of a saved table
+/// @param index Index to be replaced
+/// @param entries Table saved from an index with the same key_of
+/// @param capacity Size of the table (a power of two)
+/// @param count Number of keys in the table
+/// @param tombstones Number of removed entries in the table
+/// @return 0 if Success | 1 if False
+int hash_index_load(HashIndex *index, const HashEntry *entries, int capacity, int count, int tombstones);
+
+/// @brief Function to hash a key (FNV-1a)
+/// @param key Key to hash
+/// @return Hash of the key
+unsigned int hash_index_hash(const char *key);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -11,13 +11,140 @@ extern "C" {
 #include "book.h"
 #include "author.h"
 #include "genre.h"
+#include "hash_index.h"
+#include "string_arena.h"
+#include "postings.h"
+#include "trigram_index.h"
+#include "prefix_index.h"
+#include "dirty_set.h"
+#include "description_store.h"
 #include "log.h"
 
+/// Stable reference to a book stored in a Library. It stays valid while
+/// other books are added or removed and is invalidated when its own book
+/// is removed (the slot generation changes).
 typedef struct {
+    int slot;
+    unsigned int generation;
+} BookHandle;
+
+// Kinds of LibraryChange
+#define LB_CHANGE_ADD_BOOK 1
+#define LB_CHANGE_REMOVE_BOOK 2
+#define LB_CHANGE_BOOK_ISBN 3
+#define LB_CHANGE_BOOK_TITLE 4
+#define LB_CHANGE_BOOK_ID 5
+#define LB_CHANGE_BOOK_YEAR 6
+#define LB_CHANGE_BOOK_DESCRIPTION 7
+#define LB_CHANGE_ADD_BOOK_GENRE 8
+#define LB_CHANGE_REMOVE_BOOK_GENRE 9
+#define LB_CHANGE_ADD_BOOK_AUTHOR 10
+#define LB_CHANGE_REMOVE_BOOK_AUTHOR 11
+#define LB_CHANGE_ADD_AUTHOR 12
+#define LB_CHANGE_AUTHOR_NAME 13
+#define LB_CHANGE_ADD_GENRE 14
+#define LB_CHANGE_GENRE_NAME 15
+#define LB_CHANGE_CLEAR 16
+
+/// Change made by an lb_* function, reported to the change hook before it
+/// is applied. Pointers are only valid during the call.
+typedef struct {
+    int kind;
+    const char *isbn;   // Book changed (current ISBN before the change)
+    const Book *book;   // Book given to be added for LB_CHANGE_ADD_BOOK
+    const char *text;   // New ISBN, title, description or name
+    int value;          // New id or year, genre/author id of the change
+} LibraryChange;
+
+/// @brief Callback run for every change of a library once it is checked,
+/// before it is applied (the library still holds the state before it)
+/// @param ctx Context given to lb_set_change_hook
+/// @param change Change to be applied
+typedef void (*LibraryChangeFn)(void *ctx, const LibraryChange *change);
+
+/// @brief Callback run once an lb_* function has applied the changes it
+/// reported and released its locks (e.g. to wait for a journal sync)
+/// @param ctx Context given to lb_set_change_hook
+typedef void (*LibraryCommitFn)(void *ctx);
+
+// Locks of the concurrent mode (see lb_set_concurrent)
+#define LB_LOCK_SHARDS 16
+typedef struct LibraryLocks LibraryLocks;
+
+typedef struct Library Library;
+
+/// Storage a library runs on (see lb_set_backend), e.g. btree_backend
+typedef struct {
+    void *ctx;
+
+    // Fills an initialized book with the stored book of an ISBN,
+    // returns 0 if found | 1 if not
+    int (*load)(void *ctx, const char *isbn, Book *book);
+
+    // Writes a change before the library applies it (the library still
+    // holds the state before it), returns 0 if Success | 1 fails the change
+    int (*apply)(void *ctx, Library *lib, const LibraryChange *change);
+} LibraryBackend;
+
+#define PREFIX_TITLES 1
+#define PREFIX_AUTHORS 2
+
+/// Match of lb_prefix_search: a book title (index is its dense position)
+/// or an author name (index is its position in authors)
+typedef struct {
+    int kind;
+    int index;
+    const char *text;
+} PrefixMatch;
+
+/// Indexes saved next to the records they cover (e.g. in a snapshot).
+/// ISBN entries and postings hold dense book indexes instead of slots;
+/// postings are flattened, the books of key k are ids[offsets[k - 1]] up
+/// to ids[offsets[k]].
+typedef struct {
+    const HashEntry *isbn_entries;
+    int isbn_capacity;
+    int isbn_count;
+    int isbn_tombstones;
+
+    const HashEntry *author_entries;
+    int author_capacity;
+    int author_count;
+    int author_tombstones;
+
+    const HashEntry *genre_entries;
+    int genre_capacity;
+    int genre_count;
+    int genre_tombstones;
+
+    const int *genre_offsets;
+    const int *genre_ids;
+    int genre_lists;
+
+    const int *author_offsets;
+    const int *author_ids;
+    int author_lists;
+} LibraryIndexes;
+
+struct Library {
     Book *books;
     int book_count;
     int book_capacity;
 
+    // Slot map: books stay dense, slots give them a stable identity
+    int *book_slots;
+    int *slot_books;
+    unsigned int *slot_generations;
+    int slot_count;
+    int free_slot;
+
+    // Optional columnar copy of the hot fields, parallel to books.
+    // The Book rows stay the cold store for title and description.
+    int columnar;
+    int *book_ids;
+    int *book_years;
+    char (*book_isbns)[ISBN_SIZE];
+
     Author *authors;
     int author_count;
     int author_capacity;
@@ -26,7 +153,65 @@ typedef struct {
     int genre_count;
     int genre_capacity;
 
-} Library;
+    // Descriptions of stored books
+    StringArena strings;
+
+    // Compacted id lists (CSR) borrowed by books, see lb_compact_ids
+    int *id_pool;
+    int id_pool_size;
+
+    // Read-only region (e.g. a mapped snapshot) books may borrow
+    // descriptions and id lists from, see lb_attach_view
+    const char *view;
+    size_t view_size;
+    void (*view_release)(const char *view, size_t size);
+
+    // Descriptions left in a file, read on demand (see lb_attach_descriptions)
+    DescriptionStore *descriptions;
+
+    HashIndex isbn_index;
+    HashIndex author_index;
+    HashIndex genre_index;
+
+    // Sorted book slots per genre and per author
+    Postings genre_postings;
+    Postings author_postings;
+
+    // Trigrams of title, ISBN and description, valued by slot. Bulk loads
+    // defer it (text_stale) and the next search rebuilds it in one pass.
+    TrigramIndex text_index;
+    int text_stale;
+
+    // Set while a loader fills the library without indexing it, the saved
+    // indexes (or a rebuild) are installed by lb_restore_indexes
+    int index_deferred;
+
+    // Observer of changes (e.g. a journal), see lb_set_change_hook
+    LibraryChangeFn on_change;
+    LibraryCommitFn on_commit;
+    void *change_ctx;
+
+    // Records changed since the last checkpoint (book slots, author and
+    // genre indexes); dirty_all asks for a full one (e.g. after lb_clear)
+    DirtySet dirty_books;
+    DirtySet dirty_authors;
+    DirtySet dirty_genres;
+    int dirty_all;
+
+    // Sorted titles (by slot) and author names, kept sorted by single changes
+    // and rebuilt on the first lookup after a bulk one
+    PrefixIndex title_prefix;
+    PrefixIndex author_prefix;
+
+    // NULL unless the library is shared between threads, see lb_set_concurrent
+    LibraryLocks *locks;
+
+    // Storage holding every book, NULL to keep them all in memory (see
+    // lb_set_backend); set while books move between it and memory
+    const LibraryBackend *backend;
+    int backend_paging;
+
+};
 
 // Core Functions
 
@@ -43,39 +228,444 @@ void lb_free(Library *lib);
 /// @param lib Library to get cleared
 void lb_clear(Library *lib);
 
+/// @brief Function to set the observer told about every change made through
+/// the lb_* functions (books changed through book_* directly are not seen).
+/// on_change runs under the locks of the change, before it is applied, so
+/// a journal records it first; only running out of memory can still fail
+/// the change after that. on_commit runs after the locks are released. In
+/// concurrent mode changes of different shards call them at the same time.
+/// @param lib Library to observe
+/// @param on_change Callback (NULL to remove it)
+/// @param on_commit Callback run after the changes of a call (may be NULL)
+/// @param ctx Context passed to the callbacks
+/// @return 0 if Success | 1 if False
+int lb_set_change_hook(Library *lib, LibraryChangeFn on_change, LibraryCommitFn on_commit, void *ctx);
+
+/// @brief Function to forget the records changed so far, called once they
+/// are checkpointed
+/// @param lib Library to reset
+void lb_clear_dirty(Library *lib);
+
+//concurrency
+
+/// @brief Function to share a library between threads. In concurrent mode
+/// the lb_* changes lock the library themselves: a change of one book
+/// (title, year, id, description, genres, authors) locks its ISBN shard
+/// and the author or genre table it touches, so changes of books in other
+/// shards run at the same time; author and genre changes (bulk ones too)
+/// lock their table. Anything moving books or rebuilding the ISBN index
+/// (add, remove, ISBN change, reserve, compaction...) locks it all, and a
+/// bulk add of books does so one chunk at a time. Readers lock with
+/// lb_read_lock around the lookups and every use of what they return, and
+/// read descriptions with lb_read_book_description. Books must not be
+/// changed through book_* directly. A library running on a backend
+/// cannot be shared.
+/// @param lib Library used by a single thread at the time of the call
+/// @param enabled 1 to create the locks | 0 to drop them
+/// @return 0 if Success | 1 if False
+int lb_set_concurrent(Library *lib, int enabled);
+
+/// @brief Function to run a library on a storage backend (e.g. a B+tree,
+/// see btree_backend) so it only holds the books in use. A book looked up
+/// by ISBN (lb_find_book_by_isbn, lb_get_book_handle, the changes of a
+/// book and the duplicate checks of adds) is read from the backend when it
+/// is not in memory; every change is written to the backend before it is
+/// applied, and fails if the backend fails it (lb_clear empties the
+/// backend too). lb_evict_books drops the
+/// books in memory. Reads of the whole library (searches, listings,
+/// counts, books by genre or author) only see the books in memory, and a
+/// lookup reading a book in invalidates the books returned before it, as
+/// an add does. Not available in concurrent mode.
+/// @param lib Empty library, not concurrent
+/// @param backend Backend, kept by pointer | NULL to keep the books in memory
+/// @return 0 if Success | 1 if False
+int lb_set_backend(Library *lib, const LibraryBackend *backend);
+
+/// @brief Function to drop the books held in memory by a library running
+/// on a backend; they stay stored and are read again when looked up.
+/// Handles to them become stale.
+/// @param lib Library running on a backend
+/// @return 0 if Success | 1 if False
+int lb_evict_books(Library *lib);
+
+/// @brief Function to keep in memory a book read from the backend of a
+/// library (e.g. to read an ISBN range in at once). It is not a change:
+/// nothing is reported or written back. On success the library takes
+/// ownership of the id lists and description of the book.
+/// @param lib Library running on a backend
+/// @param book Book read from the backend
+/// @return 0 if Success | 1 if False (the book is already in memory included)
+int lb_cache_book(Library *lib, const Book *book);
+
+/// @brief Function to start reading a library in concurrent mode (does
+/// nothing otherwise). A book is read under the shared lock of its ISBN
+/// shard, so readers of different books never touch the same lock; a
+/// whole library read (searches, listings, stats, authors and genres,
+/// snapshots) takes every shard and both tables shared. A reader must
+/// not change the library before lb_read_unlock. Reads nest on the same
+/// thread: a read of the whole library, or of a book of the same shard,
+/// inside another read only counts. Other books are read inside a whole
+/// library read, not inside the read of a single book (that could wait
+/// on a change locking everything, which waits on the reader).
+/// @param lib Library to read
+/// @param isbn ISBN of the book read | NULL to read the whole library
+void lb_read_lock(const Library *lib, const char *isbn);
+
+/// @brief Function to end a read started by lb_read_lock
+/// @param lib Library read
+/// @param isbn Same ISBN given to lb_read_lock
+void lb_read_unlock(const Library *lib, const char *isbn);
+
 // CRUD Functions
 //books
 
-/// @brief Function to add a book to library
+/// @brief Function to add a book to library. On success the library takes
+/// ownership of the id lists and description of the book.
 /// @param lib Library to add the book
 /// @param book Book to be added
 /// @return 0 if Success | 1 if False
 int lb_add_book(Library *lib, const Book *book);
 
+/// @brief Function to add many books with one allocation and one log line.
+/// The batch is validated first: an empty or duplicated ISBN adds nothing.
+/// On success the library owns the id lists and descriptions of every
+/// book; if an index allocation fails midway the books before the failing
+/// one stay added and the rest remain owned by the caller. In concurrent
+/// mode large batches are added in chunks that readers see as they come;
+/// a book added meanwhile by another thread with an ISBN of the batch
+/// stops it the same way.
+/// @param lib Library to add the books
+/// @param books Books to be added
+/// @param count Number of books
+/// @return 0 if Success | 1 if False
+int lb_add_books_bulk(Library *lib, const Book *books, int count);
+
 /// @brief Function to remove a book from library
 /// @param lib Library to remove the book
 /// @param isbn ISBN of the book to be removed
 /// @return 0 if Success | 1 if False
 int lb_remove_book(Library *lib, const char *isbn);
 
+/// @brief Function to find a book by ISBN
+/// @param lib Library to search
+/// @param isbn ISBN of the book
+/// @return Book if found | NULL if not found (invalidated by add/remove)
+Book *lb_find_book_by_isbn(Library *lib, const char *isbn);
+
+/// @brief Function to get a stable handle to a book
+/// @param lib Library containing the book
+/// @param isbn ISBN of the book
+/// @param handle Handle to be filled
+/// @return 0 if Success | 1 if False
+int lb_get_book_handle(Library *lib, const char *isbn, BookHandle *handle);
+
+/// @brief Function to resolve a handle to its book
+/// @param lib Library containing the book
+/// @param handle Handle of the book
+/// @return Book if the handle is valid | NULL if the book was removed
+Book *lb_get_book(Library *lib, BookHandle handle);
+
+/// @brief Function to get the book stored in a slot (e.g. from lb_books_by_genre)
+/// @param lib Library containing the book
+/// @param slot Slot of the book
+/// @return Book if the slot holds one | NULL if not
+Book *lb_get_book_by_slot(Library *lib, int slot);
+
+/// @brief Function to remove a book from library by handle in O(1)
+/// @param lib Library to remove the book
+/// @param handle Handle of the book to be removed
+/// @return 0 if Success | 1 if False
+int lb_remove_book_by_handle(Library *lib, BookHandle handle);
+
+/// @brief Function to update the ISBN of a book keeping the index in sync
+/// @param lib Library containing the book
+/// @param isbn Current ISBN of the book
+/// @param new_isbn New ISBN to be assigned
+/// @return 0 if Success | 1 if False
+int lb_update_book_isbn(Library *lib, const char *isbn, const char *new_isbn);
+
+/// @brief Function to update the title of a book keeping the text index in sync
+/// @param lib Library containing the book
+/// @param isbn ISBN of the book
+/// @param title New title
+/// @return 0 if Success | 1 if False
+int lb_update_book_title(Library *lib, const char *isbn, const char *title);
+
+/// @brief Function to update the id of a book keeping the postings in sync
+/// @param lib Library containing the book
+/// @param isbn ISBN of the book
+/// @param new_id New ID to be assigned
+/// @return 0 if Success | 1 if False
+int lb_update_book_id(Library *lib, const char *isbn, const int new_id);
+
+/// @brief Function to update the publication year of a book
+/// @param lib Library containing the book
+/// @param isbn ISBN of the book
+/// @param new_year New publication year
+/// @return 0 if Success | 1 if False
+int lb_update_book_year(Library *lib, const char *isbn, const int new_year);
+
+/// @brief Function to update the description of a book stored in the arena
+/// @param lib Library containing the book
+/// @param isbn ISBN of the book
+/// @param description New description
+/// @return 0 if Success | 1 if False
+int lb_update_book_description(Library *lib, const char *isbn, const char *description);
+
+/// @brief Function to copy live descriptions into a fresh arena dropping garbage
+/// @param lib Library to compact
+/// @return 0 if Success | 1 if False
+int lb_compact_strings(Library *lib);
+
+/// @brief Function to let books borrow descriptions and id lists from a
+/// read-only region. Books added afterwards keep pointers into the region
+/// as views (copied out on the first change); release is called once no
+/// book can reference it anymore (lb_clear or lb_free).
+/// @param lib Library to attach the region (must not hold one)
+/// @param view Start of the region
+/// @param size Size of the region in bytes
+/// @param release Callback that frees the region (may be NULL)
+/// @return 0 if Success | 1 if False
+int lb_attach_view(Library *lib, const char *view, size_t size, void (*release)(const char *view, size_t size));
+
+/// @brief Function to give the library the store of the descriptions books
+/// reference with book_set_description_ref. The library frees the store
+/// (allocated with malloc) on lb_clear or lb_free.
+/// @param lib Library to attach the store (must not hold one)
+/// @param store Initialized store
+/// @return 0 if Success | 1 if False
+int lb_attach_descriptions(Library *lib, DescriptionStore *store);
+
+/// @brief Function to get the description of a book, reading it from the
+/// description store when it was left in a file. Such a text stays valid
+/// until as many other texts as the store caches are read.
+/// @param lib Library holding the book
+/// @param book Book to search
+/// @return Description if found | NULL if none
+const char *lb_get_book_description(const Library *lib, const Book *book);
+
+/// @brief Function to get the description of a book from several threads
+/// at once: a text left in a file is copied into the caller buffer
+/// @param lib Library holding the book
+/// @param book Book to search
+/// @param buffer Buffer grown as needed (freed by the caller)
+/// @param capacity Size of the buffer
+/// @return Description if found | NULL if none
+const char *lb_read_book_description(const Library *lib, const Book *book, char **buffer, size_t *capacity);
+
+/// @brief Function to stop indexing books, authors and genres as they are
+/// added, for loaders that restore saved indexes afterwards. Lookups miss
+/// until lb_restore_indexes runs.
+/// @param lib Library to be loaded
+void lb_defer_indexes(Library *lib);
+
+/// @brief Function to install saved indexes, or to rebuild them from the
+/// records when indexes is NULL or does not match the library
+/// @param lib Library to be indexed
+/// @param indexes Saved indexes (may be NULL)
+/// @return 0 if Success | 1 if False
+int lb_restore_indexes(Library *lib, const LibraryIndexes *indexes);
+
+/// @brief Function to pack every spilled id list into one contiguous pool.
+/// Meant to run once after a bulk load; lists changed later get a private
+/// copy and the old entries stay in the pool until the next compaction.
+/// @param lib Library to compact
+/// @return 0 if Success | 1 if False
+int lb_compact_ids(Library *lib);
+
+/// @brief Function to find the books whose title, ISBN or description
+/// contains a substring. Terms of TRIGRAM_MIN_QUERY bytes or more are
+/// answered from the trigram index, shorter ones scan the catalog.
+/// @param lib Library to search
+/// @param term Substring to search (case sensitive)
+/// @param results Filled with the dense positions of the matches
+/// @param max_results Size of results
+/// @param count Filled with the number of matches stored
+/// @return 0 if Success | 1 if False
+int lb_search_books(Library *lib, const char *term, int *results, int max_results, int *count);
+
+/// @brief Function to find titles and author names starting with a prefix
+/// (ASCII case ignored) in alphabetical order, for type-ahead
+/// @param lib Library to search
+/// @param prefix Prefix typed so far
+/// @param limit Maximum number of matches (size of results)
+/// @param kinds PREFIX_TITLES, PREFIX_AUTHORS or both
+/// @param results Filled with the matches (valid until the library changes)
+/// @param count Filled with the number of matches stored
+/// @return 0 if Success | 1 if False
+int lb_prefix_search(Library *lib, const char *prefix, int limit, int kinds, PrefixMatch *results, int *count);
+
+//postings
+
+/// @brief Function to add a genre to a stored book keeping the postings in sync
+/// @param lib Library containing the book
+/// @param isbn ISBN of the book
+/// @param genre_id ID of the genre
+/// @return 0 if Success | 1 if False
+int lb_add_book_genre(Library *lib, const char *isbn, const int genre_id);
+
+/// @brief Function to remove a genre from a stored book keeping the postings in sync
+/// @param lib Library containing the book
+/// @param isbn ISBN of the book
+/// @param genre_id ID of the genre
+/// @return 0 if Success | 1 if False
+int lb_remove_book_genre(Library *lib, const char *isbn, const int genre_id);
+
+/// @brief Function to add an author to a stored book keeping the postings in sync
+/// @param lib Library containing the book
+/// @param isbn ISBN of the book
+/// @param author_id ID of the author
+/// @return 0 if Success | 1 if False
+int lb_add_book_author(Library *lib, const char *isbn, const int author_id);
+
+/// @brief Function to remove an author from a stored book keeping the postings in sync
+/// @param lib Library containing the book
+/// @param isbn ISBN of the book
+/// @param author_id ID of the author
+/// @return 0 if Success | 1 if False
+int lb_remove_book_author(Library *lib, const char *isbn, const int author_id);
+
+/// @brief Function to get the books of a genre
+/// @param lib Library to search
+/// @param genre_id ID of the genre
+/// @param count Filled with the number of books
+/// @return Sorted slots of the books, resolved with lb_get_book_by_slot
+/// (valid until the library changes) | NULL if none
+const int *lb_books_by_genre(const Library *lib, int genre_id, int *count);
+
+/// @brief Function to get the books of an author
+/// @param lib Library to search
+/// @param author_id ID of the author
+/// @param count Filled with the number of books
+/// @return Sorted slots of the books, resolved with lb_get_book_by_slot
+/// (valid until the library changes) | NULL if none
+const int *lb_books_by_author(const Library *lib, int author_id, int *count);
+
+//columnar layout
+
+/// @brief Function to enable or disable the columnar layout of hot fields
+/// (id, ISBN, publication year). While enabled, books must be edited
+/// through the lb_* functions so the columns stay in sync.
+/// @param lib Library to change
+/// @param enabled 1 to build the columns | 0 to drop them
+/// @return 0 if Success | 1 if False
+int lb_set_columnar(Library *lib, int enabled);
+
+/// @brief Function to get the id of the book at a dense position
+/// @param lib Library containing the book
+/// @param index Position in [0, book_count)
+/// @return ID of the book
+int lb_book_id_at(const Library *lib, int index);
+
+/// @brief Function to get the publication year of the book at a dense position
+/// @param lib Library containing the book
+/// @param index Position in [0, book_count)
+/// @return Publication year of the book
+int lb_book_year_at(const Library *lib, int index);
+
+/// @brief Function to get the ISBN of the book at a dense position
+/// @param lib Library containing the book
+/// @param index Position in [0, book_count)
+/// @return ISBN of the book
+const char *lb_book_isbn_at(const Library *lib, int index);
+
+/// @brief Function to get the title of the book at a dense position
+/// @param lib Library containing the book
+/// @param index Position in [0, book_count)
+/// @return Title of the book
+const char *lb_book_title_at(const Library *lib, int index);
+
+/// @brief Function to count books published in a year range
+/// @param lib Library to scan
+/// @param from_year First year (inclusive)
+/// @param to_year Last year (inclusive)
+/// @return Number of books in the range
+int lb_count_books_by_year(const Library *lib, int from_year, int to_year);
+
 //authors
 
-/// @brief Function to add an author to a library
+/// @brief Function to add an author to a library (names are unique)
 /// @param lib Library to add the author
 /// @param author_name Name of the author to add
 /// @return 0 if Success | 1 if False
 int lb_add_author(Library *lib, const char *author_name);
 
+/// @brief Function to get the id of an author, adding it when unknown
+/// @param lib Library to search or add the author
+/// @param author_name Name of the author
+/// @param author_id Filled with the id of the existing or new author
+/// @return 0 if Success | 1 if False
+int lb_find_or_add_author(Library *lib, const char *author_name, int *author_id);
+
+/// @brief Function to add many authors keeping their ids, with one log line.
+/// Ids are positions: they must continue the stored ones (author_count + 1,
+/// + 2...) and names must be new, otherwise nothing is added.
+/// @param lib Library to add the authors
+/// @param authors Authors to be added
+/// @param count Number of authors
+/// @return 0 if Success | 1 if False
+int lb_add_authors_bulk(Library *lib, const Author *authors, int count);
+
+/// @brief Function to find an author by name
+/// @param lib Library to search
+/// @param author_name Name of the author
+/// @return Author if found | NULL if not found
+Author *lb_find_author_by_name(Library *lib, const char *author_name);
+
+/// @brief Function to rename an author keeping the name index in sync
+/// @param lib Library containing the author
+/// @param author_id ID of the author
+/// @param name New name (must not belong to another author)
+/// @return 0 if Success | 1 if False
+int lb_update_author_name(Library *lib, int author_id, const char *name);
+
 //genres
 
-/// @brief Function to add a genre to a library
+/// @brief Function to add a genre to a library (names are unique)
 /// @param lib Library to add the Genre
 /// @param genre_name Genre to add 
 /// @return 0 if Success | 1 if False
 int lb_add_genre(Library *lib, const char *genre_name);
 
+/// @brief Function to get the id of a genre, adding it when unknown
+/// @param lib Library to search or add the genre
+/// @param genre_name Name of the genre
+/// @param genre_id Filled with the id of the existing or new genre
+/// @return 0 if Success | 1 if False
+int lb_find_or_add_genre(Library *lib, const char *genre_name, int *genre_id);
+
+/// @brief Function to add many genres keeping their ids, with one log line.
+/// Ids are positions: they must continue the stored ones (genre_count + 1,
+/// + 2...) and names must be new, otherwise nothing is added.
+/// @param lib Library to add the genres
+/// @param genres Genres to be added
+/// @param count Number of genres
+/// @return 0 if Success | 1 if False
+int lb_add_genres_bulk(Library *lib, const Genre *genres, int count);
+
+/// @brief Function to find a genre by name
+/// @param lib Library to search
+/// @param genre_name Name of the genre
+/// @return Genre if found | NULL if not found
+Genre *lb_find_genre_by_name(Library *lib, const char *genre_name);
+
+/// @brief Function to rename a genre keeping the name index in sync
+/// @param lib Library containing the genre
+/// @param genre_id ID of the genre
+/// @param name New name (must not belong to another genre)
+/// @return 0 if Success | 1 if False
+int lb_update_genre_name(Library *lib, int genre_id, const char *name);
+
 //Utils Functions
 
+/// @brief Function to make room for more records with exact sized allocations
+/// @param lib Library to expand
+/// @param books Number of books to add without reallocating
+/// @param authors Number of authors to add without reallocating
+/// @param genres Number of genres to add without reallocating
+/// @return 0 if Success | 1 if False
+int lb_reserve(Library *lib, int books, int authors, int genres);
+
 /// @brief Function to expand capacity of books from a library 
 /// @param lib Library to expand the capacity of books
 /// @return 0 if Success | 1 if False
@@ -0,0 +1,70 @@
+#ifndef POSTINGS_H
+#define POSTINGS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    int *ids;
+    int count;
+    int capacity;
+} PostingList;
+
+/// Inverted index from a key id (genre or author, starting at 1) to the
+/// sorted ids of the books holding it. Lists are addressed directly by
+/// key id, so a lookup costs nothing beyond reading the result.
+/// Repeated book ids are kept as a multiset.
+typedef struct {
+    PostingList *lists;
+    int list_count;
+} Postings;
+
+/// @brief Function to initialize empty postings
+/// @param postings Postings to be initialized
+/// @return 0 if Success | 1 if False
+int postings_init(Postings *postings);
+
+/// @brief Function to free postings memory
+/// @param postings Postings to get freed
+void postings_free(Postings *postings);
+
+/// @brief Function to empty every list keeping capacity
+/// @param postings Postings to get cleared
+void postings_clear(Postings *postings);
+
+/// @brief Function to add a book id to the list of a key keeping it sorted
+/// @param postings Postings to change
+/// @param key Key id (> 0)
+/// @param book_id Book id to be added
+/// @return 0 if Success | 1 if False
+int postings_add(Postings *postings, int key, int book_id);
+
+/// @brief Function to remove one occurrence of a book id from the list of a key
+/// @param postings Postings to change
+/// @param key Key id (> 0)
+/// @param book_id Book id to be removed
+/// @return 0 if Success | 1 if not Found
+int postings_remove(Postings *postings, int key, int book_id);
+
+/// @brief Function to replace every list with a copy of flattened lists:
+/// the ids of key k are ids[offsets[k - 1]] up to ids[offsets[k]]
+/// @param postings Postings to be replaced
+/// @param offsets list_count + 1 increasing offsets into ids
+/// @param ids Sorted ids of every list
+/// @param list_count Number of lists
+/// @return 0 if Success | 1 if False
+int postings_load(Postings *postings, const int *offsets, const int *ids, int list_count);
+
+/// @brief Function to get the sorted book ids of a key
+/// @param postings Postings to search
+/// @param key Key id
+/// @param count Filled with the number of ids
+/// @return Sorted ids (valid until the next change) | NULL if empty
+const int *postings_get(const Postings *postings, int key, int *count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,99 @@
+#ifndef PREFIX_INDEX_H
+#define PREFIX_INDEX_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// @brief Callback that returns the key stored for a value
+/// @param ctx Owner of the indexed records (usually the Library)
+/// @param value Value given to prefix_index_build or prefix_index_insert
+/// @return Key of the record
+typedef const char *(*PrefixKeyFn)(const void *ctx, int value);
+
+/// Values sorted by key without case (ASCII) so every key sharing a prefix
+/// sits in one run found by binary search. Keys are not copied: the index
+/// asks key_of for them on every comparison, so the records may move
+/// (e.g. be reallocated). Single changes keep it sorted in place: a value
+/// is removed before its key changes and inserted again after. Changes of
+/// many values call prefix_index_invalidate and the next lookup rebuilds
+/// the array once.
+typedef struct {
+    int *values;
+    int count;
+    int capacity;
+    int dirty;
+
+    PrefixKeyFn key_of;
+} PrefixIndex;
+
+/// @brief Function to initialize an empty index
+/// @param index Index to be initialized
+/// @param key_of Callback giving the key of each value
+/// @return 0 if Success | 1 if False
+int prefix_index_init(PrefixIndex *index, PrefixKeyFn key_of);
+
+/// @brief Function to free index memory
+/// @param index Index to get freed
+void prefix_index_free(PrefixIndex *index);
+
+/// @brief Function to mark the index as stale
+/// @param index Index to invalidate
+void prefix_index_invalidate(PrefixIndex *index);
+
+/// @brief Function to rebuild the sorted entries of a set of values
+/// @param index Index to rebuild
+/// @param ctx Context passed to key_of
+/// @param values Values to index (NULL for [0, count))
+/// @param count Number of values
+/// @return 0 if Success | 1 if False
+int prefix_index_build(PrefixIndex *index, const void *ctx, const int *values, int count);
+
+/// @brief Function to add a value at its sorted position (nothing to do
+/// while the index is stale)
+/// @param index Index to update
+/// @param ctx Context passed to key_of
+/// @param value Value to add, its key already set
+/// @return 0 if Success | 1 if False
+int prefix_index_insert(PrefixIndex *index, const void *ctx, int value);
+
+/// @brief Function to drop a value (nothing to do while the index is stale)
+/// @param index Index to update
+/// @param ctx Context passed to key_of
+/// @param value Value to drop, its key not changed yet
+/// @return 0 if Success | 1 if False (not found included)
+int prefix_index_remove(PrefixIndex *index, const void *ctx, int value);
+
+/// @brief Function to find the first entry whose key starts with prefix
+/// @param index Index to search (must be built)
+/// @param ctx Context passed to key_of
+/// @param prefix Prefix to search
+/// @return Position of the first match | count if none
+int prefix_index_find(const PrefixIndex *index, const void *ctx, const char *prefix);
+
+/// @brief Function to check whether the entry at a position starts with prefix
+/// @param index Index to check
+/// @param ctx Context passed to key_of
+/// @param pos Position in [0, count]
+/// @param prefix Prefix to match
+/// @return 1 if it matches | 0 if not
+int prefix_index_matches(const PrefixIndex *index, const void *ctx, int pos, const char *prefix);
+
+/// @brief Function to get the key of the entry at a position
+/// @param index Index to read
+/// @param ctx Context passed to key_of
+/// @param pos Position in [0, count)
+/// @return Key of the entry
+const char *prefix_index_key(const PrefixIndex *index, const void *ctx, int pos);
+
+/// @brief Function to compare two keys ignoring ASCII case
+/// @param a First key
+/// @param b Second key
+/// @return <0, 0 or >0 like strcmp
+int prefix_compare(const char *a, const char *b);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
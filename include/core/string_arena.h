@@ -0,0 +1,71 @@
+#ifndef STRING_ARENA_H
+#define STRING_ARENA_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define STRING_ARENA_BLOCK_SIZE 65536
+
+typedef struct {
+    char *data;
+    size_t size;
+    size_t used;
+} ArenaBlock;
+
+/// Append-only storage for variable-length strings. Blocks are never
+/// moved, so a string keeps its address until the arena is cleared or
+/// freed. Removed strings only become garbage; the owner compacts by
+/// copying the live strings into a fresh arena.
+typedef struct {
+    ArenaBlock *blocks;
+    int block_count;
+    int block_capacity;
+
+    size_t bytes_used;
+    size_t bytes_live;
+} StringArena;
+
+/// @brief Function to initialize an empty arena
+/// @param arena Arena to be initialized
+/// @return 0 if Success | 1 if False
+int string_arena_init(StringArena *arena);
+
+/// @brief Function to free arena memory
+/// @param arena Arena to get freed
+void string_arena_free(StringArena *arena);
+
+/// @brief Function to drop every string keeping the first block
+/// @param arena Arena to get cleared
+void string_arena_clear(StringArena *arena);
+
+/// @brief Function to make room for bytes of strings without further allocation
+/// @param arena Arena to expand
+/// @param bytes Bytes to reserve (terminators included)
+/// @return 0 if Success | 1 if False
+int string_arena_reserve(StringArena *arena, size_t bytes);
+
+/// @brief Function to copy a string into the arena
+/// @param arena Arena to store the string
+/// @param str String to be copied
+/// @param length Length of str (without the terminator)
+/// @return NUL terminated copy | NULL if allocation failed
+char *string_arena_append(StringArena *arena, const char *str, size_t length);
+
+/// @brief Function to mark a string of the arena as garbage
+/// @param arena Arena holding the string
+/// @param length Length of the released string (without the terminator)
+void string_arena_release(StringArena *arena, size_t length);
+
+/// @brief Function to get the bytes held by released strings
+/// @param arena Arena to check
+/// @return Number of garbage bytes
+size_t string_arena_garbage(const StringArena *arena);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
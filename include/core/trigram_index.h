@@ -0,0 +1,84 @@
+#ifndef TRIGRAM_INDEX_H
+#define TRIGRAM_INDEX_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "postings.h"
+
+#define TRIGRAM_BUCKETS 65536
+#define TRIGRAM_MIN_QUERY 3
+
+/// Buffers a query works in, reused between calls of one thread
+typedef struct {
+    int *keys;
+    int key_capacity;
+    int *matches;
+    int match_capacity;
+} TrigramScratch;
+
+/// Substring index: every 3-byte window of the indexed texts is hashed
+/// into one of TRIGRAM_BUCKETS postings lists of values. A query only
+/// returns candidates holding all of its trigrams; bucket collisions can
+/// add false positives, so the caller verifies each candidate.
+typedef struct {
+    Postings postings;
+
+    // Scratch buffers of updates and trigram_index_query
+    TrigramScratch scratch;
+} TrigramIndex;
+
+/// @brief Function to initialize an empty index
+/// @param index Index to be initialized
+/// @return 0 if Success | 1 if False
+int trigram_index_init(TrigramIndex *index);
+
+/// @brief Function to free index memory
+/// @param index Index to get freed
+void trigram_index_free(TrigramIndex *index);
+
+/// @brief Function to remove every value keeping capacity
+/// @param index Index to get cleared
+void trigram_index_clear(TrigramIndex *index);
+
+/// @brief Function to index the texts of a value
+/// @param index Index to be updated
+/// @param value Value to store (unique per record)
+/// @param texts Texts of the record (NULL entries are skipped)
+/// @param text_count Number of texts
+/// @return 0 if Success | 1 if False (nothing is indexed)
+int trigram_index_add(TrigramIndex *index, int value, const char *const *texts, int text_count);
+
+/// @brief Function to drop a value, texts must match the ones it was added with
+/// @param index Index to be updated
+/// @param value Value to remove
+/// @param texts Texts of the record (NULL entries are skipped)
+/// @param text_count Number of texts
+void trigram_index_remove(TrigramIndex *index, int value, const char *const *texts, int text_count);
+
+/// @brief Function to get the candidates of a substring query
+/// @param index Index to search
+/// @param term Substring of at least TRIGRAM_MIN_QUERY bytes
+/// @param count Filled with the number of candidates
+/// @return Sorted candidate values (valid until the next call) | NULL if none
+const int *trigram_index_query(TrigramIndex *index, const char *term, int *count);
+
+/// @brief Function to get the candidates of a substring query without
+/// changing the index, so several threads can query it at once
+/// @param index Index to search
+/// @param scratch Buffers of the calling thread (zeroed before the first call)
+/// @param term Substring of at least TRIGRAM_MIN_QUERY bytes
+/// @param count Filled with the number of candidates
+/// @return Sorted candidate values (valid until the next call with scratch) | NULL if none
+const int *trigram_index_query_with(const TrigramIndex *index, TrigramScratch *scratch, const char *term, int *count);
+
+/// @brief Function to free the buffers of a scratch
+/// @param scratch Scratch to get freed
+void trigram_scratch_free(TrigramScratch *scratch);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,180 @@
+#ifndef BTREE_H
+#define BTREE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "library.h"
+#include "pager.h"
+
+#define BTREE_MAGIC "LBTREE\r\n"
+#define BTREE_VERSION 1
+#define BTREE_MAX_KEY (ISBN_SIZE - 1)
+#define BTREE_MAX_DEPTH 16
+#define BTREE_DEFAULT_FRAMES 256
+
+// Flags of a leaf cell
+#define BTREE_CELL_OVERFLOW 1u
+
+// Layout (every page PAGER_PAGE_SIZE bytes):
+//   page 0: BTreeMeta
+//   nodes:  u8 type | u8 reserved | u16 count | u16 content start |
+//           u16 free fragments | u32 link, then a u16 slot per cell
+//           (sorted by key) pointing at cells packed at the page end
+//   leaf cell:     u8 key size | u8 flags | u16 local size | key | value
+//                  (flags & BTREE_CELL_OVERFLOW: value is u32 size | u32 page)
+//   internal cell: u8 key size | u32 child | key
+// The link of a leaf is the next leaf (0 for the last one), the link of an
+// internal node is its leftmost child; cell i of an internal node points
+// at the keys >= its key. Values larger than a quarter page go to a chain
+// of overflow pages (u32 next | u32 size | bytes). Deleted cells leave
+// free space in their page, reused by later inserts; nodes are not merged.
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t page_size;
+    uint32_t root;
+    uint32_t depth;
+    uint32_t free_page;     // Head of the free page list, 0 if empty
+    uint32_t reserved;
+    uint64_t record_count;
+} BTreeMeta;
+
+/// B+tree of variable sized values keyed by ISBN, stored in a paged file
+/// through a Pager: only the pages in use stay in memory. Not thread-safe.
+/// A library runs on it through btree_backend, holding only the books in
+/// use. Authors and genres are not stored; books keep only their ids.
+typedef struct {
+    Pager pager;
+    BTreeMeta meta;
+    int meta_dirty;
+
+    // Value returned by btree_get, valid until the next call
+    char *value;
+    size_t value_capacity;
+
+    // Cells of a node being split, plus the one that did not fit
+    char *split;
+} BTree;
+
+/// @brief Callback run by btree_scan for each record in key order. Key
+/// and value are only valid during the call; the tree must not be
+/// changed from it.
+/// @param ctx Context given to btree_scan
+/// @param key Key of the record
+/// @param value Value of the record
+/// @param size Size of the value
+/// @return 0 to go on | 1 to stop the scan
+typedef int (*BTreeScanFn)(void *ctx, const char *key, const void *value, size_t size);
+
+/// @brief Function to open (or create) a tree file
+/// @param tree Tree to be opened
+/// @param path Path of the file
+/// @param frames Pages cached in memory (0 for BTREE_DEFAULT_FRAMES)
+/// @return 0 if Success | 1 if False
+int btree_open(BTree *tree, const char *path, int frames);
+
+/// @brief Function to flush and close the tree
+/// @param tree Tree to be closed
+/// @return 0 if Success | 1 if the final flush failed
+int btree_close(BTree *tree);
+
+/// @brief Function to write every changed page and sync the file. Writes
+/// are made in place: a crash between two flushes may leave a torn tree.
+/// @param tree Tree to flush
+/// @return 0 if Success | 1 if False
+int btree_flush(BTree *tree);
+
+/// @brief Function to insert a record, replacing the value of its key
+/// @param tree Tree to change
+/// @param key Key of at most BTREE_MAX_KEY bytes
+/// @param value Value of the record
+/// @param size Size of the value
+/// @return 0 if Success | 1 if False
+int btree_put(BTree *tree, const char *key, const void *value, size_t size);
+
+/// @brief Function to look up a record
+/// @param tree Tree to search
+/// @param key Key of the record
+/// @param value Filled with the value (valid until the next btree call)
+/// @param size Filled with the size of the value
+/// @return 0 if Success | 1 if False (not found included)
+int btree_get(BTree *tree, const char *key, const void **value, size_t *size);
+
+/// @brief Function to delete a record
+/// @param tree Tree to change
+/// @param key Key of the record
+/// @return 0 if Success | 1 if False (not found included)
+int btree_delete(BTree *tree, const char *key);
+
+/// @brief Function to visit the records with from <= key < to in order
+/// @param tree Tree to scan
+/// @param from First key (NULL for the first record)
+/// @param to Key to stop at (NULL for the last record)
+/// @param on_record Callback run for each record
+/// @param ctx Context given to the callback
+/// @return 0 if Success | 1 if False
+int btree_scan(BTree *tree, const char *from, const char *to, BTreeScanFn on_record, void *ctx);
+
+/// @brief Function to drop every record and shrink the file
+/// @param tree Tree to clear
+/// @return 0 if Success | 1 if False
+int btree_clear(BTree *tree);
+
+// Books
+
+/// @brief Function to store a book under its ISBN
+/// @param tree Tree to change
+/// @param lib Library holding the book (its description may be left in a file)
+/// @param book Book to store
+/// @return 0 if Success | 1 if False
+int btree_put_book(BTree *tree, const Library *lib, const Book *book);
+
+/// @brief Function to read a stored book
+/// @param tree Tree to search
+/// @param isbn ISBN of the book
+/// @param book Initialized book filled with the record (freed with book_free)
+/// @return 0 if Success | 1 if False (not found included)
+int btree_get_book(BTree *tree, const char *isbn, Book *book);
+
+/// @brief Function to add the stored books with from <= ISBN < to to a
+/// library, so it only holds the part of the catalog in use. A library
+/// running on the tree keeps them in memory (see lb_cache_book) instead,
+/// skipping the ones it already holds.
+/// @param tree Tree to read
+/// @param lib Library to fill
+/// @param from First ISBN (NULL for the first book)
+/// @param to ISBN to stop at (NULL for the last book)
+/// @return 0 if Success | 1 if False
+int btree_load_books(BTree *tree, Library *lib, const char *from, const char *to);
+
+/// @brief Function to copy a book change into the tree, called by the
+/// backend of btree_backend (or from a change hook, see lb_set_change_hook).
+/// Both run before the library applies the change: the book is read from
+/// the library and the change made to a copy of it. Author and genre
+/// changes are ignored.
+/// @param tree Tree to change
+/// @param lib Library the change was made to
+/// @param change Change reported by the hook
+/// @return 0 if Success | 1 if False
+int btree_apply_change(BTree *tree, Library *lib, const LibraryChange *change);
+
+/// @brief Function to fill a backend running a library on the tree (see
+/// lb_set_backend): books are read with btree_get_book and changes written
+/// with btree_apply_change. The tree stays open while the library uses it;
+/// authors and genres stay in the library.
+/// @param tree Open tree
+/// @param backend Backend to be filled
+/// @return 0 if Success | 1 if False
+int btree_backend(BTree *tree, LibraryBackend *backend);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
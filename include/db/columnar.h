@@ -0,0 +1,177 @@
+#ifndef COLUMNAR_H
+#define COLUMNAR_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "library.h"
+
+#define COLUMNAR_MAGIC "LBCOL\r\n"
+#define COLUMNAR_VERSION 1
+#define COLUMNAR_BLOCK_ROWS 4096
+
+// Columns of a block
+#define COLUMNAR_ID 0
+#define COLUMNAR_YEAR 1
+#define COLUMNAR_AUTHOR_COUNT 2
+#define COLUMNAR_AUTHOR_CODE 3
+#define COLUMNAR_GENRE_COUNT 4
+#define COLUMNAR_GENRE_CODE 5
+#define COLUMNAR_ISBN 6
+#define COLUMNAR_TITLE 7
+#define COLUMNAR_DESCRIPTION 8
+#define COLUMNAR_COLUMNS 9
+
+// Integer column encodings
+#define COLUMNAR_PACKED 1   // value - base, bit-packed
+#define COLUMNAR_DELTA 2    // first value, then deltas - base, bit-packed
+
+// Layout (native byte order, sections 8-byte aligned):
+//   ColumnarHeader | column data of each block | author dictionary |
+//   genre dictionary | ColumnarBlock directory
+// Books are cut into blocks of COLUMNAR_BLOCK_ROWS rows, each field of a
+// block is stored as its own column. Integer columns start with a
+// ColumnarInts header and keep the smaller of the two encodings. Author
+// and genre ids become codes (their position in the dictionary, sorted by
+// id) packed in as few bits as the dictionary needs; a book's lists are
+// its slice of the code column, sized by the count column. String columns
+// are an integer column of sizes + 1 (0 for no text) then the bytes.
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t block_rows;
+    uint64_t book_count;
+    uint64_t block_count;
+    uint64_t author_count;
+    uint64_t genre_count;
+    uint64_t author_offset;
+    uint64_t genre_offset;
+    uint64_t block_offset;
+    uint64_t file_size;
+} ColumnarHeader;
+
+typedef struct {
+    uint8_t encoding;
+    uint8_t bits;
+    uint16_t reserved;
+    uint32_t count;
+    int64_t base;       // Smallest stored value (of the deltas for COLUMNAR_DELTA)
+    int64_t first;      // First value for COLUMNAR_DELTA
+} ColumnarInts;
+
+/// Directory entry of a block: where its columns are and the range of
+/// values in them, so scans can skip blocks that cannot match
+typedef struct {
+    uint32_t rows;
+    int32_t id_min;
+    int32_t id_max;
+    int32_t year_min;
+    int32_t year_max;
+    uint32_t author_code_min;
+    uint32_t author_code_max;
+    uint32_t genre_code_min;
+    uint32_t genre_code_max;
+    uint32_t reserved;
+    uint64_t author_links;
+    uint64_t genre_links;
+    uint64_t column_offset[COLUMNAR_COLUMNS];
+} ColumnarBlock;
+
+typedef struct {
+    int32_t id;
+    char name[MAX_AUTHOR_NAME];
+} ColumnarAuthor;
+
+typedef struct {
+    int32_t id;
+    char name[MAX_GENRE];
+} ColumnarGenre;
+
+/// Read-only mapping of a columnar file
+typedef struct {
+    const char *map;
+    size_t size;
+    const ColumnarHeader *header;
+    const ColumnarBlock *blocks;
+    const ColumnarAuthor *authors;
+    const ColumnarGenre *genres;
+
+    // Blocks decoded and skipped by the scans so far
+    uint64_t blocks_read;
+    uint64_t blocks_skipped;
+} ColumnarFile;
+
+/// Catalog totals, as shown by cli_statistics
+typedef struct {
+    long books;
+    long authors;
+    long genres;
+    long author_links;
+    long genre_links;
+    int year_min;
+    int year_max;
+} ColumnarSummary;
+
+/// @brief Function to write a library as a columnar file. The file is
+/// written next to path and renamed over it. Ids of authors or genres
+/// missing from the library are not stored.
+/// @param lib Library to be saved
+/// @param path Path of the file
+/// @return 0 if Success | 1 if False
+int columnar_save(const Library *lib, const char *path);
+
+/// @brief Function to load every author, genre and book of a columnar file
+/// @param path Path of the file
+/// @param lib Initialized and empty library to be filled
+/// @return 0 if Success | 1 if False
+int columnar_load(const char *path, Library *lib);
+
+/// @brief Function to map a columnar file for scans
+/// @param file File to be opened
+/// @param path Path of the file
+/// @return 0 if Success | 1 if False
+int columnar_open(ColumnarFile *file, const char *path);
+
+/// @brief Function to unmap a columnar file
+/// @param file File to be closed
+void columnar_close(ColumnarFile *file);
+
+/// @brief Function to compute the catalog totals from the block directory,
+/// without reading any column
+/// @param file Open file
+/// @param summary Filled with the totals
+/// @return 0 if Success | 1 if False
+int columnar_summary(const ColumnarFile *file, ColumnarSummary *summary);
+
+/// @brief Function to count the books published between two years
+/// @param file Open file
+/// @param from_year First year (inclusive)
+/// @param to_year Last year (inclusive)
+/// @param count Filled with the number of books
+/// @return 0 if Success | 1 if False
+int columnar_count_by_year(ColumnarFile *file, int from_year, int to_year, long *count);
+
+/// @brief Function to count the books of a genre
+/// @param file Open file
+/// @param genre_id Genre to count
+/// @param count Filled with the number of books
+/// @return 0 if Success | 1 if False
+int columnar_count_by_genre(ColumnarFile *file, int genre_id, long *count);
+
+/// @brief Function to count the books of an author
+/// @param file Open file
+/// @param author_id Author to count
+/// @param count Filled with the number of books
+/// @return 0 if Success | 1 if False
+int columnar_count_by_author(ColumnarFile *file, int author_id, long *count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,22 @@
+#ifndef CRC32_H
+#define CRC32_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+/// @brief Function to extend a CRC-32 (IEEE) with more bytes
+/// @param crc CRC of the previous bytes (0 to start)
+/// @param data Bytes to add
+/// @param size Number of bytes
+/// @return CRC of all the bytes so far
+uint32_t crc32_update(uint32_t crc, const void *data, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
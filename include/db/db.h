@@ -0,0 +1,264 @@
+#ifndef DB_H
+#define DB_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "library.h"
+#include "journal.h"
+
+#define DB_MAGIC "LBSNAP\r\n"
+#define DB_VERSION 5
+#define DB_BYTE_ORDER 0x01020304u
+#define DB_NONE UINT64_MAX
+#define DB_CHECKPOINT_MAGIC "LBCKPT\r\n"
+#define DB_DESCRIPTION_CACHE 256
+
+// DbBookRecord flags
+#define DB_RECORD_REMOVED 1u
+
+// On-disk layout (native byte order, every section 8-byte aligned):
+//   DbHeader | authors | genres | books | id table | indexes | string heap
+// Offsets in the header are bytes from the start of the file. Book
+// records point into the id table by entry and into the string heap by
+// byte; every string in the heap is NUL terminated.
+//
+// Each section holds capacity entries of which count are used, so an
+// incremental checkpoint can rewrite changed records in place and append
+// their ids and strings without moving anything. Removed books leave a
+// record flagged DB_RECORD_REMOVED that later books reuse.
+//
+// The index section keeps the hash tables and postings of the library in
+// the layout they have in memory, so opening a snapshot installs them
+// instead of rebuilding them (see DbIndexHeader).
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint64_t file_size;
+
+    uint64_t author_offset;
+    uint64_t author_count;
+    uint64_t author_capacity;
+    uint64_t genre_offset;
+    uint64_t genre_count;
+    uint64_t genre_capacity;
+    uint64_t book_offset;
+    uint64_t book_count;
+    uint64_t book_capacity;
+    uint64_t id_offset;
+    uint64_t id_count;
+    uint64_t id_capacity;
+    uint64_t string_offset;
+    uint64_t string_size;
+    uint64_t string_capacity;
+    uint64_t index_offset;
+    uint64_t index_size;
+
+    // Journal sequence the snapshot covers, see db_checkpoint
+    uint64_t journal_sequence;
+} DbHeader;
+
+typedef struct {
+    int32_t id;
+    char name[MAX_AUTHOR_NAME];
+} DbAuthorRecord;
+
+typedef struct {
+    int32_t id;
+    char name[MAX_GENRE];
+} DbGenreRecord;
+
+typedef struct {
+    int32_t id;
+    int32_t publication_year;
+    char title[MAX_TITLE];
+    char isbn[ISBN_SIZE];
+    uint8_t flags;
+    char reserved[5];
+
+    uint32_t genre_count;
+    uint32_t author_count;
+    uint64_t genre_offset;
+    uint64_t author_offset;
+
+    uint64_t description_offset;
+    uint64_t description_length;
+} DbBookRecord;
+
+// Index section: this header, then the ISBN, author and genre tables
+// (capacity HashEntry each, ISBN values are dense book indexes), then the
+// genre and author postings as lists + 1 offsets followed by their ids.
+// crc covers everything after the header. Only full writes refresh the
+// section: sequence is the journal_sequence it was written with, so a
+// checkpoint in place leaves it stale and the next open rebuilds.
+typedef struct {
+    uint64_t sequence;
+    uint64_t size;      // Bytes after this header
+    uint32_t crc;
+    int32_t isbn_capacity;
+    int32_t isbn_count;
+    int32_t isbn_tombstones;
+    int32_t author_capacity;
+    int32_t author_count;
+    int32_t author_tombstones;
+    int32_t genre_capacity;
+    int32_t genre_count;
+    int32_t genre_tombstones;
+    int32_t genre_lists;
+    int32_t genre_ids;
+    int32_t author_lists;
+    int32_t author_ids;
+    uint32_t reserved;
+} DbIndexHeader;
+
+// Intent file of an incremental checkpoint: this header, then its writes
+// as u64 offset | u32 size | bytes (payload_size bytes, crc32 of them).
+// Once durable the writes can be redone, so a crash while applying them
+// never leaves a torn snapshot.
+typedef struct {
+    char magic[8];
+    uint64_t base_sequence;
+    uint64_t target_sequence;
+    uint64_t payload_size;
+    uint32_t crc;
+    uint32_t reserved;
+} DbIntentHeader;
+
+typedef struct {
+    int sync_mode;
+    int interval_ms;
+    int description_cache;  // > 0 leaves descriptions in the snapshot, see db_open_lazy
+} DbOptions;
+
+/// Snapshot written in the background by a forked child, see db_snapshot_async
+typedef struct {
+    pid_t pid;
+    int running;
+    int status;         // 0 if the snapshot was saved, 1 if not (once done)
+    double started;
+    double seconds;     // Time the child took (once done)
+} DbSnapshotJob;
+
+/// Snapshot plus write-ahead journal (path + ".wal") of a library. Every
+/// change made through the lb_* functions is journaled before the library
+/// applies it; with JOURNAL_SYNC_ALWAYS the call returns once the record
+/// is durable, waiting after the library locks are released. db_checkpoint
+/// folds the journal into a new snapshot.
+typedef struct {
+    Library *lib;
+    char *path;
+    char *journal_path;
+    Journal journal;
+    uint64_t sequence;
+
+    // Encoding buffer of the change hook
+    pthread_mutex_t scratch_lock;
+    char *scratch;
+    size_t scratch_capacity;
+
+    // Descriptions copied out by incremental checkpoints
+    char *text;
+    size_t text_capacity;
+
+    // Layout of the snapshot on disk, kept for incremental checkpoints
+    int has_snapshot;
+    DbHeader header;
+    int *slot_records;      // Record of each book slot, -1 if none
+    int slot_record_capacity;
+    int *free_records;      // Removed records ready for reuse
+    int free_record_count;
+    int free_record_capacity;
+
+    // Bytes written by the last checkpoint
+    uint64_t checkpoint_bytes;
+} Db;
+
+/// @brief Function to write a library snapshot. The file is written next
+/// to path (path.<pid>.tmp) and renamed over it, so readers never see a
+/// partial snapshot.
+/// @param lib Library to be saved
+/// @param path Path of the snapshot
+/// @return 0 if Success | 1 if False
+int db_save(const Library *lib, const char *path);
+
+/// @brief Function to save a snapshot without blocking: a forked child
+/// writes the copy-on-write image the library had at the call (as db_save
+/// does) while the caller keeps changing it. In concurrent mode the fork
+/// waits for the changes in progress (as a read of the whole library), so
+/// other threads may keep changing the library around it. The snapshot of a database opened with db_open
+/// is refused as path (db_checkpoint keeps its layout); write to another
+/// file instead.
+/// @param lib Library to be saved
+/// @param path Path of the snapshot
+/// @param job Filled with the running job, see db_snapshot_poll
+/// @return 0 if Success | 1 if False
+int db_snapshot_async(const Library *lib, const char *path, DbSnapshotJob *job);
+
+/// @brief Function to check a background snapshot. Once the child is done
+/// running is 0 and status holds its result.
+/// @param job Job started by db_snapshot_async
+/// @param wait 1 to wait for the child, 0 to return at once
+/// @return 0 if Success | 1 if False
+int db_snapshot_poll(DbSnapshotJob *job, int wait);
+
+/// @brief Function to load a snapshot by mapping it read-only. Fixed-width
+/// records are copied into the library; descriptions and long id lists
+/// stay in the mapping as views (copied out on the first change). The
+/// mapping is released by lb_clear or lb_free. The saved indexes are
+/// installed as they are; a stale or damaged index section is rebuilt.
+/// @param path Path of the snapshot
+/// @param lib Initialized and empty library to be filled
+/// @return 0 if Success | 1 if False
+int db_open_mmap(const char *path, Library *lib);
+
+/// @brief Function to load a snapshot leaving the descriptions in the file.
+/// Books hold a reference and lb_get_book_description reads the text on
+/// first access into an LRU cache; the snapshot stays open until lb_clear
+/// or lb_free. Every other section is read into memory.
+/// @param path Path of the snapshot
+/// @param lib Initialized and empty library to be filled
+/// @param description_cache Descriptions kept in memory (0 for DB_DESCRIPTION_CACHE)
+/// @return 0 if Success | 1 if False
+int db_open_lazy(const char *path, Library *lib, int description_cache);
+
+/// @brief Function to open a database: map the snapshot (if any), replay
+/// its journal and start journaling every change of the library
+/// @param db Database to be opened
+/// @param lib Initialized and empty library to be filled
+/// @param path Path of the snapshot
+/// @param options Commit policy (NULL for JOURNAL_SYNC_ALWAYS)
+/// @return 0 if Success | 1 if False
+int db_open(Db *db, Library *lib, const char *path, const DbOptions *options);
+
+/// @brief Function to make every journaled change durable
+/// @param db Database to sync
+/// @return 0 if Success | 1 if False
+int db_sync(Db *db);
+
+/// @brief Function to fold the journal into the snapshot and empty it. Only
+/// the records changed since the last checkpoint are written (through an
+/// intent file, path + ".ckpt", redone by db_open after a crash); the
+/// snapshot is rewritten whole after lb_clear or when a section is full.
+/// A crash at any point leaves either the old snapshot with its journal or
+/// the new snapshot with an empty one.
+/// @param db Database to checkpoint
+/// @return 0 if Success | 1 if False
+int db_checkpoint(Db *db);
+
+/// @brief Function to stop journaling and close the database (the library
+/// keeps its books and must still be freed)
+/// @param db Database to be closed
+/// @return 0 if Success | 1 if the final sync failed
+int db_close(Db *db);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,120 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <pthread.h>
+
+#define JOURNAL_MAGIC "LBWAL\r\n"
+#define JOURNAL_HEADER_SIZE 16
+#define JOURNAL_ENTRY_HEADER 8
+
+// Commit policies
+#define JOURNAL_SYNC_ALWAYS 0
+#define JOURNAL_SYNC_INTERVAL 1
+
+/// @brief Callback run for every valid entry found by journal_replay
+/// @param ctx Context given to journal_replay
+/// @param data Payload of the entry
+/// @param size Size of the payload
+typedef void (*JournalEntryFn)(void *ctx, const void *data, size_t size);
+
+/// Append-only log of opaque entries framed as [size][crc32][payload],
+/// after a header holding the magic and the sequence of the snapshot the
+/// entries apply to.
+///
+/// Appends only copy into a memory buffer. Whoever needs durability
+/// becomes the leader: it swaps the buffer out, writes it and runs one
+/// fdatasync for every entry appended so far, while later appends fill
+/// the other buffer (group commit). With JOURNAL_SYNC_ALWAYS commits wait
+/// for their entry; with JOURNAL_SYNC_INTERVAL a background thread syncs
+/// every interval_ms and commits return at once.
+typedef struct {
+    int fd;
+    uint64_t sequence;
+    int sync_mode;
+    int interval_ms;
+
+    pthread_mutex_t lock;
+    pthread_cond_t durable;
+    pthread_cond_t wake;
+    pthread_t flusher;
+    int flusher_running;
+    int stopping;
+
+    char *pending;
+    size_t pending_size;
+    size_t pending_capacity;
+    char *spare;
+    size_t spare_capacity;
+
+    uint64_t appended_lsn;
+    uint64_t durable_lsn;
+    int syncing;
+    int failed;
+
+    uint64_t sync_count;
+    uint64_t file_size;
+} Journal;
+
+/// @brief Function to open a journal for appending. A missing file, or
+/// one written for another sequence, is reset to an empty journal.
+/// @param journal Journal to be opened
+/// @param path Path of the journal file
+/// @param sequence Sequence of the snapshot the entries apply to
+/// @param sync_mode JOURNAL_SYNC_ALWAYS or JOURNAL_SYNC_INTERVAL
+/// @param interval_ms Time between syncs for JOURNAL_SYNC_INTERVAL
+/// @return 0 if Success | 1 if False
+int journal_open(Journal *journal, const char *path, uint64_t sequence, int sync_mode, int interval_ms);
+
+/// @brief Function to sync pending entries and close the journal
+/// @param journal Journal to be closed
+/// @return 0 if Success | 1 if the final sync failed
+int journal_close(Journal *journal);
+
+/// @brief Function to append an entry (buffered, see journal_wait)
+/// @param journal Journal to append the entry
+/// @param data Payload of the entry
+/// @param size Size of the payload
+/// @param lsn Filled with the sequence number of the entry (may be NULL)
+/// @return 0 if Success | 1 if False
+int journal_append(Journal *journal, const void *data, size_t size, uint64_t *lsn);
+
+/// @brief Function to wait until an entry is on disk, syncing if nobody is
+/// @param journal Journal holding the entry
+/// @param lsn Sequence number returned by journal_append
+/// @return 0 if Success | 1 if False
+int journal_wait(Journal *journal, uint64_t lsn);
+
+/// @brief Function to make every appended entry durable
+/// @param journal Journal to sync
+/// @return 0 if Success | 1 if False
+int journal_sync(Journal *journal);
+
+/// @brief Function to drop every entry and start a new sequence
+/// @param journal Journal to reset
+/// @param sequence Sequence of the snapshot that now holds the entries
+/// @return 0 if Success | 1 if False
+int journal_reset(Journal *journal, uint64_t sequence);
+
+/// @brief Function to read the entries of a journal file in order. Only a
+/// file written for sequence is replayed; other files are left for
+/// journal_open to reset. A torn or corrupted tail (crash during a write)
+/// is cut off the file.
+/// @param path Path of the journal file
+/// @param sequence Sequence of the snapshot the entries must apply to
+/// @param on_entry Callback for each valid entry
+/// @param ctx Context passed to the callback
+/// @param replayed Filled with the number of entries replayed (may be NULL)
+/// @return 0 if Success | 1 if False
+int journal_replay(const char *path, uint64_t sequence, JournalEntryFn on_entry, void *ctx, int *replayed);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
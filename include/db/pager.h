@@ -0,0 +1,93 @@
+#ifndef PAGER_H
+#define PAGER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define PAGER_PAGE_SIZE 4096
+#define PAGER_NONE UINT32_MAX
+#define PAGER_MIN_FRAMES 8
+
+typedef struct {
+    uint32_t page;      // PAGER_NONE while the frame is empty
+    int pins;
+    int dirty;
+    int referenced;     // Second chance bit of the clock
+    int next;           // Next frame of the same bucket, -1 if none
+} PagerFrame;
+
+/// Fixed pool of page frames over a file of PAGER_PAGE_SIZE pages. Pages
+/// are read on first use and stay cached until the clock picks their frame
+/// for another page: the hand sweeps the frames, skips pinned ones, clears
+/// the referenced bit of recently used ones and evicts the first frame left
+/// unreferenced since its last pass (writing it back if dirty).
+typedef struct {
+    int fd;
+    uint32_t page_count;
+
+    PagerFrame *frames;
+    char *memory;
+    int frame_count;
+    int hand;
+
+    // Page number -> frame, chained through PagerFrame.next
+    int *buckets;
+    uint32_t bucket_mask;
+
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;
+    uint64_t writes;
+} Pager;
+
+/// @brief Function to open (or create) a paged file
+/// @param pager Pager to be opened
+/// @param path Path of the file
+/// @param frames Pages held in memory (at least PAGER_MIN_FRAMES)
+/// @return 0 if Success | 1 if False
+int pager_open(Pager *pager, const char *path, int frames);
+
+/// @brief Function to write every dirty page and close the file
+/// @param pager Pager to be closed
+/// @return 0 if Success | 1 if the final flush failed
+int pager_close(Pager *pager);
+
+/// @brief Function to pin a page in memory, reading it if needed
+/// @param pager Pager holding the page
+/// @param page Page number (below page_count)
+/// @return Page data, NULL if False (bad page, read error, every frame pinned)
+char *pager_get(Pager *pager, uint32_t page);
+
+/// @brief Function to append a zeroed page to the file, returned pinned
+/// @param pager Pager to grow
+/// @param page Filled with the number of the new page
+/// @return Page data, NULL if False
+char *pager_allocate(Pager *pager, uint32_t *page);
+
+/// @brief Function to unpin a page returned by pager_get or pager_allocate
+/// @param pager Pager holding the page
+/// @param data Page data
+/// @param dirty Nonzero if the page was changed
+void pager_release(Pager *pager, const char *data, int dirty);
+
+/// @brief Function to cut the file down to its first pages, dropping the
+/// cached copies of the others (none of them may be pinned)
+/// @param pager Pager to shrink
+/// @param page_count Pages to keep
+/// @return 0 if Success | 1 if False
+int pager_truncate(Pager *pager, uint32_t page_count);
+
+/// @brief Function to write every dirty page and sync the file
+/// @param pager Pager to flush
+/// @return 0 if Success | 1 if False
+int pager_flush(Pager *pager);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef EXPORTER_H
+#define EXPORTER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+
+#include "library.h"
+
+// Bytes buffered per output file between writes
+#define EXPORT_BUFFER_SIZE (64u << 10)
+
+// Output follows the importer layouts (see importer.h), so an export can
+// be imported back as is. Author and genre ids are written as names.
+
+typedef struct {
+    int parts;          // Output files written in parallel (0 or 1 for one)
+} ExportOptions;
+
+typedef struct {
+    long records;
+    size_t bytes;
+    double seconds;
+} ExportStats;
+
+/// @brief Function to export every book as CSV with a header row. Rows
+/// are streamed through a fixed buffer, nothing is built in memory.
+/// With N parts the books are split in N contiguous ranges written by
+/// N threads to "<path>.0" .. "<path>.N-1", each with its own header.
+/// @param lib Library to export (only read)
+/// @param path Output file, truncated if it exists
+/// @param options Number of parts (NULL for a single file)
+/// @param stats Filled with counts and time (may be NULL)
+/// @return 0 if Success | 1 if False
+int export_csv(const Library *lib, const char *path, const ExportOptions *options, ExportStats *stats);
+
+/// @brief Function to export every book as JSON Lines, one object per
+/// book, streamed like export_csv
+/// @param lib Library to export (only read)
+/// @param path Output file, truncated if it exists
+/// @param options Number of parts (NULL for a single file)
+/// @param stats Filled with counts and time (may be NULL)
+/// @return 0 if Success | 1 if False
+int export_jsonl(const Library *lib, const char *path, const ExportOptions *options, ExportStats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
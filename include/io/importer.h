@@ -0,0 +1,66 @@
+#ifndef IMPORTER_H
+#define IMPORTER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+
+#include "library.h"
+
+// Input formats
+#define IMPORT_AUTO 0
+#define IMPORT_CSV 1
+#define IMPORT_JSONL 2
+
+#define IMPORT_DEFAULT_CHUNK (4u << 20)
+#define IMPORT_MAX_ERROR_ROWS 32
+
+// Records of both formats carry the same fields:
+//   CSV:   isbn,title,id,year,authors,genres,description
+//          (RFC 4180 quoting, names separated by ';', optional header row)
+//   JSONL: {"isbn":"..","title":"..","id":1,"year":1965,
+//           "authors":[".."],"genres":[".."],"description":".."}
+// Only the ISBN is required; unknown JSON keys are skipped.
+
+typedef struct {
+    int format;         // IMPORT_AUTO guesses from the first byte
+    int threads;        // Parser threads (0 for one per core)
+    size_t chunk_size;  // Target bytes per chunk (0 for IMPORT_DEFAULT_CHUNK)
+} ImportOptions;
+
+typedef struct {
+    long records;       // Books added
+    long errors;        // Rows rejected (malformed, no ISBN, duplicated)
+    long error_rows[IMPORT_MAX_ERROR_ROWS];  // First rejected line numbers
+    size_t bytes;
+    double seconds;
+    double records_per_sec;
+} ImportStats;
+
+/// @brief Function to import a catalog held in memory. The input is split
+/// into chunks on record boundaries, parsed by worker threads and added
+/// to the library in input order through lb_add_books_bulk; only a few
+/// chunks per thread are in flight at a time.
+/// @param lib Library to fill
+/// @param data Catalog text
+/// @param size Size of the text
+/// @param options Format and parallelism (NULL for defaults)
+/// @param stats Filled with counts and throughput (may be NULL)
+/// @return 0 if Success (rejected rows included) | 1 if False
+int import_buffer(Library *lib, const char *data, size_t size, const ImportOptions *options, ImportStats *stats);
+
+/// @brief Function to import a catalog file by mapping it read-only
+/// @param lib Library to fill
+/// @param path Path of a CSV or JSON Lines file
+/// @param options Format and parallelism (NULL for defaults)
+/// @param stats Filled with counts and throughput (may be NULL)
+/// @return 0 if Success (rejected rows included) | 1 if False
+int import_file(Library *lib, const char *path, const ImportOptions *options, ImportStats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
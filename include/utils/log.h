@@ -5,17 +5,88 @@
 extern "C" {
 #endif
 
-#define LOG_INFO(fmt, ...) \
-    log_register_internal("INFO", __FILE__, __LINE__, __func__, fmt, ##__VA_ARGS__)
+#include <stddef.h>
 
-#define LOG_ERROR(fmt, ...) \
-    log_register_internal("ERROR", __FILE__, __LINE__, __func__, fmt, ##__VA_ARGS__)
+#define LOG_LEVEL_TRACE 0
+#define LOG_LEVEL_DEBUG 1
+#define LOG_LEVEL_INFO 2
+#define LOG_LEVEL_WARN 3
+#define LOG_LEVEL_ERROR 4
+#define LOG_LEVEL_OFF 5
+
+// Modules with their own runtime level, a target picks its own with
+// LOG_MODULE (see set_log_module in CMakeLists.txt)
+#define LOG_MODULE_OTHER 0
+#define LOG_MODULE_CORE 1
+#define LOG_MODULE_DB 2
+#define LOG_MODULE_CLI 3
+#define LOG_MODULE_IO 4
+#define LOG_MODULE_COUNT 5
+#define LOG_MODULE_ALL -1
+
+#ifndef LOG_MODULE
+#define LOG_MODULE LOG_MODULE_OTHER
+#endif
+
+// Calls below this level are compiled out, arguments included
+#ifndef LOG_COMPILE_LEVEL
+#define LOG_COMPILE_LEVEL LOG_LEVEL_TRACE
+#endif
+
+#define LOG_DEFAULT_LEVEL LOG_LEVEL_INFO
+
+// Runtime level of each module, read before any argument is evaluated
+extern int log_levels[LOG_MODULE_COUNT];
+
+static inline int log_enabled(int module, int level) {
+    return level >= __atomic_load_n(&log_levels[module], __ATOMIC_RELAXED);
+}
+
+#define LOG_MAX_ARGS 16
+
+/// Call site of a LOG_* macro. The binary format (see log_set_binary)
+/// registers it once and then records only its id and raw arguments.
+typedef struct {
+    const char *level;
+    const char *file;
+    int line;
+    const char *func;
+    const char *fmt;
+    unsigned int id;            // 0 until registered
+    unsigned int generation;    // Binary log holding its site record
+    int arg_count;              // -1 when the call formats its own text
+    unsigned char kinds[LOG_MAX_ARGS];
+} LogSite;
+
+// The format is the first of the arguments, so a call with a format alone
+// still gives the variadic part one argument (ISO C99)
+#define LOG_FORMAT_(fmt, ...) fmt
+#define LOG_FORMAT(...) LOG_FORMAT_(__VA_ARGS__, 0)
+
+#define LOG_AT(level, name, ...) \
+    do { \
+        if ((level) >= LOG_COMPILE_LEVEL && log_enabled(LOG_MODULE, (level))) { \
+            static LogSite log_site_ = { name, __FILE__, __LINE__, __func__, LOG_FORMAT(__VA_ARGS__), 0, 0, 0, { 0 } }; \
+            log_write_site(&log_site_, __VA_ARGS__); \
+        } \
+    } while (0)
+
+#define LOG_TRACE(...) LOG_AT(LOG_LEVEL_TRACE, "TRACE", __VA_ARGS__)
+#define LOG_DEBUG(...) LOG_AT(LOG_LEVEL_DEBUG, "DEBUG", __VA_ARGS__)
+#define LOG_INFO(...) LOG_AT(LOG_LEVEL_INFO, "INFO", __VA_ARGS__)
+#define LOG_WARN(...) LOG_AT(LOG_LEVEL_WARN, "WARN", __VA_ARGS__)
+#define LOG_ERROR(...) LOG_AT(LOG_LEVEL_ERROR, "ERROR", __VA_ARGS__)
 
 #define REALLOCATION_ERROR "Reallocation Failed"
 #define ALLOCATION_ERROR "Allocation Failed"
 #define NULL_ERROR "NULL Argument"
 #define EXPAND_CAPACITY "Expand Capacity Failed"
 
+/// @brief Function behind the LOG_* macros, writing a line of a call site
+/// @param site Call site, holding the format
+/// @param fmt Same format as the site, followed by its arguments
+void log_write_site(LogSite *site, const char *fmt, ...);
+
 void log_register_internal(
     const char *level,
     const char *file,
@@ -24,7 +95,58 @@ void log_register_internal(
     const char *fmt,
     ...
 );
+
+/// Lines are formatted into a lock-free ring and written to library.log
+/// by a background thread through one descriptor. Flush policy: exit()
+/// drains the ring, log_flush waits for it, and with log_catch_crashes a
+/// fatal signal writes the lines still queued before the process dies.
+/// A full ring drops lines (see log_dropped); a forked child and anything
+/// logged after exit is written synchronously.
+
+/// @brief Function to change the runtime level of a module
+/// @param module LOG_MODULE_* or LOG_MODULE_ALL
+/// @param level Lowest LOG_LEVEL_* written (LOG_LEVEL_OFF for none)
+/// @return 0 if Success | 1 if False
+int log_set_level(int module, int level);
+
+/// @brief Function to get the runtime level of a module
+/// @param module LOG_MODULE_*
+/// @return Level if Success | -1 if False
+int log_get_level(int module);
+
+/// @brief Function to switch between text lines in library.log and the
+/// binary log (library.log.bin, rendered offline by log_decode). Binary
+/// entries hold a call site id, a timestamp and the raw arguments, kept
+/// in a buffer per thread until it fills or log_flush runs. Setting
+/// LIBRARY_LOG_FORMAT=binary in the environment starts in binary mode.
+/// @param enabled 1 for binary, 0 for text
+/// @return 0 if Success | 1 if False
+int log_set_binary(int enabled);
+
+/// @brief Function to change when library.log is rotated. The writer
+/// thread checks the size every LOG_INDEX_STRIDE bytes, then library.log
+/// becomes library.log.1 and the older files shift up (see log_reader.h).
+/// @param max_size Size rotating the log, 0 to never rotate
+/// @param keep Rotated files kept, 0 to never rotate
+/// @return 0 if Success | 1 if False
+int log_set_rotation(size_t max_size, int keep);
+
+/// @brief Function to wait until every line logged before the call is written
+void log_flush(void);
+
+/// @brief Function to install handlers writing the queued lines on SIGSEGV,
+/// SIGBUS, SIGFPE, SIGILL and SIGABRT before the default action
+void log_catch_crashes(void);
+
+/// @brief Function to get the number of lines dropped on a full ring
+/// @return Lines dropped since the start
+unsigned long log_dropped(void);
+
+/// @brief Function to print library.log and its rotated files, oldest first
+/// (log_query in log_reader.h filters them)
 void log_read();
+
+/// @brief Function to empty library.log and remove its rotated files
 void log_reset();
 
 #ifdef __cplusplus
@@ -0,0 +1,70 @@
+#ifndef LOG_BINARY_H
+#define LOG_BINARY_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdio.h>
+
+#include "log.h"
+
+#define LOG_BINARY_FILE "library.log.bin"
+#define LOG_BINARY_MAGIC "LBLOG01\n"
+#define LOG_BINARY_MAGIC_SIZE 8
+
+// Binary log layout (native byte order, no padding): the magic, then
+//   site:  u8 LOG_RECORD_SITE | u32 id | i32 line | u8 arg_count | kinds |
+//          level | file | func | fmt (u16 length + bytes each)
+//   entry: u8 LOG_RECORD_ENTRY | u32 site id | u64 ns since the epoch |
+//          u16 size | arguments (size bytes)
+// A site is written once per file before its first entry. Arguments are
+// stored raw in the order of the conversions of fmt: integers as 4 or 8
+// bytes, doubles as 8, strings as u32 length + bytes.
+#define LOG_RECORD_SITE 1
+#define LOG_RECORD_ENTRY 2
+
+// Argument kinds, read from the call with the type of their conversion
+#define LOG_ARG_INT 1       // int (and promoted char/short), 4 bytes
+#define LOG_ARG_LONG 2      // long, 8 bytes
+#define LOG_ARG_LLONG 3     // long long, 8 bytes
+#define LOG_ARG_SIZE 4      // size_t, 8 bytes
+#define LOG_ARG_INTMAX 5    // intmax_t, 8 bytes
+#define LOG_ARG_PTRDIFF 6   // ptrdiff_t, 8 bytes
+#define LOG_ARG_DOUBLE 7    // 8 bytes
+#define LOG_ARG_STRING 8    // u32 length + bytes
+#define LOG_ARG_POINTER 9   // 8 bytes
+
+#define LOG_MAX_STRING 1024
+
+/// One printf conversion
+typedef struct {
+    int length;         // Characters from the '%' to the conversion included
+    int stars;          // '*' width and precision, read as LOG_ARG_INT first
+    int kind;           // LOG_ARG_*, 0 for "%%"
+} LogSpec;
+
+/// @brief Function to parse the conversion at fmt[0] == '%'
+/// @param fmt Conversion to parse
+/// @param spec Filled with the conversion
+/// @return 0 if Success | 1 if not supported (%n, %Lf, %ls, positional...)
+int log_parse_spec(const char *fmt, LogSpec *spec);
+
+/// @brief Function to list the argument kinds a format reads
+/// @param fmt printf format
+/// @param kinds Filled with up to max kinds
+/// @param max Size of kinds
+/// @return Number of arguments if Success | -1 if the format is not supported
+int log_format_kinds(const char *fmt, unsigned char *kinds, int max);
+
+/// @brief Function to render a binary log as library.log text
+/// @param in Binary log, read from its current position
+/// @param out Text output
+/// @return 0 if Success | 1 if the log is damaged or truncated
+int log_decode(FILE *in, FILE *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
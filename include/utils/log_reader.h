@@ -0,0 +1,66 @@
+#ifndef LOG_READER_H
+#define LOG_READER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "log.h"
+
+#define LOG_FILE "library.log"
+
+// Rotation: once library.log reaches LOG_ROTATE_SIZE it becomes
+// library.log.1 (older ones shift up to library.log.LOG_ROTATE_KEEP)
+#define LOG_ROTATE_SIZE (64 * 1024 * 1024)
+#define LOG_ROTATE_KEEP 5
+#define LOG_ROTATE_MAX_KEEP 99
+
+// Sparse time index kept next to each log file (library.log.idx,
+// library.log.1.idx...): an entry every LOG_INDEX_STRIDE bytes written.
+// Every line before offset was written by second, so a reader looking
+// for lines from a later second can start at offset.
+#define LOG_INDEX_SUFFIX ".idx"
+#define LOG_INDEX_STRIDE (64 * 1024)
+
+typedef struct {
+    int64_t second;
+    uint64_t offset;
+} LogIndexEntry;
+
+// Lines are written in the order they were queued, which may trail their
+// timestamp by this many seconds
+#define LOG_ORDER_SLACK 2
+
+/// Lines to read, a zeroed filter reads everything
+typedef struct {
+    int level;          // Lowest LOG_LEVEL_* shown
+    time_t from;        // First second shown, 0 for no bound
+    time_t to;          // Last second shown, 0 for no bound
+    const char *file;   // Source file (path or base name), NULL for any
+    size_t tail;        // Only the last tail matching lines, 0 for all
+} LogFilter;
+
+/// @brief Function to parse "YYYY-MM-DD HH:MM:SS" (local time, as logged)
+/// @param text Time to parse, the time of day may be left out
+/// @param out Filled with the time
+/// @return 0 if Success | 1 if False
+int log_parse_time(const char *text, time_t *out);
+
+/// @brief Function to print the lines of a log and its rotated files,
+/// oldest first. Files are mapped, the time index skips to the window
+/// and a tail is read backwards from the end.
+/// @param path Log file (LOG_FILE), rotated files are path.1, path.2...
+/// @param filter Lines to print, NULL for all
+/// @param out Output
+/// @return Number of lines printed if Success | -1 if False
+long log_query(const char *path, const LogFilter *filter, FILE *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
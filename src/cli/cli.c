@@ -24,8 +24,7 @@ void cli_main_loop(Library *lib) {
         "Atualizar Gênero"
     };
     
-    int max_y, max_x;
-    getmaxyx(stdscr, max_y, max_x);
+    int max_x = getmaxx(stdscr);
     
     MenuWindow *menu1 = cli_create_window(main_menu, 7, 0);
     MenuWindow *menu2 = cli_create_window(update_menu, 3, max_x);
@@ -251,7 +250,7 @@ void cli_add_book(Library *lib) {
     echo();
     scanw("%511s", description);
     noecho();
-    strcpy(book.description, description);
+    book_update_description(&book, description);
     
     mvprintw(7, 5, "Número de autores: ");
     refresh();
@@ -259,9 +258,10 @@ void cli_add_book(Library *lib) {
     scanw("%d", &num_authors);
     noecho();
     
-    author_ids = (int *)malloc(num_authors * sizeof(int));
+    author_ids = (int *)malloc((size_t)num_authors * sizeof(int));
     if (!author_ids) {
         LOG_ERROR(ALLOCATION_ERROR);
+        book_free(&book);
         return;
     }
     
@@ -272,8 +272,8 @@ void cli_add_book(Library *lib) {
         scanw("%128s", author_name);
         noecho();
         
-        if (lb_add_author(lib, author_name) == 0) {
-            author_ids[i] = lib->authors[lib->author_count - 1].id;
+        if (lb_find_or_add_author(lib, author_name, &author_ids[i]) != 0) {
+            author_ids[i] = 0;
         }
     }
     
@@ -284,10 +284,11 @@ void cli_add_book(Library *lib) {
     scanw("%d", &num_genres);
     noecho();
     
-    genre_ids = (int *)malloc(num_genres * sizeof(int));
+    genre_ids = (int *)malloc((size_t)num_genres * sizeof(int));
     if (!genre_ids) {
         LOG_ERROR(ALLOCATION_ERROR);
         free(author_ids);
+        book_free(&book);
         return;
     }
     
@@ -298,8 +299,8 @@ void cli_add_book(Library *lib) {
         scanw("%64s", genre_name);
         noecho();
         
-        if (lb_add_genre(lib, genre_name) == 0) {
-            genre_ids[i] = lib->genres[lib->genre_count - 1].id;
+        if (lb_find_or_add_genre(lib, genre_name, &genre_ids[i]) != 0) {
+            genre_ids[i] = 0;
         }
     }
     
@@ -311,13 +312,21 @@ void cli_add_book(Library *lib) {
         book_add_genre(&book, genre_ids[i]);
     }
     
-    lb_add_book(lib, &book);
+    // On failure (e.g. a duplicated ISBN) the book is still ours to free
+    int failed = lb_add_book(lib, &book) != 0;
+    if (failed) {
+        book_free(&book);
+    }
     
     free(author_ids);
     free(genre_ids);
     
     clear();
-    mvprintw(10, 10, "Livro adicionado com sucesso!");
+    if (failed) {
+        mvprintw(10, 10, "Erro ao adicionar livro!");
+    } else {
+        mvprintw(10, 10, "Livro adicionado com sucesso!");
+    }
     mvprintw(11, 10, "Pressione qualquer tecla para continuar...");
     refresh();
     noecho();
@@ -360,7 +369,7 @@ MenuWindow *cli_create_window(const char **items, int count, int start_x) {
         return NULL;
     }
     
-    window->items = malloc(count * sizeof(char*));
+    window->items = malloc((size_t)count * sizeof(char*));
     if (!window->items) {
         LOG_ERROR(ALLOCATION_ERROR);
         free(window);
@@ -468,10 +477,50 @@ void cli_move_menu(MenuWindow *menu, int new_x) {
 // FUNÇÕES DE ATUALIZAÇÃO
 // ============================================================
 
+// Leituras seguem o protocolo de lb_read_lock: numa biblioteca concorrente
+// outra thread pode mudar ou mover os registros, então os nomes mostrados
+// são copiados e nenhum ponteiro é guardado entre telas
+static int cli_copy_title(Library *lib, const char *isbn, char *title) {
+    lb_read_lock(lib, isbn);
+    const Book *book = lb_find_book_by_isbn(lib, isbn);
+    if (book) {
+        memcpy(title, book->title, MAX_TITLE);
+    }
+    lb_read_unlock(lib, isbn);
+    return book != NULL;
+}
+
+static int cli_copy_author(Library *lib, int author_id, char *name) {
+    int found = 0;
+
+    lb_read_lock(lib, NULL);
+    for (int i = 0; i < lib->author_count && !found; i++) {
+        if (lib->authors[i].id == author_id) {
+            memcpy(name, lib->authors[i].name, MAX_AUTHOR_NAME);
+            found = 1;
+        }
+    }
+    lb_read_unlock(lib, NULL);
+    return found;
+}
+
+static int cli_copy_genre(Library *lib, int genre_id, char *name) {
+    int found = 0;
+
+    lb_read_lock(lib, NULL);
+    for (int i = 0; i < lib->genre_count && !found; i++) {
+        if (lib->genres[i].id == genre_id) {
+            memcpy(name, lib->genres[i].name, MAX_GENRE);
+            found = 1;
+        }
+    }
+    lb_read_unlock(lib, NULL);
+    return found;
+}
+
 void cli_update_book(Library *lib) {
     char isbn[20];
-    int max_y, max_x;
-    getmaxyx(stdscr, max_y, max_x);
+    int max_x = getmaxx(stdscr);
     
     clear();
     attron(A_BOLD);
@@ -488,15 +537,9 @@ void cli_update_book(Library *lib) {
     noecho();
     
     // Procurar livro
-    int book_idx = -1;
-    for (int i = 0; i < lib->book_count; i++) {
-        if (strcmp(lib->books[i].isbn, isbn) == 0) {
-            book_idx = i;
-            break;
-        }
-    }
+    char title[MAX_TITLE];
     
-    if (book_idx == -1) {
+    if (!cli_copy_title(lib, isbn, title)) {
         clear();
         mvprintw(5, 5, "Livro não encontrado!");
         mvprintw(6, 5, "Pressione qualquer tecla para continuar...");
@@ -524,7 +567,7 @@ void cli_update_book(Library *lib) {
     while (1) {
         clear();
         attron(A_BOLD);
-        mvprintw(1, 5, "Livro: %s", lib->books[book_idx].title);
+        mvprintw(1, 5, "Livro: %s", title);
         attroff(A_BOLD);
         
         if (in_submenu) {
@@ -539,7 +582,7 @@ void cli_update_book(Library *lib) {
                 for (int i = 0; i < frames; i++) {
                     clear();
                     int offset = (max_x * i) / frames;
-                    mvprintw(1, 5, "Livro: %s", lib->books[book_idx].title);
+                    mvprintw(1, 5, "Livro: %s", title);
                     mvwin(submenu->win, 0, max_x - offset);
                     cli_draw_menu(submenu);
                     refresh();
@@ -562,7 +605,7 @@ void cli_update_book(Library *lib) {
                     for (int i = 0; i < frames; i++) {
                         clear();
                         int offset = (max_x * i) / frames;
-                        mvprintw(1, 5, "Livro: %s", lib->books[book_idx].title);
+                        mvprintw(1, 5, "Livro: %s", title);
                         mvwin(submenu->win, 0, offset);
                         cli_draw_menu(submenu);
                         refresh();
@@ -584,7 +627,8 @@ void cli_update_book(Library *lib) {
                         echo();
                         scanw("%255s", new_title);
                         noecho();
-                        book_update_title(&lib->books[book_idx], new_title);
+                        lb_update_book_title(lib, isbn, new_title);
+                        cli_copy_title(lib, isbn, title);
                         
                         clear();
                         mvprintw(5, 5, "Título atualizado!");
@@ -599,7 +643,7 @@ void cli_update_book(Library *lib) {
                         echo();
                         scanw("%d", &new_year);
                         noecho();
-                        book_update_publication_year(&lib->books[book_idx], new_year);
+                        lb_update_book_year(lib, isbn, new_year);
                         
                         clear();
                         mvprintw(5, 5, "Ano atualizado!");
@@ -614,7 +658,7 @@ void cli_update_book(Library *lib) {
                         echo();
                         scanw("%511s", new_desc);
                         noecho();
-                        book_update_description(&lib->books[book_idx], new_desc);
+                        lb_update_book_description(lib, isbn, new_desc);
                         
                         clear();
                         mvprintw(5, 5, "Descrição atualizada!");
@@ -625,7 +669,7 @@ void cli_update_book(Library *lib) {
                         for (int i = 0; i < frames; i++) {
                             clear();
                             int offset = (max_x * i) / frames;
-                            mvprintw(1, 5, "Livro: %s", lib->books[book_idx].title);
+                            mvprintw(1, 5, "Livro: %s", title);
                             mvwin(submenu->win, 0, offset);
                             cli_draw_menu(submenu);
                             refresh();
@@ -648,8 +692,7 @@ void cli_update_book(Library *lib) {
 
 void cli_update_author(Library *lib) {
     int author_id;
-    int max_y, max_x;
-    getmaxyx(stdscr, max_y, max_x);
+    int max_x = getmaxx(stdscr);
     
     clear();
     attron(A_BOLD);
@@ -665,15 +708,9 @@ void cli_update_author(Library *lib) {
     noecho();
     
     // Procurar autor
-    int author_idx = -1;
-    for (int i = 0; i < lib->author_count; i++) {
-        if (lib->authors[i].id == author_id) {
-            author_idx = i;
-            break;
-        }
-    }
+    char name[MAX_AUTHOR_NAME];
     
-    if (author_idx == -1) {
+    if (!cli_copy_author(lib, author_id, name)) {
         clear();
         mvprintw(5, 5, "Autor não encontrado!");
         mvprintw(6, 5, "Pressione qualquer tecla para continuar...");
@@ -696,7 +733,7 @@ void cli_update_author(Library *lib) {
     while (1) {
         clear();
         attron(A_BOLD);
-        mvprintw(1, 5, "Autor: %s", lib->authors[author_idx].name);
+        mvprintw(1, 5, "Autor: %s", name);
         attroff(A_BOLD);
         
         if (in_submenu) {
@@ -711,7 +748,7 @@ void cli_update_author(Library *lib) {
                 for (int i = 0; i < frames; i++) {
                     clear();
                     int offset = (max_x * i) / frames;
-                    mvprintw(1, 5, "Autor: %s", lib->authors[author_idx].name);
+                    mvprintw(1, 5, "Autor: %s", name);
                     mvwin(submenu->win, 0, max_x - offset);
                     cli_draw_menu(submenu);
                     refresh();
@@ -734,7 +771,7 @@ void cli_update_author(Library *lib) {
                     for (int i = 0; i < frames; i++) {
                         clear();
                         int offset = (max_x * i) / frames;
-                        mvprintw(1, 5, "Autor: %s", lib->authors[author_idx].name);
+                        mvprintw(1, 5, "Autor: %s", name);
                         mvwin(submenu->win, 0, offset);
                         cli_draw_menu(submenu);
                         refresh();
@@ -756,7 +793,8 @@ void cli_update_author(Library *lib) {
                         echo();
                         scanw("%127s", new_name);
                         noecho();
-                        author_update_name(&lib->authors[author_idx], new_name);
+                        lb_update_author_name(lib, author_id, new_name);
+                        cli_copy_author(lib, author_id, name);
                         
                         clear();
                         mvprintw(5, 5, "Autor atualizado!");
@@ -767,7 +805,7 @@ void cli_update_author(Library *lib) {
                         for (int i = 0; i < frames; i++) {
                             clear();
                             int offset = (max_x * i) / frames;
-                            mvprintw(1, 5, "Autor: %s", lib->authors[author_idx].name);
+                            mvprintw(1, 5, "Autor: %s", name);
                             mvwin(submenu->win, 0, offset);
                             cli_draw_menu(submenu);
                             refresh();
@@ -790,8 +828,7 @@ void cli_update_author(Library *lib) {
 
 void cli_update_genre(Library *lib) {
     int genre_id;
-    int max_y, max_x;
-    getmaxyx(stdscr, max_y, max_x);
+    int max_x = getmaxx(stdscr);
     
     clear();
     attron(A_BOLD);
@@ -807,15 +844,9 @@ void cli_update_genre(Library *lib) {
     noecho();
     
     // Procurar gênero
-    int genre_idx = -1;
-    for (int i = 0; i < lib->genre_count; i++) {
-        if (lib->genres[i].id == genre_id) {
-            genre_idx = i;
-            break;
-        }
-    }
+    char name[MAX_GENRE];
     
-    if (genre_idx == -1) {
+    if (!cli_copy_genre(lib, genre_id, name)) {
         clear();
         mvprintw(5, 5, "Gênero não encontrado!");
         mvprintw(6, 5, "Pressione qualquer tecla para continuar...");
@@ -838,7 +869,7 @@ void cli_update_genre(Library *lib) {
     while (1) {
         clear();
         attron(A_BOLD);
-        mvprintw(1, 5, "Gênero: %s", lib->genres[genre_idx].name);
+        mvprintw(1, 5, "Gênero: %s", name);
         attroff(A_BOLD);
         
         if (in_submenu) {
@@ -853,7 +884,7 @@ void cli_update_genre(Library *lib) {
                 for (int i = 0; i < frames; i++) {
                     clear();
                     int offset = (max_x * i) / frames;
-                    mvprintw(1, 5, "Gênero: %s", lib->genres[genre_idx].name);
+                    mvprintw(1, 5, "Gênero: %s", name);
                     mvwin(submenu->win, 0, max_x - offset);
                     cli_draw_menu(submenu);
                     refresh();
@@ -876,7 +907,7 @@ void cli_update_genre(Library *lib) {
                     for (int i = 0; i < frames; i++) {
                         clear();
                         int offset = (max_x * i) / frames;
-                        mvprintw(1, 5, "Gênero: %s", lib->genres[genre_idx].name);
+                        mvprintw(1, 5, "Gênero: %s", name);
                         mvwin(submenu->win, 0, offset);
                         cli_draw_menu(submenu);
                         refresh();
@@ -898,7 +929,8 @@ void cli_update_genre(Library *lib) {
                         echo();
                         scanw("%63s", new_name);
                         noecho();
-                        update_genre_name(&lib->genres[genre_idx], new_name);
+                        lb_update_genre_name(lib, genre_id, new_name);
+                        cli_copy_genre(lib, genre_id, name);
                         
                         clear();
                         mvprintw(5, 5, "Gênero atualizado!");
@@ -909,7 +941,7 @@ void cli_update_genre(Library *lib) {
                         for (int i = 0; i < frames; i++) {
                             clear();
                             int offset = (max_x * i) / frames;
-                            mvprintw(1, 5, "Gênero: %s", lib->genres[genre_idx].name);
+                            mvprintw(1, 5, "Gênero: %s", name);
                             mvwin(submenu->win, 0, offset);
                             cli_draw_menu(submenu);
                             refresh();
@@ -931,15 +963,17 @@ void cli_update_genre(Library *lib) {
 }
 
 void cli_list_books(Library *lib) {
-    int max_y, max_x;
-    getmaxyx(stdscr, max_y, max_x);
+    int max_y = getmaxy(stdscr);
     
     clear();
     attron(A_BOLD);
     mvprintw(0, 0, "=== Lista de Livros ===");
     attroff(A_BOLD);
     
+    lb_read_lock(lib, NULL);
+    
     if (lib->book_count == 0) {
+        lb_read_unlock(lib, NULL);
         mvprintw(2, 0, "Nenhum livro registrado!");
         mvprintw(max_y - 1, 0, "Pressione qualquer tecla para continuar...");
         refresh();
@@ -950,12 +984,14 @@ void cli_list_books(Library *lib) {
     int line = 2;
     for (int i = 0; i < lib->book_count && line < max_y - 1; i++) {
         mvprintw(line, 0, "[%d] %s (ISBN: %s)", 
-                 lib->books[i].id, 
-                 lib->books[i].title, 
-                 lib->books[i].isbn);
+                 lb_book_id_at(lib, i), 
+                 lb_book_title_at(lib, i), 
+                 lb_book_isbn_at(lib, i));
         line++;
     }
     
+    lb_read_unlock(lib, NULL);
+    
     mvprintw(max_y - 1, 0, "Pressione qualquer tecla para continuar...");
     refresh();
     getch();
@@ -963,15 +999,14 @@ void cli_list_books(Library *lib) {
 
 void cli_search_book(Library *lib) {
     char search_term[256];
-    int max_y, max_x;
-    getmaxyx(stdscr, max_y, max_x);
+    int max_y = getmaxy(stdscr);
     
     clear();
     attron(A_BOLD);
     mvprintw(1, 5, "=== Buscar Livro ===");
     attroff(A_BOLD);
     
-    mvprintw(3, 5, "Título ou ISBN: ");
+    mvprintw(3, 5, "Título, ISBN ou descrição: ");
     refresh();
     echo();
     scanw("%255s", search_term);
@@ -984,19 +1019,25 @@ void cli_search_book(Library *lib) {
     
     int found = 0;
     int line = 3;
-    
-    for (int i = 0; i < lib->book_count && line < max_y - 1; i++) {
-        if (strstr(lib->books[i].title, search_term) != NULL || 
-            strstr(lib->books[i].isbn, search_term) != NULL) {
+    int max_results = max_y - 4 > 0 ? max_y - 4 : 1;
+    int *results = (int *)malloc((size_t)max_results * sizeof(int));
+
+    // Os resultados são posições, válidas só até a próxima mudança
+    lb_read_lock(lib, NULL);
+    if (results && lb_search_books(lib, search_term, results, max_results, &found) == 0) {
+        for (int i = 0; i < found; i++) {
+            int index = results[i];
             mvprintw(line, 5, "[%d] %s (ISBN: %s, Ano: %d)",
-                     lib->books[i].id,
-                     lib->books[i].title,
-                     lib->books[i].isbn,
-                     lib->books[i].publication_year);
+                     lb_book_id_at(lib, index),
+                     lb_book_title_at(lib, index),
+                     lb_book_isbn_at(lib, index),
+                     lb_book_year_at(lib, index));
             line++;
-            found++;
         }
     }
+    lb_read_unlock(lib, NULL);
+
+    free(results);
     
     if (found == 0) {
         mvprintw(3, 5, "Nenhum livro encontrado!");
@@ -1008,14 +1049,14 @@ void cli_search_book(Library *lib) {
 }
 
 void cli_statistics(Library *lib) {
-    int max_y, max_x;
-    getmaxyx(stdscr, max_y, max_x);
+    int max_y = getmaxy(stdscr);
     
     clear();
     attron(A_BOLD);
     mvprintw(1, 5, "=== Estatísticas da Biblioteca ===");
     attroff(A_BOLD);
     
+    lb_read_lock(lib, NULL);
     mvprintw(3, 5, "Total de Livros: %d", lib->book_count);
     mvprintw(4, 5, "Total de Autores: %d", lib->author_count);
     mvprintw(5, 5, "Total de Gêneros: %d", lib->genre_count);
@@ -1037,6 +1078,7 @@ void cli_statistics(Library *lib) {
         }
         mvprintw(8, 5, "Total de Relacionamentos Livro-Gênero: %d", genre_books);
     }
+    lb_read_unlock(lib, NULL);
     
     mvprintw(max_y - 1, 5, "Pressione qualquer tecla para continuar...");
     refresh();
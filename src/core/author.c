@@ -17,7 +17,7 @@ int author_update_id(Author *author, const int new_id) {
     }
 
     author->id = new_id;
-    LOG_INFO("Updated Author - ID %d - %s", new_id,author->name);
+    LOG_DEBUG("Updated Author - ID %d - %s", new_id,author->name);
     return 0;
 }
 
@@ -28,6 +28,6 @@ int author_update_name(Author *author, const char *name){
     }
 
     strcpy(author->name, name);
-    LOG_INFO("Updated Author - ID %d - %s", author->id, name);
+    LOG_DEBUG("Updated Author - ID %d - %s", author->id, name);
     return 0;
 }
\ No newline at end of file
@@ -5,6 +5,158 @@
 # include "book.h"
 #include "log.h"
 
+// Id list helpers
+
+static int *book_ids(int *ids, int *inline_ids) {
+    return ids ? ids : inline_ids;
+}
+
+// Copy a list into a new owned heap buffer of new_cap entries
+static int book_spill_ids(int **ids, int *inline_ids, int count, int *capacity, int new_cap) {
+    int *tmp = malloc((size_t)new_cap * sizeof(int));
+
+    if (!tmp) {
+        LOG_ERROR(ALLOCATION_ERROR);
+        return 1;
+    }
+
+    if (count > 0) {
+        memcpy(tmp, book_ids(*ids, inline_ids), (size_t)count * sizeof(int));
+    }
+
+    if (*capacity > 0) {
+        free(*ids);
+    }
+
+    *ids = tmp;
+    *capacity = new_cap;
+    return 0;
+}
+
+// Make room for one more id
+static int book_reserve_ids(int **ids, int *inline_ids, int count, int *capacity) {
+    if (!*ids) {
+        return count < BOOK_INLINE_IDS ? 0 : book_spill_ids(ids, inline_ids, count, capacity, BOOK_INLINE_IDS * 2);
+    }
+
+    if (*capacity == 0) {
+        if (count < BOOK_INLINE_IDS) {
+            memcpy(inline_ids, *ids, (size_t)count * sizeof(int));
+            *ids = NULL;
+            return 0;
+        }
+
+        return book_spill_ids(ids, inline_ids, count, capacity, count * 2);
+    }
+
+    if (count >= *capacity) {
+        int new_cap = *capacity * 2;
+        int *tmp = realloc(*ids, (size_t)new_cap * sizeof(int));
+
+        if (!tmp) {
+            LOG_ERROR(REALLOCATION_ERROR);
+            return 1;
+        }
+
+        *ids = tmp;
+        *capacity = new_cap;
+    }
+
+    return 0;
+}
+
+// Short lists go inline, borrowed lists get a private copy
+static int book_pack_list(int **ids, int *inline_ids, int count, int *capacity) {
+    if (!*ids) {
+        return 0;
+    }
+
+    if (count <= BOOK_INLINE_IDS) {
+        if (count > 0) {
+            memcpy(inline_ids, *ids, (size_t)count * sizeof(int));
+        }
+
+        if (*capacity > 0) {
+            free(*ids);
+        }
+
+        *ids = NULL;
+        *capacity = 0;
+        return 0;
+    }
+
+    return *capacity == 0 ? book_spill_ids(ids, inline_ids, count, capacity, count) : 0;
+}
+
+// Give a borrowed list a private copy before it is changed
+static int book_detach_list(int **ids, int *inline_ids, int count, int *capacity) {
+    if (!*ids || *capacity > 0) {
+        return 0;
+    }
+
+    return book_pack_list(ids, inline_ids, count, capacity);
+}
+
+int book_init(Book *book) {
+    if (!book) {
+        LOG_ERROR(NULL_ERROR);
+        return 1;
+    }
+
+    memset(book, 0, sizeof(*book));
+    return 0;
+}
+
+void book_free(Book *book) {
+    if (!book) {
+        LOG_ERROR(NULL_ERROR);
+        return;
+    }
+
+    book_free_ids(book);
+
+    if (book->description_capacity > 0) {
+        free(book->description);
+    }
+
+    memset(book, 0, sizeof(*book));
+}
+
+void book_free_ids(Book *book) {
+    if (!book) {
+        return;
+    }
+
+    if (book->genre_capacity > 0) {
+        free(book->genre_ids);
+    }
+
+    if (book->author_capacity > 0) {
+        free(book->author_ids);
+    }
+
+    book->genre_ids = NULL;
+    book->genre_count = 0;
+    book->genre_capacity = 0;
+
+    book->author_ids = NULL;
+    book->author_count = 0;
+    book->author_capacity = 0;
+}
+
+int book_pack_ids(Book *book) {
+    if (!book) {
+        LOG_ERROR(NULL_ERROR);
+        return 1;
+    }
+
+    if (book_pack_list(&book->genre_ids, book->genre_inline, book->genre_count, &book->genre_capacity) != 0) {
+        return 1;
+    }
+
+    return book_pack_list(&book->author_ids, book->author_inline, book->author_count, &book->author_capacity);
+}
+
 int book_update_id(Book *book, const int new_id) {
     if (!book) {
         LOG_ERROR(NULL_ERROR);
@@ -17,7 +169,7 @@ int book_update_id(Book *book, const int new_id) {
     }
 
     book->id = new_id;
-    LOG_INFO("Updated Book ID - %d - %s", new_id,book->title);
+    LOG_DEBUG("Updated Book ID - %d - %s", new_id,book->title);
     return 0;
 }
 
@@ -28,7 +180,7 @@ int book_update_title(Book *book, const char *title) {
     }
 
     strcpy(book->title, title);
-    LOG_INFO("Updated Book Title - %s - %s", book->isbn, title);
+    LOG_DEBUG("Updated Book Title - %s - %s", book->isbn, title);
     return 0;
 }
 
@@ -39,7 +191,7 @@ int book_update_isbn(Book *book, const char *isbn){
     }
 
     strcpy(book->isbn, isbn);
-    LOG_INFO("Updated Book ISBN - %s - %s", book->isbn, book->title);
+    LOG_DEBUG("Updated Book ISBN - %s - %s", book->isbn, book->title);
     return 0;
 }
 
@@ -54,8 +206,8 @@ int book_update_publication_year(Book *book, const int new_year) {
         return 1;
     }
 
-    book->id = new_year;
-    LOG_INFO("Updated Book Year - %d - %s", new_year,book->title);
+    book->publication_year = new_year;
+    LOG_DEBUG("Updated Book Year - %d - %s", new_year,book->title);
     return 0;
 }
 
@@ -65,11 +217,46 @@ int book_update_description(Book *book, const char *description) {
         return 1;
     }
 
-    strcpy(book->description, description);
-    LOG_INFO("Updated Book Description - ISBN %s ", book->isbn);
+    size_t length = strlen(description);
+
+    // Views into a library arena and references to a file are never
+    // written, a private copy is made
+    if (book->description_capacity <= 0 || (size_t)book->description_capacity <= length) {
+        char *tmp = book->description_capacity > 0 ? book->description : NULL;
+        tmp = realloc(tmp, length + 1);
+
+        if (!tmp) {
+            LOG_ERROR(REALLOCATION_ERROR);
+            return 1;
+        }
+
+        book->description = tmp;
+        book->description_capacity = (int)(length + 1);
+    }
+
+    memcpy(book->description, description, length + 1);
+    LOG_DEBUG("Updated Book Description - ISBN %s ", book->isbn);
     return 0;
 }
 
+void book_set_description_ref(Book *book, int ref) {
+    if (!book || ref < 0) {
+        LOG_ERROR(NULL_ERROR);
+        return;
+    }
+
+    if (book->description_capacity > 0) {
+        free(book->description);
+    }
+
+    book->description = NULL;
+    book->description_capacity = -(ref + 1);
+}
+
+int book_description_ref(const Book *book) {
+    return book && book->description_capacity < 0 ? -book->description_capacity - 1 : -1;
+}
+
 int book_add_genre(Book *book, const int genre_id) {
     if (!book) {
         LOG_ERROR(NULL_ERROR);
@@ -86,10 +273,10 @@ int book_add_genre(Book *book, const int genre_id) {
         return 1;
     }
 
-    book->genre_ids[book->genre_count] = genre_id;
+    book_get_genre_ids(book)[book->genre_count] = genre_id;
     book->genre_count++;
 
-    LOG_INFO("Book Genre Added - %d", genre_id);
+    LOG_DEBUG("Book Genre Added - %d", genre_id);
     return 0;
 }
 
@@ -99,9 +286,14 @@ int book_remove_genre(Book *book, const int genre_id) {
         return 1;
     }
 
+    if (book_detach_list(&book->genre_ids, book->genre_inline, book->genre_count, &book->genre_capacity) != 0) {
+        return 1;
+    }
+
+    int *ids = book_get_genre_ids(book);
     int rm_index = -1;
     for (int i = 0; i < book->genre_count; i++) {
-        if (book->genre_ids[i] == genre_id) {
+        if (ids[i] == genre_id) {
             rm_index = i;
             break;
         }
@@ -113,13 +305,13 @@ int book_remove_genre(Book *book, const int genre_id) {
     }
 
     for (int i = rm_index; i < book->genre_count - 1; i++) {
-        book->genre_ids[i] = book->genre_ids[i + 1];
+        ids[i] = ids[i + 1];
     }
 
     book->genre_count--;
-    memset(&book->genre_ids[book->genre_count], 0, sizeof(int));
+    memset(&ids[book->genre_count], 0, sizeof(int));
     
-    LOG_INFO("Book Genre Removed - %d", genre_id);
+    LOG_DEBUG("Book Genre Removed - %d", genre_id);
 
     return 0;
 }
@@ -140,10 +332,10 @@ int book_add_author(Book *book, const int author_id){
         return 1;
     }
 
-    book->author_ids[book->author_count] = author_id;
+    book_get_author_ids(book)[book->author_count] = author_id;
     book->author_count++;
 
-    LOG_INFO("Book Author Added - %d", author_id);
+    LOG_DEBUG("Book Author Added - %d", author_id);
     return 0;
 }
 
@@ -153,9 +345,14 @@ int book_remove_author(Book *book, const int author_id) {
         return 1;
     }
 
+    if (book_detach_list(&book->author_ids, book->author_inline, book->author_count, &book->author_capacity) != 0) {
+        return 1;
+    }
+
+    int *ids = book_get_author_ids(book);
     int rm_index = -1;
     for (int i = 0; i < book->author_count; i++) {
-        if (book->author_ids[i] == author_id) {
+        if (ids[i] == author_id) {
             rm_index = i;
             break;
         }
@@ -167,58 +364,51 @@ int book_remove_author(Book *book, const int author_id) {
     }
 
     for (int i = rm_index; i < book->author_count - 1; i++) {
-        book->author_ids[i] = book->author_ids[i + 1];
+        ids[i] = ids[i + 1];
     }
 
     book->author_count--;
-    memset(&book->author_ids[book->author_count], 0, sizeof(int));
+    memset(&ids[book->author_count], 0, sizeof(int));
 
-    LOG_INFO("Book Author Removed - %d", author_id);
+    LOG_DEBUG("Book Author Removed - %d", author_id);
 
     return 0;
 }
 
 int book_reserve_genre(Book *book) {
-    if (book->genre_count >= book->genre_capacity) {
-        int new_cap = book->genre_capacity ? book->genre_capacity * 2 : 2;
-        int *tmp = realloc(book->genre_ids, new_cap * sizeof(int));
+    int capacity = book->genre_capacity;
 
-        if (!tmp) {
-            LOG_ERROR(REALLOCATION_ERROR);
-            return 1;
-        }
+    if (book_reserve_ids(&book->genre_ids, book->genre_inline, book->genre_count, &book->genre_capacity) != 0) {
+        LOG_ERROR(REALLOCATION_ERROR);
+        return 1;
+    }
 
-        book->genre_ids = tmp;
-        book->genre_capacity = new_cap;
-        LOG_INFO("Capacity Expanded - Genres");
+    if (book->genre_capacity != capacity) {
+        LOG_DEBUG("Capacity Expanded - Genres");
     }
 
     return 0;
 }
 
 int book_reserve_author(Book *book) {
-    if (book->author_count >= book->author_capacity) {
-        int new_cap = book->author_capacity ? book->author_capacity * 2 : 2;
-        int *tmp = realloc(book->author_ids, new_cap * sizeof(int));
+    int capacity = book->author_capacity;
 
-        if (!tmp) {
-            LOG_ERROR(REALLOCATION_ERROR);
-            return 1;
-        }
+    if (book_reserve_ids(&book->author_ids, book->author_inline, book->author_count, &book->author_capacity) != 0) {
+        LOG_ERROR(REALLOCATION_ERROR);
+        return 1;
+    }
 
-        book->author_ids = tmp;
-        book->author_capacity = new_cap;
-        LOG_INFO("Capacity Expanded - Authors");
+    if (book->author_capacity != capacity) {
+        LOG_DEBUG("Capacity Expanded - Authors");
     }
 
     return 0;
 }
 
 int *book_get_genre_ids(Book *book) {
-    return book->genre_ids;
+    return book_ids(book->genre_ids, book->genre_inline);
 }
 
 int *book_get_author_ids(Book *book) {
-    return book->author_ids;
+    return book_ids(book->author_ids, book->author_inline);
 }
-
@@ -0,0 +1,199 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "description_store.h"
+#include "log.h"
+
+int description_store_init(DescriptionStore *store, int entries, DescriptionReadFn read,
+                           void (*release)(void *ctx), void *ctx) {
+    if (!store || !read) {
+        LOG_ERROR(NULL_ERROR);
+        return 1;
+    }
+
+    memset(store, 0, sizeof(*store));
+    store->entry_count = entries < DESCRIPTION_STORE_MIN_ENTRIES ? DESCRIPTION_STORE_MIN_ENTRIES : entries;
+    store->entries = calloc((size_t)store->entry_count, sizeof(DescriptionEntry));
+
+    if (!store->entries) {
+        LOG_ERROR(ALLOCATION_ERROR);
+        return 1;
+    }
+
+    // Entries start as one list, all free
+    for (int i = 0; i < store->entry_count; i++) {
+        store->entries[i].ref = -1;
+        store->entries[i].prev = i - 1;
+        store->entries[i].next = i + 1 < store->entry_count ? i + 1 : -1;
+    }
+
+    store->head = 0;
+    store->tail = store->entry_count - 1;
+    store->read = read;
+    store->release = release;
+    store->ctx = ctx;
+    pthread_mutex_init(&store->lock, NULL);
+    return 0;
+}
+
+void description_store_free(DescriptionStore *store) {
+    if (!store) {
+        LOG_ERROR(NULL_ERROR);
+        return;
+    }
+
+    for (int i = 0; i < store->entry_count; i++) {
+        free(store->entries[i].text);
+    }
+
+    if (store->release) {
+        store->release(store->ctx);
+    }
+
+    if (store->entries) {
+        pthread_mutex_destroy(&store->lock);
+    }
+
+    free(store->entries);
+    free(store->refs);
+    memset(store, 0, sizeof(*store));
+}
+
+int description_store_add(DescriptionStore *store, uint64_t offset, uint32_t length, int *ref) {
+    if (!store || !ref) {
+        LOG_ERROR(NULL_ERROR);
+        return 1;
+    }
+
+    if (store->ref_count == store->ref_capacity) {
+        int new_cap = store->ref_capacity ? store->ref_capacity * 2 : 64;
+        DescriptionRef *tmp = realloc(store->refs, (size_t)new_cap * sizeof(DescriptionRef));
+
+        if (!tmp) {
+            LOG_ERROR(REALLOCATION_ERROR);
+            return 1;
+        }
+
+        store->refs = tmp;
+        store->ref_capacity = new_cap;
+    }
+
+    store->refs[store->ref_count].offset = offset;
+    store->refs[store->ref_count].length = length;
+    store->refs[store->ref_count].entry = -1;
+    *ref = store->ref_count++;
+    return 0;
+}
+
+// Move an entry to the front of the list
+static void description_store_touch(DescriptionStore *store, int index) {
+    DescriptionEntry *entry = &store->entries[index];
+
+    if (store->head == index) {
+        return;
+    }
+
+    store->entries[entry->prev].next = entry->next;
+    if (entry->next >= 0) {
+        store->entries[entry->next].prev = entry->prev;
+    } else {
+        store->tail = entry->prev;
+    }
+
+    entry->prev = -1;
+    entry->next = store->head;
+    store->entries[store->head].prev = index;
+    store->head = index;
+}
+
+// Text of a reference, read into the least recently used entry on a miss
+static const char *description_store_fetch(DescriptionStore *store, int ref) {
+    if (ref < 0 || ref >= store->ref_count) {
+        LOG_ERROR("Invalid Description Reference - %d", ref);
+        return NULL;
+    }
+
+    DescriptionRef *target = &store->refs[ref];
+
+    if (target->entry >= 0) {
+        store->hits++;
+        description_store_touch(store, target->entry);
+        return store->entries[target->entry].text;
+    }
+
+    int index = store->tail;
+    DescriptionEntry *entry = &store->entries[index];
+    size_t size = (size_t)target->length + 1;
+
+    if (entry->ref >= 0) {
+        store->refs[entry->ref].entry = -1;
+        entry->ref = -1;
+    }
+
+    if (entry->capacity < size) {
+        char *tmp = realloc(entry->text, size);
+        if (!tmp) {
+            LOG_ERROR(REALLOCATION_ERROR);
+            return NULL;
+        }
+
+        entry->text = tmp;
+        entry->capacity = size;
+    }
+
+    // The stored NUL is read too, a missing one means the file changed
+    if (store->read(store->ctx, target->offset, entry->text, size) != 0 || entry->text[size - 1] != '\0') {
+        LOG_ERROR("Description Read Failed - %d", ref);
+        return NULL;
+    }
+
+    store->misses++;
+    entry->ref = ref;
+    target->entry = index;
+    description_store_touch(store, index);
+    return entry->text;
+}
+
+const char *description_store_get(DescriptionStore *store, int ref) {
+    if (!store) {
+        LOG_ERROR(NULL_ERROR);
+        return NULL;
+    }
+
+    pthread_mutex_lock(&store->lock);
+    const char *text = description_store_fetch(store, ref);
+    pthread_mutex_unlock(&store->lock);
+    return text;
+}
+
+const char *description_store_copy(DescriptionStore *store, int ref, char **buffer, size_t *capacity) {
+    if (!store || !buffer || !capacity) {
+        LOG_ERROR(NULL_ERROR);
+        return NULL;
+    }
+
+    pthread_mutex_lock(&store->lock);
+
+    const char *text = description_store_fetch(store, ref);
+    size_t size = text ? strlen(text) + 1 : 0;
+
+    if (text && *capacity < size) {
+        char *tmp = realloc(*buffer, size);
+
+        if (!tmp) {
+            LOG_ERROR(REALLOCATION_ERROR);
+            text = NULL;
+        } else {
+            *buffer = tmp;
+            *capacity = size;
+        }
+    }
+
+    if (text) {
+        memcpy(*buffer, text, size);
+    }
+
+    pthread_mutex_unlock(&store->lock);
+    return text ? *buffer : NULL;
+}
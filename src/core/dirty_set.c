@@ -0,0 +1,89 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dirty_set.h"
+#include "log.h"
+
+int dirty_set_init(DirtySet *set) {
+    if (!set) {
+        LOG_ERROR(NULL_ERROR);
+        return 1;
+    }
+
+    memset(set, 0, sizeof(*set));
+    return 0;
+}
+
+void dirty_set_free(DirtySet *set) {
+    if (!set) {
+        LOG_ERROR(NULL_ERROR);
+        return;
+    }
+
+    free(set->marks);
+    free(set->items);
+    memset(set, 0, sizeof(*set));
+}
+
+void dirty_set_clear(DirtySet *set) {
+    if (!set) {
+        LOG_ERROR(NULL_ERROR);
+        return;
+    }
+
+    // Only the marked positions need resetting
+    for (int i = 0; i < set->count; i++) {
+        set->marks[set->items[i]] = 0;
+    }
+
+    set->count = 0;
+}
+
+int dirty_set_mark(DirtySet *set, int index) {
+    if (!set || index < 0) {
+        LOG_ERROR(NULL_ERROR);
+        return 1;
+    }
+
+    if (index >= set->mark_capacity) {
+        int new_cap = set->mark_capacity ? set->mark_capacity : 64;
+        while (new_cap <= index) {
+            new_cap *= 2;
+        }
+
+        unsigned char *marks = realloc(set->marks, (size_t)new_cap);
+        if (!marks) {
+            LOG_ERROR(REALLOCATION_ERROR);
+            return 1;
+        }
+
+        memset(marks + set->mark_capacity, 0, (size_t)(new_cap - set->mark_capacity));
+        set->marks = marks;
+        set->mark_capacity = new_cap;
+    }
+
+    if (set->marks[index]) {
+        return 0;
+    }
+
+    if (set->count == set->capacity) {
+        int new_cap = set->capacity ? set->capacity * 2 : 64;
+        int *items = realloc(set->items, (size_t)new_cap * sizeof(int));
+        if (!items) {
+            LOG_ERROR(REALLOCATION_ERROR);
+            return 1;
+        }
+
+        set->items = items;
+        set->capacity = new_cap;
+    }
+
+    set->marks[index] = 1;
+    set->items[set->count++] = index;
+    return 0;
+}
+
+int dirty_set_contains(const DirtySet *set, int index) {
+    return set && index >= 0 && index < set->mark_capacity && set->marks[index];
+}
@@ -17,7 +17,7 @@ int update_genre_id(Genre *genre, const int new_id) {
     }
 
     genre->id = new_id;
-    LOG_INFO("Updated Genre - ID %d - %s", new_id,genre->name);
+    LOG_DEBUG("Updated Genre - ID %d - %s", new_id,genre->name);
     return 0;
 }
 
@@ -28,7 +28,7 @@ int update_genre_name(Genre *genre, const char *name) {
     }
 
     strcpy(genre->name, name);
-    LOG_INFO("Updated Genre - ID %d - %s", genre->id, name);
+    LOG_DEBUG("Updated Genre - ID %d - %s", genre->id, name);
     return 0;
 }
 
@@ -0,0 +1,254 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hash_index.h"
+#include "log.h"
+
+#define HASH_INDEX_MIN_CAPACITY 16
+
+unsigned int hash_index_hash(const char *key) {
+    unsigned int hash = 2166136261u;
+
+    for (const unsigned char *p = (const unsigned char *)key; *p; p++) {
+        hash ^= *p;
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+// Slot holding key, or HASH_INDEX_EMPTY when key is absent
+static int hash_index_slot(const HashIndex *index, const void *ctx, const char *key, unsigned int hash) {
+    if (index->capacity == 0) {
+        return HASH_INDEX_EMPTY;
+    }
+
+    unsigned int mask = (unsigned int)index->capacity - 1;
+
+    for (unsigned int i = hash & mask;; i = (i + 1) & mask) {
+        const HashEntry *entry = &index->entries[i];
+
+        if (entry->value == HASH_INDEX_EMPTY) {
+            return HASH_INDEX_EMPTY;
+        }
+
+        if (entry->value >= 0 && entry->hash == hash &&
+            strcmp(index->key_of(ctx, entry->value), key) == 0) {
+            return (int)i;
+        }
+    }
+}
+
+static int hash_index_rehash(HashIndex *index, int new_cap) {
+    HashEntry *entries = malloc((size_t)new_cap * sizeof(HashEntry));
+
+    if (!entries) {
+        LOG_ERROR(ALLOCATION_ERROR);
+        return 1;
+    }
+
+    for (int i = 0; i < new_cap; i++) {
+        entries[i].hash = 0;
+        entries[i].value = HASH_INDEX_EMPTY;
+    }
+
+    unsigned int mask = (unsigned int)new_cap - 1;
+
+    for (int i = 0; i < index->capacity; i++) {
+        HashEntry old = index->entries[i];
+
+        if (old.value < 0) {
+            continue;
+        }
+
+        unsigned int j = old.hash & mask;
+        while (entries[j].value != HASH_INDEX_EMPTY) {
+            j = (j + 1) & mask;
+        }
+        entries[j] = old;
+    }
+
+    free(index->entries);
+    index->entries = entries;
+    index->capacity = new_cap;
+    index->tombstones = 0;
+
+    return 0;
+}
+
+int hash_index_init(HashIndex *index, HashIndexKeyFn key_of) {
+    if (!index || !key_of) {
+        LOG_ERROR(NULL_ERROR);
+        return 1;
+    }
+
+    memset(index, 0, sizeof(*index));
+    index->key_of = key_of;
+
+    return 0;
+}
+
+void hash_index_free(HashIndex *index) {
+    if (!index) {
+        return;
+    }
+
+    free(index->entries);
+    index->entries = NULL;
+    index->capacity = 0;
+    index->count = 0;
+    index->tombstones = 0;
+}
+
+void hash_index_clear(HashIndex *index) {
+    if (!index) {
+        return;
+    }
+
+    for (int i = 0; i < index->capacity; i++) {
+        index->entries[i].hash = 0;
+        index->entries[i].value = HASH_INDEX_EMPTY;
+    }
+
+    index->count = 0;
+    index->tombstones = 0;
+}
+
+int hash_index_reserve(HashIndex *index, int count) {
+    if (!index) {
+        LOG_ERROR(NULL_ERROR);
+        return 1;
+    }
+
+    // Keep load factor (live + tombstones) under 3/4
+    int needed = count + index->tombstones;
+    if (needed * 4 < index->capacity * 3) {
+        return 0;
+    }
+
+    int new_cap = index->capacity ? index->capacity : HASH_INDEX_MIN_CAPACITY;
+    while (count * 4 >= new_cap * 3) {
+        new_cap *= 2;
+    }
+
+    return hash_index_rehash(index, new_cap);
+}
+
+int hash_index_find(const HashIndex *index, const void *ctx, const char *key) {
+    if (!index || !key) {
+        return HASH_INDEX_EMPTY;
+    }
+
+    int slot = hash_index_slot(index, ctx, key, hash_index_hash(key));
+    if (slot < 0) {
+        return HASH_INDEX_EMPTY;
+    }
+
+    return index->entries[slot].value;
+}
+
+int hash_index_insert(HashIndex *index, const void *ctx, const char *key, int value) {
+    if (!index || !key) {
+        LOG_ERROR(NULL_ERROR);
+        return 1;
+    }
+
+    if (value < 0) {
+        LOG_ERROR("Unsupported Index Value");
+        return 1;
+    }
+
+    unsigned int hash = hash_index_hash(key);
+
+    if (hash_index_slot(index, ctx, key, hash) >= 0) {
+        return 1;
+    }
+
+    if (hash_index_reserve(index, index->count + 1) != 0) {
+        LOG_ERROR(EXPAND_CAPACITY);
+        return 1;
+    }
+
+    unsigned int mask = (unsigned int)index->capacity - 1;
+    unsigned int i = hash & mask;
+
+    while (index->entries[i].value >= 0) {
+        i = (i + 1) & mask;
+    }
+
+    if (index->entries[i].value == HASH_INDEX_TOMBSTONE) {
+        index->tombstones--;
+    }
+
+    index->entries[i].hash = hash;
+    index->entries[i].value = value;
+    index->count++;
+
+    return 0;
+}
+
+int hash_index_update(HashIndex *index, const void *ctx, const char *key, int value) {
+    if (!index || !key) {
+        LOG_ERROR(NULL_ERROR);
+        return 1;
+    }
+
+    int slot = hash_index_slot(index, ctx, key, hash_index_hash(key));
+    if (slot < 0 || value < 0) {
+        return 1;
+    }
+
+    index->entries[slot].value = value;
+    return 0;
+}
+
+int hash_index_remove(HashIndex *index, const void *ctx, const char *key) {
+    if (!index || !key) {
+        LOG_ERROR(NULL_ERROR);
+        return 1;
+    }
+
+    int slot = hash_index_slot(index, ctx, key, hash_index_hash(key));
+    if (slot < 0) {
+        return 1;
+    }
+
+    index->entries[slot].value = HASH_INDEX_TOMBSTONE;
+    index->count--;
+    index->tombstones++;
+
+    return 0;
+}
+
+int hash_index_load(HashIndex *index, const HashEntry *entries, int capacity, int count, int tombstones) {
+    if (!index || (!entries && capacity > 0)) {
+        LOG_ERROR(NULL_ERROR);
+        return 1;
+    }
+
+    // Probing needs a power of two and at least one empty entry
+    if (capacity < 0 || (capacity & (capacity - 1)) != 0 || count < 0 || tombstones < 0 ||
+        (capacity > 0 && count + tombstones >= capacity) || (capacity == 0 && count > 0)) {
+        LOG_ERROR("Invalid Saved Hash Index");
+        return 1;
+    }
+
+    HashEntry *copy = NULL;
+    if (capacity > 0) {
+        copy = malloc((size_t)capacity * sizeof(HashEntry));
+        if (!copy) {
+            LOG_ERROR(ALLOCATION_ERROR);
+            return 1;
+        }
+
+        memcpy(copy, entries, (size_t)capacity * sizeof(HashEntry));
+    }
+
+    free(index->entries);
+    index->entries = copy;
+    index->capacity = capacity;
+    index->count = count;
+    index->tombstones = tombstones;
+    return 0;
+}
@@ -1,237 +1,2996 @@
+#define _GNU_SOURCE
+
 #include <stdlib.h>
 #include <stdio.h>
 #include "library.h"
 
-#include <string.h>
+#include <string.h>
+#include <pthread.h>
+
+static const char *lb_book_isbn_key(const void *ctx, int value) {
+    const Library *lib = ctx;
+    return lib->books[lib->slot_books[value]].isbn;
+}
+
+static const char *lb_author_name_key(const void *ctx, int value) {
+    const Library *lib = ctx;
+    return lib->authors[value].name;
+}
+
+static const char *lb_genre_name_key(const void *ctx, int value) {
+    const Library *lib = ctx;
+    return lib->genres[value].name;
+}
+
+// Titles are indexed by slot, which a removal leaves in place
+static const char *lb_book_title_key(const void *ctx, int value) {
+    const Library *lib = ctx;
+    return lib->books[lib->slot_books[value]].title;
+}
+
+// Names are stored truncated, lookups must use the same key
+static void lb_name_key(char *dest, const char *name, size_t size) {
+    strncpy(dest, name, size - 1);
+    dest[size - 1] = '\0';
+}
+
+// State shared by changes of different shards in concurrent mode, each
+// under a mutex of its own taken last and never nested
+#define LB_GUARD_TEXT 0         // Text index
+#define LB_GUARD_STRINGS 1      // Description arena
+#define LB_GUARD_DIRTY 2        // Dirty sets
+#define LB_GUARD_PREFIX 3       // Sorted titles and names
+#define LB_GUARDS 4
+
+static void lb_guard(Library *lib, int guard);
+static void lb_unguard(Library *lib, int guard);
+
+// Commit hook owed by the change the calling thread is making, run by
+// lb_unlock once its locks are released
+static _Thread_local LibraryCommitFn lb_commit_fn;
+static _Thread_local void *lb_commit_ctx;
+
+// Called once a change is checked and before it is applied: the backend
+// writes it first (its failure fails the change), then the hook sees it.
+// Changes of different shards call the hook at once in concurrent mode.
+static int lb_notify(Library *lib, int kind, const char *isbn, const Book *book, const char *text, int value) {
+    // Books moving between the backend and memory are not changes
+    if (lib->backend_paging) {
+        return 0;
+    }
+
+    LibraryChange change = { kind, isbn, book, text, value };
+    if (lib->backend && lib->backend->apply(lib->backend->ctx, lib, &change) != 0) {
+        LOG_ERROR("Backend Write Failed - Change %d", kind);
+        return 1;
+    }
+
+    if (!lib->on_change) {
+        return 0;
+    }
+
+    lib->on_change(lib->change_ctx, &change);
+
+    if (lib->on_commit) {
+        lb_commit_fn = lib->on_commit;
+        lb_commit_ctx = lib->change_ctx;
+    }
+    return 0;
+}
+
+// Dirty tracking for checkpoints: a failed mark falls back to a full one
+static void lb_mark(Library *lib, DirtySet *set, int value) {
+    lb_guard(lib, LB_GUARD_DIRTY);
+    if (dirty_set_mark(set, value) != 0) {
+        lib->dirty_all = 1;
+    }
+    lb_unguard(lib, LB_GUARD_DIRTY);
+}
+
+static void lb_mark_book(Library *lib, int slot) {
+    lb_mark(lib, &lib->dirty_books, slot);
+}
+
+static void lb_mark_author(Library *lib, int index) {
+    lb_mark(lib, &lib->dirty_authors, index);
+}
+
+static void lb_mark_genre(Library *lib, int index) {
+    lb_mark(lib, &lib->dirty_genres, index);
+}
+
+// Concurrent Mode
+
+// One cache line per shard, so readers of different shards share nothing
+typedef struct {
+    _Alignas(64) pthread_rwlock_t lock;
+} LibraryShard;
+
+// Lock order: shards in ascending order, authors, genres, then one guard.
+// Readers that rebuild an index on demand take rebuild last.
+struct LibraryLocks {
+    LibraryShard shards[LB_LOCK_SHARDS];
+    pthread_rwlock_t authors;   // Authors, their name index and postings
+    pthread_rwlock_t genres;    // Genres, their name index and postings
+    pthread_mutex_t guards[LB_GUARDS];
+    pthread_mutex_t rebuild;    // Text and prefix indexes rebuilt by readers
+};
+
+// Scopes of a change
+#define LB_SCOPE_ALL 1          // Every shard and table (books move, ISBN index changes)
+#define LB_SCOPE_BOOK 2         // One ISBN shard and its tables
+#define LB_SCOPE_TABLES 3       // Author and/or genre table
+
+#define LB_TABLE_AUTHORS 1
+#define LB_TABLE_GENRES 2
+
+// Books a concurrent bulk add stores under one lock, see lb_add_books_chunked
+#define LB_BULK_CHUNK 1024
+
+typedef struct {
+    int scope;                  // LB_SCOPE_*, 0 when nothing was locked
+    int shard;
+    int tables;
+} LibraryLock;
+
+// Library the calling thread is changing: lb_* calls made by a change
+// (e.g. lb_add_book reserving room) run under the locks it holds
+static _Thread_local const Library *lb_lock_owner;
+
+static int lb_shard_of(const char *isbn) {
+    return (int)((hash_index_hash(isbn) >> 16) % LB_LOCK_SHARDS);
+}
+
+static LibraryLock lb_lock(Library *lib, int scope, const char *isbn, int tables) {
+    LibraryLock lock = { 0, 0, 0 };
+
+    if (!lib || !lib->locks || lb_lock_owner == lib || (scope == LB_SCOPE_BOOK && !isbn)) {
+        return lock;
+    }
+
+    LibraryLocks *locks = lib->locks;
+    lock.scope = scope;
+    lock.tables = scope == LB_SCOPE_ALL ? LB_TABLE_AUTHORS | LB_TABLE_GENRES : tables;
+
+    if (scope == LB_SCOPE_ALL) {
+        for (int i = 0; i < LB_LOCK_SHARDS; i++) {
+            pthread_rwlock_wrlock(&locks->shards[i].lock);
+        }
+    } else if (scope == LB_SCOPE_BOOK) {
+        lock.shard = lb_shard_of(isbn);
+        pthread_rwlock_wrlock(&locks->shards[lock.shard].lock);
+    }
+
+    if (lock.tables & LB_TABLE_AUTHORS) {
+        pthread_rwlock_wrlock(&locks->authors);
+    }
+
+    if (lock.tables & LB_TABLE_GENRES) {
+        pthread_rwlock_wrlock(&locks->genres);
+    }
+
+    lb_lock_owner = lib;
+    return lock;
+}
+
+static void lb_release(Library *lib, LibraryLock lock) {
+    LibraryLocks *locks = lib->locks;
+    lb_lock_owner = NULL;
+
+    if (lock.tables & LB_TABLE_GENRES) {
+        pthread_rwlock_unlock(&locks->genres);
+    }
+
+    if (lock.tables & LB_TABLE_AUTHORS) {
+        pthread_rwlock_unlock(&locks->authors);
+    }
+
+    if (lock.scope == LB_SCOPE_ALL) {
+        for (int i = LB_LOCK_SHARDS - 1; i >= 0; i--) {
+            pthread_rwlock_unlock(&locks->shards[i].lock);
+        }
+    } else if (lock.scope == LB_SCOPE_BOOK) {
+        pthread_rwlock_unlock(&locks->shards[lock.shard].lock);
+    }
+}
+
+// The commit hook of the outermost change runs with no lock held, so
+// waiting in it (e.g. for a journal sync) does not stall other changes
+static void lb_unlock(Library *lib, LibraryLock lock) {
+    if (lock.scope != 0) {
+        lb_release(lib, lock);
+    }
+
+    if (!lb_commit_fn || lb_lock_owner == lib) {
+        return;
+    }
+
+    LibraryCommitFn commit = lb_commit_fn;
+    lb_commit_fn = NULL;
+    commit(lb_commit_ctx);
+}
+
+static LibraryLock lb_lock_all(Library *lib) {
+    return lb_lock(lib, LB_SCOPE_ALL, NULL, 0);
+}
+
+static LibraryLock lb_lock_book(Library *lib, const char *isbn, int tables) {
+    return lb_lock(lib, LB_SCOPE_BOOK, isbn, tables);
+}
+
+static LibraryLock lb_lock_tables(Library *lib, int tables) {
+    return lb_lock(lib, LB_SCOPE_TABLES, NULL, tables);
+}
+
+// Changes holding a shard or a table run alongside each other, what they
+// share besides is guarded on its own
+static void lb_guard(Library *lib, int guard) {
+    if (lib->locks) {
+        pthread_mutex_lock(&lib->locks->guards[guard]);
+    }
+}
+
+static void lb_unguard(Library *lib, int guard) {
+    if (lib->locks) {
+        pthread_mutex_unlock(&lib->locks->guards[guard]);
+    }
+}
+
+// Readers share their locks, an index they rebuild on demand is rebuilt
+// by one of them while the others wait
+static void lb_rebuild_begin(Library *lib) {
+    if (lib->locks) {
+        pthread_mutex_lock(&lib->locks->rebuild);
+    }
+}
+
+static void lb_rebuild_end(Library *lib) {
+    if (lib->locks) {
+        pthread_mutex_unlock(&lib->locks->rebuild);
+    }
+}
+
+static void lb_free_locks(LibraryLocks *locks) {
+    for (int i = 0; i < LB_LOCK_SHARDS; i++) {
+        pthread_rwlock_destroy(&locks->shards[i].lock);
+    }
+
+    pthread_rwlock_destroy(&locks->authors);
+    pthread_rwlock_destroy(&locks->genres);
+    for (int i = 0; i < LB_GUARDS; i++) {
+        pthread_mutex_destroy(&locks->guards[i]);
+    }
+
+    pthread_mutex_destroy(&locks->rebuild);
+    free(locks);
+}
+
+static LibraryLocks *lb_new_locks(void) {
+    LibraryLocks *locks = aligned_alloc(_Alignof(LibraryLocks), sizeof(LibraryLocks));
+    if (!locks) {
+        return NULL;
+    }
+
+    // Writers go first, an import is not starved by a steady flow of readers
+    pthread_rwlockattr_t attr;
+    pthread_rwlockattr_init(&attr);
+#ifdef __GLIBC__
+    pthread_rwlockattr_setkind_np(&attr, PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+#endif
+
+    for (int i = 0; i < LB_LOCK_SHARDS; i++) {
+        pthread_rwlock_init(&locks->shards[i].lock, &attr);
+    }
+
+    pthread_rwlock_init(&locks->authors, &attr);
+    pthread_rwlock_init(&locks->genres, &attr);
+    for (int i = 0; i < LB_GUARDS; i++) {
+        pthread_mutex_init(&locks->guards[i], NULL);
+    }
+
+    pthread_mutex_init(&locks->rebuild, NULL);
+    pthread_rwlockattr_destroy(&attr);
+    return locks;
+}
+
+static int lb_in_view(const Library *lib, const void *ptr) {
+    const char *p = ptr;
+    return lib->view && p >= lib->view && p < lib->view + lib->view_size;
+}
+
+static void lb_release_view(Library *lib) {
+    if (lib->view && lib->view_release) {
+        lib->view_release(lib->view, lib->view_size);
+    }
+
+    lib->view = NULL;
+    lib->view_size = 0;
+    lib->view_release = NULL;
+}
+
+static void lb_release_descriptions(Library *lib) {
+    if (lib->descriptions) {
+        description_store_free(lib->descriptions);
+        free(lib->descriptions);
+        lib->descriptions = NULL;
+    }
+}
+
+// Drop the description of a stored book, owned copy, arena or region view
+static void lb_release_description(Library *lib, Book *book) {
+    if (book->description_capacity > 0) {
+        free(book->description);
+    } else if (book->description && !lb_in_view(lib, book->description)) {
+        lb_guard(lib, LB_GUARD_STRINGS);
+        string_arena_release(&lib->strings, strlen(book->description));
+        lb_unguard(lib, LB_GUARD_STRINGS);
+    }
+
+    book->description = NULL;
+    book->description_capacity = 0;
+}
+
+// Postings
+
+// Lists hold slots: book ids are not unique (0 for books added without one)
+static void lb_unindex_book(Library *lib, int slot) {
+    Book *book = &lib->books[lib->slot_books[slot]];
+
+    const int *genre_ids = book_get_genre_ids(book);
+    for (int i = 0; i < book->genre_count; i++) {
+        if (genre_ids[i] > 0) {
+            postings_remove(&lib->genre_postings, genre_ids[i], slot);
+        }
+    }
+
+    const int *author_ids = book_get_author_ids(book);
+    for (int i = 0; i < book->author_count; i++) {
+        if (author_ids[i] > 0) {
+            postings_remove(&lib->author_postings, author_ids[i], slot);
+        }
+    }
+}
+
+// Rolls back the entries already added when one insert fails
+static int lb_index_book(Library *lib, int slot) {
+    Book *book = &lib->books[lib->slot_books[slot]];
+    const int *genre_ids = book_get_genre_ids(book);
+    const int *author_ids = book_get_author_ids(book);
+    int genres = 0;
+    int authors = 0;
+
+    for (; genres < book->genre_count; genres++) {
+        if (genre_ids[genres] > 0 && postings_add(&lib->genre_postings, genre_ids[genres], slot) != 0) {
+            break;
+        }
+    }
+
+    if (genres == book->genre_count) {
+        for (; authors < book->author_count; authors++) {
+            if (author_ids[authors] > 0 && postings_add(&lib->author_postings, author_ids[authors], slot) != 0) {
+                break;
+            }
+        }
+
+        if (authors == book->author_count) {
+            return 0;
+        }
+    }
+
+    for (int i = 0; i < genres; i++) {
+        if (genre_ids[i] > 0) {
+            postings_remove(&lib->genre_postings, genre_ids[i], slot);
+        }
+    }
+
+    for (int i = 0; i < authors; i++) {
+        if (author_ids[i] > 0) {
+            postings_remove(&lib->author_postings, author_ids[i], slot);
+        }
+    }
+
+    return 1;
+}
+
+static int lb_compare_ints(const void *a, const void *b) {
+    int x = *(const int *)a;
+    int y = *(const int *)b;
+    return (x > y) - (x < y);
+}
+
+// Saved lists hold dense book indexes, turn them back into sorted slots
+static int lb_postings_to_slots(Library *lib, Postings *postings) {
+    for (int k = 0; k < postings->list_count; k++) {
+        PostingList *list = &postings->lists[k];
+
+        for (int i = 0; i < list->count; i++) {
+            if (list->ids[i] < 0 || list->ids[i] >= lib->book_count) {
+                return 1;
+            }
+            list->ids[i] = lib->book_slots[list->ids[i]];
+        }
+
+        qsort(list->ids, (size_t)list->count, sizeof(int), lb_compare_ints);
+    }
+
+    return 0;
+}
+
+// Text Index
+
+// Descriptions left in a file are copied into buffer: the store cache slot
+// lb_get_book_description returns can be evicted by a concurrent reader
+static void lb_book_texts(const Library *lib, const Book *book, const char *texts[3], char **buffer,
+                          size_t *capacity) {
+    texts[0] = book->title;
+    texts[1] = book->isbn;
+    texts[2] = lb_read_book_description(lib, book, buffer, capacity);
+}
+
+static int lb_add_text(Library *lib, int slot, char **buffer, size_t *capacity) {
+    const char *texts[3];
+    lb_book_texts(lib, &lib->books[lib->slot_books[slot]], texts, buffer, capacity);
+    return trigram_index_add(&lib->text_index, slot, texts, 3);
+}
+
+static int lb_index_text(Library *lib, int slot) {
+    if (lib->text_stale) {
+        return 0;
+    }
+
+    char *buffer = NULL;
+    size_t capacity = 0;
+    lb_guard(lib, LB_GUARD_TEXT);
+    int failed = lb_add_text(lib, slot, &buffer, &capacity);
+    lb_unguard(lib, LB_GUARD_TEXT);
+    free(buffer);
+    return failed;
+}
+
+static void lb_unindex_text(Library *lib, int slot) {
+    if (lib->text_stale) {
+        return;
+    }
+
+    char *buffer = NULL;
+    size_t capacity = 0;
+    const char *texts[3];
+    lb_book_texts(lib, &lib->books[lib->slot_books[slot]], texts, &buffer, &capacity);
+    lb_guard(lib, LB_GUARD_TEXT);
+    trigram_index_remove(&lib->text_index, slot, texts, 3);
+    lb_unguard(lib, LB_GUARD_TEXT);
+    free(buffer);
+}
+
+// Readers of a concurrent library check text_stale before taking a lock,
+// it is cleared once the index is complete
+static int lb_rebuild_text(Library *lib) {
+    trigram_index_clear(&lib->text_index);
+
+    char *buffer = NULL;
+    size_t capacity = 0;
+    int failed = 0;
+
+    for (int i = 0; i < lib->book_count && !failed; i++) {
+        failed = lb_add_text(lib, lib->book_slots[i], &buffer, &capacity) != 0;
+    }
+
+    free(buffer);
+
+    if (failed) {
+        trigram_index_clear(&lib->text_index);
+        LOG_ERROR("Text Index Rebuild Failed");
+        return 1;
+    }
+
+    __atomic_store_n(&lib->text_stale, 0, __ATOMIC_RELEASE);
+    LOG_INFO("Text Index Rebuilt - %d Books", lib->book_count);
+    return 0;
+}
+
+static int lb_refresh_text(Library *lib) {
+    if (!__atomic_load_n(&lib->text_stale, __ATOMIC_ACQUIRE)) {
+        return 0;
+    }
+
+    lb_rebuild_begin(lib);
+    int failed = lib->text_stale && lb_rebuild_text(lib) != 0;
+    lb_rebuild_end(lib);
+    return failed;
+}
+
+static int lb_refresh_prefix(Library *lib, PrefixIndex *index, const int *values, int count) {
+    if (!__atomic_load_n(&index->dirty, __ATOMIC_ACQUIRE)) {
+        return 0;
+    }
+
+    lb_rebuild_begin(lib);
+    int failed = index->dirty && prefix_index_build(index, lib, values, count) != 0;
+    lb_rebuild_end(lib);
+    return failed;
+}
+
+// A title changes under its shard lock alone in concurrent mode, the
+// sorted titles are shared by every shard. A failed update leaves the
+// index to be rebuilt.
+static void lb_prefix_insert(Library *lib, PrefixIndex *index, int value) {
+    lb_guard(lib, LB_GUARD_PREFIX);
+    if (prefix_index_insert(index, lib, value) != 0) {
+        prefix_index_invalidate(index);
+    }
+    lb_unguard(lib, LB_GUARD_PREFIX);
+}
+
+static void lb_prefix_remove(Library *lib, PrefixIndex *index, int value) {
+    lb_guard(lib, LB_GUARD_PREFIX);
+    if (prefix_index_remove(index, lib, value) != 0) {
+        prefix_index_invalidate(index);
+    }
+    lb_unguard(lib, LB_GUARD_PREFIX);
+}
+
+// Descriptions left in a file are copied out, readers share the store cache
+static int lb_book_matches(const Library *lib, const Book *book, const char *term, char **buffer,
+                           size_t *capacity) {
+    if (strstr(book->title, term) || strstr(book->isbn, term)) {
+        return 1;
+    }
+
+    const char *description = lb_read_book_description(lib, book, buffer, capacity);
+    return description && strstr(description, term);
+}
+
+// Columnar Layout
+
+static int lb_resize_columns(Library *lib, int new_cap) {
+    int *ids = realloc(lib->book_ids, (size_t)new_cap * sizeof(int));
+    if (!ids) {
+        LOG_ERROR(REALLOCATION_ERROR);
+        return 1;
+    }
+    lib->book_ids = ids;
+
+    int *years = realloc(lib->book_years, (size_t)new_cap * sizeof(int));
+    if (!years) {
+        LOG_ERROR(REALLOCATION_ERROR);
+        return 1;
+    }
+    lib->book_years = years;
+
+    char (*isbns)[ISBN_SIZE] = realloc(lib->book_isbns, (size_t)new_cap * sizeof(*isbns));
+    if (!isbns) {
+        LOG_ERROR(REALLOCATION_ERROR);
+        return 1;
+    }
+    lib->book_isbns = isbns;
+
+    return 0;
+}
+
+static void lb_free_columns(Library *lib) {
+    free(lib->book_ids);
+    free(lib->book_years);
+    free(lib->book_isbns);
+
+    lib->book_ids = NULL;
+    lib->book_years = NULL;
+    lib->book_isbns = NULL;
+    lib->columnar = 0;
+}
+
+static void lb_store_columns(Library *lib, int index) {
+    if (!lib->columnar) {
+        return;
+    }
+
+    const Book *book = &lib->books[index];
+    lib->book_ids[index] = book->id;
+    lib->book_years[index] = book->publication_year;
+    memcpy(lib->book_isbns[index], book->isbn, ISBN_SIZE);
+}
+
+// Slot Map
+
+static int lb_resize_books(Library *lib, int new_cap) {
+    Book *books = realloc(lib->books, (size_t)new_cap * sizeof(Book));
+    if (!books) {
+        LOG_ERROR(REALLOCATION_ERROR);
+        return 1;
+    }
+    lib->books = books;
+
+    int *book_slots = realloc(lib->book_slots, (size_t)new_cap * sizeof(int));
+    if (!book_slots) {
+        LOG_ERROR(REALLOCATION_ERROR);
+        return 1;
+    }
+    lib->book_slots = book_slots;
+
+    int *slot_books = realloc(lib->slot_books, (size_t)new_cap * sizeof(int));
+    if (!slot_books) {
+        LOG_ERROR(REALLOCATION_ERROR);
+        return 1;
+    }
+    lib->slot_books = slot_books;
+
+    unsigned int *generations = realloc(lib->slot_generations, (size_t)new_cap * sizeof(unsigned int));
+    if (!generations) {
+        LOG_ERROR(REALLOCATION_ERROR);
+        return 1;
+    }
+    lib->slot_generations = generations;
+
+    if (lib->columnar && lb_resize_columns(lib, new_cap) != 0) {
+        return 1;
+    }
+
+    lib->book_capacity = new_cap;
+    return 0;
+}
+
+// Odd generation means the slot holds a book
+static int lb_slot_alive(const Library *lib, int slot) {
+    return slot >= 0 && slot < lib->slot_count && (lib->slot_generations[slot] & 1u);
+}
+
+static int lb_alloc_slot(Library *lib) {
+    int slot;
+
+    if (lib->free_slot >= 0) {
+        slot = lib->free_slot;
+        lib->free_slot = lib->slot_books[slot];
+    } else {
+        slot = lib->slot_count++;
+        lib->slot_generations[slot] = 0;
+    }
+
+    lib->slot_generations[slot]++;
+    return slot;
+}
+
+static void lb_release_slot(Library *lib, int slot) {
+    lib->slot_generations[slot]++;
+    lib->slot_books[slot] = lib->free_slot;
+    lib->free_slot = slot;
+}
+
+// Swap the last book into the hole so books stay dense
+static int lb_remove_slot(Library *lib, int slot) {
+    int index = lib->slot_books[slot];
+    int last = lib->book_count - 1;
+
+    char isbn[ISBN_SIZE];
+    memcpy(isbn, lib->books[index].isbn, ISBN_SIZE);
+    if (lb_notify(lib, LB_CHANGE_REMOVE_BOOK, isbn, NULL, NULL, 0) != 0) {
+        return 1;
+    }
+
+    hash_index_remove(&lib->isbn_index, lib, lib->books[index].isbn);
+    lb_unindex_book(lib, slot);
+    lb_unindex_text(lib, slot);
+    lb_prefix_remove(lib, &lib->title_prefix, slot);
+
+    book_free_ids(&lib->books[index]);
+    lb_release_description(lib, &lib->books[index]);
+
+    if (index != last) {
+        lib->books[index] = lib->books[last];
+        lib->book_slots[index] = lib->book_slots[last];
+        lib->slot_books[lib->book_slots[index]] = index;
+        lb_store_columns(lib, index);
+    }
+
+    lib->book_count--;
+    memset(&lib->books[lib->book_count], 0, sizeof(Book));
+
+    lb_release_slot(lib, slot);
+    lb_mark_book(lib, slot);
+    return 0;
+}
+
+static void lb_free_book_data(Library *lib) {
+    for (int i = 0; i < lib->book_count; i++) {
+        book_free_ids(&lib->books[i]);
+
+        if (lib->books[i].description_capacity > 0) {
+            free(lib->books[i].description);
+        }
+    }
+}
+
+// Compact once garbage outweighs live text
+static int lb_strings_need_compaction(Library *lib) {
+    lb_guard(lib, LB_GUARD_STRINGS);
+    size_t garbage = string_arena_garbage(&lib->strings);
+    int needed = garbage >= STRING_ARENA_BLOCK_SIZE && garbage > lib->strings.bytes_live;
+    lb_unguard(lib, LB_GUARD_STRINGS);
+    return needed;
+}
+
+static void lb_maybe_compact_strings(Library *lib) {
+    if (lb_strings_need_compaction(lib)) {
+        lb_compact_strings(lib);
+    }
+}
+
+// Room for more authors, touching nothing but the author table (bulk adds
+// of a concurrent library only lock that table)
+static int lb_reserve_author_table(Library *lib, int authors) {
+    int author_cap = lib->author_count + authors;
+    if (author_cap > lib->author_capacity) {
+        Author *tmp = realloc(lib->authors, (size_t)author_cap * sizeof(Author));
+
+        if (!tmp) {
+            LOG_ERROR(REALLOCATION_ERROR);
+            return 1;
+        }
+
+        lib->authors = tmp;
+        lib->author_capacity = author_cap;
+    }
+
+    return hash_index_reserve(&lib->author_index, author_cap);
+}
+
+static int lb_reserve_genre_table(Library *lib, int genres) {
+    int genre_cap = lib->genre_count + genres;
+    if (genre_cap > lib->genre_capacity) {
+        Genre *tmp = realloc(lib->genres, (size_t)genre_cap * sizeof(Genre));
+
+        if (!tmp) {
+            LOG_ERROR(REALLOCATION_ERROR);
+            return 1;
+        }
+
+        lib->genres = tmp;
+        lib->genre_capacity = genre_cap;
+    }
+
+    return hash_index_reserve(&lib->genre_index, genre_cap);
+}
+
+// Core Functions
+
+int lb_init(Library *lib) {
+    if (!lib){
+        LOG_ERROR(NULL_ERROR);
+        return 1;
+    } 
+
+    memset(lib, 0, sizeof(*lib));
+    hash_index_init(&lib->isbn_index, lb_book_isbn_key);
+    hash_index_init(&lib->author_index, lb_author_name_key);
+    hash_index_init(&lib->genre_index, lb_genre_name_key);
+    string_arena_init(&lib->strings);
+    postings_init(&lib->genre_postings);
+    postings_init(&lib->author_postings);
+    trigram_index_init(&lib->text_index);
+    prefix_index_init(&lib->title_prefix, lb_book_title_key);
+    prefix_index_init(&lib->author_prefix, lb_author_name_key);
+    dirty_set_init(&lib->dirty_books);
+    dirty_set_init(&lib->dirty_authors);
+    dirty_set_init(&lib->dirty_genres);
+    lib->free_slot = -1;
+
+    lib->author_capacity = 2;
+    lib->genre_capacity = 2;
+
+    if (lb_resize_books(lib, 2) != 0) {
+        lb_free(lib);
+        LOG_ERROR(ALLOCATION_ERROR);
+        return 1;
+    }
+
+    lib->authors = malloc((size_t)lib->author_capacity * sizeof(Author));
+    if (!lib->authors) {
+        lb_free(lib);
+        LOG_ERROR(ALLOCATION_ERROR);
+        return 1;
+    }
+
+    lib->genres = malloc((size_t)lib->genre_capacity * sizeof(Genre));
+    if (!lib->genres) {
+        lb_free(lib);
+        LOG_ERROR(ALLOCATION_ERROR);
+        return 1;
+    }
+
+    LOG_INFO("Init Successfully");
+    return 0;
+}
+
+void lb_free(Library *lib) {
+    if(!lib) {
+        LOG_ERROR(NULL_ERROR);
+        return;
+    }
+
+    lb_free_book_data(lib);
+    lb_release_view(lib);
+    lb_release_descriptions(lib);
+
+    free(lib->books);
+    lib->books = NULL;
+
+    free(lib->book_slots);
+    free(lib->slot_books);
+    free(lib->slot_generations);
+    lb_free_columns(lib);
+
+    free(lib->id_pool);
+    lib->id_pool = NULL;
+
+    free(lib->authors);
+    lib->authors = NULL;
+
+    free(lib->genres);
+    lib->genres = NULL;
+
+    string_arena_free(&lib->strings);
+    hash_index_free(&lib->isbn_index);
+    hash_index_free(&lib->author_index);
+    hash_index_free(&lib->genre_index);
+    postings_free(&lib->genre_postings);
+    postings_free(&lib->author_postings);
+    trigram_index_free(&lib->text_index);
+    prefix_index_free(&lib->title_prefix);
+    prefix_index_free(&lib->author_prefix);
+    dirty_set_free(&lib->dirty_books);
+    dirty_set_free(&lib->dirty_authors);
+    dirty_set_free(&lib->dirty_genres);
+
+    if (lib->locks) {
+        lb_free_locks(lib->locks);
+    }
+
+    lib->book_count = 0;
+    lib->book_capacity = 0;
+    
+    lib->author_count = 0;
+    lib->author_capacity = 0;
+
+    lib->genre_count = 0;
+    lib->genre_capacity = 0;
+
+    memset(lib, 0, sizeof(*lib));
+
+    LOG_INFO("Freed library");
+}
+
+static void lb_clear_unlocked(Library *lib) {
+    if(!lib) {
+        LOG_ERROR(NULL_ERROR);
+        return;
+    }
+
+    if (lb_notify(lib, LB_CHANGE_CLEAR, NULL, NULL, NULL, 0) != 0) {
+        return;
+    }
+
+    lb_free_book_data(lib);
+    lb_release_view(lib);
+    lb_release_descriptions(lib);
+    free(lib->id_pool);
+    lib->id_pool = NULL;
+    lib->id_pool_size = 0;
+    string_arena_clear(&lib->strings);
+    hash_index_clear(&lib->isbn_index);
+    hash_index_clear(&lib->author_index);
+    hash_index_clear(&lib->genre_index);
+    postings_clear(&lib->genre_postings);
+    postings_clear(&lib->author_postings);
+    trigram_index_clear(&lib->text_index);
+    lib->text_stale = 0;
+    lib->index_deferred = 0;
+    prefix_index_invalidate(&lib->title_prefix);
+    prefix_index_invalidate(&lib->author_prefix);
+
+    // Release every live slot so outstanding handles become stale
+    for (int slot = lib->slot_count - 1; slot >= 0; slot--) {
+        if (lb_slot_alive(lib, slot)) {
+            lb_release_slot(lib, slot);
+        }
+    }
+
+    lib->book_count = 0;
+    lib->author_count = 0;
+    lib->genre_count = 0;
+
+    // Every record is gone, only a full checkpoint can say so
+    lb_clear_dirty(lib);
+    lib->dirty_all = 1;
+
+    LOG_INFO("Library Cleared");
+}
+
+void lb_clear(Library *lib) {
+    LibraryLock lock = lb_lock_all(lib);
+    lb_clear_unlocked(lib);
+    lb_unlock(lib, lock);
+}
+
+static void lb_clear_dirty_unlocked(Library *lib) {
+    if (!lib) {
+        LOG_ERROR(NULL_ERROR);
+        return;
+    }
+
+    dirty_set_clear(&lib->dirty_books);
+    dirty_set_clear(&lib->dirty_authors);
+    dirty_set_clear(&lib->dirty_genres);
+    lib->dirty_all = 0;
+}
+
+void lb_clear_dirty(Library *lib) {
+    LibraryLock lock = lb_lock_all(lib);
+    lb_clear_dirty_unlocked(lib);
+    lb_unlock(lib, lock);
+}
+
+int lb_set_concurrent(Library *lib, int enabled) {
+    if (!lib) {
+        LOG_ERROR(NULL_ERROR);
+        return 1;
+    }
+
+    if (!enabled) {
+        if (lib->locks) {
+            lb_free_locks(lib->locks);
+            lib->locks = NULL;
+        }
+        return 0;
+    }
+
+    if (lib->locks) {
+        return 0;
+    }
+
+    if (lib->backend) {
+        LOG_ERROR("Library Running on a Backend Cannot Be Concurrent");
+        return 1;
+    }
+
+    lib->locks = lb_new_locks();
+    if (!lib->locks) {
+        LOG_ERROR(ALLOCATION_ERROR);
+        return 1;
+    }
+
+    LOG_INFO("Concurrent Mode Enabled - %d Shards", LB_LOCK_SHARDS);
+    return 0;
+}
+
+// Reads the calling thread holds on lb_read_owner, per shard then the
+// author and genre tables. Nested reads only count: locking again would
+// wait behind a writer queued in between (writers go first), which waits
+// for the thread itself.
+static _Thread_local const Library *lb_read_owner;
+static _Thread_local int lb_read_calls;
+static _Thread_local int lb_read_depth[LB_LOCK_SHARDS + 2];
+
+#define LB_READ_AUTHORS LB_LOCK_SHARDS
+#define LB_READ_GENRES (LB_LOCK_SHARDS + 1)
+
+// Depth of a lock of the owned library, NULL for another library (read
+// while the owner is held, it is locked without tracking)
+static int *lb_read_depth_of(const Library *lib, int lock) {
+    return lb_read_owner == lib ? &lb_read_depth[lock] : NULL;
+}
+
+static void lb_read_acquire(pthread_rwlock_t *lock, int *depth) {
+    if (!depth || (*depth)++ == 0) {
+        pthread_rwlock_rdlock(lock);
+    }
+}
+
+static void lb_read_release(pthread_rwlock_t *lock, int *depth) {
+    if (!depth || --(*depth) == 0) {
+        pthread_rwlock_unlock(lock);
+    }
+}
+
+void lb_read_lock(const Library *lib, const char *isbn) {
+    // A change reading its own library already holds what it needs
+    if (!lib || !lib->locks || lb_lock_owner == lib) {
+        return;
+    }
+
+    LibraryLocks *locks = lib->locks;
+
+    if (!lb_read_owner) {
+        lb_read_owner = lib;
+    }
+
+    if (lb_read_owner == lib) {
+        lb_read_calls++;
+    }
+
+    if (isbn) {
+        int shard = lb_shard_of(isbn);
+        lb_read_acquire(&locks->shards[shard].lock, lb_read_depth_of(lib, shard));
+        return;
+    }
+
+    for (int i = 0; i < LB_LOCK_SHARDS; i++) {
+        lb_read_acquire(&locks->shards[i].lock, lb_read_depth_of(lib, i));
+    }
+
+    lb_read_acquire(&locks->authors, lb_read_depth_of(lib, LB_READ_AUTHORS));
+    lb_read_acquire(&locks->genres, lb_read_depth_of(lib, LB_READ_GENRES));
+}
+
+void lb_read_unlock(const Library *lib, const char *isbn) {
+    if (!lib || !lib->locks || lb_lock_owner == lib) {
+        return;
+    }
+
+    LibraryLocks *locks = lib->locks;
+
+    if (isbn) {
+        int shard = lb_shard_of(isbn);
+        lb_read_release(&locks->shards[shard].lock, lb_read_depth_of(lib, shard));
+    } else {
+        lb_read_release(&locks->genres, lb_read_depth_of(lib, LB_READ_GENRES));
+        lb_read_release(&locks->authors, lb_read_depth_of(lib, LB_READ_AUTHORS));
+
+        for (int i = LB_LOCK_SHARDS - 1; i >= 0; i--) {
+            lb_read_release(&locks->shards[i].lock, lb_read_depth_of(lib, i));
+        }
+    }
+
+    if (lb_read_owner == lib && --lb_read_calls == 0) {
+        lb_read_owner = NULL;
+    }
+}
+
+// CRUD Functions
+
+//books
+// Copy a validated book into reserved space and index it
+static int lb_store_book(Library *lib, const Book *book) {
+    if (lb_notify(lib, LB_CHANGE_ADD_BOOK, book->isbn, book, NULL, 0) != 0) {
+        return 1;
+    }
+
+    int index = lib->book_count;
+    int slot = lb_alloc_slot(lib);
+
+    Book *stored = &lib->books[index];
+    *stored = *book;
+    lib->book_slots[index] = slot;
+    lib->slot_books[slot] = index;
+
+    if (book->description && !lb_in_view(lib, book->description)) {
+        stored->description = string_arena_append(&lib->strings, book->description, strlen(book->description));
+        stored->description_capacity = 0;
+
+        if (!stored->description) {
+            lb_release_slot(lib, slot);
+            LOG_ERROR(ALLOCATION_ERROR);
+            return 1;
+        }
+    }
+
+    if (!lib->index_deferred && hash_index_insert(&lib->isbn_index, lib, book->isbn, slot) != 0) {
+        lb_release_description(lib, stored);
+        lb_release_slot(lib, slot);
+        LOG_ERROR("ISBN Index Insert Failed");
+        return 1;
+    }
+
+    if (!lib->index_deferred && lb_index_book(lib, slot) != 0) {
+        hash_index_remove(&lib->isbn_index, lib, book->isbn);
+        lb_release_description(lib, stored);
+        lb_release_slot(lib, slot);
+        LOG_ERROR("Postings Insert Failed - %s", book->isbn);
+        return 1;
+    }
+
+    if (lb_index_text(lib, slot) != 0) {
+        lb_unindex_book(lib, slot);
+        hash_index_remove(&lib->isbn_index, lib, book->isbn);
+        lb_release_description(lib, stored);
+        lb_release_slot(lib, slot);
+        LOG_ERROR("Text Index Insert Failed - %s", book->isbn);
+        return 1;
+    }
+
+    // The text now lives in the arena, the caller's copy is ours to drop
+    if (book->description_capacity > 0) {
+        free(book->description);
+    }
+
+    // Short id lists move inline so the common case holds no allocation,
+    // lists borrowed from the attached region stay where they are
+    if (!lb_in_view(lib, stored->genre_ids) && !lb_in_view(lib, stored->author_ids) &&
+        book_pack_ids(stored) != 0) {
+        LOG_ERROR("Pack Book IDs Failed - %s", book->isbn);
+    }
+
+    lb_store_columns(lib, index);
+    lib->book_count++;
+
+    lb_mark_book(lib, slot);
+    return 0;
+}
+
+static const char *lb_batch_isbn_key(const void *ctx, int value) {
+    const Book *books = ctx;
+    return books[value].isbn;
+}
+
+// Names of a bulk batch, values past the stored records index the batch
+typedef struct {
+    const Library *lib;
+    const Author *authors;
+    const Genre *genres;
+} LibraryNameBatch;
+
+static const char *lb_batch_author_key(const void *ctx, int value) {
+    const LibraryNameBatch *batch = ctx;
+    int count = batch->lib->author_count;
+    return value < count ? batch->lib->authors[value].name : batch->authors[value - count].name;
+}
+
+static const char *lb_batch_genre_key(const void *ctx, int value) {
+    const LibraryNameBatch *batch = ctx;
+    int count = batch->lib->genre_count;
+    return value < count ? batch->lib->genres[value].name : batch->genres[value - count].name;
+}
+
+// Backend
+
+static int lb_cache_book_unlocked(Library *lib, const Book *book) {
+    if (!lib || !book) {
+        LOG_ERROR(NULL_ERROR);
+        return 1;
+    }
+
+    if (!lib->backend) {
+        LOG_ERROR("Library Has No Backend");
+        return 1;
+    }
+
+    if (book->isbn[0] == '\0' || hash_index_find(&lib->isbn_index, lib, book->isbn) >= 0) {
+        LOG_DEBUG("Book Not Cached - %s", book->isbn);
+        return 1;
+    }
+
+    if (lb_reserve_books(lib) != 0) {
+        LOG_ERROR(EXPAND_CAPACITY);
+        return 1;
+    }
+
+    lib->backend_paging = 1;
+    int failed = lb_store_book(lib, book);
+    lib->backend_paging = 0;
+
+    if (failed) {
+        return 1;
+    }
+
+    lb_prefix_insert(lib, &lib->title_prefix, lib->book_slots[lib->book_count - 1]);
+    return 0;
+}
+
+int lb_cache_book(Library *lib, const Book *book) {
+    LibraryLock lock = lb_lock_all(lib);
+    int failed = lb_cache_book_unlocked(lib, book);
+    lb_unlock(lib, lock);
+    return failed;
+}
+
+// Slot of a book, read in from the backend when it is not in memory
+static int lb_find_slot(Library *lib, const char *isbn) {
+    int slot = hash_index_find(&lib->isbn_index, lib, isbn);
+    if (slot >= 0 || !lib->backend) {
+        return slot;
+    }
+
+    Book book;
+    book_init(&book);
+    if (lib->backend->load(lib->backend->ctx, isbn, &book) != 0 || lb_cache_book_unlocked(lib, &book) != 0) {
+        book_free(&book);
+        return -1;
+    }
+
+    return lib->book_slots[lib->book_count - 1];
+}
+
+// Whether the backend stores a book, for checks that cannot read it in
+static int lb_backend_has(const Library *lib, const char *isbn) {
+    if (!lib->backend) {
+        return 0;
+    }
+
+    Book book;
+    book_init(&book);
+    int found = lib->backend->load(lib->backend->ctx, isbn, &book) == 0;
+    book_free(&book);
+    return found;
+}
+
+static int lb_set_backend_unlocked(Library *lib, const LibraryBackend *backend) {
+    if (!lib || (backend && (!backend->load || !backend->apply))) {
+        LOG_ERROR(NULL_ERROR);
+        return 1;
+    }
+
+    // Reading a book in changes the library, which readers do not lock for
+    if (lib->locks) {
+        LOG_ERROR("Concurrent Library Cannot Run on a Backend");
+        return 1;
+    }
+
+    if (backend && lib->book_count > 0) {
+        LOG_ERROR("Library Not Empty - %d Books", lib->book_count);
+        return 1;
+    }
+
+    lib->backend = backend;
+    LOG_INFO("Backend %s", backend ? "Attached" : "Detached");
+    return 0;
+}
+
+int lb_set_backend(Library *lib, const LibraryBackend *backend) {
+    LibraryLock lock = lb_lock_all(lib);
+    int failed = lb_set_backend_unlocked(lib, backend);
+    lb_unlock(lib, lock);
+    return failed;
+}
+
+static int lb_evict_books_unlocked(Library *lib) {
+    if (!lib) {
+        LOG_ERROR(NULL_ERROR);
+        return 1;
+    }
+
+    if (!lib->backend) {
+        LOG_ERROR("Library Has No Backend");
+        return 1;
+    }
+
+    int count = lib->book_count;
+
+    // Sorted again by the next lookup rather than shifted for every book
+    prefix_index_invalidate(&lib->title_prefix);
+
+    // The last book leaves no hole, nothing is swapped
+    lib->backend_paging = 1;
+    while (lib->book_count > 0) {
+        lb_remove_slot(lib, lib->book_slots[lib->book_count - 1]);
+    }
+    lib->backend_paging = 0;
+
+    lb_maybe_compact_strings(lib);
+
+    LOG_INFO("Books Evicted - %d", count);
+    return 0;
+}
+
+int lb_evict_books(Library *lib) {
+    LibraryLock lock = lb_lock_all(lib);
+    int failed = lb_evict_books_unlocked(lib);
+    lb_unlock(lib, lock);
+    return failed;
+}
+
+static int lb_add_book_unlocked(Library *lib, const Book *book) {
+    if (!lib || !book) {
+        LOG_ERROR(NULL_ERROR);
+        return 1;
+    }
+
+    if (book->isbn[0] == '\0'){
+        LOG_ERROR("Invalid ISBN");
+        return 1;
+    }
+
+    if (lb_find_slot(lib, book->isbn) >= 0) {
+        LOG_ERROR("Duplicated ISBN - %s", book->isbn);
+        return 1;
+    }
+
+    if (lb_reserve_books(lib) != 0) {
+        LOG_ERROR(EXPAND_CAPACITY);
+        return 1;
+    }
+
+    if (lb_store_book(lib, book) != 0) {
+        return 1;
+    }
+
+    lb_prefix_insert(lib, &lib->title_prefix, lib->book_slots[lib->book_count - 1]);
+    LOG_DEBUG("Book Added - %s", book->isbn);
+
+    return 0;
+}
+
+int lb_add_book(Library *lib, const Book *book) {
+    LibraryLock lock = lb_lock_all(lib);
+    int failed = lb_add_book_unlocked(lib, book);
+    lb_unlock(lib, lock);
+    return failed;
+}
+
+// An empty or duplicated ISBN (in the batch or the library) fails the batch
+static int lb_validate_books(const Library *lib, const Book *books, int count, size_t *text_bytes) {
+    HashIndex batch;
+    hash_index_init(&batch, lb_batch_isbn_key);
+
+    if (hash_index_reserve(&batch, count) != 0) {
+        hash_index_free(&batch);
+        return 1;
+    }
+
+    *text_bytes = 0;
+    for (int i = 0; i < count; i++) {
+        const char *isbn = books[i].isbn;
+
+        if (isbn[0] == '\0') {
+            LOG_ERROR("Invalid ISBN - Bulk Record %d", i);
+            hash_index_free(&batch);
+            return 1;
+        }
+
+        if (hash_index_find(&lib->isbn_index, lib, isbn) >= 0 || lb_backend_has(lib, isbn) ||
+            hash_index_insert(&batch, books, isbn, i) != 0) {
+            LOG_ERROR("Duplicated ISBN - %s", isbn);
+            hash_index_free(&batch);
+            return 1;
+        }
+
+        if (books[i].description) {
+            *text_bytes += strlen(books[i].description) + 1;
+        }
+    }
+
+    hash_index_free(&batch);
+    return 0;
+}
+
+static int lb_add_books_bulk_unlocked(Library *lib, const Book *books, int count) {
+    if (!lib || (!books && count > 0)) {
+        LOG_ERROR(NULL_ERROR);
+        return 1;
+    }
+
+    if (count <= 0) {
+        return 0;
+    }
+
+    // Validate the whole batch first so a bad record adds nothing
+    size_t text_bytes;
+    if (lb_validate_books(lib, books, count, &text_bytes) != 0) {
+        return 1;
+    }
+
+    if (lb_reserve(lib, count, 0, 0) != 0 ||
+        (text_bytes > 0 && string_arena_reserve(&lib->strings, text_bytes) != 0)) {
+        LOG_ERROR(EXPAND_CAPACITY);
+        return 1;
+    }
+
+    // Trigrams are built in one pass by the next search. Readers of a
+    // concurrent library search between chunks, its books are indexed as
+    // they come instead of rebuilding everything after each chunk.
+    if (!lib->locks) {
+        lib->text_stale = 1;
+    }
+
+    // Sorted once by the next lookup rather than shifted for every book
+    prefix_index_invalidate(&lib->title_prefix);
+
+    for (int i = 0; i < count; i++) {
+        if (lb_store_book(lib, &books[i]) != 0) {
+            LOG_ERROR("Bulk Add Stopped - %d of %d Books Added", i, count);
+            return 1;
+        }
+    }
+
+    LOG_INFO("Books Added - %d", count);
+    return 0;
+}
+
+// A concurrent import locks the library one chunk at a time, so readers
+// and other changes get in between chunks. The batch is validated as a
+// whole first; a book added meanwhile with one of its ISBNs stops it.
+static int lb_add_books_chunked(Library *lib, const Book *books, int count) {
+    size_t text_bytes;
+
+    lb_read_lock(lib, NULL);
+    int failed = lb_validate_books(lib, books, count, &text_bytes);
+    lb_read_unlock(lib, NULL);
+
+    if (failed || lb_reserve(lib, count, 0, 0) != 0) {
+        return 1;
+    }
+
+    for (int added = 0; added < count; added += LB_BULK_CHUNK) {
+        int chunk = count - added < LB_BULK_CHUNK ? count - added : LB_BULK_CHUNK;
+
+        LibraryLock lock = lb_lock_all(lib);
+        failed = lb_add_books_bulk_unlocked(lib, books + added, chunk);
+        lb_unlock(lib, lock);
+
+        if (failed) {
+            LOG_ERROR("Bulk Add Stopped - %d of %d Books Added", added, count);
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+int lb_add_books_bulk(Library *lib, const Book *books, int count) {
+    if (lib && lib->locks && lb_lock_owner != lib && books && count > LB_BULK_CHUNK) {
+        return lb_add_books_chunked(lib, books, count);
+    }
+
+    LibraryLock lock = lb_lock_all(lib);
+    int failed = lb_add_books_bulk_unlocked(lib, books, count);
+    lb_unlock(lib, lock);
+    return failed;
+}
+
+static int lb_remove_book_unlocked(Library *lib, const char *isbn){
+    if (!lib || !isbn) {
+        LOG_ERROR(NULL_ERROR);
+        return 1;
+    }
+
+    int slot = lb_find_slot(lib, isbn);
+
+    if (slot < 0) {
+        LOG_ERROR("Book to be removed not Found");
+        return 1;
+    }
+
+    if (lb_remove_slot(lib, slot) != 0) {
+        return 1;
+    }
+
+    lb_maybe_compact_strings(lib);
+
+    LOG_DEBUG("Book Removed - %s", isbn);
+
+    return 0;
+}
+
+int lb_remove_book(Library *lib, const char *isbn) {
+    LibraryLock lock = lb_lock_all(lib);
+    int failed = lb_remove_book_unlocked(lib, isbn);
+    lb_unlock(lib, lock);
+    return failed;
+}
+
+static int lb_remove_book_by_handle_unlocked(Library *lib, BookHandle handle) {
+    if (!lib) {
+        LOG_ERROR(NULL_ERROR);
+        return 1;
+    }
+
+    if (!lb_get_book(lib, handle)) {
+        LOG_ERROR("Book to be removed not Found");
+        return 1;
+    }
+
+    if (lb_remove_slot(lib, handle.slot) != 0) {
+        return 1;
+    }
+
+    lb_maybe_compact_strings(lib);
+
+    LOG_DEBUG("Book Removed - Slot %d", handle.slot);
+
+    return 0;
+}
+
+int lb_remove_book_by_handle(Library *lib, BookHandle handle) {
+    LibraryLock lock = lb_lock_all(lib);
+    int failed = lb_remove_book_by_handle_unlocked(lib, handle);
+    lb_unlock(lib, lock);
+    return failed;
+}
+
+Book *lb_find_book_by_isbn(Library *lib, const char *isbn) {
+    if (!lib || !isbn) {
+        LOG_ERROR(NULL_ERROR);
+        return NULL;
+    }
+
+    int slot = lb_find_slot(lib, isbn);
+    if (slot < 0) {
+        return NULL;
+    }
+
+    return &lib->books[lib->slot_books[slot]];
+}
+
+int lb_get_book_handle(Library *lib, const char *isbn, BookHandle *handle) {
+    if (!lib || !isbn || !handle) {
+        LOG_ERROR(NULL_ERROR);
+        return 1;
+    }
+
+    int slot = lb_find_slot(lib, isbn);
+    if (slot < 0) {
+        return 1;
+    }
+
+    handle->slot = slot;
+    handle->generation = lib->slot_generations[slot];
+    return 0;
+}
+
+Book *lb_get_book(Library *lib, BookHandle handle) {
+    if (!lib) {
+        LOG_ERROR(NULL_ERROR);
+        return NULL;
+    }
+
+    if (!lb_slot_alive(lib, handle.slot) ||
+        lib->slot_generations[handle.slot] != handle.generation) {
+        return NULL;
+    }
+
+    return &lib->books[lib->slot_books[handle.slot]];
+}
+
+Book *lb_get_book_by_slot(Library *lib, int slot) {
+    if (!lib) {
+        LOG_ERROR(NULL_ERROR);
+        return NULL;
+    }
+
+    if (!lb_slot_alive(lib, slot)) {
+        return NULL;
+    }
+
+    return &lib->books[lib->slot_books[slot]];
+}
+
+static int lb_update_book_isbn_unlocked(Library *lib, const char *isbn, const char *new_isbn) {
+    if (!lib || !isbn || !new_isbn) {
+        LOG_ERROR(NULL_ERROR);
+        return 1;
+    }
+
+    if (new_isbn[0] == '\0' || strlen(new_isbn) >= ISBN_SIZE) {
+        LOG_ERROR("Invalid ISBN");
+        return 1;
+    }
+
+    int slot = lb_find_slot(lib, isbn);
+    if (slot < 0) {
+        LOG_ERROR("Book to be updated not Found");
+        return 1;
+    }
+
+    if (lb_find_slot(lib, new_isbn) >= 0) {
+        LOG_ERROR("Duplicated ISBN - %s", new_isbn);
+        return 1;
+    }
+
+    // Room for the new key first: once the old one is gone the insert
+    // cannot fail and leave the book out of the index
+    if (hash_index_reserve(&lib->isbn_index, lib->isbn_index.count + 1) != 0) {
+        LOG_ERROR(EXPAND_CAPACITY);
+        return 1;
+    }
+
+    // isbn may point into the book itself
+    char old_isbn[ISBN_SIZE];
+    memcpy(old_isbn, lib->books[lib->slot_books[slot]].isbn, ISBN_SIZE);
+    if (lb_notify(lib, LB_CHANGE_BOOK_ISBN, old_isbn, NULL, new_isbn, 0) != 0) {
+        return 1;
+    }
+
+    hash_index_remove(&lib->isbn_index, lib, old_isbn);
+    lb_unindex_text(lib, slot);
+    book_update_isbn(&lib->books[lib->slot_books[slot]], new_isbn);
+
+    if (hash_index_insert(&lib->isbn_index, lib, new_isbn, slot) != 0) {
+        book_update_isbn(&lib->books[lib->slot_books[slot]], old_isbn);
+        hash_index_insert(&lib->isbn_index, lib, old_isbn, slot);
+        lb_index_text(lib, slot);
+        LOG_ERROR("ISBN Index Insert Failed");
+        return 1;
+    }
+
+    lb_store_columns(lib, lib->slot_books[slot]);
+
+    if (lb_index_text(lib, slot) != 0) {
+        LOG_ERROR("Text Index Insert Failed - %s", new_isbn);
+    }
+
+    lb_mark_book(lib, slot);
+    return 0;
+}
+
+int lb_update_book_isbn(Library *lib, const char *isbn, const char *new_isbn) {
+    LibraryLock lock = lb_lock_all(lib);
+    int failed = lb_update_book_isbn_unlocked(lib, isbn, new_isbn);
+    lb_unlock(lib, lock);
+    return failed;
+}
+
+static int lb_update_book_title_unlocked(Library *lib, const char *isbn, const char *title) {
+    if (!lib || !isbn || !title) {
+        LOG_ERROR(NULL_ERROR);
+        return 1;
+    }
+
+    if (strlen(title) >= MAX_TITLE) {
+        LOG_ERROR("Invalid Title");
+        return 1;
+    }
+
+    int slot = lb_find_slot(lib, isbn);
+    if (slot < 0) {
+        LOG_ERROR("Book to be updated not Found");
+        return 1;
+    }
+
+    if (lb_notify(lib, LB_CHANGE_BOOK_TITLE, isbn, NULL, title, 0) != 0) {
+        return 1;
+    }
+
+    lb_unindex_text(lib, slot);
+    lb_prefix_remove(lib, &lib->title_prefix, slot);
+    book_update_title(&lib->books[lib->slot_books[slot]], title);
+    lb_prefix_insert(lib, &lib->title_prefix, slot);
+    lb_mark_book(lib, slot);
+
+    if (lb_index_text(lib, slot) != 0) {
+        LOG_ERROR("Text Index Insert Failed - %s", isbn);
+        return 1;
+    }
+
+    return 0;
+}
+
+int lb_update_book_title(Library *lib, const char *isbn, const char *title) {
+    LibraryLock lock = lb_lock_book(lib, isbn, 0);
+    int failed = lb_update_book_title_unlocked(lib, isbn, title);
+    lb_unlock(lib, lock);
+    return failed;
+}
+
+static int lb_update_book_id_unlocked(Library *lib, const char *isbn, const int new_id) {
+    if (!lib || !isbn) {
+        LOG_ERROR(NULL_ERROR);
+        return 1;
+    }
+
+    int slot = lb_find_slot(lib, isbn);
+    if (slot < 0) {
+        LOG_ERROR("Book to be updated not Found");
+        return 1;
+    }
+
+    // Checked before the hook sees the change, book_update_id cannot fail
+    if (new_id <= 0) {
+        LOG_ERROR("Unsupported ID");
+        return 1;
+    }
+
+    if (lb_notify(lib, LB_CHANGE_BOOK_ID, isbn, NULL, NULL, new_id) != 0) {
+        return 1;
+    }
+
+    int index = lib->slot_books[slot];
+    book_update_id(&lib->books[index], new_id);
+    lb_store_columns(lib, index);
+    lb_mark_book(lib, slot);
+    return 0;
+}
+
+int lb_update_book_id(Library *lib, const char *isbn, const int new_id) {
+    LibraryLock lock = lb_lock_book(lib, isbn, 0);
+    int failed = lb_update_book_id_unlocked(lib, isbn, new_id);
+    lb_unlock(lib, lock);
+    return failed;
+}
+
+static int lb_update_book_year_unlocked(Library *lib, const char *isbn, const int new_year) {
+    if (!lib || !isbn) {
+        LOG_ERROR(NULL_ERROR);
+        return 1;
+    }
+
+    int slot = lb_find_slot(lib, isbn);
+    if (slot < 0) {
+        LOG_ERROR("Book to be updated not Found");
+        return 1;
+    }
+
+    if (new_year <= 0) {
+        LOG_ERROR("Unsupported Year");
+        return 1;
+    }
+
+    if (lb_notify(lib, LB_CHANGE_BOOK_YEAR, isbn, NULL, NULL, new_year) != 0) {
+        return 1;
+    }
+
+    int index = lib->slot_books[slot];
+    book_update_publication_year(&lib->books[index], new_year);
+    lb_store_columns(lib, index);
+    lb_mark_book(lib, slot);
+    return 0;
+}
+
+int lb_update_book_year(Library *lib, const char *isbn, const int new_year) {
+    LibraryLock lock = lb_lock_book(lib, isbn, 0);
+    int failed = lb_update_book_year_unlocked(lib, isbn, new_year);
+    lb_unlock(lib, lock);
+    return failed;
+}
+
+static int lb_update_book_description_unlocked(Library *lib, const char *isbn, const char *description) {
+    if (!lib || !isbn || !description) {
+        LOG_ERROR(NULL_ERROR);
+        return 1;
+    }
+
+    int slot = lb_find_slot(lib, isbn);
+    if (slot < 0) {
+        LOG_ERROR("Book to be updated not Found");
+        return 1;
+    }
+
+    Book *book = &lib->books[lib->slot_books[slot]];
+    lb_guard(lib, LB_GUARD_STRINGS);
+    char *text = string_arena_append(&lib->strings, description, strlen(description));
+    lb_unguard(lib, LB_GUARD_STRINGS);
+    if (!text) {
+        LOG_ERROR(ALLOCATION_ERROR);
+        return 1;
+    }
+
+    if (lb_notify(lib, LB_CHANGE_BOOK_DESCRIPTION, isbn, NULL, text, 0) != 0) {
+        return 1;
+    }
+
+    lb_unindex_text(lib, slot);
+    lb_release_description(lib, book);
+    book->description = text;
+
+    if (lb_index_text(lib, slot) != 0) {
+        LOG_ERROR("Text Index Insert Failed - %s", isbn);
+    }
+
+    LOG_DEBUG("Updated Book Description - ISBN %s ", isbn);
+    lb_mark_book(lib, slot);
+
+    // Compacting moves every description, a concurrent library does it
+    // once the shard is released (see lb_update_book_description)
+    if (!lib->locks) {
+        lb_maybe_compact_strings(lib);
+    }
+    return 0;
+}
+
+int lb_update_book_description(Library *lib, const char *isbn, const char *description) {
+    LibraryLock lock = lb_lock_book(lib, isbn, 0);
+    int failed = lb_update_book_description_unlocked(lib, isbn, description);
+    lb_unlock(lib, lock);
+
+    // Only a change that locked a shard of a concurrent library left the
+    // compaction behind; it takes the whole library for it
+    if (!failed && lock.scope != 0 && lb_strings_need_compaction(lib)) {
+        lock = lb_lock_all(lib);
+        lb_maybe_compact_strings(lib);
+        lb_unlock(lib, lock);
+    }
+
+    return failed;
+}
+
+static int lb_compact_strings_unlocked(Library *lib) {
+    if (!lib) {
+        LOG_ERROR(NULL_ERROR);
+        return 1;
+    }
+
+    StringArena fresh;
+    string_arena_init(&fresh);
+
+    // One block sized for every live string, so the copy cannot fail midway
+    if (lib->strings.bytes_live > 0 && string_arena_reserve(&fresh, lib->strings.bytes_live) != 0) {
+        LOG_ERROR(ALLOCATION_ERROR);
+        return 1;
+    }
+
+    for (int i = 0; i < lib->book_count; i++) {
+        Book *book = &lib->books[i];
+
+        if (book->description_capacity == 0 && book->description && !lb_in_view(lib, book->description)) {
+            book->description = string_arena_append(&fresh, book->description, strlen(book->description));
+        }
+    }
+
+    size_t freed = string_arena_garbage(&lib->strings);
+    string_arena_free(&lib->strings);
+    lib->strings = fresh;
+
+    LOG_INFO("Strings Compacted - %zu bytes freed", freed);
+    return 0;
+}
+
+int lb_compact_strings(Library *lib) {
+    LibraryLock lock = lb_lock_all(lib);
+    int failed = lb_compact_strings_unlocked(lib);
+    lb_unlock(lib, lock);
+    return failed;
+}
+
+static int lb_set_change_hook_unlocked(Library *lib, LibraryChangeFn on_change, LibraryCommitFn on_commit, void *ctx) {
+    if (!lib) {
+        LOG_ERROR(NULL_ERROR);
+        return 1;
+    }
+
+    lib->on_change = on_change;
+    lib->on_commit = on_commit;
+    lib->change_ctx = ctx;
+    return 0;
+}
+
+int lb_set_change_hook(Library *lib, LibraryChangeFn on_change, LibraryCommitFn on_commit, void *ctx) {
+    LibraryLock lock = lb_lock_all(lib);
+    int failed = lb_set_change_hook_unlocked(lib, on_change, on_commit, ctx);
+    lb_unlock(lib, lock);
+    return failed;
+}
+
+static int lb_attach_view_unlocked(Library *lib, const char *view, size_t size, void (*release)(const char *view, size_t size)) {
+    if (!lib || !view) {
+        LOG_ERROR(NULL_ERROR);
+        return 1;
+    }
+
+    if (lib->view) {
+        LOG_ERROR("Library already holds a View");
+        return 1;
+    }
+
+    lib->view = view;
+    lib->view_size = size;
+    lib->view_release = release;
+    return 0;
+}
+
+int lb_attach_view(Library *lib, const char *view, size_t size, void (*release)(const char *view, size_t size)) {
+    LibraryLock lock = lb_lock_all(lib);
+    int failed = lb_attach_view_unlocked(lib, view, size, release);
+    lb_unlock(lib, lock);
+    return failed;
+}
+
+static int lb_attach_descriptions_unlocked(Library *lib, DescriptionStore *store) {
+    if (!lib || !store) {
+        LOG_ERROR(NULL_ERROR);
+        return 1;
+    }
+
+    if (lib->descriptions) {
+        LOG_ERROR("Library already holds a Description Store");
+        return 1;
+    }
+
+    lib->descriptions = store;
+    return 0;
+}
+
+int lb_attach_descriptions(Library *lib, DescriptionStore *store) {
+    LibraryLock lock = lb_lock_all(lib);
+    int failed = lb_attach_descriptions_unlocked(lib, store);
+    lb_unlock(lib, lock);
+    return failed;
+}
+
+const char *lb_get_book_description(const Library *lib, const Book *book) {
+    if (!lib || !book) {
+        LOG_ERROR(NULL_ERROR);
+        return NULL;
+    }
+
+    int ref = book_description_ref(book);
+    if (ref < 0) {
+        return book->description;
+    }
+
+    if (!lib->descriptions) {
+        LOG_ERROR("Description Store Missing - %s", book->isbn);
+        return NULL;
+    }
+
+    return description_store_get(lib->descriptions, ref);
+}
+
+const char *lb_read_book_description(const Library *lib, const Book *book, char **buffer, size_t *capacity) {
+    if (!lib || !book || !buffer || !capacity) {
+        LOG_ERROR(NULL_ERROR);
+        return NULL;
+    }
+
+    int ref = book_description_ref(book);
+    if (ref < 0) {
+        return book->description;
+    }
+
+    if (!lib->descriptions) {
+        LOG_ERROR("Description Store Missing - %s", book->isbn);
+        return NULL;
+    }
+
+    return description_store_copy(lib->descriptions, ref, buffer, capacity);
+}
+
+static void lb_defer_indexes_unlocked(Library *lib) {
+    if (!lib) {
+        LOG_ERROR(NULL_ERROR);
+        return;
+    }
+
+    lib->index_deferred = 1;
+}
+
+void lb_defer_indexes(Library *lib) {
+    LibraryLock lock = lb_lock_all(lib);
+    lb_defer_indexes_unlocked(lib);
+    lb_unlock(lib, lock);
+}
+
+static int lb_values_below(const HashIndex *index, int limit) {
+    for (int i = 0; i < index->capacity; i++) {
+        if (index->entries[i].value >= limit) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+// Install saved tables, ISBN values go from dense indexes back to slots
+static int lb_load_indexes(Library *lib, const LibraryIndexes *indexes) {
+    if (indexes->isbn_count != lib->book_count || indexes->author_count > lib->author_count ||
+        indexes->genre_count > lib->genre_count) {
+        return 1;
+    }
+
+    if (hash_index_load(&lib->isbn_index, indexes->isbn_entries, indexes->isbn_capacity,
+                        indexes->isbn_count, indexes->isbn_tombstones) != 0 ||
+        hash_index_load(&lib->author_index, indexes->author_entries, indexes->author_capacity,
+                        indexes->author_count, indexes->author_tombstones) != 0 ||
+        hash_index_load(&lib->genre_index, indexes->genre_entries, indexes->genre_capacity,
+                        indexes->genre_count, indexes->genre_tombstones) != 0 ||
+        postings_load(&lib->genre_postings, indexes->genre_offsets, indexes->genre_ids, indexes->genre_lists) != 0 ||
+        postings_load(&lib->author_postings, indexes->author_offsets, indexes->author_ids, indexes->author_lists) != 0) {
+        return 1;
+    }
+
+    if (!lb_values_below(&lib->isbn_index, lib->book_count) ||
+        !lb_values_below(&lib->author_index, lib->author_count) ||
+        !lb_values_below(&lib->genre_index, lib->genre_count)) {
+        return 1;
+    }
+
+    HashEntry *entries = lib->isbn_index.entries;
+    for (int i = 0; i < lib->isbn_index.capacity; i++) {
+        if (entries[i].value >= 0) {
+            entries[i].value = lib->book_slots[entries[i].value];
+        }
+    }
+
+    return lb_postings_to_slots(lib, &lib->genre_postings) != 0 ||
+           lb_postings_to_slots(lib, &lib->author_postings) != 0;
+}
+
+static int lb_rebuild_indexes(Library *lib) {
+    hash_index_clear(&lib->isbn_index);
+    hash_index_clear(&lib->author_index);
+    hash_index_clear(&lib->genre_index);
+    postings_clear(&lib->genre_postings);
+    postings_clear(&lib->author_postings);
+
+    if (hash_index_reserve(&lib->isbn_index, lib->book_count) != 0 ||
+        hash_index_reserve(&lib->author_index, lib->author_count) != 0 ||
+        hash_index_reserve(&lib->genre_index, lib->genre_count) != 0) {
+        return 1;
+    }
+
+    // Names are unique, a repeated one (from a damaged file) keeps its first record
+    for (int i = 0; i < lib->author_count; i++) {
+        hash_index_insert(&lib->author_index, lib, lib->authors[i].name, i);
+    }
+
+    for (int i = 0; i < lib->genre_count; i++) {
+        hash_index_insert(&lib->genre_index, lib, lib->genres[i].name, i);
+    }
+
+    for (int i = 0; i < lib->book_count; i++) {
+        if (hash_index_insert(&lib->isbn_index, lib, lib->books[i].isbn, lib->book_slots[i]) != 0 ||
+            lb_index_book(lib, lib->book_slots[i]) != 0) {
+            LOG_ERROR("Index Rebuild Failed - %s", lib->books[i].isbn);
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+static int lb_restore_indexes_unlocked(Library *lib, const LibraryIndexes *indexes) {
+    if (!lib) {
+        LOG_ERROR(NULL_ERROR);
+        return 1;
+    }
+
+    lib->index_deferred = 0;
+
+    if (indexes && lb_load_indexes(lib, indexes) == 0) {
+        LOG_INFO("Indexes Restored - %d Books", lib->book_count);
+        return 0;
+    }
+
+    if (lb_rebuild_indexes(lib) != 0) {
+        return 1;
+    }
+
+    LOG_INFO("Indexes Rebuilt - %d Books", lib->book_count);
+    return 0;
+}
+
+int lb_restore_indexes(Library *lib, const LibraryIndexes *indexes) {
+    LibraryLock lock = lb_lock_all(lib);
+    int failed = lb_restore_indexes_unlocked(lib, indexes);
+    lb_unlock(lib, lock);
+    return failed;
+}
+
+// Copy a spilled list into the pool, the book borrows it from there
+static int lb_pool_list(int *pool, int offset, int **ids, int count, int *capacity) {
+    if (!*ids) {
+        return offset;
+    }
+
+    memcpy(pool + offset, *ids, (size_t)count * sizeof(int));
+
+    if (*capacity > 0) {
+        free(*ids);
+    }
+
+    *ids = pool + offset;
+    *capacity = 0;
+
+    return offset + count;
+}
+
+static int lb_compact_ids_unlocked(Library *lib) {
+    if (!lib) {
+        LOG_ERROR(NULL_ERROR);
+        return 1;
+    }
+
+    int total = 0;
+    for (int i = 0; i < lib->book_count; i++) {
+        const Book *book = &lib->books[i];
+        total += book->genre_ids ? book->genre_count : 0;
+        total += book->author_ids ? book->author_count : 0;
+    }
+
+    int *pool = NULL;
+    if (total > 0) {
+        pool = malloc((size_t)total * sizeof(int));
+
+        if (!pool) {
+            LOG_ERROR(ALLOCATION_ERROR);
+            return 1;
+        }
+    }
+
+    int offset = 0;
+    for (int i = 0; i < lib->book_count; i++) {
+        Book *book = &lib->books[i];
+        offset = lb_pool_list(pool, offset, &book->genre_ids, book->genre_count, &book->genre_capacity);
+        offset = lb_pool_list(pool, offset, &book->author_ids, book->author_count, &book->author_capacity);
+    }
+
+    free(lib->id_pool);
+    lib->id_pool = pool;
+    lib->id_pool_size = total;
+
+    LOG_INFO("ID Lists Compacted - %d ids", total);
+    return 0;
+}
+
+int lb_compact_ids(Library *lib) {
+    LibraryLock lock = lb_lock_all(lib);
+    int failed = lb_compact_ids_unlocked(lib);
+    lb_unlock(lib, lock);
+    return failed;
+}
+
+int lb_search_books(Library *lib, const char *term, int *results, int max_results, int *count) {
+    if (!lib || !term || !results || !count) {
+        LOG_ERROR(NULL_ERROR);
+        return 1;
+    }
+
+    *count = 0;
+
+    char *buffer = NULL;
+    size_t capacity = 0;
+
+    if (strlen(term) < TRIGRAM_MIN_QUERY) {
+        for (int i = 0; i < lib->book_count && *count < max_results; i++) {
+            if (lb_book_matches(lib, &lib->books[i], term, &buffer, &capacity)) {
+                results[(*count)++] = i;
+            }
+        }
+
+        free(buffer);
+        return 0;
+    }
+
+    if (lb_refresh_text(lib) != 0) {
+        return 1;
+    }
+
+    // Concurrent searches query the index with their own buffers
+    TrigramScratch own = { NULL, 0, NULL, 0 };
+    TrigramScratch *scratch = lib->locks ? &own : &lib->text_index.scratch;
+
+    // Candidates hold every trigram of the term, verify the substring
+    int candidate_count;
+    const int *candidates = trigram_index_query_with(&lib->text_index, scratch, term, &candidate_count);
+
+    for (int i = 0; i < candidate_count && *count < max_results; i++) {
+        int index = lib->slot_books[candidates[i]];
+
+        if (lb_book_matches(lib, &lib->books[index], term, &buffer, &capacity)) {
+            results[(*count)++] = index;
+        }
+    }
+
+    trigram_scratch_free(&own);
+    free(buffer);
+    return 0;
+}
+
+int lb_prefix_search(Library *lib, const char *prefix, int limit, int kinds, PrefixMatch *results, int *count) {
+    if (!lib || !prefix || !results || !count) {
+        LOG_ERROR(NULL_ERROR);
+        return 1;
+    }
+
+    *count = 0;
+
+    if ((kinds & PREFIX_TITLES) &&
+        lb_refresh_prefix(lib, &lib->title_prefix, lib->book_slots, lib->book_count) != 0) {
+        return 1;
+    }
+
+    if ((kinds & PREFIX_AUTHORS) &&
+        lb_refresh_prefix(lib, &lib->author_prefix, NULL, lib->author_count) != 0) {
+        return 1;
+    }
+
+    const PrefixIndex *titles = &lib->title_prefix;
+    const PrefixIndex *authors = &lib->author_prefix;
+    int t = (kinds & PREFIX_TITLES) ? prefix_index_find(titles, lib, prefix) : titles->count;
+    int a = (kinds & PREFIX_AUTHORS) ? prefix_index_find(authors, lib, prefix) : authors->count;
+
+    // Merge both runs in alphabetical order
+    while (*count < limit) {
+        int has_title = (kinds & PREFIX_TITLES) && prefix_index_matches(titles, lib, t, prefix);
+        int has_author = (kinds & PREFIX_AUTHORS) && prefix_index_matches(authors, lib, a, prefix);
+
+        if (!has_title && !has_author) {
+            break;
+        }
+
+        PrefixMatch *match = &results[(*count)++];
+        if (has_title && (!has_author || prefix_compare(prefix_index_key(titles, lib, t),
+                                                        prefix_index_key(authors, lib, a)) <= 0)) {
+            match->kind = PREFIX_TITLES;
+            match->index = lib->slot_books[titles->values[t]];
+            match->text = prefix_index_key(titles, lib, t);
+            t++;
+        } else {
+            match->kind = PREFIX_AUTHORS;
+            match->index = authors->values[a];
+            match->text = prefix_index_key(authors, lib, a);
+            a++;
+        }
+    }
+
+    return 0;
+}
+
+//postings
+static int lb_has_id(const int *ids, int count, int id) {
+    for (int i = 0; i < count; i++) {
+        if (ids[i] == id) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+static int lb_add_book_genre_unlocked(Library *lib, const char *isbn, const int genre_id) {
+    if (!lib || !isbn) {
+        LOG_ERROR(NULL_ERROR);
+        return 1;
+    }
+
+    Book *book = lb_find_book_by_isbn(lib, isbn);
+    if (!book) {
+        LOG_ERROR("Book to be updated not Found");
+        return 1;
+    }
+
+    if (genre_id <= 0) {
+        LOG_ERROR("Unsupported Genre ID");
+        return 1;
+    }
+
+    // Room first, so book_add_genre cannot fail once the hook saw the change
+    if (book_reserve_genre(book) != 0) {
+        return 1;
+    }
+
+    if (lb_notify(lib, LB_CHANGE_ADD_BOOK_GENRE, isbn, NULL, NULL, genre_id) != 0) {
+        return 1;
+    }
+    book_add_genre(book, genre_id);
+
+    int slot = lib->book_slots[book - lib->books];
+    if (postings_add(&lib->genre_postings, genre_id, slot) != 0) {
+        book_remove_genre(book, genre_id);
+        return 1;
+    }
+
+    lb_mark_book(lib, slot);
+    return 0;
+}
+
+int lb_add_book_genre(Library *lib, const char *isbn, const int genre_id) {
+    LibraryLock lock = lb_lock_book(lib, isbn, LB_TABLE_GENRES);
+    int failed = lb_add_book_genre_unlocked(lib, isbn, genre_id);
+    lb_unlock(lib, lock);
+    return failed;
+}
+
+static int lb_remove_book_genre_unlocked(Library *lib, const char *isbn, const int genre_id) {
+    if (!lib || !isbn) {
+        LOG_ERROR(NULL_ERROR);
+        return 1;
+    }
+
+    Book *book = lb_find_book_by_isbn(lib, isbn);
+    if (!book) {
+        LOG_ERROR("Book to be updated not Found");
+        return 1;
+    }
+
+    if (!lb_has_id(book_get_genre_ids(book), book->genre_count, genre_id)) {
+        LOG_ERROR("Genre to be removed from Book not Found");
+        return 1;
+    }
+
+    if (lb_notify(lib, LB_CHANGE_REMOVE_BOOK_GENRE, isbn, NULL, NULL, genre_id) != 0) {
+        return 1;
+    }
+
+    if (book_remove_genre(book, genre_id) != 0) {
+        return 1;
+    }
+
+    int slot = lib->book_slots[book - lib->books];
+    postings_remove(&lib->genre_postings, genre_id, slot);
+    lb_mark_book(lib, slot);
+    return 0;
+}
+
+int lb_remove_book_genre(Library *lib, const char *isbn, const int genre_id) {
+    LibraryLock lock = lb_lock_book(lib, isbn, LB_TABLE_GENRES);
+    int failed = lb_remove_book_genre_unlocked(lib, isbn, genre_id);
+    lb_unlock(lib, lock);
+    return failed;
+}
+
+static int lb_add_book_author_unlocked(Library *lib, const char *isbn, const int author_id) {
+    if (!lib || !isbn) {
+        LOG_ERROR(NULL_ERROR);
+        return 1;
+    }
+
+    Book *book = lb_find_book_by_isbn(lib, isbn);
+    if (!book) {
+        LOG_ERROR("Book to be updated not Found");
+        return 1;
+    }
+
+    if (author_id <= 0) {
+        LOG_ERROR("Unsupported Author ID");
+        return 1;
+    }
+
+    // Room first, so book_add_author cannot fail once the hook saw the change
+    if (book_reserve_author(book) != 0) {
+        return 1;
+    }
+
+    if (lb_notify(lib, LB_CHANGE_ADD_BOOK_AUTHOR, isbn, NULL, NULL, author_id) != 0) {
+        return 1;
+    }
+    book_add_author(book, author_id);
+
+    int slot = lib->book_slots[book - lib->books];
+    if (postings_add(&lib->author_postings, author_id, slot) != 0) {
+        book_remove_author(book, author_id);
+        return 1;
+    }
+
+    lb_mark_book(lib, slot);
+    return 0;
+}
+
+int lb_add_book_author(Library *lib, const char *isbn, const int author_id) {
+    LibraryLock lock = lb_lock_book(lib, isbn, LB_TABLE_AUTHORS);
+    int failed = lb_add_book_author_unlocked(lib, isbn, author_id);
+    lb_unlock(lib, lock);
+    return failed;
+}
+
+static int lb_remove_book_author_unlocked(Library *lib, const char *isbn, const int author_id) {
+    if (!lib || !isbn) {
+        LOG_ERROR(NULL_ERROR);
+        return 1;
+    }
+
+    Book *book = lb_find_book_by_isbn(lib, isbn);
+    if (!book) {
+        LOG_ERROR("Book to be updated not Found");
+        return 1;
+    }
+
+    if (!lb_has_id(book_get_author_ids(book), book->author_count, author_id)) {
+        LOG_ERROR("Author to be removed from Book not Found");
+        return 1;
+    }
+
+    if (lb_notify(lib, LB_CHANGE_REMOVE_BOOK_AUTHOR, isbn, NULL, NULL, author_id) != 0) {
+        return 1;
+    }
+
+    if (book_remove_author(book, author_id) != 0) {
+        return 1;
+    }
+
+    int slot = lib->book_slots[book - lib->books];
+    postings_remove(&lib->author_postings, author_id, slot);
+    lb_mark_book(lib, slot);
+    return 0;
+}
+
+int lb_remove_book_author(Library *lib, const char *isbn, const int author_id) {
+    LibraryLock lock = lb_lock_book(lib, isbn, LB_TABLE_AUTHORS);
+    int failed = lb_remove_book_author_unlocked(lib, isbn, author_id);
+    lb_unlock(lib, lock);
+    return failed;
+}
+
+const int *lb_books_by_genre(const Library *lib, int genre_id, int *count) {
+    if (!lib || !count) {
+        LOG_ERROR(NULL_ERROR);
+        return NULL;
+    }
+
+    return postings_get(&lib->genre_postings, genre_id, count);
+}
+
+const int *lb_books_by_author(const Library *lib, int author_id, int *count) {
+    if (!lib || !count) {
+        LOG_ERROR(NULL_ERROR);
+        return NULL;
+    }
+
+    return postings_get(&lib->author_postings, author_id, count);
+}
+
+//columnar layout
+static int lb_set_columnar_unlocked(Library *lib, int enabled) {
+    if (!lib) {
+        LOG_ERROR(NULL_ERROR);
+        return 1;
+    }
+
+    if (!enabled) {
+        lb_free_columns(lib);
+        return 0;
+    }
+
+    if (lib->columnar) {
+        return 0;
+    }
+
+    if (lb_resize_columns(lib, lib->book_capacity) != 0) {
+        lb_free_columns(lib);
+        LOG_ERROR(ALLOCATION_ERROR);
+        return 1;
+    }
+
+    lib->columnar = 1;
+    for (int i = 0; i < lib->book_count; i++) {
+        lb_store_columns(lib, i);
+    }
+
+    LOG_INFO("Columnar Layout Enabled - %d books", lib->book_count);
+    return 0;
+}
+
+int lb_set_columnar(Library *lib, int enabled) {
+    LibraryLock lock = lb_lock_all(lib);
+    int failed = lb_set_columnar_unlocked(lib, enabled);
+    lb_unlock(lib, lock);
+    return failed;
+}
+
+int lb_book_id_at(const Library *lib, int index) {
+    return lib->columnar ? lib->book_ids[index] : lib->books[index].id;
+}
+
+int lb_book_year_at(const Library *lib, int index) {
+    return lib->columnar ? lib->book_years[index] : lib->books[index].publication_year;
+}
+
+const char *lb_book_isbn_at(const Library *lib, int index) {
+    return lib->columnar ? lib->book_isbns[index] : lib->books[index].isbn;
+}
+
+const char *lb_book_title_at(const Library *lib, int index) {
+    return lib->books[index].title;
+}
 
-// Core Functions
+int lb_count_books_by_year(const Library *lib, int from_year, int to_year) {
+    if (!lib) {
+        LOG_ERROR(NULL_ERROR);
+        return 0;
+    }
 
-int lb_init(Library *lib) {
-    if (!lib){
+    int count = 0;
+
+    if (lib->columnar) {
+        const int *years = lib->book_years;
+        for (int i = 0; i < lib->book_count; i++) {
+            count += years[i] >= from_year && years[i] <= to_year;
+        }
+        return count;
+    }
+
+    for (int i = 0; i < lib->book_count; i++) {
+        int year = lib->books[i].publication_year;
+        count += year >= from_year && year <= to_year;
+    }
+
+    return count;
+}
+
+//authors
+static int lb_add_author_unlocked(Library *lib, const char *author_name) {
+    if (!lib || !author_name) {
         LOG_ERROR(NULL_ERROR);
         return 1;
-    } 
+    }
 
-    memset(lib, 0, sizeof(*lib));
+    if (lb_find_author_by_name(lib, author_name)) {
+        LOG_ERROR("Duplicated Author - %s", author_name);
+        return 1;
+    }
 
-    lib->book_capacity = 2;
-    lib->author_capacity = 2;
-    lib->genre_capacity = 2;
+    if (lb_reserve_authors(lib) != 0) {
+        LOG_ERROR(EXPAND_CAPACITY);
+        return 1;
+    }
+
+    int index = lib->author_count;
+    char key[MAX_AUTHOR_NAME];
+    lb_name_key(key, author_name, sizeof(key));
+    if (lb_notify(lib, LB_CHANGE_ADD_AUTHOR, NULL, NULL, key, index + 1) != 0) {
+        return 1;
+    }
 
-    lib->books = malloc(lib->book_capacity * sizeof(Book));
+    lib->authors[index].id = index + 1;
+    memcpy(lib->authors[index].name, key, sizeof(key));
 
-    if (!lib->books) {
-        LOG_ERROR(ALLOCATION_ERROR);
+    lib->author_count++;
+    lb_prefix_insert(lib, &lib->author_prefix, index);
+
+    hash_index_insert(&lib->author_index, lib, lib->authors[index].name, index);
+    lb_mark_author(lib, index);
+
+    LOG_DEBUG("Author added: %s", author_name);
+    return 0;
+}
+
+int lb_add_author(Library *lib, const char *author_name) {
+    LibraryLock lock = lb_lock_tables(lib, LB_TABLE_AUTHORS);
+    int failed = lb_add_author_unlocked(lib, author_name);
+    lb_unlock(lib, lock);
+    return failed;
+}
+
+static int lb_find_or_add_author_unlocked(Library *lib, const char *author_name, int *author_id) {
+    if (!lib || !author_name || !author_id) {
+        LOG_ERROR(NULL_ERROR);
         return 1;
     }
 
-    lib->authors = malloc(lib->author_capacity * sizeof(Author));
-    if (!lib->authors) {
-        free(lib->books);
-        memset(lib, 0, sizeof(*lib));
-        LOG_ERROR(ALLOCATION_ERROR);
+    Author *author = lb_find_author_by_name(lib, author_name);
+    if (author) {
+        *author_id = author->id;
+        return 0;
+    }
+
+    if (lb_add_author(lib, author_name) != 0) {
         return 1;
     }
 
-    lib->genres = malloc(lib->genre_capacity * sizeof(Genre));
-    if (!lib->genres) {
-        free(lib->books);
-        free(lib->authors);
-        memset(lib, 0, sizeof(*lib));
-        LOG_ERROR(ALLOCATION_ERROR);
+    *author_id = lib->authors[lib->author_count - 1].id;
+    return 0;
+}
+
+int lb_find_or_add_author(Library *lib, const char *author_name, int *author_id) {
+    LibraryLock lock = lb_lock_tables(lib, LB_TABLE_AUTHORS);
+    int failed = lb_find_or_add_author_unlocked(lib, author_name, author_id);
+    lb_unlock(lib, lock);
+    return failed;
+}
+
+// Ids are positions (id - 1 is the index of a author) and names are unique,
+// a batch breaking either adds nothing
+static int lb_validate_authors(Library *lib, const Author *authors, int count) {
+    LibraryNameBatch batch = { lib, authors, NULL };
+    HashIndex names;
+    hash_index_init(&names, lb_batch_author_key);
+
+    // A deferred index does not know the stored names yet
+    int stored = lib->index_deferred ? lib->author_count : 0;
+    if (hash_index_reserve(&names, stored + count) != 0) {
+        hash_index_free(&names);
         return 1;
     }
 
-    LOG_INFO("Init Successfully");
+    for (int i = 0; i < stored; i++) {
+        hash_index_insert(&names, &batch, lib->authors[i].name, i);
+    }
+
+    for (int i = 0; i < count; i++) {
+        char key[MAX_AUTHOR_NAME];
+        lb_name_key(key, authors[i].name, sizeof(key));
+
+        if (authors[i].id != lib->author_count + i + 1) {
+            LOG_ERROR("Invalid Author ID - %d", authors[i].id);
+            hash_index_free(&names);
+            return 1;
+        }
+
+        if ((!lib->index_deferred && hash_index_find(&lib->author_index, lib, key) >= 0) ||
+            hash_index_insert(&names, &batch, key, lib->author_count + i) != 0) {
+            LOG_ERROR("Duplicated Author - %s", key);
+            hash_index_free(&names);
+            return 1;
+        }
+    }
+
+    hash_index_free(&names);
     return 0;
 }
 
-void lb_free(Library *lib) {
-    if(!lib) {
+static int lb_add_authors_bulk_unlocked(Library *lib, const Author *authors, int count) {
+    if (!lib || (!authors && count > 0)) {
         LOG_ERROR(NULL_ERROR);
-        return;
+        return 1;
     }
 
-    free(lib->books->author_ids);
-    free(lib->books->genre_ids);
+    if (count <= 0) {
+        return 0;
+    }
 
-    free(lib->books);
-    lib->books = NULL;
+    if (lb_validate_authors(lib, authors, count) != 0) {
+        return 1;
+    }
 
-    free(lib->authors);
-    lib->authors = NULL;
+    if (lb_reserve_author_table(lib, count) != 0) {
+        LOG_ERROR(EXPAND_CAPACITY);
+        return 1;
+    }
 
-    free(lib->genres);
-    lib->genres = NULL;
+    for (int i = 0; i < count; i++) {
+        int index = lib->author_count;
+        char key[MAX_AUTHOR_NAME];
+        lb_name_key(key, authors[i].name, sizeof(key));
+        if (lb_notify(lib, LB_CHANGE_ADD_AUTHOR, NULL, NULL, key, authors[i].id) != 0) {
+            return 1;
+        }
 
-    lib->book_count = 0;
-    lib->book_capacity = 0;
-    
-    lib->author_count = 0;
-    lib->author_capacity = 0;
+        lib->authors[index].id = authors[i].id;
+        memcpy(lib->authors[index].name, key, sizeof(key));
+        lib->author_count++;
 
-    lib->genre_count = 0;
-    lib->genre_capacity = 0;
+        if (!lib->index_deferred) {
+            hash_index_insert(&lib->author_index, lib, lib->authors[index].name, index);
+        }
+        lb_mark_author(lib, index);
+    }
 
-    memset(lib, 0, sizeof(*lib));
+    prefix_index_invalidate(&lib->author_prefix);
+    LOG_INFO("Authors Added - %d", count);
+    return 0;
+}
 
-    LOG_INFO("Freed library");
+int lb_add_authors_bulk(Library *lib, const Author *authors, int count) {
+    LibraryLock lock = lb_lock_tables(lib, LB_TABLE_AUTHORS);
+    int failed = lb_add_authors_bulk_unlocked(lib, authors, count);
+    lb_unlock(lib, lock);
+    return failed;
 }
 
-void lb_clear(Library *lib) {
-    if(!lib) {
+Author *lb_find_author_by_name(Library *lib, const char *author_name) {
+    if (!lib || !author_name) {
         LOG_ERROR(NULL_ERROR);
-        return;
+        return NULL;
     }
 
-    free(lib->books->author_ids);
-    free(lib->books->genre_ids);
+    char key[MAX_AUTHOR_NAME];
+    lb_name_key(key, author_name, sizeof(key));
 
-    free(lib->books);
-    lib->books = NULL;
+    int index = hash_index_find(&lib->author_index, lib, key);
+    if (index < 0) {
+        return NULL;
+    }
 
-    free(lib->authors);
-    lib->authors = NULL;
+    return &lib->authors[index];
+}
 
-    free(lib->genres);
-    lib->genres = NULL;
+static int lb_update_author_name_unlocked(Library *lib, int author_id, const char *name) {
+    if (!lib || !name) {
+        LOG_ERROR(NULL_ERROR);
+        return 1;
+    }
 
-    lib->book_count = 0;
-    lib->author_count = 0;
-    lib->genre_count = 0;
+    if (author_id <= 0 || author_id > lib->author_count) {
+        LOG_ERROR("Author to be updated not Found");
+        return 1;
+    }
 
-    LOG_INFO("Library Cleared");
+    char key[MAX_AUTHOR_NAME];
+    lb_name_key(key, name, sizeof(key));
+
+    int index = author_id - 1;
+    if (lib->authors[index].id != author_id) {
+        LOG_ERROR("Author to be updated not Found");
+        return 1;
+    }
+
+    int owner = hash_index_find(&lib->author_index, lib, key);
+    if (owner >= 0 && owner != index) {
+        LOG_ERROR("Duplicated Author - %s", key);
+        return 1;
+    }
+
+    if (lb_notify(lib, LB_CHANGE_AUTHOR_NAME, NULL, NULL, key, author_id) != 0) {
+        return 1;
+    }
+
+    if (hash_index_find(&lib->author_index, lib, lib->authors[index].name) == index) {
+        hash_index_remove(&lib->author_index, lib, lib->authors[index].name);
+    }
+
+    lb_prefix_remove(lib, &lib->author_prefix, index);
+    author_update_name(&lib->authors[index], key);
+    lb_prefix_insert(lib, &lib->author_prefix, index);
+    hash_index_insert(&lib->author_index, lib, lib->authors[index].name, index);
+    lb_mark_author(lib, index);
+
+    return 0;
 }
 
-// CRUD Functions
+int lb_update_author_name(Library *lib, int author_id, const char *name) {
+    LibraryLock lock = lb_lock_tables(lib, LB_TABLE_AUTHORS);
+    int failed = lb_update_author_name_unlocked(lib, author_id, name);
+    lb_unlock(lib, lock);
+    return failed;
+}
 
-//books
-int lb_add_book(Library *lib, const Book *book) {
-    if (!lib || !book) {
+//genres
+static int lb_add_genre_unlocked(Library *lib, const char *genre_name) {
+    if (!lib || !genre_name) {
         LOG_ERROR(NULL_ERROR);
         return 1;
     }
 
-    if (book->isbn[0] == '\0'){
-        LOG_ERROR("Invalid ISBN");
+    if (lb_find_genre_by_name(lib, genre_name)) {
+        LOG_ERROR("Duplicated Genre - %s", genre_name);
         return 1;
     }
 
-    if (lb_reserve_books(lib) != 0) {
+    if (lb_reserve_genres(lib) != 0) {
         LOG_ERROR(EXPAND_CAPACITY);
         return 1;
     }
 
-    lib->books[lib->book_count] = *book;
-    lib->book_count++;
-    LOG_INFO("Book Added - %s", book->isbn);
+    int index = lib->genre_count;
+    char key[MAX_GENRE];
+    lb_name_key(key, genre_name, sizeof(key));
+    if (lb_notify(lib, LB_CHANGE_ADD_GENRE, NULL, NULL, key, index + 1) != 0) {
+        return 1;
+    }
+
+    lib->genres[index].id = index + 1;
+    memcpy(lib->genres[index].name, key, sizeof(key));
+
+    lib->genre_count++;
+
+    hash_index_insert(&lib->genre_index, lib, lib->genres[index].name, index);
+    lb_mark_genre(lib, index);
 
+    LOG_DEBUG("Genre added: %s", genre_name);
     return 0;
 }
 
-int lb_remove_book(Library *lib, const char *isbn){
-    if (!lib || !isbn) {
+int lb_add_genre(Library *lib, const char *genre_name) {
+    LibraryLock lock = lb_lock_tables(lib, LB_TABLE_GENRES);
+    int failed = lb_add_genre_unlocked(lib, genre_name);
+    lb_unlock(lib, lock);
+    return failed;
+}
+
+static int lb_find_or_add_genre_unlocked(Library *lib, const char *genre_name, int *genre_id) {
+    if (!lib || !genre_name || !genre_id) {
         LOG_ERROR(NULL_ERROR);
         return 1;
     }
 
-    int rm_index = -1;
-    for (int i = 0; i < lib->book_count; i++) {
-        if (strcmp(lib->books[i].isbn, isbn) == 0) {
-            rm_index = i;
-            break;
-        }
+    Genre *genre = lb_find_genre_by_name(lib, genre_name);
+    if (genre) {
+        *genre_id = genre->id;
+        return 0;
     }
 
-    if (rm_index < 0) {
-        LOG_ERROR("Book to be removed not Found");
+    if (lb_add_genre(lib, genre_name) != 0) {
         return 1;
     }
 
-    free(lib->books[rm_index].genre_ids);
-    free(lib->books[rm_index].author_ids);
+    *genre_id = lib->genres[lib->genre_count - 1].id;
+    return 0;
+}
+
+int lb_find_or_add_genre(Library *lib, const char *genre_name, int *genre_id) {
+    LibraryLock lock = lb_lock_tables(lib, LB_TABLE_GENRES);
+    int failed = lb_find_or_add_genre_unlocked(lib, genre_name, genre_id);
+    lb_unlock(lib, lock);
+    return failed;
+}
 
-    for (int i = rm_index; i < lib->book_count - 1; i++) {
-        lib->books[i] = lib->books[i + 1];
+// Ids are positions (id - 1 is the index of a genre) and names are unique,
+// a batch breaking either adds nothing
+static int lb_validate_genres(Library *lib, const Genre *genres, int count) {
+    LibraryNameBatch batch = { lib, NULL, genres };
+    HashIndex names;
+    hash_index_init(&names, lb_batch_genre_key);
+
+    // A deferred index does not know the stored names yet
+    int stored = lib->index_deferred ? lib->genre_count : 0;
+    if (hash_index_reserve(&names, stored + count) != 0) {
+        hash_index_free(&names);
+        return 1;
     }
 
-    lib->book_count--;
-    memset(&lib->books[lib->book_count], 0, sizeof(Book));
+    for (int i = 0; i < stored; i++) {
+        hash_index_insert(&names, &batch, lib->genres[i].name, i);
+    }
+
+    for (int i = 0; i < count; i++) {
+        char key[MAX_GENRE];
+        lb_name_key(key, genres[i].name, sizeof(key));
+
+        if (genres[i].id != lib->genre_count + i + 1) {
+            LOG_ERROR("Invalid Genre ID - %d", genres[i].id);
+            hash_index_free(&names);
+            return 1;
+        }
 
-    LOG_INFO("Book Removed - %s", isbn);
+        if ((!lib->index_deferred && hash_index_find(&lib->genre_index, lib, key) >= 0) ||
+            hash_index_insert(&names, &batch, key, lib->genre_count + i) != 0) {
+            LOG_ERROR("Duplicated Genre - %s", key);
+            hash_index_free(&names);
+            return 1;
+        }
+    }
 
+    hash_index_free(&names);
     return 0;
 }
 
-//authors
-int lb_add_author(Library *lib, const char *author_name) {
-    if (!lib || !author_name) {
+static int lb_add_genres_bulk_unlocked(Library *lib, const Genre *genres, int count) {
+    if (!lib || (!genres && count > 0)) {
         LOG_ERROR(NULL_ERROR);
         return 1;
     }
 
-    if (lb_reserve_authors(lib) != 0) {
+    if (count <= 0) {
+        return 0;
+    }
+
+    if (lb_validate_genres(lib, genres, count) != 0) {
+        return 1;
+    }
+
+    if (lb_reserve_genre_table(lib, count) != 0) {
         LOG_ERROR(EXPAND_CAPACITY);
         return 1;
     }
 
-    int index = lib->author_count;
-    lib->authors[index].id = index + 1;
-    strncpy(lib->authors[index].name,author_name,MAX_AUTHOR_NAME - 1);
-    lib->authors[index].name[MAX_AUTHOR_NAME - 1] = '\0';
+    for (int i = 0; i < count; i++) {
+        int index = lib->genre_count;
+        char key[MAX_GENRE];
+        lb_name_key(key, genres[i].name, sizeof(key));
+        if (lb_notify(lib, LB_CHANGE_ADD_GENRE, NULL, NULL, key, genres[i].id) != 0) {
+            return 1;
+        }
 
-    lib->author_count++;
+        lib->genres[index].id = genres[i].id;
+        memcpy(lib->genres[index].name, key, sizeof(key));
+        lib->genre_count++;
+
+        if (!lib->index_deferred) {
+            hash_index_insert(&lib->genre_index, lib, lib->genres[index].name, index);
+        }
+        lb_mark_genre(lib, index);
+    }
 
-    LOG_INFO("Author added: %s", author_name);
+    LOG_INFO("Genres Added - %d", count);
     return 0;
 }
 
-//genres
-int lb_add_genre(Library *lib, const char *genre_name) {
+int lb_add_genres_bulk(Library *lib, const Genre *genres, int count) {
+    LibraryLock lock = lb_lock_tables(lib, LB_TABLE_GENRES);
+    int failed = lb_add_genres_bulk_unlocked(lib, genres, count);
+    lb_unlock(lib, lock);
+    return failed;
+}
+
+Genre *lb_find_genre_by_name(Library *lib, const char *genre_name) {
     if (!lib || !genre_name) {
+        LOG_ERROR(NULL_ERROR);
+        return NULL;
+    }
+
+    char key[MAX_GENRE];
+    lb_name_key(key, genre_name, sizeof(key));
+
+    int index = hash_index_find(&lib->genre_index, lib, key);
+    if (index < 0) {
+        return NULL;
+    }
+
+    return &lib->genres[index];
+}
+
+static int lb_update_genre_name_unlocked(Library *lib, int genre_id, const char *name) {
+    if (!lib || !name) {
         LOG_ERROR(NULL_ERROR);
         return 1;
     }
 
-    if (lb_reserve_genres(lib) != 0) {
-        LOG_ERROR(EXPAND_CAPACITY);
+    if (genre_id <= 0 || genre_id > lib->genre_count) {
+        LOG_ERROR("Genre to be updated not Found");
         return 1;
     }
 
-    int index = lib->genre_count;
-    lib->genres[index].id = index + 1;
-    strncpy(lib->genres[index].name,genre_name,MAX_GENRE - 1);
-    lib->genres[index].name[MAX_GENRE - 1] = '\0';
+    char key[MAX_GENRE];
+    lb_name_key(key, name, sizeof(key));
 
-    lib->genre_count++;
+    int index = genre_id - 1;
+    if (lib->genres[index].id != genre_id) {
+        LOG_ERROR("Genre to be updated not Found");
+        return 1;
+    }
+
+    int owner = hash_index_find(&lib->genre_index, lib, key);
+    if (owner >= 0 && owner != index) {
+        LOG_ERROR("Duplicated Genre - %s", key);
+        return 1;
+    }
+
+    if (lb_notify(lib, LB_CHANGE_GENRE_NAME, NULL, NULL, key, genre_id) != 0) {
+        return 1;
+    }
+
+    if (hash_index_find(&lib->genre_index, lib, lib->genres[index].name) == index) {
+        hash_index_remove(&lib->genre_index, lib, lib->genres[index].name);
+    }
+
+    update_genre_name(&lib->genres[index], key);
+    hash_index_insert(&lib->genre_index, lib, lib->genres[index].name, index);
+    lb_mark_genre(lib, index);
 
-    LOG_INFO("Genre added: %s", genre_name);
     return 0;
 }
 
+int lb_update_genre_name(Library *lib, int genre_id, const char *name) {
+    LibraryLock lock = lb_lock_tables(lib, LB_TABLE_GENRES);
+    int failed = lb_update_genre_name_unlocked(lib, genre_id, name);
+    lb_unlock(lib, lock);
+    return failed;
+}
+
 // Utils Functions
-int lb_reserve_books(Library *lib) {
+static int lb_reserve_unlocked(Library *lib, int books, int authors, int genres) {
+    if (!lib) {
+        LOG_ERROR(NULL_ERROR);
+        return 1;
+    }
+
+    if (books < 0 || authors < 0 || genres < 0) {
+        LOG_ERROR("Unsupported Reserve Size");
+        return 1;
+    }
+
+    int book_cap = lib->book_count + books;
+    if (book_cap > lib->book_capacity && lb_resize_books(lib, book_cap) != 0) {
+        return 1;
+    }
+
+    if (hash_index_reserve(&lib->isbn_index, book_cap) != 0 ||
+        lb_reserve_author_table(lib, authors) != 0 ||
+        lb_reserve_genre_table(lib, genres) != 0) {
+        return 1;
+    }
+
+    LOG_INFO("Capacity Reserved - %d Books, %d Authors, %d Genres",
+             lib->book_capacity, lib->author_capacity, lib->genre_capacity);
+    return 0;
+}
+
+int lb_reserve(Library *lib, int books, int authors, int genres) {
+    LibraryLock lock = lb_lock_all(lib);
+    int failed = lb_reserve_unlocked(lib, books, authors, genres);
+    lb_unlock(lib, lock);
+    return failed;
+}
+
+static int lb_reserve_books_unlocked(Library *lib) {
     if (lib->book_count >= lib->book_capacity) {
         int new_cap = lib->book_capacity ? lib->book_capacity * 2 : 2;
-        Book *tmp = realloc(lib->books, new_cap * sizeof(Book));
 
-        if (!tmp) {
-            LOG_ERROR(REALLOCATION_ERROR);
+        if (lb_resize_books(lib, new_cap) != 0) {
             return 1;
         }
 
-        lib->books = tmp;
-        lib->book_capacity = new_cap;
-        LOG_INFO("Capacity Expanded - Books");
+        LOG_DEBUG("Capacity Expanded - Books");
     }
 
     return 0;
 }
 
-int lb_reserve_authors(Library *lib) {
+int lb_reserve_books(Library *lib) {
+    LibraryLock lock = lb_lock_all(lib);
+    int failed = lb_reserve_books_unlocked(lib);
+    lb_unlock(lib, lock);
+    return failed;
+}
+
+static int lb_reserve_authors_unlocked(Library *lib) {
     if (lib->author_count >= lib->author_capacity) {
         int new_cap = lib->author_capacity ? lib->author_capacity * 2 : 2;
-        Author *tmp = realloc(lib->authors,new_cap * sizeof(Author));
+        Author *tmp = realloc(lib->authors,(size_t)new_cap * sizeof(Author));
 
         if (!tmp) {
             LOG_ERROR(REALLOCATION_ERROR);
@@ -240,16 +2999,23 @@ int lb_reserve_authors(Library *lib) {
 
         lib->authors = tmp;
         lib->author_capacity = new_cap;
-        LOG_INFO("Capacity Expanded - Authors");
+        LOG_DEBUG("Capacity Expanded - Authors");
     }
 
     return 0;
 }
 
-int lb_reserve_genres(Library *lib) {
+int lb_reserve_authors(Library *lib) {
+    LibraryLock lock = lb_lock_tables(lib, LB_TABLE_AUTHORS);
+    int failed = lb_reserve_authors_unlocked(lib);
+    lb_unlock(lib, lock);
+    return failed;
+}
+
+static int lb_reserve_genres_unlocked(Library *lib) {
     if (lib->genre_count >= lib->genre_capacity) {
         int new_cap = lib->genre_capacity ? lib->genre_capacity * 2 : 2;
-        Genre *tmp = realloc(lib->genres,new_cap * sizeof(Genre));
+        Genre *tmp = realloc(lib->genres,(size_t)new_cap * sizeof(Genre));
 
         if (!tmp) {
             LOG_ERROR(REALLOCATION_ERROR);
@@ -258,10 +3024,17 @@ int lb_reserve_genres(Library *lib) {
 
         lib->genres = tmp;
         lib->genre_capacity = new_cap;
-        LOG_INFO("Capacity Expanded - Genre");
+        LOG_DEBUG("Capacity Expanded - Genre");
     }
 
     return 0;
 }
 
+int lb_reserve_genres(Library *lib) {
+    LibraryLock lock = lb_lock_tables(lib, LB_TABLE_GENRES);
+    int failed = lb_reserve_genres_unlocked(lib);
+    lb_unlock(lib, lock);
+    return failed;
+}
+
 
@@ -0,0 +1,219 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "postings.h"
+#include "log.h"
+
+// First position whose id is not lower than book_id
+static int postings_lower_bound(const PostingList *list, int book_id) {
+    int low = 0;
+    int high = list->count;
+
+    while (low < high) {
+        int mid = low + (high - low) / 2;
+
+        if (list->ids[mid] < book_id) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    return low;
+}
+
+static int postings_reserve_keys(Postings *postings, int key) {
+    if (key <= postings->list_count) {
+        return 0;
+    }
+
+    int new_count = postings->list_count ? postings->list_count : 8;
+    while (new_count < key) {
+        new_count *= 2;
+    }
+
+    PostingList *tmp = realloc(postings->lists, (size_t)new_count * sizeof(PostingList));
+    if (!tmp) {
+        LOG_ERROR(REALLOCATION_ERROR);
+        return 1;
+    }
+
+    memset(&tmp[postings->list_count], 0, (size_t)(new_count - postings->list_count) * sizeof(PostingList));
+    postings->lists = tmp;
+    postings->list_count = new_count;
+
+    return 0;
+}
+
+static int postings_reserve_ids(PostingList *list) {
+    if (list->count < list->capacity) {
+        return 0;
+    }
+
+    int new_cap = list->capacity ? list->capacity * 2 : 4;
+    int *tmp = realloc(list->ids, (size_t)new_cap * sizeof(int));
+
+    if (!tmp) {
+        LOG_ERROR(REALLOCATION_ERROR);
+        return 1;
+    }
+
+    list->ids = tmp;
+    list->capacity = new_cap;
+    return 0;
+}
+
+int postings_init(Postings *postings) {
+    if (!postings) {
+        LOG_ERROR(NULL_ERROR);
+        return 1;
+    }
+
+    memset(postings, 0, sizeof(*postings));
+    return 0;
+}
+
+void postings_free(Postings *postings) {
+    if (!postings) {
+        return;
+    }
+
+    for (int i = 0; i < postings->list_count; i++) {
+        free(postings->lists[i].ids);
+    }
+
+    free(postings->lists);
+    memset(postings, 0, sizeof(*postings));
+}
+
+void postings_clear(Postings *postings) {
+    if (!postings) {
+        return;
+    }
+
+    for (int i = 0; i < postings->list_count; i++) {
+        postings->lists[i].count = 0;
+    }
+}
+
+int postings_add(Postings *postings, int key, int book_id) {
+    if (!postings) {
+        LOG_ERROR(NULL_ERROR);
+        return 1;
+    }
+
+    if (key <= 0) {
+        LOG_ERROR("Unsupported Postings Key - %d", key);
+        return 1;
+    }
+
+    if (postings_reserve_keys(postings, key) != 0) {
+        return 1;
+    }
+
+    PostingList *list = &postings->lists[key - 1];
+    if (postings_reserve_ids(list) != 0) {
+        return 1;
+    }
+
+    // Books mostly arrive in id order, so this is usually an append
+    int pos = list->count;
+    if (pos > 0 && list->ids[pos - 1] > book_id) {
+        pos = postings_lower_bound(list, book_id);
+        memmove(&list->ids[pos + 1], &list->ids[pos], (size_t)(list->count - pos) * sizeof(int));
+    }
+
+    list->ids[pos] = book_id;
+    list->count++;
+
+    return 0;
+}
+
+int postings_remove(Postings *postings, int key, int book_id) {
+    if (!postings) {
+        LOG_ERROR(NULL_ERROR);
+        return 1;
+    }
+
+    if (key <= 0 || key > postings->list_count) {
+        return 1;
+    }
+
+    PostingList *list = &postings->lists[key - 1];
+    int pos = postings_lower_bound(list, book_id);
+
+    if (pos >= list->count || list->ids[pos] != book_id) {
+        return 1;
+    }
+
+    memmove(&list->ids[pos], &list->ids[pos + 1], (size_t)(list->count - pos - 1) * sizeof(int));
+    list->count--;
+
+    return 0;
+}
+
+const int *postings_get(const Postings *postings, int key, int *count) {
+    if (!postings || !count) {
+        LOG_ERROR(NULL_ERROR);
+        return NULL;
+    }
+
+    *count = 0;
+
+    if (key <= 0 || key > postings->list_count || postings->lists[key - 1].count == 0) {
+        return NULL;
+    }
+
+    *count = postings->lists[key - 1].count;
+    return postings->lists[key - 1].ids;
+}
+
+int postings_load(Postings *postings, const int *offsets, const int *ids, int list_count) {
+    if (!postings || (list_count > 0 && (!offsets || !ids))) {
+        LOG_ERROR(NULL_ERROR);
+        return 1;
+    }
+
+    Postings loaded;
+    postings_init(&loaded);
+
+    if (list_count > 0) {
+        loaded.lists = calloc((size_t)list_count, sizeof(PostingList));
+        if (!loaded.lists) {
+            LOG_ERROR(ALLOCATION_ERROR);
+            return 1;
+        }
+        loaded.list_count = list_count;
+    }
+
+    for (int i = 0; i < list_count; i++) {
+        int count = offsets[i + 1] - offsets[i];
+
+        if (offsets[i] < 0 || count < 0) {
+            LOG_ERROR("Invalid Saved Postings");
+            postings_free(&loaded);
+            return 1;
+        }
+
+        if (count == 0) {
+            continue;
+        }
+
+        PostingList *list = &loaded.lists[i];
+        list->ids = malloc((size_t)count * sizeof(int));
+        if (!list->ids) {
+            LOG_ERROR(ALLOCATION_ERROR);
+            postings_free(&loaded);
+            return 1;
+        }
+
+        memcpy(list->ids, ids + offsets[i], (size_t)count * sizeof(int));
+        list->count = count;
+        list->capacity = count;
+    }
+
+    postings_free(postings);
+    *postings = loaded;
+    return 0;
+}
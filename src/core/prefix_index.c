@@ -0,0 +1,237 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "prefix_index.h"
+#include "log.h"
+
+// Key and value pair, only used while sorting
+typedef struct {
+    const char *key;
+    int value;
+} PrefixEntry;
+
+// Ties keep value order so results are stable
+static int prefix_order(const char *key_a, int value_a, const char *key_b, int value_b) {
+    int cmp = prefix_compare(key_a, key_b);
+    return cmp ? cmp : (value_a > value_b) - (value_a < value_b);
+}
+
+static int prefix_entry_compare(const void *a, const void *b) {
+    const PrefixEntry *x = a;
+    const PrefixEntry *y = b;
+    return prefix_order(x->key, x->value, y->key, y->value);
+}
+
+// First position whose entry does not sort before (key, value)
+static int prefix_index_position(const PrefixIndex *index, const void *ctx, const char *key, int value) {
+    int low = 0;
+    int high = index->count;
+
+    while (low < high) {
+        int mid = low + (high - low) / 2;
+        int other = index->values[mid];
+
+        if (prefix_order(index->key_of(ctx, other), other, key, value) < 0) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    return low;
+}
+
+int prefix_compare(const char *a, const char *b) {
+    const unsigned char *x = (const unsigned char *)a;
+    const unsigned char *y = (const unsigned char *)b;
+
+    while (*x && tolower(*x) == tolower(*y)) {
+        x++;
+        y++;
+    }
+
+    return tolower(*x) - tolower(*y);
+}
+
+int prefix_index_init(PrefixIndex *index, PrefixKeyFn key_of) {
+    if (!index || !key_of) {
+        LOG_ERROR(NULL_ERROR);
+        return 1;
+    }
+
+    memset(index, 0, sizeof(*index));
+    index->dirty = 1;
+    index->key_of = key_of;
+    return 0;
+}
+
+void prefix_index_free(PrefixIndex *index) {
+    if (!index) {
+        return;
+    }
+
+    PrefixKeyFn key_of = index->key_of;
+
+    free(index->values);
+    memset(index, 0, sizeof(*index));
+    index->dirty = 1;
+    index->key_of = key_of;
+}
+
+void prefix_index_invalidate(PrefixIndex *index) {
+    if (index) {
+        __atomic_store_n(&index->dirty, 1, __ATOMIC_RELEASE);
+    }
+}
+
+static int prefix_index_reserve(PrefixIndex *index, int count) {
+    if (count <= index->capacity) {
+        return 0;
+    }
+
+    int capacity = index->capacity > 0 ? index->capacity : 16;
+    while (capacity < count) {
+        capacity *= 2;
+    }
+
+    int *tmp = realloc(index->values, (size_t)capacity * sizeof(int));
+
+    if (!tmp) {
+        LOG_ERROR(REALLOCATION_ERROR);
+        return 1;
+    }
+
+    index->values = tmp;
+    index->capacity = capacity;
+    return 0;
+}
+
+int prefix_index_build(PrefixIndex *index, const void *ctx, const int *values, int count) {
+    if (!index || !index->key_of) {
+        LOG_ERROR(NULL_ERROR);
+        return 1;
+    }
+
+    if (prefix_index_reserve(index, count) != 0) {
+        return 1;
+    }
+
+    // Sorted with their keys, only the values are kept
+    PrefixEntry *entries = NULL;
+    if (count > 0) {
+        entries = malloc((size_t)count * sizeof(PrefixEntry));
+
+        if (!entries) {
+            LOG_ERROR(ALLOCATION_ERROR);
+            return 1;
+        }
+    }
+
+    for (int i = 0; i < count; i++) {
+        entries[i].value = values ? values[i] : i;
+        entries[i].key = index->key_of(ctx, entries[i].value);
+    }
+
+    if (count > 0) {
+        qsort(entries, (size_t)count, sizeof(PrefixEntry), prefix_entry_compare);
+    }
+
+    for (int i = 0; i < count; i++) {
+        index->values[i] = entries[i].value;
+    }
+
+    free(entries);
+    index->count = count;
+
+    // Readers of a concurrent library check dirty before taking a lock
+    __atomic_store_n(&index->dirty, 0, __ATOMIC_RELEASE);
+
+    return 0;
+}
+
+int prefix_index_insert(PrefixIndex *index, const void *ctx, int value) {
+    if (!index || !index->key_of) {
+        LOG_ERROR(NULL_ERROR);
+        return 1;
+    }
+
+    // A stale index takes the value with the rest on its rebuild
+    if (index->dirty) {
+        return 0;
+    }
+
+    if (prefix_index_reserve(index, index->count + 1) != 0) {
+        return 1;
+    }
+
+    int pos = prefix_index_position(index, ctx, index->key_of(ctx, value), value);
+    memmove(&index->values[pos + 1], &index->values[pos], (size_t)(index->count - pos) * sizeof(int));
+    index->values[pos] = value;
+    index->count++;
+    return 0;
+}
+
+int prefix_index_remove(PrefixIndex *index, const void *ctx, int value) {
+    if (!index || !index->key_of) {
+        LOG_ERROR(NULL_ERROR);
+        return 1;
+    }
+
+    if (index->dirty) {
+        return 0;
+    }
+
+    int pos = prefix_index_position(index, ctx, index->key_of(ctx, value), value);
+    if (pos >= index->count || index->values[pos] != value) {
+        LOG_ERROR("Prefix Entry not Found - %d", value);
+        return 1;
+    }
+
+    index->count--;
+    memmove(&index->values[pos], &index->values[pos + 1], (size_t)(index->count - pos) * sizeof(int));
+    return 0;
+}
+
+int prefix_index_find(const PrefixIndex *index, const void *ctx, const char *prefix) {
+    if (!index || !prefix) {
+        LOG_ERROR(NULL_ERROR);
+        return 0;
+    }
+
+    int low = 0;
+    int high = index->count;
+
+    while (low < high) {
+        int mid = low + (high - low) / 2;
+
+        if (prefix_compare(index->key_of(ctx, index->values[mid]), prefix) < 0) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    return low;
+}
+
+int prefix_index_matches(const PrefixIndex *index, const void *ctx, int pos, const char *prefix) {
+    if (pos < 0 || pos >= index->count) {
+        return 0;
+    }
+
+    const unsigned char *key = (const unsigned char *)index->key_of(ctx, index->values[pos]);
+    const unsigned char *p = (const unsigned char *)prefix;
+
+    while (*p && tolower(*key) == tolower(*p)) {
+        key++;
+        p++;
+    }
+
+    return *p == '\0';
+}
+
+const char *prefix_index_key(const PrefixIndex *index, const void *ctx, int pos) {
+    return index->key_of(ctx, index->values[pos]);
+}
@@ -0,0 +1,138 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "string_arena.h"
+#include "log.h"
+
+static int string_arena_add_block(StringArena *arena, size_t size) {
+    if (arena->block_count >= arena->block_capacity) {
+        int new_cap = arena->block_capacity ? arena->block_capacity * 2 : 4;
+        ArenaBlock *tmp = realloc(arena->blocks, (size_t)new_cap * sizeof(ArenaBlock));
+
+        if (!tmp) {
+            LOG_ERROR(REALLOCATION_ERROR);
+            return 1;
+        }
+
+        arena->blocks = tmp;
+        arena->block_capacity = new_cap;
+    }
+
+    char *data = malloc(size);
+    if (!data) {
+        LOG_ERROR(ALLOCATION_ERROR);
+        return 1;
+    }
+
+    ArenaBlock *block = &arena->blocks[arena->block_count];
+    block->data = data;
+    block->size = size;
+    block->used = 0;
+    arena->block_count++;
+
+    return 0;
+}
+
+int string_arena_init(StringArena *arena) {
+    if (!arena) {
+        LOG_ERROR(NULL_ERROR);
+        return 1;
+    }
+
+    memset(arena, 0, sizeof(*arena));
+    return 0;
+}
+
+void string_arena_free(StringArena *arena) {
+    if (!arena) {
+        return;
+    }
+
+    for (int i = 0; i < arena->block_count; i++) {
+        free(arena->blocks[i].data);
+    }
+
+    free(arena->blocks);
+    memset(arena, 0, sizeof(*arena));
+}
+
+void string_arena_clear(StringArena *arena) {
+    if (!arena) {
+        return;
+    }
+
+    for (int i = 1; i < arena->block_count; i++) {
+        free(arena->blocks[i].data);
+    }
+
+    if (arena->block_count > 0) {
+        arena->blocks[0].used = 0;
+        arena->block_count = 1;
+    }
+
+    arena->bytes_used = 0;
+    arena->bytes_live = 0;
+}
+
+int string_arena_reserve(StringArena *arena, size_t bytes) {
+    if (!arena) {
+        LOG_ERROR(NULL_ERROR);
+        return 1;
+    }
+
+    ArenaBlock *block = arena->block_count ? &arena->blocks[arena->block_count - 1] : NULL;
+    if (block && block->size - block->used >= bytes) {
+        return 0;
+    }
+
+    size_t size = bytes > STRING_ARENA_BLOCK_SIZE ? bytes : STRING_ARENA_BLOCK_SIZE;
+    return string_arena_add_block(arena, size);
+}
+
+char *string_arena_append(StringArena *arena, const char *str, size_t length) {
+    if (!arena || !str) {
+        LOG_ERROR(NULL_ERROR);
+        return NULL;
+    }
+
+    size_t needed = length + 1;
+    ArenaBlock *block = arena->block_count ? &arena->blocks[arena->block_count - 1] : NULL;
+
+    if (!block || block->size - block->used < needed) {
+        size_t size = needed > STRING_ARENA_BLOCK_SIZE ? needed : STRING_ARENA_BLOCK_SIZE;
+
+        if (string_arena_add_block(arena, size) != 0) {
+            return NULL;
+        }
+
+        block = &arena->blocks[arena->block_count - 1];
+    }
+
+    char *dest = block->data + block->used;
+    memcpy(dest, str, length);
+    dest[length] = '\0';
+
+    block->used += needed;
+    arena->bytes_used += needed;
+    arena->bytes_live += needed;
+
+    return dest;
+}
+
+void string_arena_release(StringArena *arena, size_t length) {
+    if (!arena) {
+        return;
+    }
+
+    size_t bytes = length + 1;
+    arena->bytes_live = arena->bytes_live > bytes ? arena->bytes_live - bytes : 0;
+}
+
+size_t string_arena_garbage(const StringArena *arena) {
+    if (!arena) {
+        return 0;
+    }
+
+    return arena->bytes_used - arena->bytes_live;
+}
@@ -0,0 +1,249 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "trigram_index.h"
+#include "log.h"
+
+// Multiplicative hash of the 3 bytes, top 16 bits select the bucket
+static int trigram_key(const unsigned char *text) {
+    unsigned int code = ((unsigned int)text[0] << 16) | ((unsigned int)text[1] << 8) | text[2];
+    return (int)((code * 2654435761u) >> 16) + 1;
+}
+
+static int trigram_compare(const void *a, const void *b) {
+    int x = *(const int *)a;
+    int y = *(const int *)b;
+    return (x > y) - (x < y);
+}
+
+static int trigram_reserve(int **buffer, int *capacity, int count) {
+    if (count <= *capacity) {
+        return 0;
+    }
+
+    int new_cap = *capacity ? *capacity : 64;
+    while (new_cap < count) {
+        new_cap *= 2;
+    }
+
+    int *tmp = realloc(*buffer, (size_t)new_cap * sizeof(int));
+    if (!tmp) {
+        LOG_ERROR(REALLOCATION_ERROR);
+        return 1;
+    }
+
+    *buffer = tmp;
+    *capacity = new_cap;
+    return 0;
+}
+
+// Fill scratch->keys with the distinct buckets of the texts
+static int trigram_collect(TrigramScratch *scratch, const char *const *texts, int text_count, int *key_count) {
+    size_t total = 0;
+    *key_count = 0;
+
+    for (int i = 0; i < text_count; i++) {
+        size_t length = texts[i] ? strlen(texts[i]) : 0;
+        total += length >= 3 ? length - 2 : 0;
+    }
+
+    if (total == 0) {
+        return 0;
+    }
+
+    if (total > (size_t)(~0u >> 1) || trigram_reserve(&scratch->keys, &scratch->key_capacity, (int)total) != 0) {
+        return 1;
+    }
+
+    int count = 0;
+    for (int i = 0; i < text_count; i++) {
+        if (!texts[i]) {
+            continue;
+        }
+
+        const unsigned char *text = (const unsigned char *)texts[i];
+        for (; text[0] && text[1] && text[2]; text++) {
+            scratch->keys[count++] = trigram_key(text);
+        }
+    }
+
+    qsort(scratch->keys, (size_t)count, sizeof(int), trigram_compare);
+
+    int unique = 0;
+    for (int i = 0; i < count; i++) {
+        if (unique == 0 || scratch->keys[unique - 1] != scratch->keys[i]) {
+            scratch->keys[unique++] = scratch->keys[i];
+        }
+    }
+
+    *key_count = unique;
+    return 0;
+}
+
+// First position in [from, count) whose value is not lower than value
+static int trigram_lower_bound(const int *values, int from, int count, int value) {
+    int low = from;
+    int high = count;
+
+    while (low < high) {
+        int mid = low + (high - low) / 2;
+
+        if (values[mid] < value) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    return low;
+}
+
+int trigram_index_init(TrigramIndex *index) {
+    if (!index) {
+        LOG_ERROR(NULL_ERROR);
+        return 1;
+    }
+
+    memset(index, 0, sizeof(*index));
+    return postings_init(&index->postings);
+}
+
+void trigram_index_free(TrigramIndex *index) {
+    if (!index) {
+        return;
+    }
+
+    postings_free(&index->postings);
+    trigram_scratch_free(&index->scratch);
+    memset(index, 0, sizeof(*index));
+}
+
+void trigram_index_clear(TrigramIndex *index) {
+    if (!index) {
+        return;
+    }
+
+    postings_clear(&index->postings);
+}
+
+int trigram_index_add(TrigramIndex *index, int value, const char *const *texts, int text_count) {
+    if (!index || !texts) {
+        LOG_ERROR(NULL_ERROR);
+        return 1;
+    }
+
+    int key_count;
+    if (trigram_collect(&index->scratch, texts, text_count, &key_count) != 0) {
+        return 1;
+    }
+
+    for (int i = 0; i < key_count; i++) {
+        if (postings_add(&index->postings, index->scratch.keys[i], value) != 0) {
+            for (int j = 0; j < i; j++) {
+                postings_remove(&index->postings, index->scratch.keys[j], value);
+            }
+
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+void trigram_index_remove(TrigramIndex *index, int value, const char *const *texts, int text_count) {
+    if (!index || !texts) {
+        LOG_ERROR(NULL_ERROR);
+        return;
+    }
+
+    int key_count;
+    if (trigram_collect(&index->scratch, texts, text_count, &key_count) != 0) {
+        LOG_ERROR("Trigram Remove Failed - %d", value);
+        return;
+    }
+
+    for (int i = 0; i < key_count; i++) {
+        postings_remove(&index->postings, index->scratch.keys[i], value);
+    }
+}
+
+const int *trigram_index_query(TrigramIndex *index, const char *term, int *count) {
+    if (!index) {
+        LOG_ERROR(NULL_ERROR);
+        return NULL;
+    }
+
+    return trigram_index_query_with(index, &index->scratch, term, count);
+}
+
+const int *trigram_index_query_with(const TrigramIndex *index, TrigramScratch *scratch, const char *term, int *count) {
+    if (!index || !scratch || !term || !count) {
+        LOG_ERROR(NULL_ERROR);
+        return NULL;
+    }
+
+    *count = 0;
+
+    int key_count;
+    if (trigram_collect(scratch, &term, 1, &key_count) != 0 || key_count == 0) {
+        return NULL;
+    }
+
+    // Start from the shortest list, each other list can only shrink it
+    int shortest = -1;
+    int shortest_count = 0;
+    for (int i = 0; i < key_count; i++) {
+        int list_count;
+        if (!postings_get(&index->postings, scratch->keys[i], &list_count)) {
+            return NULL;
+        }
+
+        if (shortest < 0 || list_count < shortest_count) {
+            shortest = i;
+            shortest_count = list_count;
+        }
+    }
+
+    if (trigram_reserve(&scratch->matches, &scratch->match_capacity, shortest_count) != 0) {
+        return NULL;
+    }
+
+    const int *values = postings_get(&index->postings, scratch->keys[shortest], &shortest_count);
+    memcpy(scratch->matches, values, (size_t)shortest_count * sizeof(int));
+    int matches = shortest_count;
+
+    for (int i = 0; i < key_count && matches > 0; i++) {
+        if (i == shortest) {
+            continue;
+        }
+
+        int list_count;
+        const int *list = postings_get(&index->postings, scratch->keys[i], &list_count);
+        int kept = 0;
+        int pos = 0;
+
+        for (int m = 0; m < matches && pos < list_count; m++) {
+            pos = trigram_lower_bound(list, pos, list_count, scratch->matches[m]);
+
+            if (pos < list_count && list[pos] == scratch->matches[m]) {
+                scratch->matches[kept++] = scratch->matches[m];
+            }
+        }
+
+        matches = kept;
+    }
+
+    *count = matches;
+    return matches > 0 ? scratch->matches : NULL;
+}
+
+void trigram_scratch_free(TrigramScratch *scratch) {
+    if (!scratch) {
+        return;
+    }
+
+    free(scratch->keys);
+    free(scratch->matches);
+    memset(scratch, 0, sizeof(*scratch));
+}
@@ -0,0 +1,1178 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "btree.h"
+#include "log.h"
+
+#define BTREE_LEAF 1
+#define BTREE_INTERNAL 2
+
+#define BTREE_NODE_HEADER 12
+#define BTREE_LEAF_CELL_HEADER 4
+#define BTREE_INTERNAL_CELL_HEADER 5
+
+// Values above this go to overflow pages, so a node always holds a few cells
+#define BTREE_MAX_INLINE (PAGER_PAGE_SIZE / 4)
+#define BTREE_MAX_CELL (BTREE_LEAF_CELL_HEADER + BTREE_MAX_KEY + BTREE_MAX_INLINE)
+#define BTREE_MAX_CELLS (PAGER_PAGE_SIZE / 6 + 1)
+
+#define BTREE_OVERFLOW_HEADER 8
+#define BTREE_OVERFLOW_DATA (PAGER_PAGE_SIZE - BTREE_OVERFLOW_HEADER)
+
+// Book values: i32 id | i32 year | u16 title size | u16 author count |
+// u16 genre count | u16 flags | u32 description size, then the title,
+// author ids, genre ids and description
+#define BTREE_BOOK_HEADER 20
+#define BTREE_BOOK_DESCRIPTION 1u
+
+// Encoding
+
+static uint16_t btree_u16(const char *p) {
+    uint16_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static uint32_t btree_u32(const char *p) {
+    uint32_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static void btree_put_u16(char *p, size_t value) {
+    uint16_t stored = (uint16_t)value;
+    memcpy(p, &stored, sizeof(stored));
+}
+
+static void btree_put_u32(char *p, uint32_t value) {
+    memcpy(p, &value, sizeof(value));
+}
+
+// Nodes
+
+static int node_type(const char *node) {
+    return (unsigned char)node[0];
+}
+
+static int node_count(const char *node) {
+    return btree_u16(node + 2);
+}
+
+static int node_content(const char *node) {
+    return btree_u16(node + 4);
+}
+
+static int node_fragments(const char *node) {
+    return btree_u16(node + 6);
+}
+
+static uint32_t node_link(const char *node) {
+    return btree_u32(node + 8);
+}
+
+static char *node_cell(const char *node, int index) {
+    return (char *)node + btree_u16(node + BTREE_NODE_HEADER + 2 * index);
+}
+
+static void node_init(char *node, int type, uint32_t link) {
+    memset(node, 0, BTREE_NODE_HEADER);
+    node[0] = (char)type;
+    btree_put_u16(node + 4, PAGER_PAGE_SIZE);
+    btree_put_u32(node + 8, link);
+}
+
+static const char *cell_key(const char *node, const char *cell, size_t *length) {
+    *length = (unsigned char)cell[0];
+    return cell + (node_type(node) == BTREE_LEAF ? BTREE_LEAF_CELL_HEADER : BTREE_INTERNAL_CELL_HEADER);
+}
+
+static size_t cell_size(const char *node, const char *cell) {
+    size_t key_size = (unsigned char)cell[0];
+
+    if (node_type(node) == BTREE_LEAF) {
+        return BTREE_LEAF_CELL_HEADER + key_size + btree_u16(cell + 2);
+    }
+
+    return BTREE_INTERNAL_CELL_HEADER + key_size;
+}
+
+static uint32_t cell_child(const char *cell) {
+    return btree_u32(cell + 1);
+}
+
+static int key_compare(const char *a, size_t a_size, const char *b, size_t b_size) {
+    int order = memcmp(a, b, a_size < b_size ? a_size : b_size);
+    if (order != 0) {
+        return order;
+    }
+
+    return (a_size > b_size) - (a_size < b_size);
+}
+
+// First cell whose key is >= key
+static int node_search(const char *node, const char *key, size_t key_size, int *found) {
+    int low = 0;
+    int high = node_count(node);
+    *found = 0;
+
+    while (low < high) {
+        int mid = (low + high) / 2;
+        size_t mid_size;
+        const char *mid_key = cell_key(node, node_cell(node, mid), &mid_size);
+        int order = key_compare(mid_key, mid_size, key, key_size);
+
+        if (order < 0) {
+            low = mid + 1;
+        } else {
+            *found |= order == 0;
+            high = mid;
+        }
+    }
+
+    return low;
+}
+
+// Child of an internal node that holds key
+static uint32_t node_route(const char *node, const char *key, size_t key_size) {
+    int found;
+    int index = node_search(node, key, key_size, &found);
+
+    if (found) {
+        return cell_child(node_cell(node, index));
+    }
+
+    return index == 0 ? node_link(node) : cell_child(node_cell(node, index - 1));
+}
+
+// Pack the cells at the end of the page, dropping the space of removed ones
+static void node_compact(char *node) {
+    char copy[PAGER_PAGE_SIZE];
+    memcpy(copy, node, PAGER_PAGE_SIZE);
+
+    int content = PAGER_PAGE_SIZE;
+    for (int i = 0; i < node_count(copy); i++) {
+        const char *cell = node_cell(copy, i);
+        size_t size = cell_size(copy, cell);
+
+        content -= (int)size;
+        memcpy(node + content, cell, size);
+        btree_put_u16(node + BTREE_NODE_HEADER + 2 * i, (size_t)content);
+    }
+
+    btree_put_u16(node + 4, (size_t)content);
+    btree_put_u16(node + 6, 0);
+}
+
+// Insert a cell at index, 1 if the page has no room for it
+static int node_insert(char *node, int index, const char *cell, size_t size) {
+    int count = node_count(node);
+    int free_space = node_content(node) - (BTREE_NODE_HEADER + 2 * count);
+
+    if (free_space < (int)size + 2) {
+        if (free_space + node_fragments(node) < (int)size + 2) {
+            return 1;
+        }
+
+        node_compact(node);
+    }
+
+    int content = node_content(node) - (int)size;
+    memcpy(node + content, cell, size);
+
+    char *slots = node + BTREE_NODE_HEADER;
+    memmove(slots + 2 * (index + 1), slots + 2 * index, 2 * (size_t)(count - index));
+    btree_put_u16(slots + 2 * index, (size_t)content);
+
+    btree_put_u16(node + 2, (size_t)count + 1);
+    btree_put_u16(node + 4, (size_t)content);
+    return 0;
+}
+
+static void node_remove(char *node, int index) {
+    int count = node_count(node);
+    size_t size = cell_size(node, node_cell(node, index));
+
+    char *slots = node + BTREE_NODE_HEADER;
+    memmove(slots + 2 * index, slots + 2 * (index + 1), 2 * (size_t)(count - index - 1));
+    btree_put_u16(node + 2, (size_t)count - 1);
+
+    if (count == 1) {
+        btree_put_u16(node + 4, PAGER_PAGE_SIZE);
+        btree_put_u16(node + 6, 0);
+    } else {
+        btree_put_u16(node + 6, (size_t)node_fragments(node) + size);
+    }
+}
+
+// Pages
+
+static char *btree_new_page(BTree *tree, uint32_t *page) {
+    if (tree->meta.free_page == 0) {
+        return pager_allocate(&tree->pager, page);
+    }
+
+    *page = tree->meta.free_page;
+    char *data = pager_get(&tree->pager, *page);
+    if (!data) {
+        return NULL;
+    }
+
+    tree->meta.free_page = btree_u32(data);
+    tree->meta_dirty = 1;
+    memset(data, 0, PAGER_PAGE_SIZE);
+    return data;
+}
+
+static int btree_free_page(BTree *tree, uint32_t page) {
+    char *data = pager_get(&tree->pager, page);
+    if (!data) {
+        return 1;
+    }
+
+    btree_put_u32(data, tree->meta.free_page);
+    pager_release(&tree->pager, data, 1);
+
+    tree->meta.free_page = page;
+    tree->meta_dirty = 1;
+    return 0;
+}
+
+// Overflow chains
+
+static int btree_write_overflow(BTree *tree, const char *value, size_t size, uint32_t *first) {
+    char *previous = NULL;
+    *first = 0;
+
+    while (size > 0) {
+        uint32_t page;
+        char *data = btree_new_page(tree, &page);
+        if (!data) {
+            pager_release(&tree->pager, previous, 1);
+            return 1;
+        }
+
+        size_t part = size < BTREE_OVERFLOW_DATA ? size : BTREE_OVERFLOW_DATA;
+        btree_put_u32(data, 0);
+        btree_put_u32(data + 4, (uint32_t)part);
+        memcpy(data + BTREE_OVERFLOW_HEADER, value, part);
+
+        if (previous) {
+            btree_put_u32(previous, page);
+            pager_release(&tree->pager, previous, 1);
+        } else {
+            *first = page;
+        }
+
+        previous = data;
+        value += part;
+        size -= part;
+    }
+
+    pager_release(&tree->pager, previous, 1);
+    return 0;
+}
+
+static int btree_free_overflow(BTree *tree, uint32_t page) {
+    while (page != 0) {
+        char *data = pager_get(&tree->pager, page);
+        if (!data) {
+            return 1;
+        }
+
+        uint32_t next = btree_u32(data);
+        pager_release(&tree->pager, data, 0);
+
+        if (btree_free_page(tree, page) != 0) {
+            return 1;
+        }
+
+        page = next;
+    }
+
+    return 0;
+}
+
+static int btree_reserve_value(BTree *tree, size_t size) {
+    if (size <= tree->value_capacity) {
+        return 0;
+    }
+
+    size_t new_cap = tree->value_capacity ? tree->value_capacity : 1024;
+    while (new_cap < size) {
+        new_cap *= 2;
+    }
+
+    char *tmp = realloc(tree->value, new_cap);
+    if (!tmp) {
+        LOG_ERROR(REALLOCATION_ERROR);
+        return 1;
+    }
+
+    tree->value = tmp;
+    tree->value_capacity = new_cap;
+    return 0;
+}
+
+// Value of a leaf cell: inline values are returned in place unless copy
+// is set, overflow values are always gathered into tree->value
+static int btree_read_value(BTree *tree, const char *cell, int copy, const void **value, size_t *size) {
+    const char *local = cell + BTREE_LEAF_CELL_HEADER + (unsigned char)cell[0];
+
+    if (!((unsigned char)cell[1] & BTREE_CELL_OVERFLOW)) {
+        *size = btree_u16(cell + 2);
+
+        if (!copy) {
+            *value = local;
+            return 0;
+        }
+
+        if (btree_reserve_value(tree, *size) != 0) {
+            return 1;
+        }
+
+        memcpy(tree->value, local, *size);
+        *value = tree->value;
+        return 0;
+    }
+
+    *size = btree_u32(local);
+    if (btree_reserve_value(tree, *size) != 0) {
+        return 1;
+    }
+
+    size_t done = 0;
+    uint32_t page = btree_u32(local + 4);
+
+    while (page != 0 && done < *size) {
+        char *data = pager_get(&tree->pager, page);
+        if (!data) {
+            return 1;
+        }
+
+        size_t part = btree_u32(data + 4);
+        if (part > *size - done) {
+            part = *size - done;
+        }
+
+        memcpy(tree->value + done, data + BTREE_OVERFLOW_HEADER, part);
+        done += part;
+        page = btree_u32(data);
+        pager_release(&tree->pager, data, 0);
+    }
+
+    if (done != *size) {
+        LOG_ERROR("Broken Overflow Chain");
+        return 1;
+    }
+
+    *value = tree->value;
+    return 0;
+}
+
+static uint32_t btree_overflow_page(const char *cell) {
+    if (!((unsigned char)cell[1] & BTREE_CELL_OVERFLOW)) {
+        return 0;
+    }
+
+    return btree_u32(cell + BTREE_LEAF_CELL_HEADER + (unsigned char)cell[0] + 4);
+}
+
+// Descent
+
+// Leaf holding key, with the internal nodes on the way in path
+static uint32_t btree_find_leaf(BTree *tree, const char *key, size_t key_size, uint32_t *path) {
+    uint32_t page = tree->meta.root;
+
+    for (uint32_t level = 0; level + 1 < tree->meta.depth; level++) {
+        char *node = pager_get(&tree->pager, page);
+        if (!node) {
+            return 0;
+        }
+
+        path[level] = page;
+        uint32_t child = node_route(node, key, key_size);
+        pager_release(&tree->pager, node, 0);
+        page = child;
+    }
+
+    return page;
+}
+
+// Splits
+
+// Split a full node while inserting cell at index: the lower half stays in
+// the page, the upper half moves to a new right sibling. The separator is
+// the first key of the right node (a leaf keeps it, an internal node moves
+// it up and takes its child as the new leftmost link).
+static int btree_split(BTree *tree, char *node, int index, const char *cell, size_t size,
+                       char *separator, size_t *separator_size, uint32_t *right_page) {
+    int type = node_type(node);
+    int count = node_count(node) + 1;
+    size_t offsets[BTREE_MAX_CELLS + 1];
+    size_t sizes[BTREE_MAX_CELLS + 1];
+    size_t total = 0;
+
+    for (int i = 0; i < count; i++) {
+        const char *source = i == index ? cell : node_cell(node, i < index ? i : i - 1);
+        sizes[i] = i == index ? size : cell_size(node, source);
+        offsets[i] = total;
+        memcpy(tree->split + total, source, sizes[i]);
+        total += sizes[i];
+    }
+
+    // Cut near the middle of the bytes, leaving a cell on each side
+    int cut = 1;
+    size_t left_bytes = sizes[0];
+    while (cut < count - 1 && left_bytes + sizes[cut] <= total / 2) {
+        left_bytes += sizes[cut];
+        cut++;
+    }
+
+    char *right = btree_new_page(tree, right_page);
+    if (!right) {
+        return 1;
+    }
+
+    const char *middle = tree->split + offsets[cut];
+    *separator_size = (unsigned char)middle[0];
+    memcpy(separator, cell_key(node, middle, separator_size), *separator_size);
+
+    int right_from = cut;
+    if (type == BTREE_LEAF) {
+        node_init(right, BTREE_LEAF, node_link(node));
+        node_init(node, BTREE_LEAF, *right_page);
+    } else {
+        node_init(right, BTREE_INTERNAL, cell_child(middle));
+        node_init(node, BTREE_INTERNAL, node_link(node));
+        right_from = cut + 1;
+    }
+
+    for (int i = 0; i < cut; i++) {
+        node_insert(node, i, tree->split + offsets[i], sizes[i]);
+    }
+
+    for (int i = right_from; i < count; i++) {
+        node_insert(right, i - right_from, tree->split + offsets[i], sizes[i]);
+    }
+
+    pager_release(&tree->pager, right, 1);
+    return 0;
+}
+
+static size_t btree_internal_cell(char *cell, const char *key, size_t key_size, uint32_t child) {
+    cell[0] = (char)key_size;
+    btree_put_u32(cell + 1, child);
+    memcpy(cell + BTREE_INTERNAL_CELL_HEADER, key, key_size);
+    return BTREE_INTERNAL_CELL_HEADER + key_size;
+}
+
+// Insert the separator of a split child into the nodes above it
+static int btree_insert_up(BTree *tree, const uint32_t *path, uint32_t left_page,
+                           char *separator, size_t separator_size, uint32_t right_page) {
+    char cell[BTREE_INTERNAL_CELL_HEADER + BTREE_MAX_KEY];
+
+    for (int level = (int)tree->meta.depth - 2; level >= 0; level--) {
+        char *node = pager_get(&tree->pager, path[level]);
+        if (!node) {
+            return 1;
+        }
+
+        size_t size = btree_internal_cell(cell, separator, separator_size, right_page);
+        int found;
+        int index = node_search(node, separator, separator_size, &found);
+
+        if (node_insert(node, index, cell, size) == 0) {
+            pager_release(&tree->pager, node, 1);
+            return 0;
+        }
+
+        int failed = btree_split(tree, node, index, cell, size, separator, &separator_size, &right_page);
+        pager_release(&tree->pager, node, 1);
+        if (failed) {
+            return 1;
+        }
+
+        left_page = path[level];
+    }
+
+    // The root was split: grow the tree by one level
+    if (tree->meta.depth >= BTREE_MAX_DEPTH) {
+        LOG_ERROR("B+Tree too Deep");
+        return 1;
+    }
+
+    uint32_t root_page;
+    char *root = btree_new_page(tree, &root_page);
+    if (!root) {
+        return 1;
+    }
+
+    node_init(root, BTREE_INTERNAL, left_page);
+    node_insert(root, 0, cell, btree_internal_cell(cell, separator, separator_size, right_page));
+    pager_release(&tree->pager, root, 1);
+
+    tree->meta.root = root_page;
+    tree->meta.depth++;
+    tree->meta_dirty = 1;
+    return 0;
+}
+
+// Open and close
+
+static int btree_write_meta(BTree *tree) {
+    char *data = pager_get(&tree->pager, 0);
+    if (!data) {
+        return 1;
+    }
+
+    memcpy(data, &tree->meta, sizeof(BTreeMeta));
+    pager_release(&tree->pager, data, 1);
+    tree->meta_dirty = 0;
+    return 0;
+}
+
+// Empty tree: the meta page and a leaf root
+static int btree_format(BTree *tree) {
+    uint32_t page;
+
+    if (pager_truncate(&tree->pager, 0) != 0) {
+        return 1;
+    }
+
+    char *meta = pager_allocate(&tree->pager, &page);
+    if (!meta) {
+        return 1;
+    }
+    pager_release(&tree->pager, meta, 1);
+
+    char *root = pager_allocate(&tree->pager, &page);
+    if (!root) {
+        return 1;
+    }
+    node_init(root, BTREE_LEAF, 0);
+    pager_release(&tree->pager, root, 1);
+
+    memset(&tree->meta, 0, sizeof(tree->meta));
+    memcpy(tree->meta.magic, BTREE_MAGIC, sizeof(tree->meta.magic));
+    tree->meta.version = BTREE_VERSION;
+    tree->meta.page_size = PAGER_PAGE_SIZE;
+    tree->meta.root = page;
+    tree->meta.depth = 1;
+
+    return btree_write_meta(tree);
+}
+
+static int btree_check_key(const char *key, size_t *key_size) {
+    if (!key) {
+        LOG_ERROR(NULL_ERROR);
+        return 1;
+    }
+
+    *key_size = strlen(key);
+    if (*key_size == 0 || *key_size > BTREE_MAX_KEY) {
+        LOG_ERROR("Invalid B+Tree Key - %s", key);
+        return 1;
+    }
+
+    return 0;
+}
+
+int btree_open(BTree *tree, const char *path, int frames) {
+    if (!tree || !path) {
+        LOG_ERROR(NULL_ERROR);
+        return 1;
+    }
+
+    memset(tree, 0, sizeof(*tree));
+
+    tree->split = malloc(2 * PAGER_PAGE_SIZE);
+    if (!tree->split) {
+        LOG_ERROR(ALLOCATION_ERROR);
+        return 1;
+    }
+
+    if (pager_open(&tree->pager, path, frames > 0 ? frames : BTREE_DEFAULT_FRAMES) != 0) {
+        free(tree->split);
+        return 1;
+    }
+
+    int failed = 0;
+
+    if (tree->pager.page_count == 0) {
+        failed = btree_format(tree);
+    } else {
+        char *data = pager_get(&tree->pager, 0);
+        failed = !data;
+
+        if (data) {
+            memcpy(&tree->meta, data, sizeof(BTreeMeta));
+            pager_release(&tree->pager, data, 0);
+
+            if (memcmp(tree->meta.magic, BTREE_MAGIC, sizeof(tree->meta.magic)) != 0 ||
+                tree->meta.version != BTREE_VERSION || tree->meta.page_size != PAGER_PAGE_SIZE ||
+                tree->meta.root == 0 || tree->meta.root >= tree->pager.page_count ||
+                tree->meta.depth == 0 || tree->meta.depth > BTREE_MAX_DEPTH) {
+                LOG_ERROR("Invalid B+Tree File - %s", path);
+                failed = 1;
+            }
+        }
+    }
+
+    if (failed) {
+        pager_close(&tree->pager);
+        free(tree->split);
+        return 1;
+    }
+
+    return 0;
+}
+
+int btree_flush(BTree *tree) {
+    if (!tree) {
+        LOG_ERROR(NULL_ERROR);
+        return 1;
+    }
+
+    if (tree->meta_dirty && btree_write_meta(tree) != 0) {
+        return 1;
+    }
+
+    return pager_flush(&tree->pager);
+}
+
+int btree_close(BTree *tree) {
+    if (!tree) {
+        LOG_ERROR(NULL_ERROR);
+        return 1;
+    }
+
+    int failed = tree->meta_dirty && btree_write_meta(tree) != 0;
+    failed |= pager_close(&tree->pager);
+
+    free(tree->value);
+    free(tree->split);
+    memset(tree, 0, sizeof(*tree));
+    return failed;
+}
+
+// Records
+
+int btree_put(BTree *tree, const char *key, const void *value, size_t size) {
+    if (!tree || (!value && size > 0)) {
+        LOG_ERROR(NULL_ERROR);
+        return 1;
+    }
+
+    size_t key_size;
+    if (btree_check_key(key, &key_size) != 0) {
+        return 1;
+    }
+
+    char cell[BTREE_MAX_CELL];
+    size_t cell_bytes = BTREE_LEAF_CELL_HEADER + key_size;
+    cell[0] = (char)key_size;
+    cell[1] = 0;
+    memcpy(cell + BTREE_LEAF_CELL_HEADER, key, key_size);
+
+    if (size > BTREE_MAX_INLINE) {
+        uint32_t first;
+        if (btree_write_overflow(tree, value, size, &first) != 0) {
+            return 1;
+        }
+
+        cell[1] = (char)BTREE_CELL_OVERFLOW;
+        btree_put_u16(cell + 2, 8);
+        btree_put_u32(cell + cell_bytes, (uint32_t)size);
+        btree_put_u32(cell + cell_bytes + 4, first);
+        cell_bytes += 8;
+    } else {
+        btree_put_u16(cell + 2, size);
+        if (size > 0) {
+            memcpy(cell + cell_bytes, value, size);
+        }
+        cell_bytes += size;
+    }
+
+    uint32_t path[BTREE_MAX_DEPTH];
+    uint32_t leaf_page = btree_find_leaf(tree, key, key_size, path);
+    char *leaf = leaf_page ? pager_get(&tree->pager, leaf_page) : NULL;
+    if (!leaf) {
+        btree_free_overflow(tree, btree_overflow_page(cell));
+        return 1;
+    }
+
+    int found;
+    int index = node_search(leaf, key, key_size, &found);
+    uint32_t old_overflow = 0;
+
+    if (found) {
+        old_overflow = btree_overflow_page(node_cell(leaf, index));
+        node_remove(leaf, index);
+    } else {
+        tree->meta.record_count++;
+        tree->meta_dirty = 1;
+    }
+
+    int failed = 0;
+
+    if (node_insert(leaf, index, cell, cell_bytes) != 0) {
+        char separator[BTREE_MAX_KEY];
+        size_t separator_size;
+        uint32_t right_page;
+
+        failed = btree_split(tree, leaf, index, cell, cell_bytes, separator, &separator_size, &right_page);
+        pager_release(&tree->pager, leaf, 1);
+
+        if (!failed) {
+            failed = btree_insert_up(tree, path, leaf_page, separator, separator_size, right_page);
+        }
+    } else {
+        pager_release(&tree->pager, leaf, 1);
+    }
+
+    if (old_overflow != 0 && btree_free_overflow(tree, old_overflow) != 0) {
+        failed = 1;
+    }
+
+    if (failed) {
+        LOG_ERROR("B+Tree Insert Failed - %s", key);
+    }
+
+    return failed;
+}
+
+int btree_get(BTree *tree, const char *key, const void **value, size_t *size) {
+    size_t key_size;
+    if (!tree || !value || !size || btree_check_key(key, &key_size) != 0) {
+        return 1;
+    }
+
+    uint32_t path[BTREE_MAX_DEPTH];
+    uint32_t leaf_page = btree_find_leaf(tree, key, key_size, path);
+    char *leaf = leaf_page ? pager_get(&tree->pager, leaf_page) : NULL;
+    if (!leaf) {
+        return 1;
+    }
+
+    int found;
+    int index = node_search(leaf, key, key_size, &found);
+    int failed = !found || btree_read_value(tree, node_cell(leaf, index), 1, value, size) != 0;
+
+    pager_release(&tree->pager, leaf, 0);
+    return failed;
+}
+
+int btree_delete(BTree *tree, const char *key) {
+    size_t key_size;
+    if (!tree || btree_check_key(key, &key_size) != 0) {
+        return 1;
+    }
+
+    uint32_t path[BTREE_MAX_DEPTH];
+    uint32_t leaf_page = btree_find_leaf(tree, key, key_size, path);
+    char *leaf = leaf_page ? pager_get(&tree->pager, leaf_page) : NULL;
+    if (!leaf) {
+        return 1;
+    }
+
+    int found;
+    int index = node_search(leaf, key, key_size, &found);
+    if (!found) {
+        pager_release(&tree->pager, leaf, 0);
+        return 1;
+    }
+
+    uint32_t overflow = btree_overflow_page(node_cell(leaf, index));
+    node_remove(leaf, index);
+    pager_release(&tree->pager, leaf, 1);
+
+    tree->meta.record_count--;
+    tree->meta_dirty = 1;
+
+    return btree_free_overflow(tree, overflow);
+}
+
+int btree_scan(BTree *tree, const char *from, const char *to, BTreeScanFn on_record, void *ctx) {
+    if (!tree || !on_record) {
+        LOG_ERROR(NULL_ERROR);
+        return 1;
+    }
+
+    size_t from_size = from ? strlen(from) : 0;
+    size_t to_size = to ? strlen(to) : 0;
+
+    uint32_t path[BTREE_MAX_DEPTH];
+    uint32_t page = btree_find_leaf(tree, from ? from : "", from_size, path);
+    int first = 1;
+
+    while (page != 0) {
+        char *leaf = pager_get(&tree->pager, page);
+        if (!leaf) {
+            return 1;
+        }
+
+        int found;
+        int index = first ? node_search(leaf, from ? from : "", from_size, &found) : 0;
+        first = 0;
+
+        for (; index < node_count(leaf); index++) {
+            const char *cell = node_cell(leaf, index);
+            size_t key_size;
+            const char *stored = cell_key(leaf, cell, &key_size);
+
+            if (to && key_compare(stored, key_size, to, to_size) >= 0) {
+                pager_release(&tree->pager, leaf, 0);
+                return 0;
+            }
+
+            char key[BTREE_MAX_KEY + 1];
+            memcpy(key, stored, key_size);
+            key[key_size] = '\0';
+
+            const void *value;
+            size_t size;
+            if (btree_read_value(tree, cell, 0, &value, &size) != 0) {
+                pager_release(&tree->pager, leaf, 0);
+                return 1;
+            }
+
+            if (on_record(ctx, key, value, size) != 0) {
+                pager_release(&tree->pager, leaf, 0);
+                return 0;
+            }
+        }
+
+        uint32_t next = node_link(leaf);
+        pager_release(&tree->pager, leaf, 0);
+        page = next;
+    }
+
+    return 0;
+}
+
+int btree_clear(BTree *tree) {
+    if (!tree) {
+        LOG_ERROR(NULL_ERROR);
+        return 1;
+    }
+
+    return btree_format(tree);
+}
+
+// Books
+
+static size_t btree_book_size(const Book *book, const char *description) {
+    return BTREE_BOOK_HEADER + strlen(book->title) +
+           (size_t)(book->author_count + book->genre_count) * sizeof(int32_t) +
+           (description ? strlen(description) : 0);
+}
+
+static const int *btree_ids(const int *ids, const int *inline_ids) {
+    return ids ? ids : inline_ids;
+}
+
+int btree_put_book(BTree *tree, const Library *lib, const Book *book) {
+    if (!tree || !lib || !book) {
+        LOG_ERROR(NULL_ERROR);
+        return 1;
+    }
+
+    if (book->author_count > UINT16_MAX || book->genre_count > UINT16_MAX) {
+        LOG_ERROR("Too many IDs to Store - %s", book->isbn);
+        return 1;
+    }
+
+    // A description left in a file is copied out once, before the buffer grows
+    char *text = NULL;
+    size_t text_capacity = 0;
+    const char *description = lb_read_book_description(lib, book, &text, &text_capacity);
+    if (!description && book_description_ref(book) >= 0) {
+        free(text);
+        return 1;
+    }
+
+    size_t size = btree_book_size(book, description);
+    if (btree_reserve_value(tree, size) != 0) {
+        free(text);
+        return 1;
+    }
+
+    char *p = tree->value;
+    size_t title_size = strlen(book->title);
+    size_t description_size = description ? strlen(description) : 0;
+
+    int32_t numbers[2] = { book->id, book->publication_year };
+    memcpy(p, numbers, sizeof(numbers));
+    btree_put_u16(p + 8, title_size);
+    btree_put_u16(p + 10, (size_t)book->author_count);
+    btree_put_u16(p + 12, (size_t)book->genre_count);
+    btree_put_u16(p + 14, description ? BTREE_BOOK_DESCRIPTION : 0);
+    btree_put_u32(p + 16, (uint32_t)description_size);
+    p += BTREE_BOOK_HEADER;
+
+    memcpy(p, book->title, title_size);
+    p += title_size;
+
+    size_t ids_size = (size_t)book->author_count * sizeof(int32_t);
+    memcpy(p, btree_ids(book->author_ids, book->author_inline), ids_size);
+    p += ids_size;
+
+    ids_size = (size_t)book->genre_count * sizeof(int32_t);
+    memcpy(p, btree_ids(book->genre_ids, book->genre_inline), ids_size);
+    p += ids_size;
+
+    if (description_size > 0) {
+        memcpy(p, description, description_size);
+    }
+
+    free(text);
+    return btree_put(tree, book->isbn, tree->value, size);
+}
+
+static int btree_decode_book(const char *isbn, const char *value, size_t size, Book *book) {
+    if (size < BTREE_BOOK_HEADER) {
+        LOG_ERROR("Invalid Book Record - %s", isbn);
+        return 1;
+    }
+
+    int32_t numbers[2];
+    memcpy(numbers, value, sizeof(numbers));
+    size_t title_size = btree_u16(value + 8);
+    int author_count = btree_u16(value + 10);
+    int genre_count = btree_u16(value + 12);
+    int has_description = btree_u16(value + 14) & BTREE_BOOK_DESCRIPTION;
+    size_t description_size = btree_u32(value + 16);
+
+    size_t ids_size = (size_t)(author_count + genre_count) * sizeof(int32_t);
+    if (BTREE_BOOK_HEADER + title_size + ids_size + description_size != size) {
+        LOG_ERROR("Invalid Book Record - %s", isbn);
+        return 1;
+    }
+
+    book->id = numbers[0];
+    book->publication_year = numbers[1];
+    snprintf(book->isbn, ISBN_SIZE, "%s", isbn);
+
+    const char *p = value + BTREE_BOOK_HEADER;
+    size_t kept = title_size < MAX_TITLE ? title_size : MAX_TITLE - 1;
+    memcpy(book->title, p, kept);
+    book->title[kept] = '\0';
+    p += title_size;
+
+    for (int i = 0; i < author_count + genre_count; i++) {
+        int32_t id;
+        memcpy(&id, p, sizeof(id));
+        p += sizeof(id);
+
+        if ((i < author_count ? book_add_author(book, id) : book_add_genre(book, id)) != 0) {
+            return 1;
+        }
+    }
+
+    if (!has_description) {
+        return 0;
+    }
+
+    // The record is not NUL terminated
+    char *description = malloc(description_size + 1);
+    if (!description) {
+        LOG_ERROR(ALLOCATION_ERROR);
+        return 1;
+    }
+
+    memcpy(description, p, description_size);
+    description[description_size] = '\0';
+    book->description = description;
+    book->description_capacity = (int)(description_size + 1);
+    return 0;
+}
+
+int btree_get_book(BTree *tree, const char *isbn, Book *book) {
+    if (!tree || !isbn || !book) {
+        LOG_ERROR(NULL_ERROR);
+        return 1;
+    }
+
+    const void *value;
+    size_t size;
+    if (btree_get(tree, isbn, &value, &size) != 0) {
+        return 1;
+    }
+
+    return btree_decode_book(isbn, value, size, book);
+}
+
+typedef struct {
+    Library *lib;
+    int failed;
+} BTreeLoad;
+
+static int btree_load_record(void *ctx, const char *key, const void *value, size_t size) {
+    BTreeLoad *load = ctx;
+    Book book;
+    book_init(&book);
+
+    if (btree_decode_book(key, value, size, &book) != 0) {
+        book_free(&book);
+        load->failed = 1;
+        return 1;
+    }
+
+    // A library running on the tree already holds some of them
+    if (load->lib->backend) {
+        if (lb_cache_book(load->lib, &book) != 0) {
+            book_free(&book);
+        }
+        return 0;
+    }
+
+    // The library takes over the book once added
+    if (lb_add_book(load->lib, &book) != 0) {
+        book_free(&book);
+        load->failed = 1;
+        return 1;
+    }
+
+    return 0;
+}
+
+int btree_load_books(BTree *tree, Library *lib, const char *from, const char *to) {
+    if (!tree || !lib) {
+        LOG_ERROR(NULL_ERROR);
+        return 1;
+    }
+
+    BTreeLoad load = { lib, 0 };
+    if (btree_scan(tree, from, to, btree_load_record, &load) != 0) {
+        return 1;
+    }
+
+    return load.failed;
+}
+
+// Copy of a stored book with a change made to it: the hook sees the change
+// before the library applies it. The description stays where the library
+// keeps it, the copy only owns its id lists.
+static int btree_changed_book(Library *lib, const LibraryChange *change, Book *copy) {
+    Book *book = lb_find_book_by_isbn(lib, change->isbn);
+    if (!book) {
+        LOG_ERROR("Book to be stored not Found - %s", change->isbn);
+        return 1;
+    }
+
+    book_init(copy);
+    copy->id = book->id;
+    copy->publication_year = book->publication_year;
+    memcpy(copy->title, book->title, MAX_TITLE);
+    memcpy(copy->isbn, book->isbn, ISBN_SIZE);
+    copy->description = book->description;
+    copy->description_capacity = book->description_capacity > 0 ? 0 : book->description_capacity;
+
+    int failed = 0;
+    const int *ids = book_get_author_ids(book);
+    for (int i = 0; i < book->author_count && !failed; i++) {
+        failed = book_add_author(copy, ids[i]);
+    }
+
+    ids = book_get_genre_ids(book);
+    for (int i = 0; i < book->genre_count && !failed; i++) {
+        failed = book_add_genre(copy, ids[i]);
+    }
+
+    if (failed) {
+        book_free_ids(copy);
+        return 1;
+    }
+
+    switch (change->kind) {
+        case LB_CHANGE_BOOK_ISBN:
+            return book_update_isbn(copy, change->text);
+        case LB_CHANGE_BOOK_TITLE:
+            return book_update_title(copy, change->text);
+        case LB_CHANGE_BOOK_ID:
+            copy->id = change->value;
+            return 0;
+        case LB_CHANGE_BOOK_YEAR:
+            copy->publication_year = change->value;
+            return 0;
+        case LB_CHANGE_BOOK_DESCRIPTION:
+            copy->description = (char *)change->text;
+            copy->description_capacity = 0;
+            return 0;
+        case LB_CHANGE_ADD_BOOK_GENRE:
+            return book_add_genre(copy, change->value);
+        case LB_CHANGE_REMOVE_BOOK_GENRE:
+            return book_remove_genre(copy, change->value);
+        case LB_CHANGE_ADD_BOOK_AUTHOR:
+            return book_add_author(copy, change->value);
+        case LB_CHANGE_REMOVE_BOOK_AUTHOR:
+            return book_remove_author(copy, change->value);
+        default:
+            return 0;
+    }
+}
+
+int btree_apply_change(BTree *tree, Library *lib, const LibraryChange *change) {
+    if (!tree || !lib || !change) {
+        LOG_ERROR(NULL_ERROR);
+        return 1;
+    }
+
+    switch (change->kind) {
+        case LB_CHANGE_ADD_BOOK:
+            return btree_put_book(tree, lib, change->book);
+
+        case LB_CHANGE_REMOVE_BOOK:
+            return btree_delete(tree, change->isbn);
+
+        case LB_CHANGE_BOOK_ISBN:
+        case LB_CHANGE_BOOK_TITLE:
+        case LB_CHANGE_BOOK_ID:
+        case LB_CHANGE_BOOK_YEAR:
+        case LB_CHANGE_BOOK_DESCRIPTION:
+        case LB_CHANGE_ADD_BOOK_GENRE:
+        case LB_CHANGE_REMOVE_BOOK_GENRE:
+        case LB_CHANGE_ADD_BOOK_AUTHOR:
+        case LB_CHANGE_REMOVE_BOOK_AUTHOR: {
+            Book copy;
+            if (btree_changed_book(lib, change, &copy) != 0) {
+                return 1;
+            }
+
+            int failed = (change->kind == LB_CHANGE_BOOK_ISBN && btree_delete(tree, change->isbn) != 0) ||
+                         btree_put_book(tree, lib, &copy) != 0;
+            book_free_ids(&copy);
+            return failed;
+        }
+
+        case LB_CHANGE_CLEAR:
+            return btree_clear(tree);
+
+        default:
+            // Authors and genres are not stored in the tree, books keep their ids
+            return 0;
+    }
+}
+
+static int btree_backend_load(void *ctx, const char *isbn, Book *book) {
+    return btree_get_book(ctx, isbn, book);
+}
+
+static int btree_backend_apply(void *ctx, Library *lib, const LibraryChange *change) {
+    return btree_apply_change(ctx, lib, change);
+}
+
+int btree_backend(BTree *tree, LibraryBackend *backend) {
+    if (!tree || !backend) {
+        LOG_ERROR(NULL_ERROR);
+        return 1;
+    }
+
+    backend->ctx = tree;
+    backend->load = btree_backend_load;
+    backend->apply = btree_backend_apply;
+    return 0;
+}
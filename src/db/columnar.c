@@ -0,0 +1,1039 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "columnar.h"
+#include "log.h"
+
+#define COLUMNAR_WRITE_BUFFER (1 << 20)
+#define COLUMNAR_NO_CODE UINT32_MAX
+
+_Static_assert(sizeof(ColumnarHeader) == 80, "ColumnarHeader layout changed");
+_Static_assert(sizeof(ColumnarInts) == 24, "ColumnarInts layout changed");
+_Static_assert(sizeof(ColumnarBlock) % 8 == 0, "ColumnarBlock must stay aligned");
+
+typedef struct {
+    FILE *file;
+    uint64_t offset;
+    int failed;
+
+    // Descriptions left in a file are copied here, not read from the cache
+    char *text;
+    size_t text_capacity;
+} ColumnarWriter;
+
+// Dictionary of author or genre ids, sorted: a code is a position in it
+typedef struct {
+    int *ids;
+    const char **names;
+    int count;
+} ColumnarDictionary;
+
+// Column buffers of the block being written or read
+typedef struct {
+    int64_t *values;
+    int *ints;
+    int *codes;
+    size_t code_capacity;
+} ColumnarBuffers;
+
+// Writing
+
+static void columnar_write(ColumnarWriter *writer, const void *data, size_t size) {
+    if (writer->failed || size == 0) {
+        return;
+    }
+
+    if (fwrite(data, 1, size, writer->file) != size) {
+        writer->failed = 1;
+        return;
+    }
+
+    writer->offset += size;
+}
+
+static void columnar_align(ColumnarWriter *writer) {
+    static const char zeros[8];
+    size_t gap = (size_t)((8 - writer->offset % 8) % 8);
+    columnar_write(writer, zeros, gap);
+}
+
+static int columnar_bits(uint64_t range) {
+    int bits = 0;
+
+    while (range > 0) {
+        bits++;
+        range >>= 1;
+    }
+
+    return bits;
+}
+
+static uint64_t columnar_packed_size(uint64_t count, int bits) {
+    return (count * (uint64_t)bits + 63) / 64 * 8;
+}
+
+static void columnar_write_packed(ColumnarWriter *writer, const int64_t *values, uint32_t count, int64_t base,
+                                  int bits) {
+    if (bits == 0) {
+        return;
+    }
+
+    uint64_t word = 0;
+    int used = 0;
+
+    for (uint32_t i = 0; i < count; i++) {
+        uint64_t value = (uint64_t)(values[i] - base);
+        word |= value << used;
+
+        if (used + bits >= 64) {
+            columnar_write(writer, &word, sizeof(word));
+            word = used > 0 ? value >> (64 - used) : 0;
+            used = used + bits - 64;
+        } else {
+            used += bits;
+        }
+    }
+
+    if (used > 0) {
+        columnar_write(writer, &word, sizeof(word));
+    }
+}
+
+// Write an integer column with the smaller of the two encodings
+static void columnar_write_ints(ColumnarWriter *writer, int64_t *values, uint32_t count) {
+    ColumnarInts header;
+    memset(&header, 0, sizeof(header));
+    header.encoding = COLUMNAR_PACKED;
+    header.count = count;
+
+    int64_t min = count > 0 ? values[0] : 0;
+    int64_t max = min;
+    int64_t delta_min = 0;
+    int64_t delta_max = 0;
+
+    for (uint32_t i = 0; i < count; i++) {
+        min = values[i] < min ? values[i] : min;
+        max = values[i] > max ? values[i] : max;
+
+        if (i > 0) {
+            int64_t delta = values[i] - values[i - 1];
+            delta_min = i == 1 || delta < delta_min ? delta : delta_min;
+            delta_max = i == 1 || delta > delta_max ? delta : delta_max;
+        }
+    }
+
+    int packed_bits = columnar_bits((uint64_t)(max - min));
+    int delta_bits = columnar_bits((uint64_t)(delta_max - delta_min));
+
+    if (count > 1 && columnar_packed_size(count - 1, delta_bits) < columnar_packed_size(count, packed_bits)) {
+        header.encoding = COLUMNAR_DELTA;
+        header.bits = (uint8_t)delta_bits;
+        header.base = delta_min;
+        header.first = values[0];
+        columnar_write(writer, &header, sizeof(header));
+
+        // Deltas are made in place, back to front
+        for (uint32_t i = count - 1; i > 0; i--) {
+            values[i] -= values[i - 1];
+        }
+
+        columnar_write_packed(writer, values + 1, count - 1, delta_min, delta_bits);
+        return;
+    }
+
+    header.bits = (uint8_t)packed_bits;
+    header.base = min;
+    columnar_write(writer, &header, sizeof(header));
+    columnar_write_packed(writer, values, count, min, packed_bits);
+}
+
+static const char *columnar_text(ColumnarWriter *writer, const Library *lib, const Book *book, int column) {
+    if (column == COLUMNAR_ISBN) {
+        return book->isbn;
+    }
+
+    if (column == COLUMNAR_TITLE) {
+        return book->title;
+    }
+
+    // A description that cannot be read back from its file fails the save
+    const char *description = lb_read_book_description(lib, book, &writer->text, &writer->text_capacity);
+    if (!description && book_description_ref(book) >= 0) {
+        writer->failed = 1;
+    }
+
+    return description;
+}
+
+static void columnar_write_strings(ColumnarWriter *writer, ColumnarBuffers *buffers, const Library *lib,
+                                   int first, uint32_t rows, int column) {
+    for (uint32_t i = 0; i < rows; i++) {
+        const char *text = columnar_text(writer, lib, &lib->books[first + (int)i], column);
+        buffers->values[i] = text ? (int64_t)strlen(text) + 1 : 0;
+    }
+
+    columnar_write_ints(writer, buffers->values, rows);
+
+    // Texts keep their NUL so loads can read them in place
+    for (uint32_t i = 0; i < rows; i++) {
+        const char *text = columnar_text(writer, lib, &lib->books[first + (int)i], column);
+
+        if (text) {
+            columnar_write(writer, text, strlen(text) + 1);
+        }
+    }
+}
+
+// Dictionaries
+
+static int columnar_dictionary_init(ColumnarDictionary *dictionary, const void *records, int count, size_t stride,
+                                    size_t name_offset) {
+    dictionary->count = 0;
+    dictionary->ids = malloc((size_t)(count > 0 ? count : 1) * sizeof(int));
+    dictionary->names = malloc((size_t)(count > 0 ? count : 1) * sizeof(char *));
+
+    if (!dictionary->ids || !dictionary->names) {
+        LOG_ERROR(ALLOCATION_ERROR);
+        free(dictionary->ids);
+        free(dictionary->names);
+        return 1;
+    }
+
+    // Insertion keeps the common case (ids already in order) linear
+    const char *record = records;
+    for (int i = 0; i < count; i++, record += stride) {
+        int id = *(const int *)record;
+        int at = dictionary->count;
+
+        while (at > 0 && dictionary->ids[at - 1] > id) {
+            at--;
+        }
+
+        // Duplicated ids keep their first name
+        if (at > 0 && dictionary->ids[at - 1] == id) {
+            continue;
+        }
+
+        memmove(dictionary->ids + at + 1, dictionary->ids + at, (size_t)(dictionary->count - at) * sizeof(int));
+        memmove(dictionary->names + at + 1, dictionary->names + at,
+                (size_t)(dictionary->count - at) * sizeof(char *));
+        dictionary->ids[at] = id;
+        dictionary->names[at] = record + name_offset;
+        dictionary->count++;
+    }
+
+    return 0;
+}
+
+static void columnar_dictionary_free(ColumnarDictionary *dictionary) {
+    free(dictionary->ids);
+    free(dictionary->names);
+}
+
+static int columnar_id_compare(const void *a, const void *b) {
+    int left = *(const int *)a;
+    int right = *(const int *)b;
+    return (left > right) - (left < right);
+}
+
+static uint32_t columnar_code(const ColumnarDictionary *dictionary, int id) {
+    if (id >= 1 && id <= dictionary->count && dictionary->ids[id - 1] == id) {
+        return (uint32_t)(id - 1);
+    }
+
+    const int *found = bsearch(&id, dictionary->ids, (size_t)dictionary->count, sizeof(int), columnar_id_compare);
+    return found ? (uint32_t)(found - dictionary->ids) : COLUMNAR_NO_CODE;
+}
+
+// Count and code columns of the author (or genre) lists of a block
+static void columnar_write_lists(ColumnarWriter *writer, ColumnarBuffers *buffers, const Library *lib,
+                                 const ColumnarDictionary *dictionary, int first, ColumnarBlock *block,
+                                 int authors) {
+    uint32_t code_min = COLUMNAR_NO_CODE;
+    uint32_t code_max = 0;
+    uint64_t links = 0;
+
+    for (uint32_t i = 0; i < block->rows; i++) {
+        Book *book = &lib->books[first + (int)i];
+        const int *ids = authors ? book_get_author_ids(book) : book_get_genre_ids(book);
+        int count = authors ? book->author_count : book->genre_count;
+        int kept = 0;
+
+        for (int j = 0; j < count; j++) {
+            kept += columnar_code(dictionary, ids[j]) != COLUMNAR_NO_CODE;
+        }
+
+        buffers->values[i] = kept;
+        links += (uint64_t)kept;
+    }
+
+    int count_column = authors ? COLUMNAR_AUTHOR_COUNT : COLUMNAR_GENRE_COUNT;
+    columnar_align(writer);
+    block->column_offset[count_column] = writer->offset;
+    columnar_write_ints(writer, buffers->values, block->rows);
+
+    // Codes are packed with the width of the dictionary, not per block,
+    // so they are written in runs through the value buffer
+    int bits = columnar_bits(dictionary->count > 0 ? (uint64_t)dictionary->count - 1 : 0);
+    ColumnarInts header;
+    memset(&header, 0, sizeof(header));
+    header.encoding = COLUMNAR_PACKED;
+    header.bits = (uint8_t)bits;
+    header.count = (uint32_t)links;
+
+    columnar_align(writer);
+    block->column_offset[count_column + 1] = writer->offset;
+    columnar_write(writer, &header, sizeof(header));
+
+    uint64_t word = 0;
+    int used = 0;
+
+    for (uint32_t i = 0; i < block->rows && bits > 0; i++) {
+        Book *book = &lib->books[first + (int)i];
+        const int *ids = authors ? book_get_author_ids(book) : book_get_genre_ids(book);
+        int count = authors ? book->author_count : book->genre_count;
+
+        for (int j = 0; j < count; j++) {
+            uint32_t code = columnar_code(dictionary, ids[j]);
+            if (code == COLUMNAR_NO_CODE) {
+                continue;
+            }
+
+            code_min = code < code_min ? code : code_min;
+            code_max = code > code_max ? code : code_max;
+
+            word |= (uint64_t)code << used;
+            if (used + bits >= 64) {
+                columnar_write(writer, &word, sizeof(word));
+                word = used > 0 ? (uint64_t)code >> (64 - used) : 0;
+                used = used + bits - 64;
+            } else {
+                used += bits;
+            }
+        }
+    }
+
+    if (used > 0) {
+        columnar_write(writer, &word, sizeof(word));
+    }
+
+    // A one-entry dictionary packs in zero bits, the stats still hold
+    if (bits == 0 && links > 0) {
+        code_min = 0;
+    }
+
+    if (authors) {
+        block->author_links = links;
+        block->author_code_min = code_min;
+        block->author_code_max = code_max;
+    } else {
+        block->genre_links = links;
+        block->genre_code_min = code_min;
+        block->genre_code_max = code_max;
+    }
+}
+
+static void columnar_write_block(ColumnarWriter *writer, ColumnarBuffers *buffers, const Library *lib,
+                                 const ColumnarDictionary *authors, const ColumnarDictionary *genres, int first,
+                                 ColumnarBlock *block) {
+    block->id_min = INT_MAX;
+    block->id_max = INT_MIN;
+    block->year_min = INT_MAX;
+    block->year_max = INT_MIN;
+
+    for (uint32_t i = 0; i < block->rows; i++) {
+        int id = lib->books[first + (int)i].id;
+        block->id_min = id < block->id_min ? id : block->id_min;
+        block->id_max = id > block->id_max ? id : block->id_max;
+        buffers->values[i] = id;
+    }
+
+    columnar_align(writer);
+    block->column_offset[COLUMNAR_ID] = writer->offset;
+    columnar_write_ints(writer, buffers->values, block->rows);
+
+    for (uint32_t i = 0; i < block->rows; i++) {
+        int year = lib->books[first + (int)i].publication_year;
+        block->year_min = year < block->year_min ? year : block->year_min;
+        block->year_max = year > block->year_max ? year : block->year_max;
+        buffers->values[i] = year;
+    }
+
+    columnar_align(writer);
+    block->column_offset[COLUMNAR_YEAR] = writer->offset;
+    columnar_write_ints(writer, buffers->values, block->rows);
+
+    columnar_write_lists(writer, buffers, lib, authors, first, block, 1);
+    columnar_write_lists(writer, buffers, lib, genres, first, block, 0);
+
+    for (int column = COLUMNAR_ISBN; column <= COLUMNAR_DESCRIPTION; column++) {
+        columnar_align(writer);
+        block->column_offset[column] = writer->offset;
+        columnar_write_strings(writer, buffers, lib, first, block->rows, column);
+    }
+}
+
+static void columnar_buffers_free(ColumnarBuffers *buffers) {
+    free(buffers->values);
+    free(buffers->ints);
+    free(buffers->codes);
+}
+
+static int columnar_write_file(const Library *lib, ColumnarWriter *writer, const ColumnarDictionary *authors,
+                               const ColumnarDictionary *genres) {
+    ColumnarHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, COLUMNAR_MAGIC, sizeof(header.magic));
+    header.version = COLUMNAR_VERSION;
+    header.block_rows = COLUMNAR_BLOCK_ROWS;
+    header.book_count = (uint64_t)lib->book_count;
+    header.block_count = ((uint64_t)lib->book_count + COLUMNAR_BLOCK_ROWS - 1) / COLUMNAR_BLOCK_ROWS;
+    header.author_count = (uint64_t)authors->count;
+    header.genre_count = (uint64_t)genres->count;
+
+    ColumnarBuffers buffers;
+    memset(&buffers, 0, sizeof(buffers));
+    buffers.values = malloc(COLUMNAR_BLOCK_ROWS * sizeof(int64_t));
+    ColumnarBlock *blocks = calloc(header.block_count > 0 ? header.block_count : 1, sizeof(ColumnarBlock));
+
+    if (!buffers.values || !blocks) {
+        LOG_ERROR(ALLOCATION_ERROR);
+        columnar_buffers_free(&buffers);
+        free(blocks);
+        return 1;
+    }
+
+    // Placeholder, rewritten once the offsets are known
+    columnar_write(writer, &header, sizeof(header));
+
+    for (uint64_t b = 0; b < header.block_count && !writer->failed; b++) {
+        int first = (int)(b * COLUMNAR_BLOCK_ROWS);
+        int rows = lib->book_count - first;
+        blocks[b].rows = (uint32_t)(rows < COLUMNAR_BLOCK_ROWS ? rows : COLUMNAR_BLOCK_ROWS);
+        columnar_write_block(writer, &buffers, lib, authors, genres, first, &blocks[b]);
+    }
+
+    columnar_align(writer);
+    header.author_offset = writer->offset;
+    for (int i = 0; i < authors->count; i++) {
+        ColumnarAuthor record;
+        memset(&record, 0, sizeof(record));
+        record.id = authors->ids[i];
+        snprintf(record.name, sizeof(record.name), "%s", authors->names[i]);
+        columnar_write(writer, &record, sizeof(record));
+    }
+
+    columnar_align(writer);
+    header.genre_offset = writer->offset;
+    for (int i = 0; i < genres->count; i++) {
+        ColumnarGenre record;
+        memset(&record, 0, sizeof(record));
+        record.id = genres->ids[i];
+        snprintf(record.name, sizeof(record.name), "%s", genres->names[i]);
+        columnar_write(writer, &record, sizeof(record));
+    }
+
+    columnar_align(writer);
+    header.block_offset = writer->offset;
+    columnar_write(writer, blocks, header.block_count * sizeof(ColumnarBlock));
+    header.file_size = writer->offset;
+
+    if (!writer->failed && (fseek(writer->file, 0, SEEK_SET) != 0 ||
+                            fwrite(&header, sizeof(header), 1, writer->file) != 1)) {
+        writer->failed = 1;
+    }
+
+    columnar_buffers_free(&buffers);
+    free(blocks);
+    return writer->failed;
+}
+
+int columnar_save(const Library *lib, const char *path) {
+    if (!lib || !path) {
+        LOG_ERROR(NULL_ERROR);
+        return 1;
+    }
+
+    size_t path_length = strlen(path);
+    char *tmp_path = malloc(path_length + 5);
+    if (!tmp_path) {
+        LOG_ERROR(ALLOCATION_ERROR);
+        return 1;
+    }
+
+    memcpy(tmp_path, path, path_length);
+    memcpy(tmp_path + path_length, ".tmp", 5);
+
+    ColumnarDictionary authors;
+    ColumnarDictionary genres;
+    if (columnar_dictionary_init(&authors, lib->authors, lib->author_count, sizeof(Author),
+                                 offsetof(Author, name)) != 0) {
+        free(tmp_path);
+        return 1;
+    }
+    if (columnar_dictionary_init(&genres, lib->genres, lib->genre_count, sizeof(Genre),
+                                 offsetof(Genre, name)) != 0) {
+        columnar_dictionary_free(&authors);
+        free(tmp_path);
+        return 1;
+    }
+
+    ColumnarWriter writer = { fopen(tmp_path, "wb"), 0, 0, NULL, 0 };
+    int failed = !writer.file;
+
+    if (writer.file) {
+        setvbuf(writer.file, NULL, _IOFBF, COLUMNAR_WRITE_BUFFER);
+        failed = columnar_write_file(lib, &writer, &authors, &genres);
+
+        if (fflush(writer.file) != 0 || fsync(fileno(writer.file)) != 0) {
+            failed = 1;
+        }
+
+        if (fclose(writer.file) != 0) {
+            failed = 1;
+        }
+    }
+
+    free(writer.text);
+    columnar_dictionary_free(&authors);
+    columnar_dictionary_free(&genres);
+
+    if (failed || rename(tmp_path, path) != 0) {
+        LOG_ERROR("Columnar Write Failed - %s", path);
+        remove(tmp_path);
+        free(tmp_path);
+        return 1;
+    }
+
+    free(tmp_path);
+    LOG_INFO("Columnar File Saved - %s - %d Books", path, lib->book_count);
+    return 0;
+}
+
+// Reading
+
+static int columnar_fits(const ColumnarFile *file, uint64_t offset, uint64_t size) {
+    return offset <= file->size && size <= file->size - offset;
+}
+
+static const ColumnarInts *columnar_ints(const ColumnarFile *file, uint64_t offset, uint32_t count) {
+    if (offset % 8 != 0 || !columnar_fits(file, offset, sizeof(ColumnarInts))) {
+        return NULL;
+    }
+
+    const ColumnarInts *ints = (const ColumnarInts *)(file->map + offset);
+    uint64_t values = ints->encoding == COLUMNAR_DELTA && ints->count > 0 ? ints->count - 1u : ints->count;
+
+    if (ints->count != count || ints->bits > 64 ||
+        (ints->encoding != COLUMNAR_PACKED && ints->encoding != COLUMNAR_DELTA) ||
+        !columnar_fits(file, offset + sizeof(ColumnarInts), columnar_packed_size(values, ints->bits))) {
+        return NULL;
+    }
+
+    return ints;
+}
+
+static uint64_t columnar_get_bits(const uint64_t *words, uint64_t index, int bits) {
+    if (bits == 0) {
+        return 0;
+    }
+
+    uint64_t bit = index * (uint64_t)bits;
+    uint64_t word = bit / 64;
+    int shift = (int)(bit % 64);
+
+    uint64_t value = words[word] >> shift;
+    if (shift + bits > 64) {
+        value |= words[word + 1] << (64 - shift);
+    }
+
+    return bits == 64 ? value : value & ((UINT64_C(1) << bits) - 1);
+}
+
+// Decode an integer column of count values, NULL if it is damaged
+static const char *columnar_decode(const ColumnarFile *file, uint64_t offset, uint32_t count, int *out) {
+    const ColumnarInts *ints = columnar_ints(file, offset, count);
+    if (!ints) {
+        LOG_ERROR("Invalid Columnar Column");
+        return NULL;
+    }
+
+    const uint64_t *words = (const uint64_t *)(ints + 1);
+
+    if (ints->encoding == COLUMNAR_PACKED) {
+        for (uint32_t i = 0; i < count; i++) {
+            out[i] = (int)(ints->base + (int64_t)columnar_get_bits(words, i, ints->bits));
+        }
+    } else if (count > 0) {
+        int64_t value = ints->first;
+        out[0] = (int)value;
+
+        for (uint32_t i = 1; i < count; i++) {
+            value += ints->base + (int64_t)columnar_get_bits(words, i - 1, ints->bits);
+            out[i] = (int)value;
+        }
+    }
+
+    uint64_t values = ints->encoding == COLUMNAR_DELTA && count > 0 ? count - 1u : count;
+    return (const char *)words + columnar_packed_size(values, ints->bits);
+}
+
+static int columnar_reserve_codes(ColumnarBuffers *buffers, uint64_t count) {
+    if (count <= buffers->code_capacity) {
+        return 0;
+    }
+
+    int *tmp = realloc(buffers->codes, (size_t)count * sizeof(int));
+    if (!tmp) {
+        LOG_ERROR(REALLOCATION_ERROR);
+        return 1;
+    }
+
+    buffers->codes = tmp;
+    buffers->code_capacity = (size_t)count;
+    return 0;
+}
+
+// Decode the count and code columns of the author (or genre) lists
+static int columnar_decode_lists(const ColumnarFile *file, const ColumnarBlock *block, ColumnarBuffers *buffers,
+                                 int authors) {
+    int count_column = authors ? COLUMNAR_AUTHOR_COUNT : COLUMNAR_GENRE_COUNT;
+    uint64_t links = authors ? block->author_links : block->genre_links;
+
+    if (links > UINT32_MAX || columnar_reserve_codes(buffers, links) != 0 ||
+        !columnar_decode(file, block->column_offset[count_column], block->rows, buffers->ints) ||
+        !columnar_decode(file, block->column_offset[count_column + 1], (uint32_t)links, buffers->codes)) {
+        return 1;
+    }
+
+    uint64_t total = 0;
+    uint64_t dictionary = authors ? file->header->author_count : file->header->genre_count;
+
+    for (uint32_t i = 0; i < block->rows; i++) {
+        total += (uint64_t)buffers->ints[i];
+    }
+
+    for (uint64_t i = 0; i < links; i++) {
+        if ((uint64_t)buffers->codes[i] >= dictionary) {
+            total = UINT64_MAX;
+        }
+    }
+
+    if (total != links) {
+        LOG_ERROR("Invalid Columnar Lists");
+        return 1;
+    }
+
+    return 0;
+}
+
+static int columnar_validate(const ColumnarFile *file) {
+    const ColumnarHeader *header = file->header;
+
+    if (file->size < sizeof(ColumnarHeader) || memcmp(header->magic, COLUMNAR_MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != COLUMNAR_VERSION || header->block_rows != COLUMNAR_BLOCK_ROWS ||
+        header->file_size != file->size) {
+        return 1;
+    }
+
+    if (header->author_offset % 8 != 0 || header->genre_offset % 8 != 0 || header->block_offset % 8 != 0 ||
+        header->author_count > file->size / sizeof(ColumnarAuthor) ||
+        header->genre_count > file->size / sizeof(ColumnarGenre) ||
+        header->block_count > file->size / sizeof(ColumnarBlock) ||
+        !columnar_fits(file, header->author_offset, header->author_count * sizeof(ColumnarAuthor)) ||
+        !columnar_fits(file, header->genre_offset, header->genre_count * sizeof(ColumnarGenre)) ||
+        !columnar_fits(file, header->block_offset, header->block_count * sizeof(ColumnarBlock))) {
+        return 1;
+    }
+
+    uint64_t books = 0;
+    for (uint64_t b = 0; b < header->block_count; b++) {
+        if (file->blocks[b].rows > COLUMNAR_BLOCK_ROWS) {
+            return 1;
+        }
+        books += file->blocks[b].rows;
+    }
+
+    return books != header->book_count;
+}
+
+int columnar_open(ColumnarFile *file, const char *path) {
+    if (!file || !path) {
+        LOG_ERROR(NULL_ERROR);
+        return 1;
+    }
+
+    memset(file, 0, sizeof(*file));
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        LOG_ERROR("Columnar File not Found - %s", path);
+        return 1;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(ColumnarHeader)) {
+        LOG_ERROR("Invalid Columnar File - %s", path);
+        close(fd);
+        return 1;
+    }
+
+    void *map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (map == MAP_FAILED) {
+        LOG_ERROR("Columnar Map Failed - %s", path);
+        return 1;
+    }
+
+    file->map = map;
+    file->size = (size_t)st.st_size;
+    file->header = map;
+    file->blocks = (const ColumnarBlock *)(file->map + file->header->block_offset);
+    file->authors = (const ColumnarAuthor *)(file->map + file->header->author_offset);
+    file->genres = (const ColumnarGenre *)(file->map + file->header->genre_offset);
+
+    // The directory is only read once its bounds are known to be valid
+    const ColumnarHeader *header = file->header;
+    int bounds_ok = header->block_offset % 8 == 0 && header->block_count <= file->size / sizeof(ColumnarBlock) &&
+                    columnar_fits(file, header->block_offset, header->block_count * sizeof(ColumnarBlock));
+
+    if (!bounds_ok || columnar_validate(file) != 0) {
+        LOG_ERROR("Invalid Columnar File - %s", path);
+        columnar_close(file);
+        return 1;
+    }
+
+    return 0;
+}
+
+void columnar_close(ColumnarFile *file) {
+    if (!file || !file->map) {
+        return;
+    }
+
+    munmap((void *)file->map, file->size);
+    memset(file, 0, sizeof(*file));
+}
+
+static int columnar_buffers_init(ColumnarBuffers *buffers) {
+    memset(buffers, 0, sizeof(*buffers));
+    buffers->ints = malloc(COLUMNAR_BLOCK_ROWS * sizeof(int));
+
+    if (!buffers->ints) {
+        LOG_ERROR(ALLOCATION_ERROR);
+        return 1;
+    }
+
+    return 0;
+}
+
+// Strings of a block: sizes in ints, the texts returned
+static const char *columnar_decode_strings(const ColumnarFile *file, const ColumnarBlock *block, int column,
+                                           int *sizes) {
+    const char *texts = columnar_decode(file, block->column_offset[column], block->rows, sizes);
+    if (!texts) {
+        return NULL;
+    }
+
+    uint64_t total = 0;
+    for (uint32_t i = 0; i < block->rows; i++) {
+        if (sizes[i] < 0) {
+            return NULL;
+        }
+        total += (uint64_t)sizes[i];
+    }
+
+    if (!columnar_fits(file, (uint64_t)(texts - file->map), total)) {
+        LOG_ERROR("Invalid Columnar Strings");
+        return NULL;
+    }
+
+    return texts;
+}
+
+static int columnar_load_block(const ColumnarFile *file, const ColumnarBlock *block, ColumnarBuffers *buffers,
+                               Library *lib, Book *books, int *sizes) {
+    for (uint32_t i = 0; i < block->rows; i++) {
+        book_init(&books[i]);
+    }
+
+    int failed = !columnar_decode(file, block->column_offset[COLUMNAR_ID], block->rows, buffers->ints);
+    for (uint32_t i = 0; i < block->rows && !failed; i++) {
+        books[i].id = buffers->ints[i];
+    }
+
+    failed = failed || !columnar_decode(file, block->column_offset[COLUMNAR_YEAR], block->rows, buffers->ints);
+    for (uint32_t i = 0; i < block->rows && !failed; i++) {
+        books[i].publication_year = buffers->ints[i];
+    }
+
+    for (int authors = 1; authors >= 0 && !failed; authors--) {
+        failed = columnar_decode_lists(file, block, buffers, authors);
+        uint64_t code = 0;
+
+        for (uint32_t i = 0; i < block->rows && !failed; i++) {
+            for (int j = 0; j < buffers->ints[i] && !failed; j++, code++) {
+                int index = buffers->codes[code];
+                failed = authors ? book_add_author(&books[i], file->authors[index].id)
+                                 : book_add_genre(&books[i], file->genres[index].id);
+            }
+        }
+    }
+
+    for (int column = COLUMNAR_ISBN; column <= COLUMNAR_DESCRIPTION && !failed; column++) {
+        const char *text = columnar_decode_strings(file, block, column, sizes);
+        failed = !text;
+
+        for (uint32_t i = 0; i < block->rows && !failed; i++) {
+            if (sizes[i] == 0) {
+                continue;
+            }
+
+            if (text[sizes[i] - 1] != '\0') {
+                failed = 1;
+            } else if (column == COLUMNAR_ISBN) {
+                snprintf(books[i].isbn, ISBN_SIZE, "%s", text);
+            } else if (column == COLUMNAR_TITLE) {
+                snprintf(books[i].title, MAX_TITLE, "%s", text);
+            } else {
+                failed = book_update_description(&books[i], text);
+            }
+
+            text += sizes[i];
+        }
+    }
+
+    // The library takes over the books it adds, the rest are freed here
+    int before = lib->book_count;
+    if (failed || lb_add_books_bulk(lib, books, (int)block->rows) != 0) {
+        for (uint32_t i = (uint32_t)(lib->book_count - before); i < block->rows; i++) {
+            book_free(&books[i]);
+        }
+        return 1;
+    }
+
+    return 0;
+}
+
+int columnar_load(const char *path, Library *lib) {
+    if (!path || !lib) {
+        LOG_ERROR(NULL_ERROR);
+        return 1;
+    }
+
+    ColumnarFile file;
+    if (columnar_open(&file, path) != 0) {
+        return 1;
+    }
+
+    const ColumnarHeader *header = file.header;
+    Author *authors = malloc((header->author_count > 0 ? header->author_count : 1) * sizeof(Author));
+    Genre *genres = malloc((header->genre_count > 0 ? header->genre_count : 1) * sizeof(Genre));
+    Book *books = malloc(COLUMNAR_BLOCK_ROWS * sizeof(Book));
+    int *sizes = malloc(COLUMNAR_BLOCK_ROWS * sizeof(int));
+    ColumnarBuffers buffers;
+    int failed = columnar_buffers_init(&buffers);
+
+    if (!authors || !genres || !books || !sizes) {
+        LOG_ERROR(ALLOCATION_ERROR);
+        failed = 1;
+    }
+
+    for (uint64_t i = 0; i < header->author_count && !failed; i++) {
+        authors[i].id = file.authors[i].id;
+        snprintf(authors[i].name, MAX_AUTHOR_NAME, "%.*s", MAX_AUTHOR_NAME - 1, file.authors[i].name);
+    }
+
+    for (uint64_t i = 0; i < header->genre_count && !failed; i++) {
+        genres[i].id = file.genres[i].id;
+        snprintf(genres[i].name, MAX_GENRE, "%.*s", MAX_GENRE - 1, file.genres[i].name);
+    }
+
+    failed = failed || lb_add_authors_bulk(lib, authors, (int)header->author_count) != 0 ||
+             lb_add_genres_bulk(lib, genres, (int)header->genre_count) != 0 ||
+             lb_reserve(lib, (int)header->book_count, 0, 0) != 0;
+
+    for (uint64_t b = 0; b < header->block_count && !failed; b++) {
+        failed = columnar_load_block(&file, &file.blocks[b], &buffers, lib, books, sizes);
+    }
+
+    if (failed) {
+        LOG_ERROR("Columnar Load Failed - %s", path);
+    } else {
+        LOG_INFO("Columnar File Loaded - %s - %d Books", path, lib->book_count);
+    }
+
+    columnar_buffers_free(&buffers);
+    free(authors);
+    free(genres);
+    free(books);
+    free(sizes);
+    columnar_close(&file);
+    return failed;
+}
+
+// Scans
+
+int columnar_summary(const ColumnarFile *file, ColumnarSummary *summary) {
+    if (!file || !file->map || !summary) {
+        LOG_ERROR(NULL_ERROR);
+        return 1;
+    }
+
+    memset(summary, 0, sizeof(*summary));
+    summary->authors = (long)file->header->author_count;
+    summary->genres = (long)file->header->genre_count;
+    summary->year_min = INT_MAX;
+    summary->year_max = INT_MIN;
+
+    for (uint64_t b = 0; b < file->header->block_count; b++) {
+        const ColumnarBlock *block = &file->blocks[b];
+        if (block->rows == 0) {
+            continue;
+        }
+
+        summary->books += (long)block->rows;
+        summary->author_links += (long)block->author_links;
+        summary->genre_links += (long)block->genre_links;
+        summary->year_min = block->year_min < summary->year_min ? block->year_min : summary->year_min;
+        summary->year_max = block->year_max > summary->year_max ? block->year_max : summary->year_max;
+    }
+
+    if (summary->books == 0) {
+        summary->year_min = 0;
+        summary->year_max = 0;
+    }
+
+    return 0;
+}
+
+int columnar_count_by_year(ColumnarFile *file, int from_year, int to_year, long *count) {
+    if (!file || !file->map || !count) {
+        LOG_ERROR(NULL_ERROR);
+        return 1;
+    }
+
+    *count = 0;
+    int *years = malloc(COLUMNAR_BLOCK_ROWS * sizeof(int));
+    if (!years) {
+        LOG_ERROR(ALLOCATION_ERROR);
+        return 1;
+    }
+
+    int failed = 0;
+
+    for (uint64_t b = 0; b < file->header->block_count && !failed; b++) {
+        const ColumnarBlock *block = &file->blocks[b];
+
+        // Blocks wholly out of (or wholly in) the range need no decoding
+        if (block->rows == 0 || block->year_max < from_year || block->year_min > to_year) {
+            file->blocks_skipped++;
+            continue;
+        }
+
+        if (block->year_min >= from_year && block->year_max <= to_year) {
+            *count += (long)block->rows;
+            file->blocks_skipped++;
+            continue;
+        }
+
+        if (!columnar_decode(file, block->column_offset[COLUMNAR_YEAR], block->rows, years)) {
+            failed = 1;
+            break;
+        }
+
+        file->blocks_read++;
+        for (uint32_t i = 0; i < block->rows; i++) {
+            *count += years[i] >= from_year && years[i] <= to_year;
+        }
+    }
+
+    free(years);
+    return failed;
+}
+
+static int columnar_count_lists(ColumnarFile *file, int id, int authors, long *count) {
+    if (!file || !file->map || !count) {
+        LOG_ERROR(NULL_ERROR);
+        return 1;
+    }
+
+    *count = 0;
+
+    // The dictionary is sorted by id
+    uint64_t low = 0;
+    uint64_t high = authors ? file->header->author_count : file->header->genre_count;
+    while (low < high) {
+        uint64_t mid = (low + high) / 2;
+        int mid_id = authors ? file->authors[mid].id : file->genres[mid].id;
+
+        if (mid_id < id) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    uint64_t entries = authors ? file->header->author_count : file->header->genre_count;
+    if (low == entries || (authors ? file->authors[low].id : file->genres[low].id) != id) {
+        return 0;
+    }
+
+    uint32_t code = (uint32_t)low;
+    ColumnarBuffers buffers;
+    if (columnar_buffers_init(&buffers) != 0) {
+        return 1;
+    }
+
+    int failed = 0;
+
+    for (uint64_t b = 0; b < file->header->block_count && !failed; b++) {
+        const ColumnarBlock *block = &file->blocks[b];
+        uint64_t links = authors ? block->author_links : block->genre_links;
+        uint32_t code_min = authors ? block->author_code_min : block->genre_code_min;
+        uint32_t code_max = authors ? block->author_code_max : block->genre_code_max;
+
+        if (links == 0 || code < code_min || code > code_max) {
+            file->blocks_skipped++;
+            continue;
+        }
+
+        if (columnar_decode_lists(file, block, &buffers, authors) != 0) {
+            failed = 1;
+            break;
+        }
+
+        file->blocks_read++;
+        uint64_t next = 0;
+
+        for (uint32_t i = 0; i < block->rows; i++) {
+            int has = 0;
+
+            for (int j = 0; j < buffers.ints[i]; j++) {
+                has |= (uint32_t)buffers.codes[next++] == code;
+            }
+
+            *count += has;
+        }
+    }
+
+    columnar_buffers_free(&buffers);
+    return failed;
+}
+
+int columnar_count_by_genre(ColumnarFile *file, int genre_id, long *count) {
+    return columnar_count_lists(file, genre_id, 0, count);
+}
+
+int columnar_count_by_author(ColumnarFile *file, int author_id, long *count) {
+    return columnar_count_lists(file, author_id, 1, count);
+}
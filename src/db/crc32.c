@@ -0,0 +1,31 @@
+#include <pthread.h>
+
+#include "crc32.h"
+
+static uint32_t crc32_table[256];
+static pthread_once_t crc32_once = PTHREAD_ONCE_INIT;
+
+static void crc32_init(void) {
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t crc = i;
+
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 1u) ? (crc >> 1) ^ 0xEDB88320u : crc >> 1;
+        }
+
+        crc32_table[i] = crc;
+    }
+}
+
+uint32_t crc32_update(uint32_t crc, const void *data, size_t size) {
+    pthread_once(&crc32_once, crc32_init);
+
+    const unsigned char *bytes = data;
+    crc = ~crc;
+
+    for (size_t i = 0; i < size; i++) {
+        crc = crc32_table[(crc ^ bytes[i]) & 0xFFu] ^ (crc >> 8);
+    }
+
+    return ~crc;
+}
@@ -0,0 +1,1781 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <time.h>
+
+#include "db.h"
+#include "crc32.h"
+#include "log.h"
+
+#define DB_LOAD_CHUNK 4096
+#define DB_WRITE_BUFFER (1 << 20)
+
+// Free room left in each section by checkpoints: a quarter of the used
+// size, at least this many entries
+#define DB_MIN_SLACK_RECORDS 64
+#define DB_MIN_SLACK_BYTES 4096
+
+_Static_assert(sizeof(int) == sizeof(int32_t), "id table stores int");
+_Static_assert(sizeof(DbHeader) == 168, "DbHeader layout changed");
+_Static_assert(sizeof(DbIndexHeader) == 80, "DbIndexHeader layout changed");
+_Static_assert(sizeof(HashEntry) == 8, "index section stores HashEntry");
+_Static_assert(sizeof(DbBookRecord) == 200, "DbBookRecord layout changed");
+
+typedef struct {
+    FILE *file;
+    uint64_t offset;
+    int failed;
+} DbWriter;
+
+static uint64_t db_align(uint64_t offset) {
+    return (offset + 7) & ~(uint64_t)7;
+}
+
+static const int *db_ids(const int *ids, const int *inline_ids) {
+    return ids ? ids : inline_ids;
+}
+
+static void db_write(DbWriter *writer, const void *data, size_t size) {
+    if (writer->failed || size == 0) {
+        return;
+    }
+
+    if (fwrite(data, 1, size, writer->file) != size) {
+        writer->failed = 1;
+        return;
+    }
+
+    writer->offset += size;
+}
+
+// Zero fill up to the next section
+static void db_pad(DbWriter *writer, uint64_t target) {
+    static const char zeros[8];
+
+    while (!writer->failed && writer->offset < target) {
+        uint64_t gap = target - writer->offset;
+        db_write(writer, zeros, gap < sizeof(zeros) ? (size_t)gap : sizeof(zeros));
+    }
+}
+
+static int db_section_fits(uint64_t offset, uint64_t count, uint64_t item, uint64_t size) {
+    return offset <= size && offset % 8 == 0 && count <= (size - offset) / item;
+}
+
+static void db_unmap(const char *view, size_t size) {
+    munmap((void *)view, size);
+}
+
+static void db_free_view(const char *view, size_t size) {
+    (void)size;
+    free((void *)view);
+}
+
+static int db_read_at(int fd, uint64_t offset, char *buffer, size_t size) {
+    size_t done = 0;
+
+    while (done < size) {
+        ssize_t got = pread(fd, buffer + done, size - done, (off_t)(offset + done));
+        if (got < 0 && errno == EINTR) {
+            continue;
+        }
+
+        if (got <= 0) {
+            return 1;
+        }
+
+        done += (size_t)got;
+    }
+
+    return 0;
+}
+
+// Description store callbacks, the context is the snapshot descriptor
+static int db_read_description(void *ctx, uint64_t offset, char *buffer, size_t size) {
+    return db_read_at((int)(intptr_t)ctx, offset, buffer, size);
+}
+
+static void db_close_descriptions(void *ctx) {
+    close((int)(intptr_t)ctx);
+}
+
+static uint64_t db_capacity(uint64_t count, int slack, uint64_t min_slack) {
+    if (!slack) {
+        return count;
+    }
+
+    uint64_t extra = count / 4;
+    return count + (extra > min_slack ? extra : min_slack);
+}
+
+static uint64_t db_postings_ids(const Postings *postings) {
+    uint64_t count = 0;
+
+    for (int i = 0; i < postings->list_count; i++) {
+        count += (uint64_t)postings->lists[i].count;
+    }
+
+    return count;
+}
+
+static uint64_t db_index_body_size(const Library *lib) {
+    uint64_t entries = (uint64_t)lib->isbn_index.capacity + (uint64_t)lib->author_index.capacity +
+                       (uint64_t)lib->genre_index.capacity;
+    uint64_t ints = (uint64_t)lib->genre_postings.list_count + 1 + db_postings_ids(&lib->genre_postings) +
+                    (uint64_t)lib->author_postings.list_count + 1 + db_postings_ids(&lib->author_postings);
+
+    return entries * sizeof(HashEntry) + ints * sizeof(int32_t);
+}
+
+// Section offsets of a library, header.file_size included. With slack the
+// sections get free room for incremental checkpoints.
+static void db_layout(const Library *lib, uint64_t sequence, int slack, DbHeader *header) {
+    uint64_t id_count = 0;
+    uint64_t string_size = 0;
+    char *text = NULL;
+    size_t text_capacity = 0;
+
+    for (int i = 0; i < lib->book_count; i++) {
+        const Book *book = &lib->books[i];
+        const char *description = lb_read_book_description(lib, book, &text, &text_capacity);
+        id_count += (uint64_t)book->genre_count + (uint64_t)book->author_count;
+
+        if (description) {
+            string_size += strlen(description) + 1;
+        }
+    }
+
+    free(text);
+
+    memset(header, 0, sizeof(*header));
+    memcpy(header->magic, DB_MAGIC, sizeof(header->magic));
+    header->version = DB_VERSION;
+    header->byte_order = DB_BYTE_ORDER;
+    header->journal_sequence = sequence;
+
+    uint64_t offset = sizeof(DbHeader);
+
+    header->author_offset = offset;
+    header->author_count = (uint64_t)lib->author_count;
+    header->author_capacity = db_capacity(header->author_count, slack, DB_MIN_SLACK_RECORDS);
+    offset = db_align(offset + header->author_capacity * sizeof(DbAuthorRecord));
+
+    header->genre_offset = offset;
+    header->genre_count = (uint64_t)lib->genre_count;
+    header->genre_capacity = db_capacity(header->genre_count, slack, DB_MIN_SLACK_RECORDS);
+    offset = db_align(offset + header->genre_capacity * sizeof(DbGenreRecord));
+
+    header->book_offset = offset;
+    header->book_count = (uint64_t)lib->book_count;
+    header->book_capacity = db_capacity(header->book_count, slack, DB_MIN_SLACK_RECORDS);
+    offset = db_align(offset + header->book_capacity * sizeof(DbBookRecord));
+
+    header->id_offset = offset;
+    header->id_count = id_count;
+    header->id_capacity = db_capacity(id_count, slack, DB_MIN_SLACK_RECORDS * 4);
+    offset = db_align(offset + header->id_capacity * sizeof(int32_t));
+
+    header->index_offset = offset;
+    header->index_size = sizeof(DbIndexHeader) + db_index_body_size(lib);
+    offset = db_align(offset + header->index_size);
+
+    header->string_offset = offset;
+    header->string_size = string_size;
+    header->string_capacity = db_capacity(string_size, slack, DB_MIN_SLACK_BYTES);
+    header->file_size = db_align(offset + header->string_capacity);
+}
+
+// Records are zeroed first, so the copy keeps at least one NUL at the end
+static void db_copy_text(char *dest, const char *text, size_t size) {
+    memcpy(dest, text, strnlen(text, size - 1));
+}
+
+static void db_author_record(const Author *author, DbAuthorRecord *record) {
+    memset(record, 0, sizeof(*record));
+    record->id = author->id;
+    db_copy_text(record->name, author->name, sizeof(record->name));
+}
+
+static void db_genre_record(const Genre *genre, DbGenreRecord *record) {
+    memset(record, 0, sizeof(*record));
+    record->id = genre->id;
+    db_copy_text(record->name, genre->name, sizeof(record->name));
+}
+
+// Record of a book whose ids start at entry id_next of the id table and
+// whose description starts at byte string_next of the string heap
+static void db_book_record(const Book *book, const char *description, uint64_t id_next, uint64_t string_next,
+                           DbBookRecord *record) {
+    memset(record, 0, sizeof(*record));
+
+    record->id = book->id;
+    record->publication_year = book->publication_year;
+    db_copy_text(record->title, book->title, sizeof(record->title));
+    db_copy_text(record->isbn, book->isbn, sizeof(record->isbn));
+
+    record->genre_count = (uint32_t)book->genre_count;
+    record->genre_offset = id_next;
+    record->author_count = (uint32_t)book->author_count;
+    record->author_offset = id_next + record->genre_count;
+
+    record->description_offset = DB_NONE;
+    if (description) {
+        record->description_offset = string_next;
+        record->description_length = strlen(description);
+    }
+}
+
+// Sink of the index section body: crc32 on the first pass, file on the second
+typedef void (*DbEmitFn)(void *ctx, const void *data, size_t size);
+
+static void db_emit_crc(void *ctx, const void *data, size_t size) {
+    uint32_t *crc = ctx;
+    *crc = crc32_update(*crc, data, size);
+}
+
+static void db_emit_write(void *ctx, const void *data, size_t size) {
+    db_write(ctx, data, size);
+}
+
+// Lists hold slots, saved as dense book indexes like the ISBN entries
+static void db_emit_postings(const Library *lib, const Postings *postings, DbEmitFn emit, void *ctx) {
+    int offset = 0;
+    int chunk[256];
+
+    emit(ctx, &offset, sizeof(offset));
+    for (int i = 0; i < postings->list_count; i++) {
+        offset += postings->lists[i].count;
+        emit(ctx, &offset, sizeof(offset));
+    }
+
+    for (int i = 0; i < postings->list_count; i++) {
+        const PostingList *list = &postings->lists[i];
+
+        for (int done = 0; done < list->count;) {
+            int n = 0;
+            while (n < (int)(sizeof(chunk) / sizeof(chunk[0])) && done < list->count) {
+                chunk[n++] = lib->slot_books[list->ids[done++]];
+            }
+
+            emit(ctx, chunk, (size_t)n * sizeof(int));
+        }
+    }
+}
+
+static void db_emit_index_body(const Library *lib, DbEmitFn emit, void *ctx) {
+    // Slots do not survive a reload, books are saved densely
+    for (int i = 0; i < lib->isbn_index.capacity; i++) {
+        HashEntry entry = lib->isbn_index.entries[i];
+        if (entry.value >= 0) {
+            entry.value = lib->slot_books[entry.value];
+        }
+
+        emit(ctx, &entry, sizeof(entry));
+    }
+
+    emit(ctx, lib->author_index.entries, (size_t)lib->author_index.capacity * sizeof(HashEntry));
+    emit(ctx, lib->genre_index.entries, (size_t)lib->genre_index.capacity * sizeof(HashEntry));
+    db_emit_postings(lib, &lib->genre_postings, emit, ctx);
+    db_emit_postings(lib, &lib->author_postings, emit, ctx);
+}
+
+static void db_write_index(DbWriter *writer, const Library *lib, const DbHeader *header) {
+    DbIndexHeader index;
+    memset(&index, 0, sizeof(index));
+
+    index.sequence = header->journal_sequence;
+    index.size = header->index_size - sizeof(DbIndexHeader);
+    index.isbn_capacity = lib->isbn_index.capacity;
+    index.isbn_count = lib->isbn_index.count;
+    index.isbn_tombstones = lib->isbn_index.tombstones;
+    index.author_capacity = lib->author_index.capacity;
+    index.author_count = lib->author_index.count;
+    index.author_tombstones = lib->author_index.tombstones;
+    index.genre_capacity = lib->genre_index.capacity;
+    index.genre_count = lib->genre_index.count;
+    index.genre_tombstones = lib->genre_index.tombstones;
+    index.genre_lists = lib->genre_postings.list_count;
+    index.genre_ids = (int32_t)db_postings_ids(&lib->genre_postings);
+    index.author_lists = lib->author_postings.list_count;
+    index.author_ids = (int32_t)db_postings_ids(&lib->author_postings);
+
+    db_emit_index_body(lib, db_emit_crc, &index.crc);
+    db_write(writer, &index, sizeof(index));
+    db_emit_index_body(lib, db_emit_write, writer);
+}
+
+static void db_write_sections(DbWriter *writer, const Library *lib, const DbHeader *header) {
+    db_write(writer, header, sizeof(*header));
+
+    for (int i = 0; i < lib->author_count; i++) {
+        DbAuthorRecord record;
+        db_author_record(&lib->authors[i], &record);
+        db_write(writer, &record, sizeof(record));
+    }
+
+    db_pad(writer, header->genre_offset);
+
+    for (int i = 0; i < lib->genre_count; i++) {
+        DbGenreRecord record;
+        db_genre_record(&lib->genres[i], &record);
+        db_write(writer, &record, sizeof(record));
+    }
+
+    db_pad(writer, header->book_offset);
+
+    uint64_t id_next = 0;
+    uint64_t string_next = 0;
+
+    // Descriptions left in a file are copied here, not read from the cache
+    char *text = NULL;
+    size_t text_capacity = 0;
+
+    for (int i = 0; i < lib->book_count; i++) {
+        const char *description = lb_read_book_description(lib, &lib->books[i], &text, &text_capacity);
+
+        // A description that cannot be read back from its file fails the save
+        if (!description && book_description_ref(&lib->books[i]) >= 0) {
+            writer->failed = 1;
+        }
+
+        DbBookRecord record;
+        db_book_record(&lib->books[i], description, id_next, string_next, &record);
+        db_write(writer, &record, sizeof(record));
+
+        id_next += (uint64_t)record.genre_count + record.author_count;
+        if (record.description_offset != DB_NONE) {
+            string_next += record.description_length + 1;
+        }
+    }
+
+    db_pad(writer, header->id_offset);
+
+    for (int i = 0; i < lib->book_count; i++) {
+        const Book *book = &lib->books[i];
+        db_write(writer, db_ids(book->genre_ids, book->genre_inline), (size_t)book->genre_count * sizeof(int));
+        db_write(writer, db_ids(book->author_ids, book->author_inline), (size_t)book->author_count * sizeof(int));
+    }
+
+    db_pad(writer, header->index_offset);
+    db_write_index(writer, lib, header);
+    db_pad(writer, header->string_offset);
+
+    for (int i = 0; i < lib->book_count; i++) {
+        const char *description = lb_read_book_description(lib, &lib->books[i], &text, &text_capacity);
+
+        if (description) {
+            db_write(writer, description, strlen(description) + 1);
+        }
+    }
+
+    free(text);
+
+    db_pad(writer, header->file_size);
+}
+
+static int db_write_snapshot(const Library *lib, const char *path, uint64_t sequence, int slack, DbHeader *written) {
+    // Named after the writing process, so a background child and a
+    // checkpoint of the parent never share a temporary file
+    size_t tmp_size = strlen(path) + 32;
+    char *tmp_path = malloc(tmp_size);
+    if (!tmp_path) {
+        LOG_ERROR(ALLOCATION_ERROR);
+        return 1;
+    }
+
+    snprintf(tmp_path, tmp_size, "%s.%ld.tmp", path, (long)getpid());
+
+    DbWriter writer = { fopen(tmp_path, "wb"), 0, 0 };
+    if (!writer.file) {
+        LOG_ERROR("Snapshot Create Failed - %s", tmp_path);
+        free(tmp_path);
+        return 1;
+    }
+
+    setvbuf(writer.file, NULL, _IOFBF, DB_WRITE_BUFFER);
+
+    DbHeader header;
+    db_layout(lib, sequence, slack, &header);
+    db_write_sections(&writer, lib, &header);
+
+    if (fflush(writer.file) != 0 || fsync(fileno(writer.file)) != 0) {
+        writer.failed = 1;
+    }
+
+    if (fclose(writer.file) != 0) {
+        writer.failed = 1;
+    }
+
+    if (writer.failed || writer.offset != header.file_size || rename(tmp_path, path) != 0) {
+        LOG_ERROR("Snapshot Write Failed - %s", path);
+        remove(tmp_path);
+        free(tmp_path);
+        return 1;
+    }
+
+    free(tmp_path);
+
+    if (written) {
+        *written = header;
+    }
+
+    LOG_INFO("Snapshot Saved - %s - %d Books", path, lib->book_count);
+    return 0;
+}
+
+int db_save(const Library *lib, const char *path) {
+    if (!lib || !path) {
+        LOG_ERROR(NULL_ERROR);
+        return 1;
+    }
+
+    return db_write_snapshot(lib, path, 0, 0, NULL);
+}
+
+static double db_now(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+}
+
+static void db_on_change(void *ctx, const LibraryChange *change);
+
+// 1 if both paths name the same file (or the same name not yet created)
+static int db_same_file(const char *a, const char *b) {
+    struct stat sa, sb;
+
+    if (strcmp(a, b) == 0) {
+        return 1;
+    }
+
+    return stat(a, &sa) == 0 && stat(b, &sb) == 0 && sa.st_dev == sb.st_dev && sa.st_ino == sb.st_ino;
+}
+
+int db_snapshot_async(const Library *lib, const char *path, DbSnapshotJob *job) {
+    if (!lib || !path || !job) {
+        LOG_ERROR(NULL_ERROR);
+        return 1;
+    }
+
+    // Renaming over the snapshot of an open database would change the
+    // layout its incremental checkpoints write into
+    if (lib->on_change == db_on_change && db_same_file(path, ((const Db *)lib->change_ctx)->path)) {
+        LOG_ERROR("Snapshot Path In Use - %s", path);
+        return 1;
+    }
+
+    memset(job, 0, sizeof(*job));
+    job->started = db_now();
+
+    // Only the forking thread lives on in the child: no other thread may be
+    // halfway through a change, or hold the store lock the child reads
+    // descriptions through, when the image is taken
+    lb_read_lock(lib, NULL);
+
+    if (lib->descriptions) {
+        pthread_mutex_lock(&lib->descriptions->lock);
+    }
+
+    pid_t pid = fork();
+
+    if (lib->descriptions) {
+        pthread_mutex_unlock(&lib->descriptions->lock);
+    }
+
+    if (pid == 0) {
+        // The child sees the library frozen at the fork and leaves through
+        // _exit so nothing of the parent (stdio buffers, atexit) runs twice
+        _exit(db_write_snapshot(lib, path, 0, 0, NULL) != 0 ? 1 : 0);
+    }
+
+    lb_read_unlock(lib, NULL);
+
+    if (pid < 0) {
+        LOG_ERROR("Snapshot Fork Failed - %s", path);
+        return 1;
+    }
+
+    job->pid = pid;
+    job->running = 1;
+    LOG_INFO("Background Snapshot Started - %s - %d Books", path, lib->book_count);
+    return 0;
+}
+
+int db_snapshot_poll(DbSnapshotJob *job, int wait) {
+    if (!job) {
+        LOG_ERROR(NULL_ERROR);
+        return 1;
+    }
+
+    if (!job->running) {
+        return 0;
+    }
+
+    int status;
+    pid_t done;
+
+    do {
+        done = waitpid(job->pid, &status, wait ? 0 : WNOHANG);
+    } while (done < 0 && errno == EINTR);
+
+    if (done < 0) {
+        LOG_ERROR("Background Snapshot Lost - %d", (int)job->pid);
+        job->running = 0;
+        job->status = 1;
+        return 1;
+    }
+
+    if (done == 0) {
+        return 0;
+    }
+
+    job->running = 0;
+    job->status = WIFEXITED(status) && WEXITSTATUS(status) == 0 ? 0 : 1;
+    job->seconds = db_now() - job->started;
+
+    if (job->status != 0) {
+        LOG_ERROR("Background Snapshot Failed - %d", (int)job->pid);
+    } else {
+        LOG_INFO("Background Snapshot Done - %.3f s", job->seconds);
+    }
+
+    return 0;
+}
+
+static int db_validate(const DbHeader *header, uint64_t size) {
+    if (memcmp(header->magic, DB_MAGIC, sizeof(header->magic)) != 0) {
+        LOG_ERROR("Snapshot Magic Mismatch");
+        return 1;
+    }
+
+    if (header->version != DB_VERSION || header->byte_order != DB_BYTE_ORDER) {
+        LOG_ERROR("Unsupported Snapshot Version - %u", header->version);
+        return 1;
+    }
+
+    if (header->file_size != size ||
+        header->author_capacity > INT_MAX || header->genre_capacity > INT_MAX || header->book_capacity > INT_MAX ||
+        header->author_count > header->author_capacity || header->genre_count > header->genre_capacity ||
+        header->book_count > header->book_capacity || header->id_count > header->id_capacity ||
+        header->string_size > header->string_capacity ||
+        !db_section_fits(header->author_offset, header->author_capacity, sizeof(DbAuthorRecord), size) ||
+        !db_section_fits(header->genre_offset, header->genre_capacity, sizeof(DbGenreRecord), size) ||
+        !db_section_fits(header->book_offset, header->book_capacity, sizeof(DbBookRecord), size) ||
+        !db_section_fits(header->id_offset, header->id_capacity, sizeof(int32_t), size) ||
+        !db_section_fits(header->index_offset, header->index_size, 1, header->string_offset) ||
+        !db_section_fits(header->string_offset, header->string_capacity, 1, size)) {
+        LOG_ERROR("Corrupted Snapshot Header");
+        return 1;
+    }
+
+    return 0;
+}
+
+// Id list of a record: inline copy when short, view into the id table otherwise
+static int db_load_ids(const DbHeader *header, const char *base, uint64_t offset, uint32_t count,
+                       int **ids, int *ids_count, int *inline_ids) {
+    if (count > INT_MAX || offset > header->id_count || count > header->id_count - offset) {
+        return 1;
+    }
+
+    const int *table = (const int *)(const void *)(base + header->id_offset) + offset;
+
+    if (count <= BOOK_INLINE_IDS) {
+        memcpy(inline_ids, table, count * sizeof(int));
+        *ids = NULL;
+    } else {
+        *ids = (int *)table;
+    }
+
+    *ids_count = (int)count;
+    return 0;
+}
+
+// Descriptions become references into store when one is given (the string
+// heap is then not in base), views into base otherwise
+static int db_load_book(const DbHeader *header, const char *base, DescriptionStore *store,
+                        const DbBookRecord *record, Book *book) {
+    memset(book, 0, sizeof(*book));
+
+    if (!memchr(record->title, '\0', MAX_TITLE) || !memchr(record->isbn, '\0', ISBN_SIZE)) {
+        return 1;
+    }
+
+    book->id = record->id;
+    book->publication_year = record->publication_year;
+    memcpy(book->title, record->title, MAX_TITLE);
+    memcpy(book->isbn, record->isbn, ISBN_SIZE);
+
+    if (db_load_ids(header, base, record->genre_offset, record->genre_count,
+                    &book->genre_ids, &book->genre_count, book->genre_inline) != 0 ||
+        db_load_ids(header, base, record->author_offset, record->author_count,
+                    &book->author_ids, &book->author_count, book->author_inline) != 0) {
+        return 1;
+    }
+
+    if (record->description_offset != DB_NONE) {
+        const char *heap = base + header->string_offset;
+        uint64_t offset = record->description_offset;
+
+        if (offset >= header->string_size || record->description_length >= header->string_size - offset ||
+            record->description_length > UINT32_MAX) {
+            return 1;
+        }
+
+        // The NUL of a text left in the file is checked when it is read
+        if (store) {
+            int ref;
+            if (description_store_add(store, header->string_offset + offset,
+                                      (uint32_t)record->description_length, &ref) != 0) {
+                return 1;
+            }
+
+            book_set_description_ref(book, ref);
+            return 0;
+        }
+
+        if (heap[offset + record->description_length] != '\0') {
+            return 1;
+        }
+
+        book->description = (char *)(heap + offset);
+    }
+
+    return 0;
+}
+
+static int db_load_authors(Library *lib, const DbHeader *header, const char *base) {
+    int count = (int)header->author_count;
+    if (count == 0) {
+        return 0;
+    }
+
+    Author *authors = malloc((size_t)count * sizeof(Author));
+    if (!authors) {
+        LOG_ERROR(ALLOCATION_ERROR);
+        return 1;
+    }
+
+    const DbAuthorRecord *records = (const void *)(base + header->author_offset);
+    for (int i = 0; i < count; i++) {
+        authors[i].id = records[i].id;
+        memcpy(authors[i].name, records[i].name, MAX_AUTHOR_NAME);
+        authors[i].name[MAX_AUTHOR_NAME - 1] = '\0';
+    }
+
+    int failed = lb_add_authors_bulk(lib, authors, count);
+    free(authors);
+    return failed;
+}
+
+static int db_load_genres(Library *lib, const DbHeader *header, const char *base) {
+    int count = (int)header->genre_count;
+    if (count == 0) {
+        return 0;
+    }
+
+    Genre *genres = malloc((size_t)count * sizeof(Genre));
+    if (!genres) {
+        LOG_ERROR(ALLOCATION_ERROR);
+        return 1;
+    }
+
+    const DbGenreRecord *records = (const void *)(base + header->genre_offset);
+    for (int i = 0; i < count; i++) {
+        genres[i].id = records[i].id;
+        memcpy(genres[i].name, records[i].name, MAX_GENRE);
+        genres[i].name[MAX_GENRE - 1] = '\0';
+    }
+
+    int failed = lb_add_genres_bulk(lib, genres, count);
+    free(genres);
+    return failed;
+}
+
+static int db_load_books(Library *lib, const DbHeader *header, const char *base) {
+    DescriptionStore *store = lib->descriptions;
+    int book_count = (int)header->book_count;
+
+    if (book_count == 0) {
+        return 0;
+    }
+
+    if (lb_reserve(lib, book_count, 0, 0) != 0) {
+        return 1;
+    }
+
+    int chunk_size = book_count < DB_LOAD_CHUNK ? book_count : DB_LOAD_CHUNK;
+    Book *chunk = malloc((size_t)chunk_size * sizeof(Book));
+    if (!chunk) {
+        LOG_ERROR(ALLOCATION_ERROR);
+        return 1;
+    }
+
+    const DbBookRecord *records = (const void *)(base + header->book_offset);
+    int pending = 0;
+
+    int failed = 0;
+
+    for (int i = 0; i < book_count && !failed; i++) {
+        // Removed records wait for a book to reuse them
+        if (records[i].flags & DB_RECORD_REMOVED) {
+            continue;
+        }
+
+        if (db_load_book(header, base, store, &records[i], &chunk[pending]) != 0) {
+            LOG_ERROR("Corrupted Snapshot Record - %d", i);
+            failed = 1;
+        } else if (++pending == chunk_size) {
+            failed = lb_add_books_bulk(lib, chunk, pending);
+            pending = 0;
+        }
+    }
+
+    if (!failed && pending > 0) {
+        failed = lb_add_books_bulk(lib, chunk, pending);
+    }
+
+    free(chunk);
+    return failed;
+}
+
+// Offsets of saved postings must start at 0, never decrease and end at ids
+static int db_offsets_valid(const int *offsets, int lists, int ids) {
+    if (offsets[0] != 0 || offsets[lists] != ids) {
+        return 0;
+    }
+
+    for (int i = 0; i < lists; i++) {
+        if (offsets[i + 1] < offsets[i]) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+// Saved indexes of the snapshot, 1 when they are missing, damaged or stale
+static int db_load_indexes(const DbHeader *header, const char *base, LibraryIndexes *indexes) {
+    DbIndexHeader index;
+    if (header->index_size < sizeof(index)) {
+        return 1;
+    }
+
+    memcpy(&index, base + header->index_offset, sizeof(index));
+    const char *body = base + header->index_offset + sizeof(index);
+
+    if (index.sequence != header->journal_sequence || index.size != header->index_size - sizeof(index) ||
+        index.isbn_capacity < 0 || index.author_capacity < 0 || index.genre_capacity < 0 ||
+        index.genre_lists < 0 || index.genre_ids < 0 || index.author_lists < 0 || index.author_ids < 0) {
+        return 1;
+    }
+
+    uint64_t entries = (uint64_t)index.isbn_capacity + (uint64_t)index.author_capacity +
+                       (uint64_t)index.genre_capacity;
+    uint64_t ints = (uint64_t)index.genre_lists + 1 + (uint64_t)index.genre_ids +
+                    (uint64_t)index.author_lists + 1 + (uint64_t)index.author_ids;
+
+    if (entries * sizeof(HashEntry) + ints * sizeof(int32_t) != index.size ||
+        crc32_update(0, body, (size_t)index.size) != index.crc) {
+        return 1;
+    }
+
+    const HashEntry *tables = (const void *)body;
+    const int *postings = (const void *)(tables + entries);
+
+    indexes->isbn_entries = tables;
+    indexes->isbn_capacity = index.isbn_capacity;
+    indexes->isbn_count = index.isbn_count;
+    indexes->isbn_tombstones = index.isbn_tombstones;
+
+    indexes->author_entries = tables + index.isbn_capacity;
+    indexes->author_capacity = index.author_capacity;
+    indexes->author_count = index.author_count;
+    indexes->author_tombstones = index.author_tombstones;
+
+    indexes->genre_entries = tables + index.isbn_capacity + index.author_capacity;
+    indexes->genre_capacity = index.genre_capacity;
+    indexes->genre_count = index.genre_count;
+    indexes->genre_tombstones = index.genre_tombstones;
+
+    indexes->genre_offsets = postings;
+    indexes->genre_ids = postings + index.genre_lists + 1;
+    indexes->genre_lists = index.genre_lists;
+
+    indexes->author_offsets = indexes->genre_ids + index.genre_ids;
+    indexes->author_ids = indexes->author_offsets + index.author_lists + 1;
+    indexes->author_lists = index.author_lists;
+
+    if (!db_offsets_valid(indexes->genre_offsets, index.genre_lists, index.genre_ids) ||
+        !db_offsets_valid(indexes->author_offsets, index.author_lists, index.author_ids)) {
+        return 1;
+    }
+
+    return 0;
+}
+
+// Records are added unindexed, then the saved indexes are installed (or
+// rebuilt when they no longer match the records)
+static int db_load_library(Library *lib, const DbHeader *header, const char *base) {
+    lb_defer_indexes(lib);
+
+    if (db_load_authors(lib, header, base) != 0 || db_load_genres(lib, header, base) != 0 ||
+        db_load_books(lib, header, base) != 0) {
+        return 1;
+    }
+
+    LibraryIndexes indexes;
+    if (db_load_indexes(header, base, &indexes) != 0) {
+        LOG_WARN("Snapshot Indexes Stale - Rebuilding");
+        return lb_restore_indexes(lib, NULL);
+    }
+
+    return lb_restore_indexes(lib, &indexes);
+}
+
+// Read every section before the string heap, the descriptor stays open
+// in the description store of the library
+static int db_read_snapshot(const char *path, Library *lib, DbHeader *loaded, int fd, size_t size,
+                            int description_cache) {
+    DbHeader header;
+    if (db_read_at(fd, 0, (char *)&header, sizeof(header)) != 0 || db_validate(&header, size) != 0) {
+        LOG_ERROR("Corrupted Snapshot - %s", path);
+        close(fd);
+        return 1;
+    }
+
+    char *base = malloc((size_t)header.string_offset);
+    DescriptionStore *store = malloc(sizeof(DescriptionStore));
+
+    if (!base || !store) {
+        LOG_ERROR(ALLOCATION_ERROR);
+        free(base);
+        free(store);
+        close(fd);
+        return 1;
+    }
+
+    if (db_read_at(fd, 0, base, (size_t)header.string_offset) != 0) {
+        LOG_ERROR("Snapshot Read Failed - %s", path);
+        free(base);
+        free(store);
+        close(fd);
+        return 1;
+    }
+
+    if (description_store_init(store, description_cache, db_read_description, db_close_descriptions,
+                               (void *)(intptr_t)fd) != 0) {
+        free(base);
+        free(store);
+        close(fd);
+        return 1;
+    }
+
+    // The library owns the sections and the store from here
+    if (lb_attach_view(lib, base, (size_t)header.string_offset, db_free_view) != 0) {
+        description_store_free(store);
+        free(store);
+        free(base);
+        return 1;
+    }
+
+    if (lb_attach_descriptions(lib, store) != 0 || db_load_library(lib, &header, base) != 0) {
+        if (!lib->descriptions) {
+            description_store_free(store);
+            free(store);
+        }
+
+        lb_clear(lib);
+        return 1;
+    }
+
+    *loaded = header;
+    LOG_INFO("Snapshot Opened - %s - %d Books - Descriptions on Demand", path, lib->book_count);
+    return 0;
+}
+
+// Map the whole snapshot. With description_cache > 0 every section but the
+// string heap is read into memory instead, and descriptions are read from
+// the file on demand through a store of that many entries.
+static int db_map_snapshot(const char *path, Library *lib, DbHeader *mapped, int description_cache) {
+    if (lib->book_count > 0 || lib->author_count > 0 || lib->genre_count > 0 || lib->view || lib->descriptions) {
+        LOG_ERROR("Snapshot needs an empty Library");
+        return 1;
+    }
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        LOG_ERROR("Snapshot not Found - %s", path);
+        return 1;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(DbHeader)) {
+        LOG_ERROR("Corrupted Snapshot - %s", path);
+        close(fd);
+        return 1;
+    }
+
+    size_t size = (size_t)st.st_size;
+
+    if (description_cache > 0) {
+        return db_read_snapshot(path, lib, mapped, fd, size, description_cache);
+    }
+
+    void *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (map == MAP_FAILED) {
+        LOG_ERROR("Snapshot Map Failed - %s", path);
+        return 1;
+    }
+
+    const char *base = map;
+    const DbHeader *header = map;
+
+    if (db_validate(header, size) != 0) {
+        munmap(map, size);
+        return 1;
+    }
+
+    if (lb_attach_view(lib, base, size, db_unmap) != 0) {
+        munmap(map, size);
+        return 1;
+    }
+
+    // The library owns the mapping from here, lb_clear releases it
+    if (db_load_library(lib, header, base) != 0) {
+        lb_clear(lib);
+        return 1;
+    }
+
+    *mapped = *header;
+    LOG_INFO("Snapshot Opened - %s - %d Books", path, lib->book_count);
+    return 0;
+}
+
+int db_open_mmap(const char *path, Library *lib) {
+    if (!path || !lib) {
+        LOG_ERROR(NULL_ERROR);
+        return 1;
+    }
+
+    DbHeader header;
+    return db_map_snapshot(path, lib, &header, 0);
+}
+
+int db_open_lazy(const char *path, Library *lib, int description_cache) {
+    if (!path || !lib) {
+        LOG_ERROR(NULL_ERROR);
+        return 1;
+    }
+
+    DbHeader header;
+    return db_map_snapshot(path, lib, &header, description_cache > 0 ? description_cache : DB_DESCRIPTION_CACHE);
+}
+
+
+// Journal entries: u8 kind | i32 value | isbn | text, and for an added
+// book i32 id | i32 year | title | genre ids | author ids | description.
+// Strings are u32 length + bytes + NUL (UINT32_MAX for NULL), id lists are
+// u32 count + ids, so replay reads everything in place.
+
+typedef struct {
+    char *data;
+    size_t size;
+    size_t capacity;
+    int failed;
+} DbBuffer;
+
+typedef struct {
+    const char *data;
+    size_t size;
+    size_t offset;
+    int failed;
+} DbReader;
+
+static void db_put(DbBuffer *buffer, const void *data, size_t size) {
+    if (buffer->failed) {
+        return;
+    }
+
+    if (buffer->size + size > buffer->capacity) {
+        size_t new_cap = buffer->capacity ? buffer->capacity : 256;
+        while (new_cap < buffer->size + size) {
+            new_cap *= 2;
+        }
+
+        char *tmp = realloc(buffer->data, new_cap);
+        if (!tmp) {
+            LOG_ERROR(REALLOCATION_ERROR);
+            buffer->failed = 1;
+            return;
+        }
+
+        buffer->data = tmp;
+        buffer->capacity = new_cap;
+    }
+
+    if (size > 0) {
+        memcpy(buffer->data + buffer->size, data, size);
+        buffer->size += size;
+    }
+}
+
+static void db_put_u32(DbBuffer *buffer, uint32_t value) {
+    db_put(buffer, &value, sizeof(value));
+}
+
+static void db_put_string(DbBuffer *buffer, const char *text) {
+    if (!text) {
+        db_put_u32(buffer, UINT32_MAX);
+        return;
+    }
+
+    size_t length = strlen(text);
+    db_put_u32(buffer, (uint32_t)length);
+    db_put(buffer, text, length + 1);
+}
+
+static void db_put_ids(DbBuffer *buffer, const int *ids, int count) {
+    db_put_u32(buffer, (uint32_t)count);
+    db_put(buffer, ids, (size_t)count * sizeof(int));
+}
+
+static void db_encode_change(DbBuffer *buffer, const Library *lib, const LibraryChange *change) {
+    unsigned char kind = (unsigned char)change->kind;
+    db_put(buffer, &kind, sizeof(kind));
+    db_put_u32(buffer, (uint32_t)change->value);
+    db_put_string(buffer, change->isbn);
+    db_put_string(buffer, change->text);
+
+    if (change->kind == LB_CHANGE_ADD_BOOK) {
+        const Book *book = change->book;
+
+        db_put_u32(buffer, (uint32_t)book->id);
+        db_put_u32(buffer, (uint32_t)book->publication_year);
+        db_put_string(buffer, book->title);
+        db_put_ids(buffer, db_ids(book->genre_ids, book->genre_inline), book->genre_count);
+        db_put_ids(buffer, db_ids(book->author_ids, book->author_inline), book->author_count);
+
+        char *text = NULL;
+        size_t text_capacity = 0;
+        db_put_string(buffer, lb_read_book_description(lib, book, &text, &text_capacity));
+        free(text);
+    }
+}
+
+static const void *db_get(DbReader *reader, size_t size) {
+    if (reader->failed || size > reader->size - reader->offset) {
+        reader->failed = 1;
+        return NULL;
+    }
+
+    const void *data = reader->data + reader->offset;
+    reader->offset += size;
+    return data;
+}
+
+static uint32_t db_get_u32(DbReader *reader) {
+    uint32_t value = 0;
+    const void *data = db_get(reader, sizeof(value));
+
+    if (data) {
+        memcpy(&value, data, sizeof(value));
+    }
+
+    return value;
+}
+
+static const char *db_get_string(DbReader *reader) {
+    uint32_t length = db_get_u32(reader);
+    if (reader->failed || length == UINT32_MAX) {
+        return NULL;
+    }
+
+    const char *text = db_get(reader, (size_t)length + 1);
+    if (text && text[length] != '\0') {
+        reader->failed = 1;
+        return NULL;
+    }
+
+    return text;
+}
+
+// Id list copied into the book: inline when short, owned buffer otherwise
+static int db_get_ids(DbReader *reader, int **ids, int *count, int *capacity, int *inline_ids) {
+    uint32_t length = db_get_u32(reader);
+    const void *data = length <= INT_MAX / sizeof(int) ? db_get(reader, (size_t)length * sizeof(int)) : NULL;
+
+    if (!data) {
+        reader->failed = 1;
+        return 1;
+    }
+
+    int *target = inline_ids;
+    if (length > BOOK_INLINE_IDS) {
+        target = malloc((size_t)length * sizeof(int));
+        if (!target) {
+            LOG_ERROR(ALLOCATION_ERROR);
+            return 1;
+        }
+
+        *ids = target;
+        *capacity = (int)length;
+    }
+
+    memcpy(target, data, (size_t)length * sizeof(int));
+    *count = (int)length;
+    return 0;
+}
+
+static int db_apply_add_book(Library *lib, DbReader *reader, const char *isbn) {
+    Book book;
+    book_init(&book);
+
+    book.id = (int)db_get_u32(reader);
+    book.publication_year = (int)db_get_u32(reader);
+    const char *title = db_get_string(reader);
+
+    if (!isbn || !title || reader->failed) {
+        return 1;
+    }
+
+    snprintf(book.isbn, ISBN_SIZE, "%s", isbn);
+    snprintf(book.title, MAX_TITLE, "%s", title);
+
+    int failed = db_get_ids(reader, &book.genre_ids, &book.genre_count, &book.genre_capacity, book.genre_inline) ||
+                 db_get_ids(reader, &book.author_ids, &book.author_count, &book.author_capacity, book.author_inline);
+
+    const char *description = db_get_string(reader);
+    if (!failed && !reader->failed && description) {
+        failed = book_update_description(&book, description);
+    }
+
+    if (failed || reader->failed || lb_add_book(lib, &book) != 0) {
+        book_free(&book);
+        return 1;
+    }
+
+    return 0;
+}
+
+static int db_apply_name(Library *lib, int kind, int id, const char *name) {
+    if (!name) {
+        return 1;
+    }
+
+    if (kind == LB_CHANGE_ADD_AUTHOR) {
+        // Bulk insert keeps the journaled id
+        Author author = { .id = id };
+        snprintf(author.name, MAX_AUTHOR_NAME, "%s", name);
+        return lb_add_authors_bulk(lib, &author, 1);
+    }
+
+    if (kind == LB_CHANGE_ADD_GENRE) {
+        Genre genre = { .id = id };
+        snprintf(genre.name, MAX_GENRE, "%s", name);
+        return lb_add_genres_bulk(lib, &genre, 1);
+    }
+
+    if (kind == LB_CHANGE_AUTHOR_NAME) {
+        return lb_update_author_name(lib, id, name);
+    }
+
+    return lb_update_genre_name(lib, id, name);
+}
+
+static void db_apply_entry(void *ctx, const void *data, size_t size) {
+    Library *lib = ctx;
+    DbReader reader = { data, size, 0, 0 };
+
+    const unsigned char *kind = db_get(&reader, 1);
+    int value = (int)db_get_u32(&reader);
+    const char *isbn = db_get_string(&reader);
+    const char *text = db_get_string(&reader);
+
+    if (!kind || reader.failed) {
+        LOG_ERROR("Corrupted Journal Entry");
+        return;
+    }
+
+    int failed = 1;
+    switch (*kind) {
+        case LB_CHANGE_ADD_BOOK:
+            failed = db_apply_add_book(lib, &reader, isbn);
+            break;
+        case LB_CHANGE_REMOVE_BOOK:
+            failed = lb_remove_book(lib, isbn);
+            break;
+        case LB_CHANGE_BOOK_ISBN:
+            failed = lb_update_book_isbn(lib, isbn, text);
+            break;
+        case LB_CHANGE_BOOK_TITLE:
+            failed = lb_update_book_title(lib, isbn, text);
+            break;
+        case LB_CHANGE_BOOK_ID:
+            failed = lb_update_book_id(lib, isbn, value);
+            break;
+        case LB_CHANGE_BOOK_YEAR:
+            failed = lb_update_book_year(lib, isbn, value);
+            break;
+        case LB_CHANGE_BOOK_DESCRIPTION:
+            failed = lb_update_book_description(lib, isbn, text);
+            break;
+        case LB_CHANGE_ADD_BOOK_GENRE:
+            failed = lb_add_book_genre(lib, isbn, value);
+            break;
+        case LB_CHANGE_REMOVE_BOOK_GENRE:
+            failed = lb_remove_book_genre(lib, isbn, value);
+            break;
+        case LB_CHANGE_ADD_BOOK_AUTHOR:
+            failed = lb_add_book_author(lib, isbn, value);
+            break;
+        case LB_CHANGE_REMOVE_BOOK_AUTHOR:
+            failed = lb_remove_book_author(lib, isbn, value);
+            break;
+        case LB_CHANGE_ADD_AUTHOR:
+        case LB_CHANGE_AUTHOR_NAME:
+        case LB_CHANGE_ADD_GENRE:
+        case LB_CHANGE_GENRE_NAME:
+            failed = db_apply_name(lib, *kind, value, text);
+            break;
+        case LB_CHANGE_CLEAR:
+            lb_clear(lib);
+            failed = 0;
+            break;
+    }
+
+    if (failed) {
+        LOG_ERROR("Journal Entry not Applied - Kind %u", (unsigned int)*kind);
+    }
+}
+
+// Last record journaled by the change the calling thread is making
+static _Thread_local uint64_t db_commit_lsn;
+
+// Changes of different shards of a concurrent library come in at once and
+// share the scratch buffer. The record is appended before the library
+// applies the change; db_on_commit waits for it once the locks are gone.
+static void db_on_change(void *ctx, const LibraryChange *change) {
+    Db *db = ctx;
+
+    pthread_mutex_lock(&db->scratch_lock);
+    DbBuffer buffer = { db->scratch, 0, db->scratch_capacity, 0 };
+
+    db_encode_change(&buffer, db->lib, change);
+    db->scratch = buffer.data;
+    db->scratch_capacity = buffer.capacity;
+
+    uint64_t lsn;
+    int failed = buffer.failed || journal_append(&db->journal, buffer.data, buffer.size, &lsn) != 0;
+    pthread_mutex_unlock(&db->scratch_lock);
+
+    if (failed) {
+        LOG_ERROR("Change not Journaled - Kind %d", change->kind);
+        return;
+    }
+
+    db_commit_lsn = lsn;
+}
+
+// Changes waiting on the same sync are made durable together, the
+// interval flusher makes them durable later
+static void db_on_commit(void *ctx) {
+    Db *db = ctx;
+
+    if (db->journal.sync_mode == JOURNAL_SYNC_ALWAYS && journal_wait(&db->journal, db_commit_lsn) != 0) {
+        LOG_ERROR("Journal Sync Failed - LSN %llu", (unsigned long long)db_commit_lsn);
+    }
+}
+
+// Checkpoints
+
+static char *db_path_with(const char *path, const char *suffix) {
+    size_t path_length = strlen(path);
+    size_t suffix_length = strlen(suffix);
+    char *result = malloc(path_length + suffix_length + 1);
+
+    if (!result) {
+        LOG_ERROR(ALLOCATION_ERROR);
+        return NULL;
+    }
+
+    memcpy(result, path, path_length);
+    memcpy(result + path_length, suffix, suffix_length + 1);
+    return result;
+}
+
+static void db_put_write(DbBuffer *intent, uint64_t offset, const void *data, size_t size) {
+    uint32_t length = (uint32_t)size;
+    db_put(intent, &offset, sizeof(offset));
+    db_put(intent, &length, sizeof(length));
+    db_put(intent, data, size);
+}
+
+// Apply the writes of an intent payload to the snapshot
+static int db_apply_writes(int fd, const char *payload, size_t size, uint64_t file_size) {
+    DbReader reader = { payload, size, 0, 0 };
+
+    while (reader.offset < reader.size) {
+        const void *offset_data = db_get(&reader, sizeof(uint64_t));
+        uint32_t length = db_get_u32(&reader);
+        const char *data = db_get(&reader, length);
+
+        if (!offset_data || !data) {
+            return 1;
+        }
+
+        uint64_t offset;
+        memcpy(&offset, offset_data, sizeof(offset));
+
+        if (offset > file_size || length > file_size - offset) {
+            return 1;
+        }
+
+        size_t done = 0;
+        while (done < length) {
+            ssize_t written = pwrite(fd, data + done, length - done, (off_t)(offset + done));
+            if (written <= 0) {
+                return 1;
+            }
+
+            done += (size_t)written;
+        }
+    }
+
+    return fdatasync(fd);
+}
+
+// Finish an incremental checkpoint cut short by a crash. Only intents
+// written for the sequence the snapshot is at (or was moving to) are
+// redone; a torn intent means the snapshot was never touched.
+static int db_recover_intent(const char *path) {
+    char *intent_path = db_path_with(path, ".ckpt");
+    if (!intent_path) {
+        return 1;
+    }
+
+    FILE *file = fopen(intent_path, "rb");
+    if (!file) {
+        free(intent_path);
+        return 0;
+    }
+
+    DbIntentHeader intent;
+    char *payload = NULL;
+    int valid = fread(&intent, sizeof(intent), 1, file) == 1 &&
+                memcmp(intent.magic, DB_CHECKPOINT_MAGIC, sizeof(intent.magic)) == 0 &&
+                (payload = malloc((size_t)intent.payload_size + 1)) &&
+                fread(payload, 1, (size_t)intent.payload_size, file) == intent.payload_size &&
+                crc32_update(0, payload, (size_t)intent.payload_size) == intent.crc;
+    fclose(file);
+
+    int failed = 0;
+    int fd = valid ? open(path, O_RDWR) : -1;
+
+    if (fd >= 0) {
+        DbHeader header;
+        struct stat st;
+
+        if (pread(fd, &header, sizeof(header), 0) == (ssize_t)sizeof(header) && fstat(fd, &st) == 0 &&
+            (header.journal_sequence == intent.base_sequence || header.journal_sequence == intent.target_sequence)) {
+            failed = db_apply_writes(fd, payload, (size_t)intent.payload_size, (uint64_t)st.st_size);
+            if (!failed) {
+                LOG_INFO("Checkpoint Redone - %s - Sequence %llu", path, (unsigned long long)intent.target_sequence);
+            }
+        }
+
+        close(fd);
+    }
+
+    if (failed) {
+        LOG_ERROR("Checkpoint Redo Failed - %s", path);
+    } else {
+        remove(intent_path);
+    }
+
+    free(payload);
+    free(intent_path);
+    return failed;
+}
+
+static int db_reserve_slots(Db *db, int slot_count) {
+    if (slot_count <= db->slot_record_capacity) {
+        return 0;
+    }
+
+    int new_cap = db->slot_record_capacity ? db->slot_record_capacity : 64;
+    while (new_cap < slot_count) {
+        new_cap *= 2;
+    }
+
+    int *tmp = realloc(db->slot_records, (size_t)new_cap * sizeof(int));
+    if (!tmp) {
+        LOG_ERROR(REALLOCATION_ERROR);
+        return 1;
+    }
+
+    for (int i = db->slot_record_capacity; i < new_cap; i++) {
+        tmp[i] = -1;
+    }
+
+    db->slot_records = tmp;
+    db->slot_record_capacity = new_cap;
+    return 0;
+}
+
+static int db_push_free_record(Db *db, int record) {
+    if (db->free_record_count == db->free_record_capacity) {
+        int new_cap = db->free_record_capacity ? db->free_record_capacity * 2 : 16;
+        int *tmp = realloc(db->free_records, (size_t)new_cap * sizeof(int));
+        if (!tmp) {
+            LOG_ERROR(REALLOCATION_ERROR);
+            return 1;
+        }
+
+        db->free_records = tmp;
+        db->free_record_capacity = new_cap;
+    }
+
+    db->free_records[db->free_record_count++] = record;
+    return 0;
+}
+
+// Map book slots to the records of the snapshot: the k-th live record
+// holds the k-th dense book, as loads and full writes both go in order
+static int db_track_records(Db *db, const DbBookRecord *records) {
+    Library *lib = db->lib;
+
+    if (db_reserve_slots(db, lib->slot_count) != 0) {
+        return 1;
+    }
+
+    for (int i = 0; i < db->slot_record_capacity; i++) {
+        db->slot_records[i] = -1;
+    }
+
+    db->free_record_count = 0;
+    int dense = 0;
+
+    for (int record = 0; record < (int)db->header.book_count; record++) {
+        if (records && (records[record].flags & DB_RECORD_REMOVED)) {
+            if (db_push_free_record(db, record) != 0) {
+                return 1;
+            }
+        } else if (dense < lib->book_count) {
+            db->slot_records[lib->book_slots[dense++]] = record;
+        }
+    }
+
+    return 0;
+}
+
+// Writes of one changed book slot, 1 when the snapshot has no room left
+static int db_collect_book(Db *db, DbBuffer *intent, DbHeader *header, int slot) {
+    Library *lib = db->lib;
+    int record = slot < db->slot_record_capacity ? db->slot_records[slot] : -1;
+
+    if (slot >= lib->slot_count || !(lib->slot_generations[slot] & 1u)) {
+        if (record < 0) {
+            return 0;
+        }
+
+        DbBookRecord removed;
+        memset(&removed, 0, sizeof(removed));
+        removed.flags = DB_RECORD_REMOVED;
+
+        db_put_write(intent, header->book_offset + (uint64_t)record * sizeof(DbBookRecord), &removed, sizeof(removed));
+        db->slot_records[slot] = -1;
+        return db_push_free_record(db, record);
+    }
+
+    const Book *book = &lib->books[lib->slot_books[slot]];
+    uint64_t id_count = (uint64_t)book->genre_count + (uint64_t)book->author_count;
+    const char *description = lb_read_book_description(lib, book, &db->text, &db->text_capacity);
+    uint64_t text_size = description ? strlen(description) + 1 : 0;
+
+    if ((!description && book_description_ref(book) >= 0) || id_count > header->id_capacity - header->id_count ||
+        text_size > header->string_capacity - header->string_size || db_reserve_slots(db, slot + 1) != 0) {
+        return 1;
+    }
+
+    if (record < 0) {
+        if (db->free_record_count > 0) {
+            record = db->free_records[--db->free_record_count];
+        } else if (header->book_count < header->book_capacity) {
+            record = (int)header->book_count++;
+        } else {
+            return 1;
+        }
+    }
+
+    // The old ids and text stay behind as garbage until a full rewrite
+    DbBookRecord updated;
+    db_book_record(book, description, header->id_count, header->string_size, &updated);
+
+    uint64_t id_offset = header->id_offset + header->id_count * sizeof(int32_t);
+    db_put_write(intent, id_offset, db_ids(book->genre_ids, book->genre_inline),
+                 (size_t)book->genre_count * sizeof(int));
+    db_put_write(intent, id_offset + (uint64_t)book->genre_count * sizeof(int32_t),
+                 db_ids(book->author_ids, book->author_inline), (size_t)book->author_count * sizeof(int));
+
+    if (description) {
+        db_put_write(intent, header->string_offset + header->string_size, description, (size_t)text_size);
+    }
+
+    db_put_write(intent, header->book_offset + (uint64_t)record * sizeof(DbBookRecord), &updated, sizeof(updated));
+
+    header->id_count += id_count;
+    header->string_size += text_size;
+    db->slot_records[slot] = record;
+    return 0;
+}
+
+// Writes of every record changed since the last checkpoint, the header
+// last. 1 when they do not fit the free room of the snapshot.
+static int db_collect_changes(Db *db, DbBuffer *intent, DbHeader *header) {
+    Library *lib = db->lib;
+
+    for (int i = 0; i < lib->dirty_authors.count; i++) {
+        int index = lib->dirty_authors.items[i];
+        if (index >= lib->author_count || (uint64_t)index >= header->author_capacity) {
+            return 1;
+        }
+
+        DbAuthorRecord record;
+        db_author_record(&lib->authors[index], &record);
+        db_put_write(intent, header->author_offset + (uint64_t)index * sizeof(record), &record, sizeof(record));
+
+        if ((uint64_t)index >= header->author_count) {
+            header->author_count = (uint64_t)index + 1;
+        }
+    }
+
+    for (int i = 0; i < lib->dirty_genres.count; i++) {
+        int index = lib->dirty_genres.items[i];
+        if (index >= lib->genre_count || (uint64_t)index >= header->genre_capacity) {
+            return 1;
+        }
+
+        DbGenreRecord record;
+        db_genre_record(&lib->genres[index], &record);
+        db_put_write(intent, header->genre_offset + (uint64_t)index * sizeof(record), &record, sizeof(record));
+
+        if ((uint64_t)index >= header->genre_count) {
+            header->genre_count = (uint64_t)index + 1;
+        }
+    }
+
+    for (int i = 0; i < lib->dirty_books.count; i++) {
+        if (db_collect_book(db, intent, header, lib->dirty_books.items[i]) != 0) {
+            return 1;
+        }
+    }
+
+    db_put_write(intent, 0, header, sizeof(*header));
+    return intent->failed;
+}
+
+// Write only the changed records: intent file first, then in place
+static int db_checkpoint_changes(Db *db, uint64_t sequence) {
+    DbHeader header = db->header;
+    header.journal_sequence = sequence;
+
+    DbBuffer intent = { NULL, 0, 0, 0 };
+    if (db_collect_changes(db, &intent, &header) != 0) {
+        free(intent.data);
+        return 1;
+    }
+
+    DbIntentHeader intent_header;
+    memset(&intent_header, 0, sizeof(intent_header));
+    memcpy(intent_header.magic, DB_CHECKPOINT_MAGIC, sizeof(intent_header.magic));
+    intent_header.base_sequence = db->header.journal_sequence;
+    intent_header.target_sequence = sequence;
+    intent_header.payload_size = intent.size;
+    intent_header.crc = crc32_update(0, intent.data, intent.size);
+
+    char *intent_path = db_path_with(db->path, ".ckpt");
+    int intent_fd = intent_path ? open(intent_path, O_WRONLY | O_CREAT | O_TRUNC, 0644) : -1;
+    int fd = -1;
+    int failed = 1;
+
+    if (intent_fd >= 0) {
+        FILE *file = fdopen(intent_fd, "wb");
+        failed = !file || fwrite(&intent_header, sizeof(intent_header), 1, file) != 1 ||
+                 fwrite(intent.data, 1, intent.size, file) != intent.size || fflush(file) != 0 ||
+                 fsync(intent_fd) != 0;
+
+        if (file) {
+            fclose(file);
+        } else {
+            close(intent_fd);
+        }
+    }
+
+    if (!failed) {
+        fd = open(db->path, O_RDWR);
+        failed = fd < 0 || db_apply_writes(fd, intent.data, intent.size, header.file_size) != 0;
+    }
+
+    if (fd >= 0) {
+        close(fd);
+    }
+
+    // A failed apply keeps its intent, db_checkpoint moves to a sequence
+    // the intent can never match before rewriting the snapshot
+    if (!failed) {
+        remove(intent_path);
+        db->header = header;
+        db->checkpoint_bytes = 2 * intent.size + sizeof(intent_header);
+    }
+
+    free(intent_path);
+    free(intent.data);
+    return failed;
+}
+
+static int db_checkpoint_full(Db *db, uint64_t sequence) {
+    DbHeader header;
+
+    if (db_write_snapshot(db->lib, db->path, sequence, 1, &header) != 0) {
+        db->has_snapshot = 0;
+        return 1;
+    }
+
+    db->header = header;
+    db->has_snapshot = 1;
+    db->checkpoint_bytes = header.file_size;
+
+    // A record map that cannot be built forces the next checkpoint full
+    if (db_track_records(db, NULL) != 0) {
+        db->has_snapshot = 0;
+    }
+
+    return 0;
+}
+
+int db_open(Db *db, Library *lib, const char *path, const DbOptions *options) {
+    if (!db || !lib || !path) {
+        LOG_ERROR(NULL_ERROR);
+        return 1;
+    }
+
+    memset(db, 0, sizeof(*db));
+    db->lib = lib;
+    db->path = db_path_with(path, "");
+    db->journal_path = db_path_with(path, ".wal");
+
+    int sync_mode = options ? options->sync_mode : JOURNAL_SYNC_ALWAYS;
+    int interval_ms = options ? options->interval_ms : 0;
+    int description_cache = options ? options->description_cache : 0;
+    int failed = !db->path || !db->journal_path || db_recover_intent(path) != 0;
+
+    if (!failed && access(path, F_OK) == 0) {
+        failed = db_map_snapshot(path, lib, &db->header, description_cache) != 0 ||
+                 db_track_records(db, (const DbBookRecord *)(const void *)(lib->view + db->header.book_offset)) != 0;
+        db->has_snapshot = !failed;
+    }
+
+    // Changes replayed here are already in the journal, the snapshot is not
+    uint64_t sequence = db->header.journal_sequence;
+    lb_set_change_hook(lib, NULL, NULL, NULL);
+    lb_clear_dirty(lib);
+
+    if (!failed) {
+        failed = journal_replay(db->journal_path, sequence, db_apply_entry, lib, NULL) != 0 ||
+                 journal_open(&db->journal, db->journal_path, sequence, sync_mode, interval_ms) != 0;
+    }
+
+    if (failed) {
+        lb_clear(lib);
+        free(db->path);
+        free(db->journal_path);
+        free(db->slot_records);
+        free(db->free_records);
+        memset(db, 0, sizeof(*db));
+        return 1;
+    }
+
+    db->sequence = sequence;
+    pthread_mutex_init(&db->scratch_lock, NULL);
+    lb_set_change_hook(lib, db_on_change, db_on_commit, db);
+
+    LOG_INFO("Database Opened - %s - %d Books", path, lib->book_count);
+    return 0;
+}
+
+int db_sync(Db *db) {
+    if (!db || !db->lib) {
+        LOG_ERROR(NULL_ERROR);
+        return 1;
+    }
+
+    return journal_sync(&db->journal);
+}
+
+int db_checkpoint(Db *db) {
+    if (!db || !db->lib) {
+        LOG_ERROR(NULL_ERROR);
+        return 1;
+    }
+
+    if (journal_sync(&db->journal) != 0) {
+        return 1;
+    }
+
+    // Once the snapshot carries the new sequence the old journal no
+    // longer matches it and is dropped
+    uint64_t sequence = db->sequence + 1;
+    int incremental = db->has_snapshot && !db->lib->dirty_all;
+
+    if (incremental && db_checkpoint_changes(db, sequence) != 0) {
+        incremental = 0;
+        sequence++;
+    }
+
+    if (!incremental && db_checkpoint_full(db, sequence) != 0) {
+        return 1;
+    }
+
+    db->sequence = sequence;
+    lb_clear_dirty(db->lib);
+
+    if (journal_reset(&db->journal, sequence) != 0) {
+        return 1;
+    }
+
+    LOG_INFO("Checkpoint Done - %s - Sequence %llu - %llu Bytes", db->path, (unsigned long long)sequence,
+             (unsigned long long)db->checkpoint_bytes);
+    return 0;
+}
+
+int db_close(Db *db) {
+    if (!db || !db->lib) {
+        LOG_ERROR(NULL_ERROR);
+        return 1;
+    }
+
+    lb_set_change_hook(db->lib, NULL, NULL, NULL);
+    int result = journal_close(&db->journal);
+    pthread_mutex_destroy(&db->scratch_lock);
+
+    free(db->path);
+    free(db->journal_path);
+    free(db->scratch);
+    free(db->text);
+    free(db->slot_records);
+    free(db->free_records);
+    memset(db, 0, sizeof(*db));
+    return result;
+}
@@ -0,0 +1,442 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "journal.h"
+#include "crc32.h"
+#include "log.h"
+
+// Wake the interval flusher early once this much is buffered
+#define JOURNAL_EARLY_FLUSH (1 << 20)
+
+static int journal_write_all(int fd, const char *data, size_t size) {
+    while (size > 0) {
+        ssize_t written = write(fd, data, size);
+
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            return 1;
+        }
+
+        data += written;
+        size -= (size_t)written;
+    }
+
+    return 0;
+}
+
+static int journal_read_all(int fd, char *data, size_t size) {
+    while (size > 0) {
+        ssize_t got = read(fd, data, size);
+
+        if (got < 0 && errno == EINTR) {
+            continue;
+        }
+
+        if (got <= 0) {
+            return 1;
+        }
+
+        data += got;
+        size -= (size_t)got;
+    }
+
+    return 0;
+}
+
+static int journal_write_header(int fd, uint64_t sequence) {
+    char header[JOURNAL_HEADER_SIZE];
+    memcpy(header, JOURNAL_MAGIC, 8);
+    memcpy(header + 8, &sequence, sizeof(sequence));
+
+    if (ftruncate(fd, 0) != 0 || lseek(fd, 0, SEEK_SET) < 0 ||
+        journal_write_all(fd, header, sizeof(header)) != 0 || fsync(fd) != 0) {
+        return 1;
+    }
+
+    return 0;
+}
+
+// Write and sync everything appended so far. Called with the lock held,
+// which is dropped during the I/O so other threads keep appending.
+static void journal_flush_locked(Journal *journal) {
+    journal->syncing = 1;
+
+    char *data = journal->pending;
+    size_t size = journal->pending_size;
+    size_t capacity = journal->pending_capacity;
+    uint64_t target = journal->appended_lsn;
+
+    journal->pending = journal->spare;
+    journal->pending_capacity = journal->spare_capacity;
+    journal->pending_size = 0;
+    journal->spare = data;
+    journal->spare_capacity = capacity;
+
+    pthread_mutex_unlock(&journal->lock);
+    int failed = journal_write_all(journal->fd, data, size) != 0 || fdatasync(journal->fd) != 0;
+    pthread_mutex_lock(&journal->lock);
+
+    if (failed) {
+        journal->failed = 1;
+        LOG_ERROR("Journal Write Failed");
+    } else {
+        journal->durable_lsn = target;
+        journal->file_size += size;
+        journal->sync_count++;
+    }
+
+    journal->syncing = 0;
+    pthread_cond_broadcast(&journal->durable);
+}
+
+static void *journal_flusher(void *arg) {
+    Journal *journal = arg;
+
+    pthread_mutex_lock(&journal->lock);
+
+    while (!journal->stopping) {
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += journal->interval_ms / 1000;
+        deadline.tv_nsec += (long)(journal->interval_ms % 1000) * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+
+        pthread_cond_timedwait(&journal->wake, &journal->lock, &deadline);
+
+        if (journal->appended_lsn > journal->durable_lsn && !journal->syncing && !journal->failed) {
+            journal_flush_locked(journal);
+        }
+    }
+
+    pthread_mutex_unlock(&journal->lock);
+    return NULL;
+}
+
+int journal_open(Journal *journal, const char *path, uint64_t sequence, int sync_mode, int interval_ms) {
+    if (!journal || !path) {
+        LOG_ERROR(NULL_ERROR);
+        return 1;
+    }
+
+    if (sync_mode == JOURNAL_SYNC_INTERVAL && interval_ms <= 0) {
+        LOG_ERROR("Unsupported Journal Interval - %d", interval_ms);
+        return 1;
+    }
+
+    memset(journal, 0, sizeof(*journal));
+    journal->sequence = sequence;
+    journal->sync_mode = sync_mode;
+    journal->interval_ms = interval_ms;
+
+    journal->fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (journal->fd < 0) {
+        LOG_ERROR("Journal Open Failed - %s", path);
+        return 1;
+    }
+
+    struct stat st;
+    char header[JOURNAL_HEADER_SIZE];
+    uint64_t file_sequence = 0;
+    int valid = fstat(journal->fd, &st) == 0 && st.st_size >= JOURNAL_HEADER_SIZE &&
+                journal_read_all(journal->fd, header, sizeof(header)) == 0 &&
+                memcmp(header, JOURNAL_MAGIC, 8) == 0;
+
+    if (valid) {
+        memcpy(&file_sequence, header + 8, sizeof(file_sequence));
+    }
+
+    if (!valid || file_sequence != sequence) {
+        if (journal_write_header(journal->fd, sequence) != 0) {
+            LOG_ERROR("Journal Reset Failed - %s", path);
+            close(journal->fd);
+            return 1;
+        }
+
+        journal->file_size = JOURNAL_HEADER_SIZE;
+    } else {
+        journal->file_size = (uint64_t)st.st_size;
+    }
+
+    if (lseek(journal->fd, 0, SEEK_END) < 0) {
+        close(journal->fd);
+        return 1;
+    }
+
+    pthread_mutex_init(&journal->lock, NULL);
+    pthread_cond_init(&journal->durable, NULL);
+    pthread_cond_init(&journal->wake, NULL);
+
+    if (sync_mode == JOURNAL_SYNC_INTERVAL) {
+        if (pthread_create(&journal->flusher, NULL, journal_flusher, journal) != 0) {
+            LOG_ERROR("Journal Flusher Start Failed");
+            pthread_mutex_destroy(&journal->lock);
+            pthread_cond_destroy(&journal->durable);
+            pthread_cond_destroy(&journal->wake);
+            close(journal->fd);
+            return 1;
+        }
+
+        journal->flusher_running = 1;
+    }
+
+    return 0;
+}
+
+int journal_close(Journal *journal) {
+    if (!journal) {
+        LOG_ERROR(NULL_ERROR);
+        return 1;
+    }
+
+    if (journal->flusher_running) {
+        pthread_mutex_lock(&journal->lock);
+        journal->stopping = 1;
+        pthread_cond_signal(&journal->wake);
+        pthread_mutex_unlock(&journal->lock);
+
+        pthread_join(journal->flusher, NULL);
+        journal->flusher_running = 0;
+    }
+
+    int failed = journal_sync(journal);
+
+    close(journal->fd);
+    pthread_mutex_destroy(&journal->lock);
+    pthread_cond_destroy(&journal->durable);
+    pthread_cond_destroy(&journal->wake);
+    free(journal->pending);
+    free(journal->spare);
+    memset(journal, 0, sizeof(*journal));
+    journal->fd = -1;
+
+    return failed;
+}
+
+int journal_append(Journal *journal, const void *data, size_t size, uint64_t *lsn) {
+    if (!journal || (!data && size > 0)) {
+        LOG_ERROR(NULL_ERROR);
+        return 1;
+    }
+
+    if (size > UINT32_MAX - JOURNAL_ENTRY_HEADER) {
+        LOG_ERROR("Journal Entry too Large");
+        return 1;
+    }
+
+    uint32_t length = (uint32_t)size;
+    uint32_t crc = crc32_update(0, data, size);
+
+    pthread_mutex_lock(&journal->lock);
+
+    if (journal->failed) {
+        pthread_mutex_unlock(&journal->lock);
+        return 1;
+    }
+
+    size_t needed = journal->pending_size + JOURNAL_ENTRY_HEADER + size;
+    if (needed > journal->pending_capacity) {
+        size_t new_cap = journal->pending_capacity ? journal->pending_capacity : 4096;
+        while (new_cap < needed) {
+            new_cap *= 2;
+        }
+
+        char *tmp = realloc(journal->pending, new_cap);
+        if (!tmp) {
+            pthread_mutex_unlock(&journal->lock);
+            LOG_ERROR(REALLOCATION_ERROR);
+            return 1;
+        }
+
+        journal->pending = tmp;
+        journal->pending_capacity = new_cap;
+    }
+
+    char *dest = journal->pending + journal->pending_size;
+    memcpy(dest, &length, sizeof(length));
+    memcpy(dest + 4, &crc, sizeof(crc));
+    if (size > 0) {
+        memcpy(dest + JOURNAL_ENTRY_HEADER, data, size);
+    }
+
+    journal->pending_size = needed;
+    journal->appended_lsn++;
+
+    if (lsn) {
+        *lsn = journal->appended_lsn;
+    }
+
+    if (journal->flusher_running && journal->pending_size >= JOURNAL_EARLY_FLUSH) {
+        pthread_cond_signal(&journal->wake);
+    }
+
+    pthread_mutex_unlock(&journal->lock);
+    return 0;
+}
+
+int journal_wait(Journal *journal, uint64_t lsn) {
+    if (!journal) {
+        LOG_ERROR(NULL_ERROR);
+        return 1;
+    }
+
+    pthread_mutex_lock(&journal->lock);
+
+    // The first waiter syncs for everyone, the rest ride along
+    while (journal->durable_lsn < lsn && !journal->failed) {
+        if (!journal->syncing) {
+            journal_flush_locked(journal);
+        } else {
+            pthread_cond_wait(&journal->durable, &journal->lock);
+        }
+    }
+
+    int failed = journal->durable_lsn < lsn;
+    pthread_mutex_unlock(&journal->lock);
+
+    return failed;
+}
+
+int journal_sync(Journal *journal) {
+    if (!journal) {
+        LOG_ERROR(NULL_ERROR);
+        return 1;
+    }
+
+    pthread_mutex_lock(&journal->lock);
+    uint64_t lsn = journal->appended_lsn;
+    pthread_mutex_unlock(&journal->lock);
+
+    return journal_wait(journal, lsn);
+}
+
+int journal_reset(Journal *journal, uint64_t sequence) {
+    if (!journal) {
+        LOG_ERROR(NULL_ERROR);
+        return 1;
+    }
+
+    pthread_mutex_lock(&journal->lock);
+
+    while (journal->syncing) {
+        pthread_cond_wait(&journal->durable, &journal->lock);
+    }
+
+    int failed = journal_write_header(journal->fd, sequence);
+
+    if (failed) {
+        journal->failed = 1;
+        LOG_ERROR("Journal Reset Failed");
+    } else {
+        journal->sequence = sequence;
+        journal->pending_size = 0;
+        journal->durable_lsn = journal->appended_lsn;
+        journal->file_size = JOURNAL_HEADER_SIZE;
+    }
+
+    pthread_cond_broadcast(&journal->durable);
+    pthread_mutex_unlock(&journal->lock);
+
+    return failed;
+}
+
+int journal_replay(const char *path, uint64_t sequence, JournalEntryFn on_entry, void *ctx, int *replayed) {
+    if (!path || !on_entry) {
+        LOG_ERROR(NULL_ERROR);
+        return 1;
+    }
+
+    if (replayed) {
+        *replayed = 0;
+    }
+
+    int fd = open(path, O_RDWR);
+    if (fd < 0) {
+        return errno == ENOENT ? 0 : 1;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return 1;
+    }
+
+    size_t size = (size_t)st.st_size;
+    if (size < JOURNAL_HEADER_SIZE) {
+        close(fd);
+        return 0;
+    }
+
+    char *data = malloc(size);
+    if (!data) {
+        LOG_ERROR(ALLOCATION_ERROR);
+        close(fd);
+        return 1;
+    }
+
+    if (journal_read_all(fd, data, size) != 0) {
+        LOG_ERROR("Journal Read Failed - %s", path);
+        free(data);
+        close(fd);
+        return 1;
+    }
+
+    uint64_t file_sequence;
+    memcpy(&file_sequence, data + 8, sizeof(file_sequence));
+
+    if (memcmp(data, JOURNAL_MAGIC, 8) != 0 || file_sequence != sequence) {
+        free(data);
+        close(fd);
+        return 0;
+    }
+
+    size_t offset = JOURNAL_HEADER_SIZE;
+    int count = 0;
+
+    while (size - offset >= JOURNAL_ENTRY_HEADER) {
+        uint32_t length;
+        uint32_t crc;
+        memcpy(&length, data + offset, sizeof(length));
+        memcpy(&crc, data + offset + 4, sizeof(crc));
+
+        const char *payload = data + offset + JOURNAL_ENTRY_HEADER;
+        if (length > size - offset - JOURNAL_ENTRY_HEADER || crc32_update(0, payload, length) != crc) {
+            break;
+        }
+
+        on_entry(ctx, payload, length);
+        offset += JOURNAL_ENTRY_HEADER + length;
+        count++;
+    }
+
+    if (offset < size) {
+        LOG_ERROR("Journal Tail Dropped - %zu bytes", size - offset);
+
+        if (ftruncate(fd, (off_t)offset) != 0) {
+            LOG_ERROR("Journal Truncate Failed - %s", path);
+        }
+    }
+
+    free(data);
+    close(fd);
+
+    if (replayed) {
+        *replayed = count;
+    }
+
+    LOG_INFO("Journal Replayed - %d Entries", count);
+    return 0;
+}
@@ -0,0 +1,319 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "pager.h"
+#include "log.h"
+
+static uint32_t pager_bucket(const Pager *pager, uint32_t page) {
+    return (page * 2654435761u) & pager->bucket_mask;
+}
+
+static char *pager_data(const Pager *pager, int frame) {
+    return pager->memory + (size_t)frame * PAGER_PAGE_SIZE;
+}
+
+static int pager_lookup(const Pager *pager, uint32_t page) {
+    int frame = pager->buckets[pager_bucket(pager, page)];
+
+    while (frame >= 0 && pager->frames[frame].page != page) {
+        frame = pager->frames[frame].next;
+    }
+
+    return frame;
+}
+
+static void pager_unlink(Pager *pager, int frame) {
+    int *link = &pager->buckets[pager_bucket(pager, pager->frames[frame].page)];
+
+    while (*link != frame) {
+        link = &pager->frames[*link].next;
+    }
+
+    *link = pager->frames[frame].next;
+    pager->frames[frame].page = PAGER_NONE;
+}
+
+static int pager_write_frame(Pager *pager, int frame) {
+    const char *data = pager_data(pager, frame);
+    off_t offset = (off_t)pager->frames[frame].page * PAGER_PAGE_SIZE;
+    size_t done = 0;
+
+    while (done < PAGER_PAGE_SIZE) {
+        ssize_t written = pwrite(pager->fd, data + done, PAGER_PAGE_SIZE - done, offset + (off_t)done);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            LOG_ERROR("Page Write Failed - %u", pager->frames[frame].page);
+            return 1;
+        }
+
+        done += (size_t)written;
+    }
+
+    pager->frames[frame].dirty = 0;
+    pager->writes++;
+    return 0;
+}
+
+// Pick a frame for a new page with the clock, writing back its old page
+static int pager_victim(Pager *pager) {
+    // Two sweeps: the first may only clear referenced bits
+    for (int step = 0; step < 2 * pager->frame_count; step++) {
+        int frame = pager->hand;
+        PagerFrame *entry = &pager->frames[frame];
+        pager->hand = (pager->hand + 1) % pager->frame_count;
+
+        if (entry->page == PAGER_NONE) {
+            return frame;
+        }
+
+        if (entry->pins > 0) {
+            continue;
+        }
+
+        if (entry->referenced) {
+            entry->referenced = 0;
+            continue;
+        }
+
+        if (entry->dirty && pager_write_frame(pager, frame) != 0) {
+            return -1;
+        }
+
+        pager_unlink(pager, frame);
+        pager->evictions++;
+        return frame;
+    }
+
+    LOG_ERROR("Every Page Frame is Pinned");
+    return -1;
+}
+
+static char *pager_install(Pager *pager, int frame, uint32_t page) {
+    PagerFrame *entry = &pager->frames[frame];
+    uint32_t bucket = pager_bucket(pager, page);
+
+    entry->page = page;
+    entry->pins = 1;
+    entry->dirty = 0;
+    entry->referenced = 1;
+    entry->next = pager->buckets[bucket];
+    pager->buckets[bucket] = frame;
+
+    return pager_data(pager, frame);
+}
+
+int pager_open(Pager *pager, const char *path, int frames) {
+    if (!pager || !path) {
+        LOG_ERROR(NULL_ERROR);
+        return 1;
+    }
+
+    memset(pager, 0, sizeof(*pager));
+    pager->frame_count = frames < PAGER_MIN_FRAMES ? PAGER_MIN_FRAMES : frames;
+
+    uint32_t buckets = 1;
+    while (buckets < (uint32_t)pager->frame_count * 2) {
+        buckets *= 2;
+    }
+    pager->bucket_mask = buckets - 1;
+
+    pager->fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (pager->fd < 0) {
+        LOG_ERROR("Paged File Open Failed - %s", path);
+        return 1;
+    }
+
+    struct stat st;
+    if (fstat(pager->fd, &st) != 0) {
+        close(pager->fd);
+        return 1;
+    }
+
+    // A torn last page is not part of the file
+    pager->page_count = (uint32_t)((uint64_t)st.st_size / PAGER_PAGE_SIZE);
+
+    pager->frames = malloc((size_t)pager->frame_count * sizeof(PagerFrame));
+    pager->memory = malloc((size_t)pager->frame_count * PAGER_PAGE_SIZE);
+    pager->buckets = malloc((size_t)buckets * sizeof(int));
+
+    if (!pager->frames || !pager->memory || !pager->buckets) {
+        LOG_ERROR(ALLOCATION_ERROR);
+        free(pager->frames);
+        free(pager->memory);
+        free(pager->buckets);
+        close(pager->fd);
+        return 1;
+    }
+
+    for (int i = 0; i < pager->frame_count; i++) {
+        pager->frames[i].page = PAGER_NONE;
+        pager->frames[i].pins = 0;
+        pager->frames[i].dirty = 0;
+        pager->frames[i].referenced = 0;
+        pager->frames[i].next = -1;
+    }
+
+    for (uint32_t i = 0; i < buckets; i++) {
+        pager->buckets[i] = -1;
+    }
+
+    return 0;
+}
+
+int pager_close(Pager *pager) {
+    if (!pager || pager->fd < 0) {
+        return 1;
+    }
+
+    int failed = pager_flush(pager);
+
+    if (close(pager->fd) != 0) {
+        failed = 1;
+    }
+
+    free(pager->frames);
+    free(pager->memory);
+    free(pager->buckets);
+    memset(pager, 0, sizeof(*pager));
+    pager->fd = -1;
+
+    return failed;
+}
+
+char *pager_get(Pager *pager, uint32_t page) {
+    if (!pager) {
+        LOG_ERROR(NULL_ERROR);
+        return NULL;
+    }
+
+    if (page >= pager->page_count) {
+        LOG_ERROR("Page out of Range - %u", page);
+        return NULL;
+    }
+
+    int frame = pager_lookup(pager, page);
+    if (frame >= 0) {
+        pager->frames[frame].pins++;
+        pager->frames[frame].referenced = 1;
+        pager->hits++;
+        return pager_data(pager, frame);
+    }
+
+    frame = pager_victim(pager);
+    if (frame < 0) {
+        return NULL;
+    }
+
+    char *data = pager_data(pager, frame);
+    off_t offset = (off_t)page * PAGER_PAGE_SIZE;
+    size_t done = 0;
+
+    while (done < PAGER_PAGE_SIZE) {
+        ssize_t got = pread(pager->fd, data + done, PAGER_PAGE_SIZE - done, offset + (off_t)done);
+        if (got < 0 && errno == EINTR) {
+            continue;
+        }
+
+        // Allocated pages may not have been written yet
+        if (got <= 0) {
+            memset(data + done, 0, PAGER_PAGE_SIZE - done);
+            break;
+        }
+
+        done += (size_t)got;
+    }
+
+    pager->misses++;
+    return pager_install(pager, frame, page);
+}
+
+char *pager_allocate(Pager *pager, uint32_t *page) {
+    if (!pager || !page) {
+        LOG_ERROR(NULL_ERROR);
+        return NULL;
+    }
+
+    int frame = pager_victim(pager);
+    if (frame < 0) {
+        return NULL;
+    }
+
+    *page = pager->page_count++;
+
+    char *data = pager_install(pager, frame, *page);
+    memset(data, 0, PAGER_PAGE_SIZE);
+    pager->frames[frame].dirty = 1;
+    return data;
+}
+
+void pager_release(Pager *pager, const char *data, int dirty) {
+    if (!pager || !data) {
+        return;
+    }
+
+    int frame = (int)((data - pager->memory) / PAGER_PAGE_SIZE);
+    PagerFrame *entry = &pager->frames[frame];
+
+    if (entry->pins > 0) {
+        entry->pins--;
+    }
+
+    entry->dirty |= dirty != 0;
+}
+
+int pager_truncate(Pager *pager, uint32_t page_count) {
+    if (!pager) {
+        LOG_ERROR(NULL_ERROR);
+        return 1;
+    }
+
+    for (int i = 0; i < pager->frame_count; i++) {
+        if (pager->frames[i].page != PAGER_NONE && pager->frames[i].page >= page_count) {
+            pager_unlink(pager, i);
+            pager->frames[i].pins = 0;
+            pager->frames[i].dirty = 0;
+            pager->frames[i].referenced = 0;
+        }
+    }
+
+    if (ftruncate(pager->fd, (off_t)page_count * PAGER_PAGE_SIZE) != 0) {
+        LOG_ERROR("Paged File Truncate Failed");
+        return 1;
+    }
+
+    if (page_count < pager->page_count) {
+        pager->page_count = page_count;
+    }
+
+    return 0;
+}
+
+int pager_flush(Pager *pager) {
+    if (!pager) {
+        LOG_ERROR(NULL_ERROR);
+        return 1;
+    }
+
+    for (int i = 0; i < pager->frame_count; i++) {
+        if (pager->frames[i].page != PAGER_NONE && pager->frames[i].dirty && pager_write_frame(pager, i) != 0) {
+            return 1;
+        }
+    }
+
+    if (fdatasync(pager->fd) != 0) {
+        LOG_ERROR("Paged File Sync Failed");
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,509 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "exporter.h"
+#include "log.h"
+
+#define EXPORT_CSV 1
+#define EXPORT_JSONL 2
+
+#define EXPORT_CSV_HEADER "isbn,title,id,year,authors,genres,description\n"
+
+// Author or genre name by id
+typedef struct {
+    int id;
+    const char *name;
+} ExportName;
+
+// Names sorted by id. Ids are usually 1..count, then the name of id
+// sits at id - 1 and no search is needed.
+typedef struct {
+    ExportName *names;
+    int count;
+} ExportNames;
+
+typedef struct {
+    int fd;
+    size_t used;
+    size_t written;
+    int failed;
+    char buffer[EXPORT_BUFFER_SIZE];
+} ExportWriter;
+
+// One output file and the range of books it holds
+typedef struct {
+    const Library *lib;
+    const ExportNames *authors;
+    const ExportNames *genres;
+    int format;
+    int from;
+    int to;
+    char *path;
+    long records;
+    size_t bytes;
+    int failed;
+} ExportPart;
+
+// Names
+
+static int export_name_compare(const void *a, const void *b) {
+    int left = ((const ExportName *)a)->id;
+    int right = ((const ExportName *)b)->id;
+    return (left > right) - (left < right);
+}
+
+static int export_names_init(ExportNames *names, const void *records, int count, size_t stride,
+                             size_t name_offset) {
+    names->count = count;
+    names->names = malloc((size_t)(count > 0 ? count : 1) * sizeof(ExportName));
+    if (!names->names) {
+        LOG_ERROR(ALLOCATION_ERROR);
+        return 1;
+    }
+
+    const char *record = records;
+    int sorted = 1;
+
+    for (int i = 0; i < count; i++, record += stride) {
+        names->names[i].id = *(const int *)record;
+        names->names[i].name = record + name_offset;
+        sorted = sorted && (i == 0 || names->names[i - 1].id < names->names[i].id);
+    }
+
+    if (!sorted) {
+        qsort(names->names, (size_t)count, sizeof(ExportName), export_name_compare);
+    }
+
+    return 0;
+}
+
+static const char *export_name(const ExportNames *names, int id) {
+    if (id >= 1 && id <= names->count && names->names[id - 1].id == id) {
+        return names->names[id - 1].name;
+    }
+
+    ExportName key = { id, NULL };
+    const ExportName *found = bsearch(&key, names->names, (size_t)names->count, sizeof(ExportName),
+                                      export_name_compare);
+    return found ? found->name : NULL;
+}
+
+// Buffered output
+
+static void export_write(ExportWriter *writer, const char *data, size_t size) {
+    while (size > 0 && !writer->failed) {
+        ssize_t done = write(writer->fd, data, size);
+        if (done < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            writer->failed = 1;
+            return;
+        }
+
+        data += done;
+        size -= (size_t)done;
+        writer->written += (size_t)done;
+    }
+}
+
+static void export_flush(ExportWriter *writer) {
+    export_write(writer, writer->buffer, writer->used);
+    writer->used = 0;
+}
+
+static void export_put(ExportWriter *writer, const char *data, size_t size) {
+    if (writer->used + size > EXPORT_BUFFER_SIZE) {
+        export_flush(writer);
+
+        // Larger than the whole buffer: no point copying it
+        if (size > EXPORT_BUFFER_SIZE) {
+            export_write(writer, data, size);
+            return;
+        }
+    }
+
+    memcpy(writer->buffer + writer->used, data, size);
+    writer->used += size;
+}
+
+static void export_putc(ExportWriter *writer, char c) {
+    if (writer->used == EXPORT_BUFFER_SIZE) {
+        export_flush(writer);
+    }
+
+    writer->buffer[writer->used++] = c;
+}
+
+static void export_put_int(ExportWriter *writer, int value) {
+    char digits[12];
+    int pos = sizeof(digits);
+    unsigned int magnitude = value < 0 ? 0u - (unsigned int)value : (unsigned int)value;
+
+    do {
+        digits[--pos] = (char)('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude > 0);
+
+    if (value < 0) {
+        digits[--pos] = '-';
+    }
+
+    export_put(writer, digits + pos, sizeof(digits) - (size_t)pos);
+}
+
+// CSV
+
+static int export_csv_needs_quotes(const char *text) {
+    return text[strcspn(text, ",\"\r\n")] != '\0';
+}
+
+// Write the text quoted, doubling its quotes
+static void export_csv_quoted(ExportWriter *writer, const char *text) {
+    for (;;) {
+        const char *quote = strchr(text, '"');
+        size_t length = quote ? (size_t)(quote - text) + 1 : strlen(text);
+
+        export_put(writer, text, length);
+        if (!quote) {
+            return;
+        }
+
+        export_putc(writer, '"');
+        text = quote + 1;
+    }
+}
+
+static void export_csv_text(ExportWriter *writer, const char *text) {
+    if (!export_csv_needs_quotes(text)) {
+        export_put(writer, text, strlen(text));
+        return;
+    }
+
+    export_putc(writer, '"');
+    export_csv_quoted(writer, text);
+    export_putc(writer, '"');
+}
+
+// Names joined by ';', quoted as a whole when any of them needs it
+static void export_csv_names(ExportWriter *writer, const ExportNames *names, const int *ids, int count) {
+    int quoted = 0;
+    for (int i = 0; i < count && !quoted; i++) {
+        const char *name = export_name(names, ids[i]);
+        quoted = name && export_csv_needs_quotes(name);
+    }
+
+    if (quoted) {
+        export_putc(writer, '"');
+    }
+
+    int written = 0;
+    for (int i = 0; i < count; i++) {
+        const char *name = export_name(names, ids[i]);
+        if (!name) {
+            continue;
+        }
+
+        if (written++ > 0) {
+            export_putc(writer, ';');
+        }
+
+        if (quoted) {
+            export_csv_quoted(writer, name);
+        } else {
+            export_put(writer, name, strlen(name));
+        }
+    }
+
+    if (quoted) {
+        export_putc(writer, '"');
+    }
+}
+
+static void export_csv_row(ExportWriter *writer, const ExportPart *part, Book *book, const char *description) {
+    export_csv_text(writer, book->isbn);
+    export_putc(writer, ',');
+    export_csv_text(writer, book->title);
+    export_putc(writer, ',');
+    export_put_int(writer, book->id);
+    export_putc(writer, ',');
+    export_put_int(writer, book->publication_year);
+    export_putc(writer, ',');
+    export_csv_names(writer, part->authors, book_get_author_ids(book), book->author_count);
+    export_putc(writer, ',');
+    export_csv_names(writer, part->genres, book_get_genre_ids(book), book->genre_count);
+    export_putc(writer, ',');
+    if (description) {
+        export_csv_text(writer, description);
+    }
+    export_putc(writer, '\n');
+}
+
+// JSON Lines
+
+static void export_json_string(ExportWriter *writer, const char *text) {
+    static const char hex[] = "0123456789abcdef";
+    export_putc(writer, '"');
+
+    for (;;) {
+        // Copy the run of plain characters in one go
+        const char *p = text;
+        while (*p && *p != '"' && *p != '\\' && (unsigned char)*p >= 0x20) {
+            p++;
+        }
+
+        export_put(writer, text, (size_t)(p - text));
+        if (*p == '\0') {
+            break;
+        }
+
+        char escape[6] = { '\\', 0, 0, 0, 0, 0 };
+        size_t length = 2;
+
+        switch (*p) {
+            case '"': escape[1] = '"'; break;
+            case '\\': escape[1] = '\\'; break;
+            case '\n': escape[1] = 'n'; break;
+            case '\r': escape[1] = 'r'; break;
+            case '\t': escape[1] = 't'; break;
+            case '\b': escape[1] = 'b'; break;
+            case '\f': escape[1] = 'f'; break;
+            default:
+                escape[1] = 'u';
+                escape[2] = '0';
+                escape[3] = '0';
+                escape[4] = hex[(unsigned char)*p >> 4];
+                escape[5] = hex[*p & 0xF];
+                length = 6;
+                break;
+        }
+
+        export_put(writer, escape, length);
+        text = p + 1;
+    }
+
+    export_putc(writer, '"');
+}
+
+static void export_json_names(ExportWriter *writer, const ExportNames *names, const int *ids, int count) {
+    export_putc(writer, '[');
+
+    int written = 0;
+    for (int i = 0; i < count; i++) {
+        const char *name = export_name(names, ids[i]);
+        if (!name) {
+            continue;
+        }
+
+        if (written++ > 0) {
+            export_putc(writer, ',');
+        }
+        export_json_string(writer, name);
+    }
+
+    export_putc(writer, ']');
+}
+
+static void export_json_row(ExportWriter *writer, const ExportPart *part, Book *book, const char *description) {
+    export_put(writer, "{\"isbn\":", 8);
+    export_json_string(writer, book->isbn);
+    export_put(writer, ",\"title\":", 9);
+    export_json_string(writer, book->title);
+    export_put(writer, ",\"id\":", 6);
+    export_put_int(writer, book->id);
+    export_put(writer, ",\"year\":", 8);
+    export_put_int(writer, book->publication_year);
+    export_put(writer, ",\"authors\":", 11);
+    export_json_names(writer, part->authors, book_get_author_ids(book), book->author_count);
+    export_put(writer, ",\"genres\":", 10);
+    export_json_names(writer, part->genres, book_get_genre_ids(book), book->genre_count);
+    if (description) {
+        export_put(writer, ",\"description\":", 15);
+        export_json_string(writer, description);
+    }
+    export_put(writer, "}\n", 2);
+}
+
+// Parts
+
+static void *export_part_run(void *arg) {
+    ExportPart *part = arg;
+
+    ExportWriter *writer = malloc(sizeof(ExportWriter));
+    if (!writer) {
+        LOG_ERROR(ALLOCATION_ERROR);
+        part->failed = 1;
+        return NULL;
+    }
+
+    writer->fd = open(part->path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    writer->used = 0;
+    writer->written = 0;
+    writer->failed = writer->fd < 0;
+
+    if (!writer->failed && part->format == EXPORT_CSV) {
+        export_put(writer, EXPORT_CSV_HEADER, sizeof(EXPORT_CSV_HEADER) - 1);
+    }
+
+    // Descriptions left in a file are copied here, parts run concurrently
+    char *text = NULL;
+    size_t text_capacity = 0;
+
+    for (int i = part->from; i < part->to && !writer->failed; i++) {
+        Book *book = &part->lib->books[i];
+        const char *description = lb_read_book_description(part->lib, book, &text, &text_capacity);
+
+        if (!description && book_description_ref(book) >= 0) {
+            writer->failed = 1;
+            break;
+        }
+
+        if (part->format == EXPORT_CSV) {
+            export_csv_row(writer, part, book, description);
+        } else {
+            export_json_row(writer, part, book, description);
+        }
+
+        part->records++;
+    }
+
+    free(text);
+
+    export_flush(writer);
+
+    if (writer->fd >= 0 && close(writer->fd) != 0) {
+        writer->failed = 1;
+    }
+
+    if (writer->failed) {
+        LOG_ERROR("Export Write Failed - %s", part->path);
+    }
+
+    part->bytes = writer->written;
+    part->failed = writer->failed;
+    free(writer);
+    return NULL;
+}
+
+static double export_now(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+}
+
+static int export_run(const Library *lib, const char *path, const ExportOptions *options, ExportStats *stats,
+                      int format) {
+    if (!lib || !path) {
+        LOG_ERROR(NULL_ERROR);
+        return 1;
+    }
+
+    ExportStats local_stats;
+    if (!stats) {
+        stats = &local_stats;
+    }
+    memset(stats, 0, sizeof(*stats));
+
+    double started = export_now();
+    int parts = options && options->parts > 1 ? options->parts : 1;
+
+    ExportNames authors;
+    ExportNames genres;
+    if (export_names_init(&authors, lib->authors, lib->author_count, sizeof(Author), offsetof(Author, name)) != 0) {
+        return 1;
+    }
+    if (export_names_init(&genres, lib->genres, lib->genre_count, sizeof(Genre), offsetof(Genre, name)) != 0) {
+        free(authors.names);
+        return 1;
+    }
+
+    ExportPart *part_list = calloc((size_t)parts, sizeof(ExportPart));
+    pthread_t *threads = malloc((size_t)parts * sizeof(pthread_t));
+    int *running = calloc((size_t)parts, sizeof(int));
+    int failed = !part_list || !threads || !running;
+
+    if (failed) {
+        LOG_ERROR(ALLOCATION_ERROR);
+    }
+
+    size_t path_size = strlen(path) + 16;
+    for (int i = 0; i < parts && !failed; i++) {
+        ExportPart *part = &part_list[i];
+        part->lib = lib;
+        part->authors = &authors;
+        part->genres = &genres;
+        part->format = format;
+        part->from = (int)((long)lib->book_count * i / parts);
+        part->to = (int)((long)lib->book_count * (i + 1) / parts);
+
+        part->path = malloc(path_size);
+        if (!part->path) {
+            LOG_ERROR(ALLOCATION_ERROR);
+            failed = 1;
+        } else if (parts == 1) {
+            snprintf(part->path, path_size, "%s", path);
+        } else {
+            snprintf(part->path, path_size, "%s.%d", path, i);
+        }
+    }
+
+    if (!failed) {
+        // The last part runs here, as do parts whose thread did not start
+        for (int i = 0; i < parts - 1; i++) {
+            running[i] = pthread_create(&threads[i], NULL, export_part_run, &part_list[i]) == 0;
+        }
+
+        for (int i = 0; i < parts; i++) {
+            if (i == parts - 1 || !running[i]) {
+                export_part_run(&part_list[i]);
+            }
+        }
+
+        for (int i = 0; i < parts - 1; i++) {
+            if (running[i]) {
+                pthread_join(threads[i], NULL);
+            }
+        }
+
+        for (int i = 0; i < parts; i++) {
+            stats->records += part_list[i].records;
+            stats->bytes += part_list[i].bytes;
+            failed |= part_list[i].failed;
+        }
+    }
+
+    for (int i = 0; part_list && i < parts; i++) {
+        free(part_list[i].path);
+    }
+
+    free(part_list);
+    free(threads);
+    free(running);
+    free(authors.names);
+    free(genres.names);
+
+    stats->seconds = export_now() - started;
+
+    if (failed) {
+        return 1;
+    }
+
+    LOG_INFO("Export Done - %ld Records - %zu Bytes - %d Parts", stats->records, stats->bytes, parts);
+    return 0;
+}
+
+int export_csv(const Library *lib, const char *path, const ExportOptions *options, ExportStats *stats) {
+    return export_run(lib, path, options, stats, EXPORT_CSV);
+}
+
+int export_jsonl(const Library *lib, const char *path, const ExportOptions *options, ExportStats *stats) {
+    return export_run(lib, path, options, stats, EXPORT_JSONL);
+}
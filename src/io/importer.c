@@ -0,0 +1,1171 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <errno.h>
+#include <limits.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "importer.h"
+#include "log.h"
+
+#define IMPORT_NONE ((size_t)-1)
+
+// Chunks in flight per parser thread, bounds the memory of an import
+#define IMPORT_SLOTS_PER_THREAD 2
+
+#define IMPORT_CHUNK_FREE 0
+#define IMPORT_CHUNK_PENDING 1
+#define IMPORT_CHUNK_DONE 2
+
+// Parsed row: strings are offsets into the text of its chunk, names of a
+// list are stored one after the other
+typedef struct {
+    long line;
+    int id;
+    int year;
+    size_t isbn;
+    size_t title;
+    size_t description;
+    size_t authors;
+    int author_count;
+    size_t genres;
+    int genre_count;
+} ImportRecord;
+
+typedef struct {
+    long line;
+    const char *reason;
+} ImportError;
+
+typedef struct {
+    const char *data;
+    size_t size;
+    int state;
+
+    // Lines are counted from the start of the chunk
+    long line_count;
+
+    ImportRecord *records;
+    int record_count;
+    int record_capacity;
+
+    char *text;
+    size_t text_size;
+    size_t text_capacity;
+
+    ImportError *errors;
+    int error_count;
+    int error_capacity;
+} ImportChunk;
+
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t ready;
+    pthread_cond_t done;
+
+    ImportChunk *chunks;
+    int slots;
+    long dispatched;
+    long next_parse;
+    int stopping;
+    int format;
+} ImportQueue;
+
+// Per row parse state
+typedef struct {
+    ImportChunk *chunk;
+    const char *pos;
+    const char *end;
+    long line;
+    const char *error;
+} ImportCursor;
+
+// Chunk buffers
+
+static int import_text_reserve(ImportChunk *chunk, size_t extra) {
+    if (chunk->text_size + extra <= chunk->text_capacity) {
+        return 0;
+    }
+
+    size_t new_cap = chunk->text_capacity ? chunk->text_capacity : 4096;
+    while (new_cap < chunk->text_size + extra) {
+        new_cap *= 2;
+    }
+
+    char *tmp = realloc(chunk->text, new_cap);
+    if (!tmp) {
+        LOG_ERROR(REALLOCATION_ERROR);
+        return 1;
+    }
+
+    chunk->text = tmp;
+    chunk->text_capacity = new_cap;
+    return 0;
+}
+
+static ImportRecord *import_new_record(ImportChunk *chunk) {
+    if (chunk->record_count == chunk->record_capacity) {
+        int new_cap = chunk->record_capacity ? chunk->record_capacity * 2 : 256;
+        ImportRecord *tmp = realloc(chunk->records, (size_t)new_cap * sizeof(ImportRecord));
+        if (!tmp) {
+            LOG_ERROR(REALLOCATION_ERROR);
+            return NULL;
+        }
+
+        chunk->records = tmp;
+        chunk->record_capacity = new_cap;
+    }
+
+    ImportRecord *record = &chunk->records[chunk->record_count];
+    memset(record, 0, sizeof(*record));
+    record->isbn = IMPORT_NONE;
+    record->title = IMPORT_NONE;
+    record->description = IMPORT_NONE;
+    return record;
+}
+
+static void import_add_error(ImportChunk *chunk, long line, const char *reason) {
+    if (chunk->error_count == chunk->error_capacity) {
+        int new_cap = chunk->error_capacity ? chunk->error_capacity * 2 : 16;
+        ImportError *tmp = realloc(chunk->errors, (size_t)new_cap * sizeof(ImportError));
+        if (!tmp) {
+            LOG_ERROR(REALLOCATION_ERROR);
+            return;
+        }
+
+        chunk->errors = tmp;
+        chunk->error_capacity = new_cap;
+    }
+
+    chunk->errors[chunk->error_count].line = line;
+    chunk->errors[chunk->error_count].reason = reason;
+    chunk->error_count++;
+}
+
+static void import_chunk_free(ImportChunk *chunk) {
+    free(chunk->records);
+    free(chunk->text);
+    free(chunk->errors);
+    memset(chunk, 0, sizeof(*chunk));
+}
+
+// Field values
+
+// Parse an int held in text[start..], the text is dropped afterwards
+static int import_take_int(ImportCursor *cursor, size_t start, int *value) {
+    ImportChunk *chunk = cursor->chunk;
+    const char *text = chunk->text + start;
+    chunk->text_size = start;
+
+    while (*text == ' ') {
+        text++;
+    }
+
+    if (*text == '\0') {
+        *value = 0;
+        return 0;
+    }
+
+    char *end;
+    errno = 0;
+    long parsed = strtol(text, &end, 10);
+
+    while (*end == ' ') {
+        end++;
+    }
+
+    if (errno != 0 || *end != '\0' || parsed < INT_MIN || parsed > INT_MAX) {
+        cursor->error = "Invalid Number";
+        return 1;
+    }
+
+    *value = (int)parsed;
+    return 0;
+}
+
+// Split text[start..] on ';' into trimmed names stored one after the other
+static int import_split_names(ImportChunk *chunk, size_t start) {
+    char *read = chunk->text + start;
+    char *write = read;
+    int count = 0;
+
+    while (*read) {
+        char *name_end = strchr(read, ';');
+        if (!name_end) {
+            name_end = read + strlen(read);
+        }
+
+        char *next = *name_end ? name_end + 1 : name_end;
+        char *first = read;
+        char *last = name_end;
+        while (first < last && isspace((unsigned char)*first)) {
+            first++;
+        }
+        while (last > first && isspace((unsigned char)last[-1])) {
+            last--;
+        }
+
+        if (last > first) {
+            size_t length = (size_t)(last - first);
+            memmove(write, first, length);
+            write[length] = '\0';
+            write += length + 1;
+            count++;
+        }
+
+        // The terminator written above may land on the ';'
+        read = next;
+    }
+
+    chunk->text_size = (size_t)(write - chunk->text);
+    return count;
+}
+
+static int import_check_record(ImportCursor *cursor, const ImportRecord *record) {
+    const ImportChunk *chunk = cursor->chunk;
+
+    if (record->isbn == IMPORT_NONE || chunk->text[record->isbn] == '\0') {
+        cursor->error = "Missing ISBN";
+    } else if (strlen(chunk->text + record->isbn) >= ISBN_SIZE) {
+        cursor->error = "ISBN too Long";
+    }
+
+    return cursor->error != NULL;
+}
+
+// CSV
+
+// Copy one field (unquoting it) into the chunk text, NUL terminated.
+// Stops on the ',' or line end after it; returns 1 at the end of the row.
+static int import_csv_field(ImportCursor *cursor, size_t *start) {
+    ImportChunk *chunk = cursor->chunk;
+    const char *pos = cursor->pos;
+    const char *end = cursor->end;
+    *start = chunk->text_size;
+
+    if (pos < end && *pos == '"') {
+        pos++;
+
+        for (;;) {
+            const char *quote = memchr(pos, '"', (size_t)(end - pos));
+            if (!quote) {
+                cursor->error = "Unterminated Quote";
+                cursor->pos = end;
+                return 1;
+            }
+
+            size_t length = (size_t)(quote - pos);
+            if (import_text_reserve(chunk, length + 2) != 0) {
+                cursor->error = ALLOCATION_ERROR;
+                return 1;
+            }
+
+            for (const char *c = pos; c < quote; c++) {
+                cursor->line += *c == '\n';
+            }
+
+            memcpy(chunk->text + chunk->text_size, pos, length);
+            chunk->text_size += length;
+            pos = quote + 1;
+
+            // "" is an escaped quote, anything else closes the field
+            if (pos < end && *pos == '"') {
+                chunk->text[chunk->text_size++] = '"';
+                pos++;
+            } else {
+                break;
+            }
+        }
+    } else {
+        const char *field_end = pos;
+        while (field_end < end && *field_end != ',' && *field_end != '\n') {
+            field_end++;
+        }
+
+        size_t length = (size_t)(field_end - pos);
+        if (length > 0 && pos[length - 1] == '\r' && (field_end == end || *field_end == '\n')) {
+            length--;
+        }
+
+        if (import_text_reserve(chunk, length + 1) != 0) {
+            cursor->error = ALLOCATION_ERROR;
+            return 1;
+        }
+
+        memcpy(chunk->text + chunk->text_size, pos, length);
+        chunk->text_size += length;
+        pos = field_end;
+    }
+
+    chunk->text[chunk->text_size++] = '\0';
+
+    if (pos < end && *pos == '\r') {
+        pos++;
+    }
+
+    if (pos < end && *pos == ',') {
+        cursor->pos = pos + 1;
+        return 0;
+    }
+
+    if (pos < end && *pos != '\n') {
+        cursor->error = "Text after Quoted Field";
+    }
+
+    cursor->pos = pos;
+    return 1;
+}
+
+static void import_skip_line(ImportCursor *cursor) {
+    const char *newline = memchr(cursor->pos, '\n', (size_t)(cursor->end - cursor->pos));
+    cursor->pos = newline ? newline : cursor->end;
+}
+
+static void import_csv_row(ImportCursor *cursor) {
+    ImportChunk *chunk = cursor->chunk;
+    ImportRecord *record = import_new_record(chunk);
+    if (!record) {
+        cursor->error = ALLOCATION_ERROR;
+        return;
+    }
+
+    record->line = cursor->line;
+    size_t row_text = chunk->text_size;
+    int last = 0;
+
+    for (int column = 0; !last && !cursor->error; column++) {
+        size_t start;
+        last = import_csv_field(cursor, &start);
+        if (cursor->error) {
+            break;
+        }
+
+        switch (column) {
+            case 0:
+                record->isbn = start;
+                break;
+            case 1:
+                record->title = start;
+                break;
+            case 2:
+                import_take_int(cursor, start, &record->id);
+                break;
+            case 3:
+                import_take_int(cursor, start, &record->year);
+                break;
+            case 4:
+                record->authors = start;
+                record->author_count = import_split_names(chunk, start);
+                break;
+            case 5:
+                record->genres = start;
+                record->genre_count = import_split_names(chunk, start);
+                break;
+            case 6:
+                if (chunk->text[start] != '\0') {
+                    record->description = start;
+                }
+                break;
+            default:
+                // Extra columns are ignored
+                chunk->text_size = start;
+                break;
+        }
+    }
+
+    if (cursor->error || import_check_record(cursor, record) != 0) {
+        chunk->text_size = row_text;
+        import_skip_line(cursor);
+        return;
+    }
+
+    chunk->record_count++;
+}
+
+// JSON Lines
+
+static void import_json_space(ImportCursor *cursor) {
+    while (cursor->pos < cursor->end && (*cursor->pos == ' ' || *cursor->pos == '\t' || *cursor->pos == '\r')) {
+        cursor->pos++;
+    }
+}
+
+static int import_json_expect(ImportCursor *cursor, char c) {
+    import_json_space(cursor);
+
+    if (cursor->pos >= cursor->end || *cursor->pos != c) {
+        cursor->error = "Malformed JSON";
+        return 1;
+    }
+
+    cursor->pos++;
+    return 0;
+}
+
+static int import_hex4(const char *p, unsigned int *value) {
+    *value = 0;
+
+    for (int i = 0; i < 4; i++) {
+        char c = p[i];
+        unsigned int digit;
+
+        if (c >= '0' && c <= '9') {
+            digit = (unsigned int)(c - '0');
+        } else if (c >= 'a' && c <= 'f') {
+            digit = (unsigned int)(c - 'a' + 10);
+        } else if (c >= 'A' && c <= 'F') {
+            digit = (unsigned int)(c - 'A' + 10);
+        } else {
+            return 1;
+        }
+
+        *value = *value * 16 + digit;
+    }
+
+    return 0;
+}
+
+static void import_put_utf8(ImportChunk *chunk, unsigned int code) {
+    char *out = chunk->text + chunk->text_size;
+
+    if (code < 0x80) {
+        out[0] = (char)code;
+        chunk->text_size += 1;
+    } else if (code < 0x800) {
+        out[0] = (char)(0xC0 | (code >> 6));
+        out[1] = (char)(0x80 | (code & 0x3F));
+        chunk->text_size += 2;
+    } else if (code < 0x10000) {
+        out[0] = (char)(0xE0 | (code >> 12));
+        out[1] = (char)(0x80 | ((code >> 6) & 0x3F));
+        out[2] = (char)(0x80 | (code & 0x3F));
+        chunk->text_size += 3;
+    } else {
+        out[0] = (char)(0xF0 | (code >> 18));
+        out[1] = (char)(0x80 | ((code >> 12) & 0x3F));
+        out[2] = (char)(0x80 | ((code >> 6) & 0x3F));
+        out[3] = (char)(0x80 | (code & 0x3F));
+        chunk->text_size += 4;
+    }
+}
+
+// Decode a JSON string into the chunk text, NUL terminated
+static int import_json_string(ImportCursor *cursor, size_t *start) {
+    ImportChunk *chunk = cursor->chunk;
+
+    if (import_json_expect(cursor, '"') != 0) {
+        return 1;
+    }
+
+    const char *close = cursor->pos;
+    while (close < cursor->end && *close != '"') {
+        close += *close == '\\' ? 2 : 1;
+    }
+
+    if (close >= cursor->end) {
+        cursor->error = "Unterminated String";
+        return 1;
+    }
+
+    // Escapes never grow the text
+    if (import_text_reserve(chunk, (size_t)(close - cursor->pos) + 1) != 0) {
+        cursor->error = ALLOCATION_ERROR;
+        return 1;
+    }
+
+    *start = chunk->text_size;
+    const char *p = cursor->pos;
+
+    while (p < close) {
+        if (*p != '\\') {
+            chunk->text[chunk->text_size++] = *p++;
+            continue;
+        }
+
+        char escape = p[1];
+        p += 2;
+
+        switch (escape) {
+            case '"': chunk->text[chunk->text_size++] = '"'; break;
+            case '\\': chunk->text[chunk->text_size++] = '\\'; break;
+            case '/': chunk->text[chunk->text_size++] = '/'; break;
+            case 'b': chunk->text[chunk->text_size++] = '\b'; break;
+            case 'f': chunk->text[chunk->text_size++] = '\f'; break;
+            case 'n': chunk->text[chunk->text_size++] = '\n'; break;
+            case 'r': chunk->text[chunk->text_size++] = '\r'; break;
+            case 't': chunk->text[chunk->text_size++] = '\t'; break;
+            case 'u': {
+                unsigned int code;
+                if (close - p < 4 || import_hex4(p, &code) != 0) {
+                    cursor->error = "Invalid Escape";
+                    return 1;
+                }
+                p += 4;
+
+                // Characters outside the BMP come as a surrogate pair
+                unsigned int low;
+                if (code >= 0xD800 && code < 0xDC00 && close - p >= 6 && p[0] == '\\' && p[1] == 'u' &&
+                    import_hex4(p + 2, &low) == 0 && low >= 0xDC00 && low < 0xE000) {
+                    code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                    p += 6;
+                }
+
+                import_put_utf8(chunk, code);
+                break;
+            }
+            default:
+                cursor->error = "Invalid Escape";
+                return 1;
+        }
+    }
+
+    chunk->text[chunk->text_size++] = '\0';
+    cursor->pos = close + 1;
+    return 0;
+}
+
+static int import_json_null(ImportCursor *cursor) {
+    import_json_space(cursor);
+
+    if (cursor->end - cursor->pos >= 4 && memcmp(cursor->pos, "null", 4) == 0) {
+        cursor->pos += 4;
+        return 1;
+    }
+
+    return 0;
+}
+
+static int import_json_int(ImportCursor *cursor, int *value) {
+    import_json_space(cursor);
+
+    if (import_json_null(cursor)) {
+        *value = 0;
+        return 0;
+    }
+
+    const char *p = cursor->pos;
+    int negative = p < cursor->end && *p == '-';
+    p += negative;
+
+    long parsed = 0;
+    const char *digits = p;
+    while (p < cursor->end && *p >= '0' && *p <= '9' && parsed <= INT_MAX) {
+        parsed = parsed * 10 + (*p++ - '0');
+    }
+
+    if (p == digits || parsed > INT_MAX || (p < cursor->end && (*p == '.' || *p == 'e' || *p == 'E'))) {
+        cursor->error = "Invalid Number";
+        return 1;
+    }
+
+    *value = (int)(negative ? -parsed : parsed);
+    cursor->pos = p;
+    return 0;
+}
+
+// Array of strings (a single string is taken as a list of one)
+static int import_json_names(ImportCursor *cursor, size_t *start, int *count) {
+    ImportChunk *chunk = cursor->chunk;
+    *start = chunk->text_size;
+    *count = 0;
+
+    import_json_space(cursor);
+    if (import_json_null(cursor)) {
+        return 0;
+    }
+
+    if (cursor->pos < cursor->end && *cursor->pos == '"') {
+        size_t name;
+        if (import_json_string(cursor, &name) != 0) {
+            return 1;
+        }
+
+        *count = 1;
+        return 0;
+    }
+
+    if (import_json_expect(cursor, '[') != 0) {
+        return 1;
+    }
+
+    import_json_space(cursor);
+    if (cursor->pos < cursor->end && *cursor->pos == ']') {
+        cursor->pos++;
+        return 0;
+    }
+
+    for (;;) {
+        size_t name;
+        if (import_json_string(cursor, &name) != 0) {
+            return 1;
+        }
+
+        // Empty names are dropped like in CSV
+        if (chunk->text[name] == '\0') {
+            chunk->text_size = name;
+        } else {
+            (*count)++;
+        }
+
+        import_json_space(cursor);
+        if (cursor->pos < cursor->end && *cursor->pos == ',') {
+            cursor->pos++;
+            continue;
+        }
+
+        return import_json_expect(cursor, ']');
+    }
+}
+
+// Skip any value of an unknown key
+static int import_json_skip(ImportCursor *cursor) {
+    import_json_space(cursor);
+    int depth = 0;
+
+    while (cursor->pos < cursor->end) {
+        char c = *cursor->pos;
+
+        if (c == '"') {
+            size_t start;
+            if (import_json_string(cursor, &start) != 0) {
+                return 1;
+            }
+            cursor->chunk->text_size = start;
+            continue;
+        }
+
+        if (depth == 0 && (c == ',' || c == '}' || c == ']')) {
+            return 0;
+        }
+
+        if (c == '{' || c == '[') {
+            depth++;
+        } else if (c == '}' || c == ']') {
+            depth--;
+        }
+
+        cursor->pos++;
+    }
+
+    cursor->error = "Malformed JSON";
+    return 1;
+}
+
+static int import_json_field(ImportCursor *cursor, ImportRecord *record) {
+    ImportChunk *chunk = cursor->chunk;
+    size_t key;
+
+    if (import_json_string(cursor, &key) != 0 || import_json_expect(cursor, ':') != 0) {
+        return 1;
+    }
+
+    char name[16];
+    snprintf(name, sizeof(name), "%s", chunk->text + key);
+    int known = strlen(chunk->text + key) < sizeof(name);
+    chunk->text_size = key;
+
+    size_t *text_field = NULL;
+    if (known && strcmp(name, "isbn") == 0) {
+        text_field = &record->isbn;
+    } else if (known && strcmp(name, "title") == 0) {
+        text_field = &record->title;
+    } else if (known && strcmp(name, "description") == 0) {
+        text_field = &record->description;
+    }
+
+    if (text_field) {
+        if (import_json_null(cursor)) {
+            *text_field = IMPORT_NONE;
+            return 0;
+        }
+
+        return import_json_string(cursor, text_field);
+    }
+
+    if (known && strcmp(name, "id") == 0) {
+        return import_json_int(cursor, &record->id);
+    }
+
+    if (known && strcmp(name, "year") == 0) {
+        return import_json_int(cursor, &record->year);
+    }
+
+    if (known && strcmp(name, "authors") == 0) {
+        return import_json_names(cursor, &record->authors, &record->author_count);
+    }
+
+    if (known && strcmp(name, "genres") == 0) {
+        return import_json_names(cursor, &record->genres, &record->genre_count);
+    }
+
+    return import_json_skip(cursor);
+}
+
+static void import_json_row(ImportCursor *cursor) {
+    ImportChunk *chunk = cursor->chunk;
+    ImportRecord *record = import_new_record(chunk);
+    if (!record) {
+        cursor->error = ALLOCATION_ERROR;
+        return;
+    }
+
+    record->line = cursor->line;
+    size_t row_text = chunk->text_size;
+
+    // Rows end at the newline, the parser never reads past it
+    const char *newline = memchr(cursor->pos, '\n', (size_t)(cursor->end - cursor->pos));
+    const char *chunk_end = cursor->end;
+    cursor->end = newline ? newline : chunk_end;
+
+    if (import_json_expect(cursor, '{') == 0) {
+        import_json_space(cursor);
+
+        if (cursor->pos < cursor->end && *cursor->pos == '}') {
+            cursor->pos++;
+        } else {
+            while (import_json_field(cursor, record) == 0) {
+                import_json_space(cursor);
+
+                if (cursor->pos < cursor->end && *cursor->pos == ',') {
+                    cursor->pos++;
+                    continue;
+                }
+
+                import_json_expect(cursor, '}');
+                break;
+            }
+        }
+    }
+
+    import_json_space(cursor);
+    if (!cursor->error && cursor->pos != cursor->end) {
+        cursor->error = "Text after Record";
+    }
+
+    cursor->pos = cursor->end;
+    cursor->end = chunk_end;
+
+    if (cursor->error || import_check_record(cursor, record) != 0) {
+        chunk->text_size = row_text;
+        return;
+    }
+
+    chunk->record_count++;
+}
+
+// Parse every row of a chunk, rows never span two chunks
+static void import_parse_chunk(ImportChunk *chunk, int format) {
+    ImportCursor cursor = { chunk, chunk->data, chunk->data + chunk->size, 0, NULL };
+
+    while (cursor.pos < cursor.end) {
+        // Blank lines are not rows
+        const char *p = cursor.pos;
+        while (p < cursor.end && (*p == ' ' || *p == '\t' || *p == '\r')) {
+            p++;
+        }
+
+        if (p < cursor.end && *p != '\n') {
+            cursor.error = NULL;
+
+            if (format == IMPORT_JSONL) {
+                import_json_row(&cursor);
+            } else {
+                import_csv_row(&cursor);
+            }
+
+            if (cursor.error) {
+                import_add_error(chunk, cursor.line, cursor.error);
+            }
+        } else {
+            cursor.pos = p;
+        }
+
+        if (cursor.pos < cursor.end && *cursor.pos == '\n') {
+            cursor.pos++;
+            cursor.line++;
+        }
+    }
+
+    chunk->line_count = cursor.line;
+}
+
+// Splitting
+
+// End of the chunk starting at start: the first row boundary after
+// start + target. CSV boundaries must sit outside quotes, so quotes are
+// counted from the start (an escaped "" counts twice and changes nothing);
+// JSON Lines rows never hold a raw newline.
+static size_t import_split(const char *data, size_t size, size_t start, size_t target, int format) {
+    if (size - start <= target) {
+        return size;
+    }
+
+    size_t want = start + target;
+
+    if (format == IMPORT_JSONL) {
+        const char *newline = memchr(data + want, '\n', size - want);
+        return newline ? (size_t)(newline - data) + 1 : size;
+    }
+
+    size_t pos = start;
+    int quoted = 0;
+
+    while (pos < size) {
+        const char *newline = memchr(data + pos, '\n', size - pos);
+        size_t line_end = newline ? (size_t)(newline - data) : size;
+
+        const char *q = data + pos;
+        while ((q = memchr(q, '"', (size_t)(data + line_end - q))) != NULL) {
+            quoted = !quoted;
+            q++;
+        }
+
+        pos = line_end < size ? line_end + 1 : size;
+
+        if (pos >= want && !quoted) {
+            return pos;
+        }
+    }
+
+    return size;
+}
+
+// Workers
+
+static void *import_worker(void *arg) {
+    ImportQueue *queue = arg;
+
+    pthread_mutex_lock(&queue->lock);
+
+    for (;;) {
+        while (!queue->stopping && queue->next_parse == queue->dispatched) {
+            pthread_cond_wait(&queue->ready, &queue->lock);
+        }
+
+        if (queue->stopping) {
+            break;
+        }
+
+        ImportChunk *chunk = &queue->chunks[queue->next_parse % queue->slots];
+        queue->next_parse++;
+        pthread_mutex_unlock(&queue->lock);
+
+        import_parse_chunk(chunk, queue->format);
+
+        pthread_mutex_lock(&queue->lock);
+        chunk->state = IMPORT_CHUNK_DONE;
+        pthread_cond_broadcast(&queue->done);
+    }
+
+    pthread_mutex_unlock(&queue->lock);
+    return NULL;
+}
+
+// Consumer
+
+typedef struct {
+    Book *books;
+    int capacity;
+    HashIndex batch;
+    long line_base;
+    ImportStats *stats;
+} ImportSink;
+
+static const char *import_batch_key(const void *ctx, int value) {
+    const Book *books = ctx;
+    return books[value].isbn;
+}
+
+static void import_reject(ImportSink *sink, long line, const char *reason) {
+    ImportStats *stats = sink->stats;
+
+    if (stats->errors < IMPORT_MAX_ERROR_ROWS) {
+        stats->error_rows[stats->errors] = line;
+    }
+
+    stats->errors++;
+    LOG_ERROR("Import Row Rejected - Line %ld - %s", line, reason);
+}
+
+static int import_resolve_names(Library *lib, const char *names, int count, Book *book, int authors) {
+    for (int i = 0; i < count; i++) {
+        int id;
+        int failed = authors ? lb_find_or_add_author(lib, names, &id) : lb_find_or_add_genre(lib, names, &id);
+
+        if (failed || (authors ? book_add_author(book, id) : book_add_genre(book, id)) != 0) {
+            return 1;
+        }
+
+        names += strlen(names) + 1;
+    }
+
+    return 0;
+}
+
+// Build the books of a parsed chunk and add them in one batch
+static int import_consume(Library *lib, ImportSink *sink, const ImportChunk *chunk) {
+    for (int i = 0; i < chunk->error_count; i++) {
+        import_reject(sink, sink->line_base + chunk->errors[i].line, chunk->errors[i].reason);
+    }
+
+    if (chunk->record_count > sink->capacity) {
+        Book *tmp = realloc(sink->books, (size_t)chunk->record_count * sizeof(Book));
+        if (!tmp) {
+            LOG_ERROR(REALLOCATION_ERROR);
+            return 1;
+        }
+
+        sink->books = tmp;
+        sink->capacity = chunk->record_count;
+    }
+
+    hash_index_clear(&sink->batch);
+    int count = 0;
+    int failed = 0;
+
+    for (int i = 0; i < chunk->record_count && !failed; i++) {
+        const ImportRecord *record = &chunk->records[i];
+        const char *isbn = chunk->text + record->isbn;
+        long line = sink->line_base + record->line;
+
+        if (lb_find_book_by_isbn(lib, isbn) || hash_index_find(&sink->batch, sink->books, isbn) >= 0) {
+            import_reject(sink, line, "Duplicated ISBN");
+            continue;
+        }
+
+        Book *book = &sink->books[count];
+        book_init(book);
+        book->id = record->id;
+        book->publication_year = record->year;
+        snprintf(book->isbn, ISBN_SIZE, "%s", isbn);
+        if (record->title != IMPORT_NONE) {
+            snprintf(book->title, MAX_TITLE, "%s", chunk->text + record->title);
+        }
+
+        failed = import_resolve_names(lib, chunk->text + record->authors, record->author_count, book, 1) ||
+                 import_resolve_names(lib, chunk->text + record->genres, record->genre_count, book, 0) ||
+                 (record->description != IMPORT_NONE &&
+                  book_update_description(book, chunk->text + record->description) != 0) ||
+                 hash_index_insert(&sink->batch, sink->books, book->isbn, count) != 0;
+
+        if (failed) {
+            book_free(book);
+        } else {
+            count++;
+        }
+    }
+
+    if (!failed && count > 0 && lb_add_books_bulk(lib, sink->books, count) != 0) {
+        failed = 1;
+    }
+
+    if (failed) {
+        for (int i = 0; i < count; i++) {
+            book_free(&sink->books[i]);
+        }
+
+        LOG_ERROR("Import Batch Failed");
+        return 1;
+    }
+
+    sink->stats->records += count;
+    sink->line_base += chunk->line_count;
+    return 0;
+}
+
+static double import_now(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+}
+
+// CSV header row: the first field names the ISBN column
+static size_t import_skip_header(const char *data, size_t size) {
+    if (size < 4 || strncasecmp(data, "isbn", 4) != 0 || (size > 4 && data[4] != ',' && data[4] != '\n' && data[4] != '\r')) {
+        return 0;
+    }
+
+    const char *newline = memchr(data, '\n', size);
+    return newline ? (size_t)(newline - data) + 1 : size;
+}
+
+int import_buffer(Library *lib, const char *data, size_t size, const ImportOptions *options, ImportStats *stats) {
+    if (!lib || (!data && size > 0)) {
+        LOG_ERROR(NULL_ERROR);
+        return 1;
+    }
+
+    ImportStats local_stats;
+    if (!stats) {
+        stats = &local_stats;
+    }
+    memset(stats, 0, sizeof(*stats));
+    stats->bytes = size;
+
+    double started = import_now();
+
+    int format = options ? options->format : IMPORT_AUTO;
+    int threads = options ? options->threads : 0;
+    size_t chunk_size = options && options->chunk_size ? options->chunk_size : IMPORT_DEFAULT_CHUNK;
+
+    if (format == IMPORT_AUTO) {
+        size_t first = 0;
+        while (first < size && isspace((unsigned char)data[first])) {
+            first++;
+        }
+        format = first < size && data[first] == '{' ? IMPORT_JSONL : IMPORT_CSV;
+    }
+
+    if (threads <= 0) {
+        long cores = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cores > 0 ? (int)cores : 1;
+    }
+
+    size_t offset = format == IMPORT_CSV ? import_skip_header(data, size) : 0;
+
+    ImportSink sink;
+    memset(&sink, 0, sizeof(sink));
+    sink.stats = stats;
+    sink.line_base = offset > 0 ? 2 : 1;
+    hash_index_init(&sink.batch, import_batch_key);
+
+    ImportQueue queue;
+    memset(&queue, 0, sizeof(queue));
+    queue.slots = threads * IMPORT_SLOTS_PER_THREAD;
+    queue.format = format;
+    queue.chunks = calloc((size_t)queue.slots, sizeof(ImportChunk));
+
+    pthread_t *workers = malloc((size_t)threads * sizeof(pthread_t));
+    if (!queue.chunks || !workers) {
+        LOG_ERROR(ALLOCATION_ERROR);
+        free(queue.chunks);
+        free(workers);
+        hash_index_free(&sink.batch);
+        return 1;
+    }
+
+    pthread_mutex_init(&queue.lock, NULL);
+    pthread_cond_init(&queue.ready, NULL);
+    pthread_cond_init(&queue.done, NULL);
+
+    int started_threads = 0;
+    while (started_threads < threads &&
+           pthread_create(&workers[started_threads], NULL, import_worker, &queue) == 0) {
+        started_threads++;
+    }
+
+    int failed = started_threads == 0;
+    long consumed = 0;
+
+    while (!failed && (offset < size || consumed < queue.dispatched)) {
+        // Keep every slot busy, a free slot is only touched by this thread
+        while (offset < size && queue.dispatched - consumed < queue.slots) {
+            ImportChunk *chunk = &queue.chunks[queue.dispatched % queue.slots];
+            size_t end = import_split(data, size, offset, chunk_size, format);
+
+            chunk->data = data + offset;
+            chunk->size = end - offset;
+            chunk->record_count = 0;
+            chunk->text_size = 0;
+            chunk->error_count = 0;
+            chunk->line_count = 0;
+            chunk->state = IMPORT_CHUNK_PENDING;
+            offset = end;
+
+            pthread_mutex_lock(&queue.lock);
+            queue.dispatched++;
+            pthread_cond_signal(&queue.ready);
+            pthread_mutex_unlock(&queue.lock);
+        }
+
+        ImportChunk *chunk = &queue.chunks[consumed % queue.slots];
+
+        pthread_mutex_lock(&queue.lock);
+        while (chunk->state != IMPORT_CHUNK_DONE) {
+            pthread_cond_wait(&queue.done, &queue.lock);
+        }
+        pthread_mutex_unlock(&queue.lock);
+
+        failed = import_consume(lib, &sink, chunk);
+        chunk->state = IMPORT_CHUNK_FREE;
+        consumed++;
+    }
+
+    // Parsed chunks still in flight are simply dropped
+    pthread_mutex_lock(&queue.lock);
+    queue.stopping = 1;
+    pthread_cond_broadcast(&queue.ready);
+    pthread_mutex_unlock(&queue.lock);
+
+    for (int i = 0; i < started_threads; i++) {
+        pthread_join(workers[i], NULL);
+    }
+
+    for (int i = 0; i < queue.slots; i++) {
+        import_chunk_free(&queue.chunks[i]);
+    }
+
+    pthread_mutex_destroy(&queue.lock);
+    pthread_cond_destroy(&queue.ready);
+    pthread_cond_destroy(&queue.done);
+    free(queue.chunks);
+    free(workers);
+    free(sink.books);
+    hash_index_free(&sink.batch);
+
+    stats->seconds = import_now() - started;
+    stats->records_per_sec = stats->seconds > 0 ? (double)stats->records / stats->seconds : 0;
+
+    LOG_INFO("Import Done - %ld Records - %ld Errors - %.0f Records/s - %d Threads",
+             stats->records, stats->errors, stats->records_per_sec, started_threads);
+    return failed;
+}
+
+int import_file(Library *lib, const char *path, const ImportOptions *options, ImportStats *stats) {
+    if (!lib || !path) {
+        LOG_ERROR(NULL_ERROR);
+        return 1;
+    }
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        LOG_ERROR("Import File not Found - %s", path);
+        return 1;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return 1;
+    }
+
+    size_t size = (size_t)st.st_size;
+    if (size == 0) {
+        close(fd);
+        return import_buffer(lib, NULL, 0, options, stats);
+    }
+
+    void *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (map == MAP_FAILED) {
+        LOG_ERROR("Import Map Failed - %s", path);
+        return 1;
+    }
+
+    // Chunks are read once, front to back
+    posix_madvise(map, size, POSIX_MADV_SEQUENTIAL);
+
+    int failed = import_buffer(lib, map, size, options, stats);
+    munmap(map, size);
+    return failed;
+}
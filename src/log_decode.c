@@ -0,0 +1,38 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "log_binary.h"
+
+// log_decode [binary log [text output]]: defaults to library.log.bin and stdout
+int main(int argc, char *argv[]) {
+    if (argc > 3 || (argc > 1 && (strcmp(argv[1], "-h") == 0 || strcmp(argv[1], "--help") == 0))) {
+        fprintf(stderr, "Usage: %s [binary log] [text output]\n", argv[0]);
+        return 1;
+    }
+
+    const char *input = argc > 1 ? argv[1] : LOG_BINARY_FILE;
+    FILE *in = fopen(input, "rb");
+    if (!in) {
+        fprintf(stderr, "Cannot open %s\n", input);
+        return 1;
+    }
+
+    FILE *out = argc > 2 ? fopen(argv[2], "w") : stdout;
+    if (!out) {
+        fprintf(stderr, "Cannot create %s\n", argv[2]);
+        fclose(in);
+        return 1;
+    }
+
+    int failed = log_decode(in, out);
+    if (failed) {
+        fprintf(stderr, "Damaged or truncated log - %s\n", input);
+    }
+
+    fclose(in);
+    if (out != stdout && fclose(out) != 0) {
+        failed = 1;
+    }
+
+    return failed;
+}
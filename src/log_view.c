@@ -0,0 +1,76 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "log_reader.h"
+
+static const char *const log_view_levels[] = { "TRACE", "DEBUG", "INFO", "WARN", "ERROR" };
+
+static int log_view_usage(const char *name) {
+    fprintf(stderr,
+            "Usage: %s [--level LEVEL] [--from TIME] [--to TIME] [--file SOURCE] [--tail N] [log]\n"
+            "  LEVEL is TRACE, DEBUG, INFO, WARN or ERROR\n"
+            "  TIME is \"YYYY-MM-DD HH:MM:SS\" or YYYY-MM-DD\n",
+            name);
+    return 1;
+}
+
+// log_view [options] [log]: defaults to library.log and its rotated files
+int main(int argc, char *argv[]) {
+    LogFilter filter = { LOG_LEVEL_TRACE, 0, 0, NULL, 0 };
+    const char *path = LOG_FILE;
+
+    for (int i = 1; i < argc; i++) {
+        const char *option = argv[i];
+        const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+
+        if (option[0] != '-') {
+            path = option;
+            continue;
+        }
+
+        if (!value || strcmp(option, "-h") == 0 || strcmp(option, "--help") == 0) {
+            return log_view_usage(argv[0]);
+        }
+
+        i++;
+
+        if (strcmp(option, "--level") == 0) {
+            filter.level = -1;
+            for (int level = 0; level < (int)(sizeof(log_view_levels) / sizeof(log_view_levels[0])); level++) {
+                if (strcmp(value, log_view_levels[level]) == 0) {
+                    filter.level = level;
+                }
+            }
+
+            if (filter.level < 0) {
+                return log_view_usage(argv[0]);
+            }
+        } else if (strcmp(option, "--from") == 0) {
+            if (log_parse_time(value, &filter.from) != 0) {
+                return log_view_usage(argv[0]);
+            }
+        } else if (strcmp(option, "--to") == 0) {
+            if (log_parse_time(value, &filter.to) != 0) {
+                return log_view_usage(argv[0]);
+            }
+        } else if (strcmp(option, "--file") == 0) {
+            filter.file = value;
+        } else if (strcmp(option, "--tail") == 0) {
+            char *end;
+            filter.tail = strtoul(value, &end, 10);
+            if (*end != '\0' || filter.tail == 0) {
+                return log_view_usage(argv[0]);
+            }
+        } else {
+            return log_view_usage(argv[0]);
+        }
+    }
+
+    if (log_query(path, &filter, stdout) < 0) {
+        fprintf(stderr, "Cannot read %s\n", path);
+        return 1;
+    }
+
+    return 0;
+}
@@ -4,9 +4,15 @@
 
 #include "library.h"
 #include "cli.h"
+#include "db.h"
 #include "log.h"
 
+#define DB_FILE "library.db"
+#define DB_SYNC_INTERVAL_MS 100
+
 int main(int argc, char *argv[]) {
+    (void)argc;
+    (void)argv;
 /*
     if (argc < 2) {
         printf("Uso: %s [opções]\n", argv[0]);
@@ -14,6 +20,9 @@ int main(int argc, char *argv[]) {
         return 1;
     }
 */
+    // Queued log lines reach library.log even if the program crashes
+    log_catch_crashes();
+
     Library MyLib;
     lb_init(&MyLib);
 /*
@@ -38,7 +47,17 @@ int main(int argc, char *argv[]) {
         }
     }
 */
+    // Changes are journaled as they happen, the snapshot is rewritten on exit
+    Db db;
+    DbOptions options = { JOURNAL_SYNC_INTERVAL, DB_SYNC_INTERVAL_MS, 0 };
+    if (db_open(&db, &MyLib, DB_FILE, &options) != 0) {
+        lb_free(&MyLib);
+        return 1;
+    }
+
     cli_main_loop(&MyLib);
+    db_checkpoint(&db);
+    db_close(&db);
     lb_free(&MyLib);
 
     return 0;
@@ -1,11 +1,767 @@
+#define _XOPEN_SOURCE 700
+
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 #include <stdarg.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sched.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
 #include "log.h"
+#include "log_binary.h"
+#include "log_reader.h"
+
+// Ring of formatted lines (power of two). A full ring makes a producer
+// yield this many times for the writer before the line is dropped.
+#define LOG_RING_SLOTS 1024
+#define LOG_LINE_SIZE 512
+#define LOG_FULL_RETRIES 64
+
+// Lines handed to one writev and the writer's idle wait
+#define LOG_BATCH 64
+#define LOG_IDLE_NS 50000000L
+
+// Binary entries are kept per thread, a buffer is written once it cannot
+// hold the largest entry
+#define LOG_BUFFER_SIZE (64 * 1024)
+#define LOG_ENTRY_HEADER 15
+#define LOG_MAX_ENTRY (LOG_ENTRY_HEADER + LOG_MAX_ARGS * (4 + LOG_MAX_STRING) + 1)
+
+// A slot is free for the producer claiming position p when sequence == p,
+// and holds a line for the writer when sequence == p + 1 (bounded MPSC
+// queue: producers race on head with a CAS, only the writer moves tail)
+typedef struct {
+    atomic_size_t sequence;
+    size_t length;
+    char text[LOG_LINE_SIZE];
+} LogSlot;
+
+typedef struct {
+    LogSlot slots[LOG_RING_SLOTS];
+    atomic_size_t head;
+    atomic_size_t tail;
+    atomic_ulong dropped;
+    atomic_ulong dropped_total;
+
+    int fd;
+    pthread_t writer;
+    atomic_int stop;
+
+    // Time index and rotation, kept by the writer every LOG_INDEX_STRIDE
+    // bytes. file_lock keeps log_reset off a rotation in progress.
+    int index_fd;
+    size_t since_index;
+    atomic_size_t max_size;
+    atomic_int keep;
+    pthread_mutex_t file_lock;
+
+    // Lines are written synchronously: no writer thread (failed to start,
+    // after exit or in a forked child)
+    atomic_int direct;
+
+    // The writer sleeps on wake when idle, producers signal it then
+    atomic_int sleeping;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+} LogState;
+
+int log_levels[LOG_MODULE_COUNT] = {
+    LOG_DEFAULT_LEVEL, LOG_DEFAULT_LEVEL, LOG_DEFAULT_LEVEL, LOG_DEFAULT_LEVEL, LOG_DEFAULT_LEVEL
+};
+
+typedef struct LogBuffer {
+    atomic_flag busy;       // Held by the owner while appending, or a flush
+    atomic_int owned;       // Taken by a live thread
+    size_t used;
+    struct LogBuffer *next;
+    char data[LOG_BUFFER_SIZE];
+} LogBuffer;
+
+typedef struct {
+    int fd;
+    atomic_int enabled;
+
+    // Sites whose generation differs write their record again (the file
+    // was opened or reset since)
+    unsigned int generation;
+    unsigned int site_count;
+    pthread_mutex_t lock;   // Site records and file restarts
+
+    // Every thread buffer ever made, released ones are reused
+    _Atomic(LogBuffer *) buffers;
+    pthread_key_t key;
+} LogBinary;
+
+static LogState log_state = {
+    .fd = -1,
+    .index_fd = -1,
+    .since_index = LOG_INDEX_STRIDE,
+    .max_size = LOG_ROTATE_SIZE,
+    .keep = LOG_ROTATE_KEEP,
+    .file_lock = PTHREAD_MUTEX_INITIALIZER
+};
+static LogBinary log_bin = { .fd = -1, .lock = PTHREAD_MUTEX_INITIALIZER };
+static pthread_once_t log_once = PTHREAD_ONCE_INIT;
+static _Thread_local LogBuffer *log_thread_buffer;
+
+// Formatted "YYYY-MM-DD HH:MM:SS" of the current second, per thread. Sized
+// for six fields of any int width, so nothing is ever cut.
+static _Thread_local time_t log_stamp_second = -1;
+static _Thread_local char log_stamp[6 * 11 + 6];
+
+static const char *log_timestamp(void) {
+    time_t now = time(NULL);
+
+    if (now != log_stamp_second) {
+        struct tm t;
+        if (!localtime_r(&now, &t)) {
+            return NULL;
+        }
+
+        snprintf(log_stamp, sizeof(log_stamp), "%04d-%02d-%02d %02d:%02d:%02d",
+                 t.tm_year + 1900, t.tm_mon + 1, t.tm_mday, t.tm_hour, t.tm_min, t.tm_sec);
+        log_stamp_second = now;
+    }
+
+    return log_stamp;
+}
+
+static void log_write_all(int fd, const char *text, size_t length) {
+    while (length > 0) {
+        ssize_t done = write(fd, text, length);
+        if (done < 0 && errno == EINTR) {
+            continue;
+        }
+
+        if (done <= 0) {
+            return;
+        }
+
+        text += done;
+        length -= (size_t)done;
+    }
+}
+
+// Line into buffer, cut to size with the newline kept. Returns its length.
+static size_t log_format(char *buffer, size_t size, const char *level, const char *file, int line,
+                         const char *func, const char *fmt, va_list args) {
+    const char *stamp = log_timestamp();
+    int head = snprintf(buffer, size, "%s | %s | %s:%d (%s) | ", stamp ? stamp : "", level, file, line, func);
+    size_t length = head < 0 ? 0 : (size_t)head;
+
+    if (length < size - 1) {
+        int body = vsnprintf(buffer + length, size - 1 - length, fmt, args);
+        length += body < 0 ? 0 : (size_t)body;
+    }
+
+    if (length > size - 2) {
+        length = size - 2;
+    }
+
+    buffer[length++] = '\n';
+    buffer[length] = '\0';
+    return length;
+}
+
+static void log_wake_writer(void) {
+    if (atomic_load_explicit(&log_state.sleeping, memory_order_acquire)) {
+        pthread_mutex_lock(&log_state.lock);
+        pthread_cond_signal(&log_state.wake);
+        pthread_mutex_unlock(&log_state.lock);
+    }
+}
+
+static void log_write_dropped(void) {
+    unsigned long dropped = atomic_exchange(&log_state.dropped, 0);
+    if (dropped == 0) {
+        return;
+    }
+
+    char line[128];
+    const char *stamp = log_timestamp();
+    int length = snprintf(line, sizeof(line), "%s | WARN | log | %lu Messages Dropped\n",
+                          stamp ? stamp : "", dropped);
+
+    if (length > 0) {
+        log_write_all(log_state.fd, line, (size_t)length < sizeof(line) ? (size_t)length : sizeof(line) - 1);
+    }
+}
+
+static int log_file_name(char *name, size_t size, int age, const char *suffix) {
+    int length = age == 0 ? snprintf(name, size, "%s%s", LOG_FILE, suffix)
+                          : snprintf(name, size, "%s.%d%s", LOG_FILE, age, suffix);
+    return length < 0 || (size_t)length >= size;
+}
+
+// Replace what fd refers to by a new file of that name, the descriptor
+// number stays valid for the crash handler
+static void log_reopen(int fd, const char *name) {
+    int opened = open(name, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (opened < 0) {
+        return;
+    }
+
+    if (fd >= 0 && dup2(opened, fd) == fd) {
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+    }
+
+    close(opened);
+}
+
+// Empty a log file, through the writer's descriptor when it has one
+static void log_truncate(int fd, const char *name) {
+    if (fd >= 0 && ftruncate(fd, 0) == 0) {
+        return;
+    }
+
+    FILE *file = fopen(name, "w");
+    if (file) {
+        fclose(file);
+    }
+}
+
+// library.log becomes library.log.1, older files shift up, the oldest is
+// dropped. Each index moves with its log.
+static void log_rotate(void) {
+    static const char *const suffixes[] = { "", LOG_INDEX_SUFFIX };
+    char from[64];
+    char to[64];
+    int keep = atomic_load(&log_state.keep);
+
+    for (size_t s = 0; s < 2; s++) {
+        for (int age = keep; age > 0; age--) {
+            if (log_file_name(from, sizeof(from), age - 1, suffixes[s]) == 0 &&
+                log_file_name(to, sizeof(to), age, suffixes[s]) == 0) {
+                rename(from, to);
+            }
+        }
+    }
+
+    log_reopen(log_state.fd, LOG_FILE);
+    log_reopen(log_state.index_fd, LOG_FILE LOG_INDEX_SUFFIX);
+}
+
+// Every LOG_INDEX_STRIDE bytes: rotate a full log, or note where the next
+// batch starts with the current second (lines before it are not newer)
+static void log_checkpoint(void) {
+    pthread_mutex_lock(&log_state.file_lock);
+
+    off_t end = lseek(log_state.fd, 0, SEEK_END);
+    size_t max_size = atomic_load(&log_state.max_size);
+
+    if (end >= 0 && max_size > 0 && (size_t)end >= max_size && atomic_load(&log_state.keep) > 0) {
+        log_rotate();
+    } else if (end > 0 && log_state.index_fd >= 0) {
+        LogIndexEntry entry = { (int64_t)time(NULL), (uint64_t)end };
+        log_write_all(log_state.index_fd, (const char *)&entry, sizeof(entry));
+    }
+
+    log_state.since_index = 0;
+    pthread_mutex_unlock(&log_state.file_lock);
+}
+
+// Write every published line in batches, returns how many were written
+static size_t log_drain(void) {
+    size_t tail = atomic_load_explicit(&log_state.tail, memory_order_relaxed);
+    size_t total = 0;
+
+    for (;;) {
+        struct iovec batch[LOG_BATCH];
+        size_t count = 0;
+
+        while (count < LOG_BATCH) {
+            LogSlot *slot = &log_state.slots[(tail + count) & (LOG_RING_SLOTS - 1)];
+            size_t sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+
+            if (sequence != tail + count + 1) {
+                break;
+            }
+
+            batch[count].iov_base = slot->text;
+            batch[count].iov_len = slot->length;
+            count++;
+        }
+
+        if (count == 0) {
+            break;
+        }
+
+        if (log_state.since_index >= LOG_INDEX_STRIDE) {
+            log_checkpoint();
+        }
+
+        // Partial writes fall back to one line at a time
+        size_t size = 0;
+        for (size_t i = 0; i < count; i++) {
+            size += batch[i].iov_len;
+        }
+        log_state.since_index += size;
+
+        ssize_t done = writev(log_state.fd, batch, (int)count);
+        if (done >= 0 && (size_t)done < size) {
+            for (size_t i = 0; i < count; i++) {
+                if ((size_t)done >= batch[i].iov_len) {
+                    done -= (ssize_t)batch[i].iov_len;
+                    continue;
+                }
+
+                log_write_all(log_state.fd, (const char *)batch[i].iov_base + done, batch[i].iov_len - (size_t)done);
+                done = 0;
+            }
+        }
+
+        // Hand the slots back to producers one lap ahead
+        for (size_t i = 0; i < count; i++) {
+            LogSlot *slot = &log_state.slots[(tail + i) & (LOG_RING_SLOTS - 1)];
+            atomic_store_explicit(&slot->sequence, tail + i + LOG_RING_SLOTS, memory_order_release);
+        }
+
+        tail += count;
+        total += count;
+        atomic_store_explicit(&log_state.tail, tail, memory_order_release);
+    }
+
+    log_write_dropped();
+    return total;
+}
+
+static void *log_writer_main(void *arg) {
+    (void)arg;
+
+    for (;;) {
+        if (log_drain() > 0) {
+            continue;
+        }
+
+        if (atomic_load(&log_state.stop)) {
+            break;
+        }
+
+        // Sleep until signaled, re-checking the ring once asleep so a line
+        // published meanwhile is not left waiting for the timeout
+        pthread_mutex_lock(&log_state.lock);
+        atomic_store(&log_state.sleeping, 1);
+
+        size_t tail = atomic_load(&log_state.tail);
+        LogSlot *slot = &log_state.slots[tail & (LOG_RING_SLOTS - 1)];
+
+        if (atomic_load(&slot->sequence) != tail + 1 && !atomic_load(&log_state.stop)) {
+            struct timespec until;
+            clock_gettime(CLOCK_REALTIME, &until);
+            until.tv_nsec += LOG_IDLE_NS;
+            if (until.tv_nsec >= 1000000000L) {
+                until.tv_sec++;
+                until.tv_nsec -= 1000000000L;
+            }
+
+            pthread_cond_timedwait(&log_state.wake, &log_state.lock, &until);
+        }
+
+        atomic_store(&log_state.sleeping, 0);
+        pthread_mutex_unlock(&log_state.lock);
+    }
+
+    log_drain();
+    return NULL;
+}
+
+// Binary Log
+
+static void log_buffer_lock(LogBuffer *buffer) {
+    while (atomic_flag_test_and_set_explicit(&buffer->busy, memory_order_acquire)) {
+        sched_yield();
+    }
+}
+
+static void log_buffer_unlock(LogBuffer *buffer) {
+    atomic_flag_clear_explicit(&buffer->busy, memory_order_release);
+}
+
+// Whole entries in one write, so threads never interleave inside one
+static void log_buffer_write(LogBuffer *buffer) {
+    if (buffer->used > 0 && log_bin.fd >= 0) {
+        log_write_all(log_bin.fd, buffer->data, buffer->used);
+    }
+
+    buffer->used = 0;
+}
+
+static void log_flush_buffers(void) {
+    for (LogBuffer *buffer = atomic_load(&log_bin.buffers); buffer; buffer = buffer->next) {
+        log_buffer_lock(buffer);
+        log_buffer_write(buffer);
+        log_buffer_unlock(buffer);
+    }
+}
+
+// Thread exit: write what is left and hand the buffer to the next thread
+static void log_release_buffer(void *ptr) {
+    LogBuffer *buffer = ptr;
+
+    log_buffer_lock(buffer);
+    log_buffer_write(buffer);
+    log_buffer_unlock(buffer);
+    atomic_store(&buffer->owned, 0);
+}
+
+static LogBuffer *log_get_buffer(void) {
+    if (log_thread_buffer) {
+        return log_thread_buffer;
+    }
+
+    LogBuffer *buffer = atomic_load(&log_bin.buffers);
+    for (; buffer; buffer = buffer->next) {
+        int released = 0;
+        if (atomic_compare_exchange_strong(&buffer->owned, &released, 1)) {
+            break;
+        }
+    }
+
+    if (!buffer) {
+        buffer = calloc(1, sizeof(LogBuffer));
+        if (!buffer) {
+            return NULL;
+        }
+
+        atomic_flag_clear(&buffer->busy);
+        atomic_init(&buffer->owned, 1);
+        buffer->next = atomic_load(&log_bin.buffers);
+        while (!atomic_compare_exchange_weak(&log_bin.buffers, &buffer->next, buffer)) {
+        }
+    }
+
+    pthread_setspecific(log_bin.key, buffer);
+    log_thread_buffer = buffer;
+    return buffer;
+}
+
+static void log_put(char **out, const void *data, size_t size) {
+    memcpy(*out, data, size);
+    *out += size;
+}
+
+static void log_put_text(char **out, const char *text) {
+    size_t length = strlen(text);
+    uint16_t size = (uint16_t)(length < UINT16_MAX ? length : UINT16_MAX);
+
+    log_put(out, &size, sizeof(size));
+    log_put(out, text, size);
+}
+
+// Give the site an id and write its record to the current file
+static void log_register_site(LogSite *site) {
+    pthread_mutex_lock(&log_bin.lock);
+
+    if (site->generation != log_bin.generation && log_bin.fd >= 0) {
+        if (site->id == 0) {
+            site->arg_count = log_format_kinds(site->fmt, site->kinds, LOG_MAX_ARGS);
+            site->id = ++log_bin.site_count;
+        }
+
+        // A format the encoder cannot follow is rendered at the call
+        static const unsigned char text_kind = LOG_ARG_STRING;
+        int32_t line = site->line;
+        uint8_t arg_count = (uint8_t)(site->arg_count < 0 ? 1 : site->arg_count);
+        const unsigned char *kinds = site->arg_count < 0 ? &text_kind : site->kinds;
+        const char *fmt = site->arg_count < 0 ? "%s" : site->fmt;
+
+        size_t size = 1 + sizeof(site->id) + sizeof(line) + 1 + arg_count + 4 * sizeof(uint16_t) +
+                      strlen(site->level) + strlen(site->file) + strlen(site->func) + strlen(fmt);
+        char *record = malloc(size);
 
-#define LOG_FILE "library.log"
+        if (record) {
+            char *out = record;
+            *out++ = LOG_RECORD_SITE;
+            log_put(&out, &site->id, sizeof(site->id));
+            log_put(&out, &line, sizeof(line));
+            *out++ = (char)arg_count;
+            log_put(&out, kinds, arg_count);
+            log_put_text(&out, site->level);
+            log_put_text(&out, site->file);
+            log_put_text(&out, site->func);
+            log_put_text(&out, fmt);
 
+            log_write_all(log_bin.fd, record, (size_t)(out - record));
+            free(record);
+            __atomic_store_n(&site->generation, log_bin.generation, __ATOMIC_RELEASE);
+        }
+    }
+
+    pthread_mutex_unlock(&log_bin.lock);
+}
+
+static uint64_t log_clock(void) {
+    struct timespec now;
+#ifdef CLOCK_REALTIME_COARSE
+    clock_gettime(CLOCK_REALTIME_COARSE, &now);
+#else
+    clock_gettime(CLOCK_REALTIME, &now);
+#endif
+    return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
+
+// Raw arguments in the order of the conversions, returns their size
+static size_t log_encode_args(const LogSite *site, char *out, va_list args) {
+    char *start = out;
+
+    for (int i = 0; i < site->arg_count; i++) {
+        switch (site->kinds[i]) {
+            case LOG_ARG_INT: {
+                int32_t value = va_arg(args, int);
+                log_put(&out, &value, sizeof(value));
+                break;
+            }
+            case LOG_ARG_LONG: {
+                int64_t value = va_arg(args, long);
+                log_put(&out, &value, sizeof(value));
+                break;
+            }
+            case LOG_ARG_LLONG: {
+                int64_t value = va_arg(args, long long);
+                log_put(&out, &value, sizeof(value));
+                break;
+            }
+            case LOG_ARG_SIZE: {
+                uint64_t value = va_arg(args, size_t);
+                log_put(&out, &value, sizeof(value));
+                break;
+            }
+            case LOG_ARG_INTMAX: {
+                int64_t value = va_arg(args, intmax_t);
+                log_put(&out, &value, sizeof(value));
+                break;
+            }
+            case LOG_ARG_PTRDIFF: {
+                int64_t value = va_arg(args, ptrdiff_t);
+                log_put(&out, &value, sizeof(value));
+                break;
+            }
+            case LOG_ARG_DOUBLE: {
+                double value = va_arg(args, double);
+                log_put(&out, &value, sizeof(value));
+                break;
+            }
+            case LOG_ARG_POINTER: {
+                uint64_t value = (uint64_t)(uintptr_t)va_arg(args, void *);
+                log_put(&out, &value, sizeof(value));
+                break;
+            }
+            default: {
+                const char *text = va_arg(args, const char *);
+                if (!text) {
+                    text = "(null)";
+                }
+
+                uint32_t length = (uint32_t)strnlen(text, LOG_MAX_STRING);
+                log_put(&out, &length, sizeof(length));
+                log_put(&out, text, length);
+                break;
+            }
+        }
+    }
+
+    return (size_t)(out - start);
+}
+
+static void log_write_binary(LogSite *site, va_list args) {
+    if (__atomic_load_n(&site->generation, __ATOMIC_ACQUIRE) !=
+        __atomic_load_n(&log_bin.generation, __ATOMIC_ACQUIRE)) {
+        log_register_site(site);
+    }
+
+    LogBuffer *buffer = log_get_buffer();
+    if (!buffer) {
+        return;
+    }
+
+    log_buffer_lock(buffer);
+
+    if (LOG_BUFFER_SIZE - buffer->used < LOG_MAX_ENTRY) {
+        log_buffer_write(buffer);
+    }
+
+    char *entry = buffer->data + buffer->used;
+    char *out = entry;
+    uint64_t stamp = log_clock();
+
+    *out++ = LOG_RECORD_ENTRY;
+    log_put(&out, &site->id, sizeof(site->id));
+    log_put(&out, &stamp, sizeof(stamp));
+
+    size_t size;
+    if (site->arg_count < 0) {
+        int length = vsnprintf(out + 2 + sizeof(uint32_t), LOG_MAX_STRING + 1, site->fmt, args);
+        uint32_t text = (uint32_t)(length < 0 ? 0 : length > LOG_MAX_STRING ? LOG_MAX_STRING : length);
+        memcpy(out + 2, &text, sizeof(text));
+        size = sizeof(text) + text;
+    } else {
+        size = log_encode_args(site, out + 2, args);
+    }
+
+    uint16_t size16 = (uint16_t)size;
+    memcpy(out, &size16, sizeof(size16));
+    buffer->used += LOG_ENTRY_HEADER + size;
+
+    // Without the exit handler (forked child, after exit) nothing waits
+    if (atomic_load_explicit(&log_state.direct, memory_order_relaxed)) {
+        log_buffer_write(buffer);
+    }
+
+    log_buffer_unlock(buffer);
+}
+
+// Text Log
+
+static void log_write_text(const char *level, const char *file, int line, const char *func, const char *fmt,
+                           va_list args) {
+    if (log_state.fd < 0) {
+        return;
+    }
+
+    if (atomic_load_explicit(&log_state.direct, memory_order_acquire)) {
+        char text[LOG_LINE_SIZE];
+        size_t length = log_format(text, sizeof(text), level, file, line, func, fmt, args);
+        log_write_all(log_state.fd, text, length);
+        return;
+    }
+
+    // Claim a slot
+    size_t position = atomic_load_explicit(&log_state.head, memory_order_relaxed);
+    LogSlot *slot = NULL;
+    int retries = 0;
+
+    while (!slot) {
+        LogSlot *candidate = &log_state.slots[position & (LOG_RING_SLOTS - 1)];
+        size_t sequence = atomic_load_explicit(&candidate->sequence, memory_order_acquire);
+        intptr_t lag = (intptr_t)sequence - (intptr_t)position;
+
+        if (lag == 0) {
+            if (atomic_compare_exchange_weak_explicit(&log_state.head, &position, position + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                slot = candidate;
+            }
+        } else if (lag < 0) {
+            // Full: give the writer a chance, then drop the line
+            if (retries++ == LOG_FULL_RETRIES) {
+                atomic_fetch_add(&log_state.dropped, 1);
+                atomic_fetch_add(&log_state.dropped_total, 1);
+                return;
+            }
+
+            log_wake_writer();
+            sched_yield();
+            position = atomic_load_explicit(&log_state.head, memory_order_relaxed);
+        } else {
+            position = atomic_load_explicit(&log_state.head, memory_order_relaxed);
+        }
+    }
+
+    slot->length = log_format(slot->text, sizeof(slot->text), level, file, line, func, fmt, args);
+    atomic_store_explicit(&slot->sequence, position + 1, memory_order_release);
+    log_wake_writer();
+}
+
+static void log_shutdown(void) {
+    if (atomic_exchange(&log_state.direct, 1)) {
+        return;
+    }
+
+    atomic_store(&log_state.stop, 1);
+    pthread_mutex_lock(&log_state.lock);
+    pthread_cond_signal(&log_state.wake);
+    pthread_mutex_unlock(&log_state.lock);
+    pthread_join(log_state.writer, NULL);
+    log_flush_buffers();
+}
+
+static void log_before_fork(void) {
+    pthread_mutex_lock(&log_bin.lock);
+}
+
+static void log_after_fork_parent(void) {
+    pthread_mutex_unlock(&log_bin.lock);
+}
+
+// The child of a fork has no writer thread, it logs synchronously. The
+// binary entries it inherited are the parent's to write.
+static void log_after_fork(void) {
+    atomic_store(&log_state.direct, 1);
+    pthread_mutex_unlock(&log_bin.lock);
+
+    for (LogBuffer *buffer = atomic_load(&log_bin.buffers); buffer; buffer = buffer->next) {
+        buffer->used = 0;
+        atomic_flag_clear(&buffer->busy);
+    }
+}
+
+static int log_open_binary(void) {
+    if (log_bin.fd >= 0) {
+        return 0;
+    }
+
+    log_bin.fd = open(LOG_BINARY_FILE, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (log_bin.fd < 0) {
+        return 1;
+    }
+
+    struct stat st;
+    if (fstat(log_bin.fd, &st) == 0 && st.st_size == 0) {
+        log_write_all(log_bin.fd, LOG_BINARY_MAGIC, LOG_BINARY_MAGIC_SIZE);
+    }
+
+    __atomic_add_fetch(&log_bin.generation, 1, __ATOMIC_RELEASE);
+    return 0;
+}
+
+static void log_start(void) {
+    log_state.fd = open(LOG_FILE, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    log_state.index_fd = open(LOG_FILE LOG_INDEX_SUFFIX, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+
+    for (size_t i = 0; i < LOG_RING_SLOTS; i++) {
+        atomic_init(&log_state.slots[i].sequence, i);
+    }
+
+    pthread_mutex_init(&log_state.lock, NULL);
+    pthread_cond_init(&log_state.wake, NULL);
+    pthread_key_create(&log_bin.key, log_release_buffer);
+
+    const char *format = getenv("LIBRARY_LOG_FORMAT");
+    if (format && strcmp(format, "binary") == 0 && log_open_binary() == 0) {
+        atomic_store(&log_bin.enabled, 1);
+    }
+
+    if (log_state.fd < 0 || pthread_create(&log_state.writer, NULL, log_writer_main, NULL) != 0) {
+        atomic_store(&log_state.direct, 1);
+        return;
+    }
+
+    atexit(log_shutdown);
+    pthread_atfork(log_before_fork, log_after_fork_parent, log_after_fork);
+}
+
+void log_write_site(LogSite *site, const char *fmt, ...) {
+    pthread_once(&log_once, log_start);
+
+    va_list args;
+    va_start(args, fmt);
+
+    if (atomic_load_explicit(&log_bin.enabled, memory_order_relaxed)) {
+        log_write_binary(site, args);
+    } else {
+        log_write_text(site->level, site->file, site->line, site->func, site->fmt, args);
+    }
+
+    va_end(args);
+}
 
 void log_register_internal(
     const char *level,
@@ -15,63 +771,161 @@ void log_register_internal(
     const char *fmt,
     ...
 ) {
-    
-    FILE *log = fopen(LOG_FILE, "a");
-    if (!log) {
-        return;
+    pthread_once(&log_once, log_start);
+
+    va_list args;
+    va_start(args, fmt);
+    log_write_text(level, file, line, func, fmt, args);
+    va_end(args);
+}
+
+int log_set_binary(int enabled) {
+    pthread_once(&log_once, log_start);
+
+    if (!enabled) {
+        atomic_store(&log_bin.enabled, 0);
+        log_flush_buffers();
+        return 0;
     }
 
-    time_t now = time(NULL);
-    struct tm *t = localtime(&now);
+    pthread_mutex_lock(&log_bin.lock);
+    int failed = log_open_binary();
+    pthread_mutex_unlock(&log_bin.lock);
+
+    if (!failed) {
+        atomic_store(&log_bin.enabled, 1);
+    }
+
+    return failed;
+}
+
+int log_set_level(int module, int level) {
+    if (module < LOG_MODULE_ALL || module >= LOG_MODULE_COUNT || level < LOG_LEVEL_TRACE || level > LOG_LEVEL_OFF) {
+        return 1;
+    }
+
+    for (int i = 0; i < LOG_MODULE_COUNT; i++) {
+        if (module == LOG_MODULE_ALL || module == i) {
+            __atomic_store_n(&log_levels[i], level, __ATOMIC_RELAXED);
+        }
+    }
+
+    return 0;
+}
+
+int log_get_level(int module) {
+    if (module < 0 || module >= LOG_MODULE_COUNT) {
+        return -1;
+    }
 
-    if (!t) {
-        fclose(log);
+    return __atomic_load_n(&log_levels[module], __ATOMIC_RELAXED);
+}
+
+void log_flush(void) {
+    pthread_once(&log_once, log_start);
+    log_flush_buffers();
+
+    if (atomic_load(&log_state.direct)) {
         return;
     }
 
-    fprintf(log,
-        "%04d-%02d-%02d %02d:%02d:%02d | %s | %s:%d (%s) | ",
-        t->tm_year + 1900,
-        t->tm_mon + 1,
-        t->tm_mday,
-        t->tm_hour,
-        t->tm_min,
-        t->tm_sec,
-        level,
-        file,
-        line,
-        func
-    );
+    // Lines claimed before the call, published or about to be
+    size_t target = atomic_load(&log_state.head);
+    struct timespec pause = { 0, 1000000L };
 
-    va_list args;
-    va_start(args, fmt);
+    while (atomic_load(&log_state.tail) < target && !atomic_load(&log_state.direct)) {
+        pthread_mutex_lock(&log_state.lock);
+        pthread_cond_signal(&log_state.wake);
+        pthread_mutex_unlock(&log_state.lock);
+        nanosleep(&pause, NULL);
+    }
+}
+
+unsigned long log_dropped(void) {
+    return atomic_load(&log_state.dropped_total);
+}
 
-    vfprintf(log, fmt, args);
+// Fatal signals write what the writer has not reached yet (only write(2)
+// is used), then the default action runs (SA_RESETHAND restored it)
+static void log_on_crash(int sig) {
+    if (log_state.fd >= 0 && !atomic_load(&log_state.direct)) {
+        size_t tail = atomic_load(&log_state.tail);
 
-    va_end(args);
+        for (size_t i = 0; i < LOG_RING_SLOTS; i++) {
+            LogSlot *slot = &log_state.slots[(tail + i) & (LOG_RING_SLOTS - 1)];
+            if (atomic_load(&slot->sequence) != tail + i + 1) {
+                break;
+            }
 
-    fprintf(log, "\n");
+            log_write_all(log_state.fd, slot->text, slot->length);
+        }
+    }
 
-    fclose(log);
+    // Binary entries are written without taking the buffers
+    for (LogBuffer *buffer = atomic_load(&log_bin.buffers); buffer; buffer = buffer->next) {
+        log_buffer_write(buffer);
+    }
+
+    raise(sig);
 }
 
-void log_read() {
-    FILE *log = fopen("library.log", "r");
+void log_catch_crashes(void) {
+    static const int signals[] = { SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT };
 
-    if(log == NULL) return;
+    pthread_once(&log_once, log_start);
 
-    char line[256];
+    for (size_t i = 0; i < sizeof(signals) / sizeof(signals[0]); i++) {
+        struct sigaction action;
+        memset(&action, 0, sizeof(action));
+        action.sa_handler = log_on_crash;
+        sigemptyset(&action.sa_mask);
+        action.sa_flags = (int)SA_RESETHAND;
+        sigaction(signals[i], &action, NULL);
+    }
+}
 
-    while(fgets(line, sizeof(line), log)) {
-        printf("%s", line);
+int log_set_rotation(size_t max_size, int keep) {
+    if (keep < 0 || keep > LOG_ROTATE_MAX_KEEP) {
+        return 1;
     }
 
-    fclose(log);
+    atomic_store(&log_state.max_size, max_size);
+    atomic_store(&log_state.keep, keep);
+    return 0;
 }
- 
+
+void log_read() {
+    log_flush();
+    log_query(LOG_FILE, NULL, stdout);
+}
+
 void log_reset(){
-    FILE *log = fopen("library.log", "w");
-    if (!log) return;
+    log_flush();
 
-    fclose(log);
-}
\ No newline at end of file
+    // A restarted binary log declares its sites again
+    pthread_mutex_lock(&log_bin.lock);
+    if (log_bin.fd >= 0 && ftruncate(log_bin.fd, 0) == 0) {
+        log_write_all(log_bin.fd, LOG_BINARY_MAGIC, LOG_BINARY_MAGIC_SIZE);
+        __atomic_add_fetch(&log_bin.generation, 1, __ATOMIC_RELEASE);
+    }
+    pthread_mutex_unlock(&log_bin.lock);
+
+    // Rotated logs go, the writer appends so truncating is enough for the rest
+    pthread_mutex_lock(&log_state.file_lock);
+
+    char name[64];
+    for (int age = 1; age <= LOG_ROTATE_MAX_KEEP; age++) {
+        if (log_file_name(name, sizeof(name), age, "") != 0 || unlink(name) != 0) {
+            break;
+        }
+
+        if (log_file_name(name, sizeof(name), age, LOG_INDEX_SUFFIX) == 0) {
+            unlink(name);
+        }
+    }
+
+    log_truncate(log_state.index_fd, LOG_FILE LOG_INDEX_SUFFIX);
+    log_truncate(log_state.fd, LOG_FILE);
+
+    pthread_mutex_unlock(&log_state.file_lock);
+}
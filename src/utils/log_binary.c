@@ -0,0 +1,409 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include "log_binary.h"
+
+static int log_is_digit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+static int log_integer_kind(char modifier) {
+    switch (modifier) {
+        case 0:
+        case 'h':
+            return LOG_ARG_INT;
+        case 'l':
+            return LOG_ARG_LONG;
+        case 'q':
+            return LOG_ARG_LLONG;
+        case 'z':
+            return LOG_ARG_SIZE;
+        case 'j':
+            return LOG_ARG_INTMAX;
+        case 't':
+            return LOG_ARG_PTRDIFF;
+        default:
+            return 0;
+    }
+}
+
+int log_parse_spec(const char *fmt, LogSpec *spec) {
+    const char *p = fmt + 1;
+    memset(spec, 0, sizeof(*spec));
+
+    if (*p == '%') {
+        spec->length = 2;
+        return 0;
+    }
+
+    while (*p && strchr("-+ #0", *p)) {
+        p++;
+    }
+
+    if (*p == '*') {
+        spec->stars++;
+        p++;
+    } else {
+        while (log_is_digit(*p)) {
+            p++;
+        }
+    }
+
+    // Positional arguments are not supported
+    if (*p == '$') {
+        return 1;
+    }
+
+    if (*p == '.') {
+        p++;
+        if (*p == '*') {
+            spec->stars++;
+            p++;
+        } else {
+            while (log_is_digit(*p)) {
+                p++;
+            }
+        }
+    }
+
+    // 'q' stands for ll
+    char modifier = 0;
+    if (*p == 'h') {
+        modifier = 'h';
+        p += p[1] == 'h' ? 2 : 1;
+    } else if (*p == 'l') {
+        modifier = p[1] == 'l' ? 'q' : 'l';
+        p += p[1] == 'l' ? 2 : 1;
+    } else if (*p && strchr("zjtL", *p)) {
+        modifier = *p++;
+    }
+
+    switch (*p) {
+        case 'd': case 'i': case 'u': case 'o': case 'x': case 'X':
+            spec->kind = log_integer_kind(modifier);
+            break;
+        case 'c':
+            spec->kind = modifier == 0 ? LOG_ARG_INT : 0;
+            break;
+        case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+            spec->kind = modifier == 0 || modifier == 'l' ? LOG_ARG_DOUBLE : 0;
+            break;
+        case 's':
+            spec->kind = modifier == 0 ? LOG_ARG_STRING : 0;
+            break;
+        case 'p':
+            spec->kind = modifier == 0 ? LOG_ARG_POINTER : 0;
+            break;
+        default:
+            break;
+    }
+
+    if (spec->kind == 0) {
+        return 1;
+    }
+
+    spec->length = (int)(p + 1 - fmt);
+    return 0;
+}
+
+int log_format_kinds(const char *fmt, unsigned char *kinds, int max) {
+    int count = 0;
+
+    for (const char *p = fmt; *p; p++) {
+        if (*p != '%') {
+            continue;
+        }
+
+        LogSpec spec;
+        if (log_parse_spec(p, &spec) != 0 || count + spec.stars + (spec.kind != 0) > max) {
+            return -1;
+        }
+
+        for (int i = 0; i < spec.stars; i++) {
+            kinds[count++] = LOG_ARG_INT;
+        }
+
+        if (spec.kind) {
+            kinds[count++] = (unsigned char)spec.kind;
+        }
+
+        p += spec.length - 1;
+    }
+
+    return count;
+}
+
+// Decoder
+
+typedef struct {
+    int line;
+    char *level;
+    char *file;
+    char *func;
+    char *fmt;
+} LogDecodedSite;
+
+typedef struct {
+    LogDecodedSite *sites;
+    uint32_t capacity;
+} LogSites;
+
+static void log_free_site(LogDecodedSite *site) {
+    free(site->level);
+    free(site->file);
+    free(site->func);
+    free(site->fmt);
+    memset(site, 0, sizeof(*site));
+}
+
+static int log_read_bytes(FILE *in, void *data, size_t size) {
+    return fread(data, 1, size, in) == size ? 0 : 1;
+}
+
+static char *log_read_string(FILE *in) {
+    uint16_t length;
+    if (log_read_bytes(in, &length, sizeof(length)) != 0) {
+        return NULL;
+    }
+
+    char *text = malloc((size_t)length + 1);
+    if (!text || log_read_bytes(in, text, length) != 0) {
+        free(text);
+        return NULL;
+    }
+
+    text[length] = '\0';
+    return text;
+}
+
+static int log_read_site(FILE *in, LogSites *sites) {
+    uint32_t id;
+    int32_t line;
+    uint8_t arg_count;
+    unsigned char kinds[LOG_MAX_ARGS];
+
+    if (log_read_bytes(in, &id, sizeof(id)) != 0 || log_read_bytes(in, &line, sizeof(line)) != 0 ||
+        log_read_bytes(in, &arg_count, sizeof(arg_count)) != 0 || arg_count > LOG_MAX_ARGS ||
+        log_read_bytes(in, kinds, arg_count) != 0 || id == 0 || id > UINT32_MAX / 2) {
+        return 1;
+    }
+
+    if (id >= sites->capacity) {
+        uint32_t capacity = sites->capacity ? sites->capacity : 64;
+        while (capacity <= id) {
+            capacity *= 2;
+        }
+
+        LogDecodedSite *tmp = realloc(sites->sites, (size_t)capacity * sizeof(LogDecodedSite));
+        if (!tmp) {
+            return 1;
+        }
+
+        memset(tmp + sites->capacity, 0, (size_t)(capacity - sites->capacity) * sizeof(LogDecodedSite));
+        sites->sites = tmp;
+        sites->capacity = capacity;
+    }
+
+    // A reset log declares its sites again
+    LogDecodedSite *site = &sites->sites[id];
+    log_free_site(site);
+    site->line = line;
+    site->level = log_read_string(in);
+    site->file = site->level ? log_read_string(in) : NULL;
+    site->func = site->file ? log_read_string(in) : NULL;
+    site->fmt = site->func ? log_read_string(in) : NULL;
+
+    // The kinds follow from the format, it must still read them all
+    unsigned char expected[LOG_MAX_ARGS];
+    if (!site->fmt || log_format_kinds(site->fmt, expected, LOG_MAX_ARGS) != arg_count ||
+        memcmp(expected, kinds, arg_count) != 0) {
+        log_free_site(site);
+        return 1;
+    }
+
+    return 0;
+}
+
+static int log_take(const char *payload, size_t size, size_t *at, void *data, size_t length) {
+    if (length > size - *at) {
+        return 1;
+    }
+
+    memcpy(data, payload + *at, length);
+    *at += length;
+    return 0;
+}
+
+// One argument rendered through its own conversion. Wide integers are all
+// printed as long long, '*' are replaced by their stored value.
+static int log_render_arg(FILE *out, const char *conversion, const LogSpec *spec, const char *payload,
+                          size_t size, size_t *at) {
+    char format[64];
+    size_t n = 0;
+    int wide = spec->kind >= LOG_ARG_LONG && spec->kind <= LOG_ARG_PTRDIFF;
+
+    if (spec->length > 40) {
+        return 1;
+    }
+
+    for (int i = 0; i < spec->length - 1; i++) {
+        char c = conversion[i];
+
+        if (c == '*') {
+            int32_t value;
+            if (log_take(payload, size, at, &value, sizeof(value)) != 0) {
+                return 1;
+            }
+            n += (size_t)snprintf(format + n, sizeof(format) - n, "%d", value);
+        } else if (!wide || !strchr("lzjt", c)) {
+            format[n++] = c;
+        }
+    }
+
+    if (wide) {
+        format[n++] = 'l';
+        format[n++] = 'l';
+    }
+    format[n++] = conversion[spec->length - 1];
+    format[n] = '\0';
+
+    if (spec->kind == LOG_ARG_INT) {
+        int32_t value;
+        if (log_take(payload, size, at, &value, sizeof(value)) != 0) {
+            return 1;
+        }
+        fprintf(out, format, value);
+    } else if (wide) {
+        int64_t value;
+        if (log_take(payload, size, at, &value, sizeof(value)) != 0) {
+            return 1;
+        }
+        fprintf(out, format, (long long)value);
+    } else if (spec->kind == LOG_ARG_DOUBLE) {
+        double value;
+        if (log_take(payload, size, at, &value, sizeof(value)) != 0) {
+            return 1;
+        }
+        fprintf(out, format, value);
+    } else if (spec->kind == LOG_ARG_POINTER) {
+        uint64_t value;
+        if (log_take(payload, size, at, &value, sizeof(value)) != 0) {
+            return 1;
+        }
+        fprintf(out, format, (void *)(uintptr_t)value);
+    } else {
+        uint32_t length;
+        char text[LOG_MAX_STRING + 1];
+        if (log_take(payload, size, at, &length, sizeof(length)) != 0 || length > LOG_MAX_STRING ||
+            log_take(payload, size, at, text, length) != 0) {
+            return 1;
+        }
+        text[length] = '\0';
+        fprintf(out, format, text);
+    }
+
+    return 0;
+}
+
+static int log_render(FILE *out, const LogDecodedSite *site, const char *payload, size_t size) {
+    size_t at = 0;
+
+    for (const char *p = site->fmt; *p;) {
+        if (*p != '%') {
+            fputc(*p++, out);
+            continue;
+        }
+
+        LogSpec spec;
+        if (log_parse_spec(p, &spec) != 0) {
+            return 1;
+        }
+
+        if (spec.kind == 0) {
+            fputc('%', out);
+        } else if (log_render_arg(out, p, &spec, payload, size, &at) != 0) {
+            return 1;
+        }
+
+        p += spec.length;
+    }
+
+    return at == size ? 0 : 1;
+}
+
+static int log_read_entry(FILE *in, FILE *out, const LogSites *sites, char *payload) {
+    uint32_t id;
+    uint64_t ns;
+    uint16_t size;
+
+    if (log_read_bytes(in, &id, sizeof(id)) != 0 || log_read_bytes(in, &ns, sizeof(ns)) != 0 ||
+        log_read_bytes(in, &size, sizeof(size)) != 0 || log_read_bytes(in, payload, size) != 0) {
+        return 1;
+    }
+
+    if (id >= sites->capacity || !sites->sites[id].fmt) {
+        return 1;
+    }
+
+    const LogDecodedSite *site = &sites->sites[id];
+    time_t seconds = (time_t)(ns / 1000000000u);
+    struct tm t;
+
+    if (!localtime_r(&seconds, &t)) {
+        return 1;
+    }
+
+    fprintf(out, "%04d-%02d-%02d %02d:%02d:%02d | %s | %s:%d (%s) | ",
+            t.tm_year + 1900, t.tm_mon + 1, t.tm_mday, t.tm_hour, t.tm_min, t.tm_sec,
+            site->level, site->file, site->line, site->func);
+
+    if (log_render(out, site, payload, size) != 0) {
+        return 1;
+    }
+
+    fputc('\n', out);
+    return 0;
+}
+
+int log_decode(FILE *in, FILE *out) {
+    if (!in || !out) {
+        return 1;
+    }
+
+    char magic[LOG_BINARY_MAGIC_SIZE];
+    if (log_read_bytes(in, magic, sizeof(magic)) != 0 || memcmp(magic, LOG_BINARY_MAGIC, sizeof(magic)) != 0) {
+        return 1;
+    }
+
+    LogSites sites = { NULL, 0 };
+    char *payload = malloc(UINT16_MAX);
+    int failed = !payload;
+
+    while (!failed) {
+        int type = fgetc(in);
+
+        if (type == EOF) {
+            break;
+        }
+
+        if (type == LOG_RECORD_SITE) {
+            failed = log_read_site(in, &sites);
+        } else if (type == LOG_RECORD_ENTRY) {
+            failed = log_read_entry(in, out, &sites, payload);
+        } else {
+            failed = 1;
+        }
+    }
+
+    for (uint32_t i = 0; i < sites.capacity; i++) {
+        log_free_site(&sites.sites[i]);
+    }
+
+    free(sites.sites);
+    free(payload);
+    return failed;
+}
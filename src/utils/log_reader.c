@@ -0,0 +1,414 @@
+#define _XOPEN_SOURCE 700
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "log_reader.h"
+
+// "YYYY-MM-DD HH:MM:SS" at the start of every line
+#define LOG_STAMP_SIZE 19
+
+typedef struct {
+    const char *data;
+    size_t size;
+} LogMap;
+
+// Last stamp parsed, lines of the same second skip mktime
+typedef struct {
+    char text[LOG_STAMP_SIZE];
+    time_t second;
+    int valid;
+} LogStampCache;
+
+static const char *log_level_names[] = { "TRACE", "DEBUG", "INFO", "WARN", "ERROR" };
+
+static int log_map(const char *path, LogMap *map) {
+    map->data = NULL;
+    map->size = 0;
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return 1;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return 1;
+    }
+
+    if (st.st_size > 0) {
+        void *data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            close(fd);
+            return 1;
+        }
+
+        map->data = data;
+        map->size = (size_t)st.st_size;
+    }
+
+    close(fd);
+    return 0;
+}
+
+static void log_unmap(LogMap *map) {
+    if (map->data) {
+        munmap((void *)map->data, map->size);
+    }
+
+    map->data = NULL;
+    map->size = 0;
+}
+
+int log_parse_time(const char *text, time_t *out) {
+    if (!text || !out) {
+        return 1;
+    }
+
+    struct tm t;
+    memset(&t, 0, sizeof(t));
+
+    int used = 0;
+    if (sscanf(text, "%4d-%2d-%2d%n", &t.tm_year, &t.tm_mon, &t.tm_mday, &used) != 3) {
+        return 1;
+    }
+
+    const char *rest = text + used;
+    if (*rest) {
+        int more = 0;
+        if (sscanf(rest, " %2d:%2d:%2d%n", &t.tm_hour, &t.tm_min, &t.tm_sec, &more) != 3 || rest[more] != '\0') {
+            return 1;
+        }
+    }
+
+    if (t.tm_mon < 1 || t.tm_mon > 12 || t.tm_mday < 1 || t.tm_mday > 31 ||
+        t.tm_hour > 23 || t.tm_min > 59 || t.tm_sec > 60) {
+        return 1;
+    }
+
+    t.tm_year -= 1900;
+    t.tm_mon -= 1;
+    t.tm_isdst = -1;
+
+    time_t second = mktime(&t);
+    if (second == (time_t)-1) {
+        return 1;
+    }
+
+    *out = second;
+    return 0;
+}
+
+static int log_line_time(const char *line, size_t length, LogStampCache *cache, time_t *out) {
+    if (length < LOG_STAMP_SIZE) {
+        return 1;
+    }
+
+    if (cache->valid && memcmp(cache->text, line, LOG_STAMP_SIZE) == 0) {
+        *out = cache->second;
+        return 0;
+    }
+
+    char text[LOG_STAMP_SIZE + 1];
+    memcpy(text, line, LOG_STAMP_SIZE);
+    text[LOG_STAMP_SIZE] = '\0';
+
+    if (log_parse_time(text, out) != 0) {
+        return 1;
+    }
+
+    memcpy(cache->text, line, LOG_STAMP_SIZE);
+    cache->second = *out;
+    cache->valid = 1;
+    return 0;
+}
+
+// Level and source file of "stamp | LEVEL | file:line (func) | message"
+static int log_line_fields(const char *line, size_t length, int *level, const char **file, size_t *file_length) {
+    size_t at = LOG_STAMP_SIZE;
+
+    if (length < at + 3 || memcmp(line + at, " | ", 3) != 0) {
+        return 1;
+    }
+    at += 3;
+
+    size_t name = at;
+    while (at < length && line[at] != ' ') {
+        at++;
+    }
+
+    *level = -1;
+    for (int i = 0; i < (int)(sizeof(log_level_names) / sizeof(log_level_names[0])); i++) {
+        if (strlen(log_level_names[i]) == at - name && memcmp(line + name, log_level_names[i], at - name) == 0) {
+            *level = i;
+        }
+    }
+
+    if (*level < 0 || length < at + 3 || memcmp(line + at, " | ", 3) != 0) {
+        return 1;
+    }
+    at += 3;
+
+    *file = line + at;
+    while (at < length && line[at] != ':' && line[at] != ' ') {
+        at++;
+    }
+
+    *file_length = (size_t)(line + at - *file);
+    return 0;
+}
+
+// A path matches itself and its base name
+static int log_file_matches(const char *file, size_t length, const char *wanted) {
+    size_t size = strlen(wanted);
+
+    if (size > length || memcmp(file + length - size, wanted, size) != 0) {
+        return 0;
+    }
+
+    return size == length || file[length - size - 1] == '/';
+}
+
+static int log_filter_empty(const LogFilter *filter) {
+    return filter->level <= LOG_LEVEL_TRACE && filter->from == 0 && filter->to == 0 && !filter->file;
+}
+
+// 1 if the line is shown. second is its time, -1 when it has none.
+static int log_line_matches(const char *line, size_t length, const LogFilter *filter, LogStampCache *cache,
+                            time_t *second) {
+    int level;
+    const char *file;
+    size_t file_length;
+
+    if (log_line_time(line, length, cache, second) != 0) {
+        *second = -1;
+        return log_filter_empty(filter);
+    }
+
+    if (log_filter_empty(filter)) {
+        return 1;
+    }
+
+    if ((filter->from && *second < filter->from) || (filter->to && *second > filter->to)) {
+        return 0;
+    }
+
+    if (log_line_fields(line, length, &level, &file, &file_length) != 0) {
+        return 0;
+    }
+
+    return level >= filter->level && (!filter->file || log_file_matches(file, file_length, filter->file));
+}
+
+// Part of a log holding the lines of the time window, from its index:
+// lines before the last entry earlier than from are older, and lines
+// after the first entry past to (and the order slack) are newer
+static void log_index_window(const char *path, const LogFilter *filter, const LogMap *map, size_t *start,
+                             size_t *end) {
+    char name[PATH_MAX];
+    LogMap index;
+
+    *start = 0;
+    *end = map->size;
+
+    if ((filter->from == 0 && filter->to == 0) ||
+        snprintf(name, sizeof(name), "%s%s", path, LOG_INDEX_SUFFIX) >= (int)sizeof(name) ||
+        log_map(name, &index) != 0) {
+        return;
+    }
+
+    const LogIndexEntry *entries = (const LogIndexEntry *)index.data;
+    size_t count = index.size / sizeof(LogIndexEntry);
+
+    if (filter->from) {
+        size_t low = 0;
+        size_t high = count;
+        while (low < high) {
+            size_t mid = low + (high - low) / 2;
+            if (entries[mid].second < (int64_t)filter->from) {
+                low = mid + 1;
+            } else {
+                high = mid;
+            }
+        }
+
+        // A stale entry (past the end of the file) is not used
+        for (size_t i = low; i > 0; i--) {
+            if (entries[i - 1].offset <= map->size) {
+                *start = (size_t)entries[i - 1].offset;
+                break;
+            }
+        }
+    }
+
+    if (filter->to) {
+        for (size_t i = 0; i < count; i++) {
+            if (entries[i].second > (int64_t)filter->to + LOG_ORDER_SLACK) {
+                if (entries[i].offset >= *start && entries[i].offset <= map->size) {
+                    *end = (size_t)entries[i].offset;
+                }
+                break;
+            }
+        }
+    }
+
+    log_unmap(&index);
+
+    // Offsets are line starts, unless the file changed under the index
+    while (*start > 0 && *start < *end && map->data[*start - 1] != '\n') {
+        (*start)++;
+    }
+}
+
+static long log_scan(const char *path, const LogMap *map, const LogFilter *filter, FILE *out) {
+    LogStampCache cache = { { 0 }, 0, 0 };
+    size_t start;
+    size_t end;
+    long count = 0;
+
+    log_index_window(path, filter, map, &start, &end);
+
+    while (start < end) {
+        const char *line = map->data + start;
+        const char *newline = memchr(line, '\n', end - start);
+        size_t length = newline ? (size_t)(newline - line) : end - start;
+        time_t second;
+
+        if (log_line_matches(line, length, filter, &cache, &second)) {
+            fwrite(line, 1, length, out);
+            fputc('\n', out);
+            count++;
+        } else if (filter->to && second != -1 && second > filter->to + LOG_ORDER_SLACK) {
+            break;
+        }
+
+        start += length + 1;
+    }
+
+    return count;
+}
+
+typedef struct {
+    char **lines;
+    size_t count;
+} LogTail;
+
+// Matching lines from the end of a log, newest first, until the tail is
+// full. Returns 1 once nothing older can match.
+static int log_scan_back(const char *path, const LogMap *map, const LogFilter *filter, LogTail *tail) {
+    LogStampCache cache = { { 0 }, 0, 0 };
+    size_t start;
+    size_t end;
+
+    log_index_window(path, filter, map, &start, &end);
+
+    if (end > start && map->data[end - 1] == '\n') {
+        end--;
+    }
+
+    while (end > start && tail->count < filter->tail) {
+        size_t begin = end;
+        while (begin > start && map->data[begin - 1] != '\n') {
+            begin--;
+        }
+
+        time_t second;
+        if (log_line_matches(map->data + begin, end - begin, filter, &cache, &second)) {
+            char *line = malloc(end - begin + 1);
+            if (!line) {
+                return 1;
+            }
+
+            memcpy(line, map->data + begin, end - begin);
+            line[end - begin] = '\0';
+            tail->lines[tail->count++] = line;
+        } else if (filter->from && second != -1 && second < filter->from - LOG_ORDER_SLACK) {
+            return 1;
+        }
+
+        if (begin == start) {
+            break;
+        }
+        end = begin - 1;
+    }
+
+    return tail->count == filter->tail || (filter->from && start > 0);
+}
+
+// Name of the log rotated `age` times, the log itself for 0
+static int log_rotated_name(char *name, size_t size, const char *path, int age) {
+    int length = age == 0 ? snprintf(name, size, "%s", path) : snprintf(name, size, "%s.%d", path, age);
+    return length < 0 || (size_t)length >= size;
+}
+
+long log_query(const char *path, const LogFilter *filter, FILE *out) {
+    static const LogFilter everything = { LOG_LEVEL_TRACE, 0, 0, NULL, 0 };
+    char name[PATH_MAX];
+
+    if (!path || !out) {
+        return -1;
+    }
+
+    if (!filter) {
+        filter = &everything;
+    }
+
+    // Oldest rotated file
+    int oldest = 0;
+    while (oldest < LOG_ROTATE_MAX_KEEP && log_rotated_name(name, sizeof(name), path, oldest + 1) == 0 &&
+           access(name, F_OK) == 0) {
+        oldest++;
+    }
+
+    if (oldest == 0 && access(path, F_OK) != 0) {
+        return -1;
+    }
+
+    long count = 0;
+    LogTail tail = { NULL, 0 };
+
+    if (filter->tail > 0) {
+        tail.lines = malloc(filter->tail * sizeof(char *));
+        if (!tail.lines) {
+            return -1;
+        }
+    }
+
+    // A tail reads the newest file first, everything else the oldest
+    for (int i = 0; i <= oldest; i++) {
+        int age = filter->tail > 0 ? i : oldest - i;
+        LogMap map;
+
+        if (log_rotated_name(name, sizeof(name), path, age) != 0 || log_map(name, &map) != 0) {
+            continue;
+        }
+
+        int done = 0;
+        if (filter->tail > 0) {
+            done = log_scan_back(name, &map, filter, &tail);
+        } else {
+            count += log_scan(name, &map, filter, out);
+        }
+
+        log_unmap(&map);
+        if (done) {
+            break;
+        }
+    }
+
+    for (size_t i = tail.count; i > 0; i--) {
+        fprintf(out, "%s\n", tail.lines[i - 1]);
+        free(tail.lines[i - 1]);
+        count++;
+    }
+
+    free(tail.lines);
+    fflush(out);
+    return count;
+}
@@ -0,0 +1,35 @@
+#ifndef TEST_LOG_DIR_H
+#define TEST_LOG_DIR_H
+
+#include <gtest/gtest.h>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <unistd.h>
+#include "../include/utils/log.h"
+
+// library.log is written to the working directory, so each test binary runs
+// in a temporary directory of its own (the log is opened on the first line)
+class LogDirEnvironment : public ::testing::Environment {
+public:
+    void SetUp() override {
+        std::string pattern = ::testing::TempDir() + "library_test_XXXXXX";
+        ASSERT_NE(mkdtemp(pattern.data()), nullptr);
+        dir = pattern;
+        ASSERT_EQ(chdir(dir.c_str()), 0);
+    }
+
+    void TearDown() override {
+        log_flush();
+        std::error_code error;
+        std::filesystem::remove_all(dir, error);
+    }
+
+private:
+    std::string dir;
+};
+
+static ::testing::Environment *const log_dir_environment =
+    ::testing::AddGlobalTestEnvironment(new LogDirEnvironment);
+
+#endif
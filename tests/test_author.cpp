@@ -2,6 +2,7 @@
 #include <cstring>
 #include <vector>
 #include "../include/core/library.h"
+#include "log_dir.h"
 
 class AuthorTest : public ::testing::Test {
 protected:
@@ -168,6 +169,93 @@ TEST_F(AuthorTest, FindAuthorByName) {
     EXPECT_EQ(lib.authors[found_index].id, 2);
 }
 
+TEST_F(AuthorTest, FindOrAddAuthorDeduplicates) {
+    int first = 0, second = 0, other = 0;
+
+    EXPECT_EQ(lb_find_or_add_author(&lib, "Isaac Asimov", &first), 0);
+    EXPECT_EQ(lb_find_or_add_author(&lib, "Agatha Christie", &other), 0);
+    EXPECT_EQ(lb_find_or_add_author(&lib, "Isaac Asimov", &second), 0);
+
+    EXPECT_EQ(first, second);
+    EXPECT_NE(first, other);
+    EXPECT_EQ(lib.author_count, 2);
+}
+
+TEST_F(AuthorTest, FindAuthorByNameIndex) {
+    for (int i = 0; i < 1000; i++) {
+        char author_name[100];
+        snprintf(author_name, sizeof(author_name), "Author_%d", i);
+        lb_add_author(&lib, author_name);
+    }
+
+    Author *author = lb_find_author_by_name(&lib, "Author_731");
+    ASSERT_NE(author, nullptr);
+    EXPECT_EQ(author->id, 732);
+    EXPECT_EQ(lb_find_author_by_name(&lib, "Nobody"), nullptr);
+}
+
+TEST_F(AuthorTest, FindOrAddAuthorTruncatedName) {
+    char long_name[256];
+    memset(long_name, 'A', 255);
+    long_name[255] = '\0';
+
+    int first = 0, second = 0;
+    EXPECT_EQ(lb_find_or_add_author(&lib, long_name, &first), 0);
+    EXPECT_EQ(lb_find_or_add_author(&lib, long_name, &second), 0);
+    EXPECT_EQ(first, second);
+    EXPECT_EQ(lib.author_count, 1);
+}
+
+TEST_F(AuthorTest, UpdateAuthorNameKeepsIndex) {
+    lb_add_author(&lib, "Isaac Asimov");
+    lb_add_author(&lib, "Agatha Christie");
+
+    EXPECT_EQ(lb_update_author_name(&lib, 1, "I. Asimov"), 0);
+    EXPECT_EQ(lb_find_author_by_name(&lib, "Isaac Asimov"), nullptr);
+    ASSERT_NE(lb_find_author_by_name(&lib, "I. Asimov"), nullptr);
+    EXPECT_EQ(lb_find_author_by_name(&lib, "I. Asimov")->id, 1);
+
+    EXPECT_EQ(lb_update_author_name(&lib, 1, "Agatha Christie"), 1);
+    EXPECT_EQ(lb_update_author_name(&lib, 99, "Nobody"), 1);
+}
+
+TEST_F(AuthorTest, AddAuthorRejectsDuplicatedName) {
+    EXPECT_EQ(lb_add_author(&lib, "Isaac Asimov"), 0);
+    EXPECT_EQ(lb_add_author(&lib, "Isaac Asimov"), 1);
+    EXPECT_EQ(lib.author_count, 1);
+}
+
+TEST_F(AuthorTest, AddAuthorsBulkRejectsBadBatch) {
+    lb_add_author(&lib, "Isaac Asimov");
+
+    Author authors[3];
+    memset(authors, 0, sizeof(authors));
+    for (int i = 0; i < 3; i++) {
+        authors[i].id = i + 2;
+        snprintf(authors[i].name, sizeof(authors[i].name), "Author_%d", i);
+    }
+
+    // Ids that are not the next positions would rename the wrong author
+    authors[1].id = 7;
+    EXPECT_EQ(lb_add_authors_bulk(&lib, authors, 3), 1);
+    authors[1].id = 3;
+
+    // Repeated inside the batch, then already stored
+    strcpy(authors[2].name, "Author_0");
+    EXPECT_EQ(lb_add_authors_bulk(&lib, authors, 3), 1);
+    strcpy(authors[2].name, "Isaac Asimov");
+    EXPECT_EQ(lb_add_authors_bulk(&lib, authors, 3), 1);
+    EXPECT_EQ(lib.author_count, 1);
+
+    strcpy(authors[2].name, "Author_2");
+    ASSERT_EQ(lb_add_authors_bulk(&lib, authors, 3), 0);
+    EXPECT_EQ(lib.author_count, 4);
+
+    EXPECT_EQ(lb_update_author_name(&lib, 3, "Renamed"), 0);
+    EXPECT_STREQ(lib.authors[2].name, "Renamed");
+    EXPECT_EQ(lb_update_author_name(&lib, 5, "Nobody"), 1);
+}
+
 // ========== Author Clear Tests ==========
 
 TEST_F(AuthorTest, ClearLibraryAuthors) {
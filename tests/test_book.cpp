@@ -1,18 +1,21 @@
 #include <gtest/gtest.h>
 #include <cstring>
 #include <cstdlib>
+#include <string>
 #include "../include/core/library.h"
+#include "log_dir.h"
 
 class BookTest : public ::testing::Test {
 protected:
     Book book;
     
     void SetUp() override {
+        book_init(&book);
         book.id = 1;
         strcpy(book.title, "Test Book");
         strcpy(book.isbn, "978-0000000000");
         book.publication_year = 2020;
-        strcpy(book.description, "A test book");
+        book_update_description(&book, "A test book");
         book.genre_ids = (int*)malloc(2 * sizeof(int));
         book.author_ids = (int*)malloc(2 * sizeof(int));
         book.genre_capacity = 2;
@@ -22,8 +25,7 @@ protected:
     }
     
     void TearDown() override {
-        free(book.genre_ids);
-        free(book.author_ids);
+        book_free(&book);
     }
 };
 
@@ -146,6 +148,51 @@ TEST_F(BookTest, AddAuthorNullPointer) {
     EXPECT_EQ(book_add_author(nullptr, 1), 1);
 }
 
+// ========== Inline ID Tests ==========
+
+TEST(BookInlineTest, ShortListsStayInline) {
+    Book book;
+    book_init(&book);
+
+    for (int i = 1; i <= BOOK_INLINE_IDS; i++) {
+        EXPECT_EQ(book_add_genre(&book, i), 0);
+    }
+
+    EXPECT_EQ(book.genre_ids, nullptr);
+    EXPECT_EQ(book.genre_count, BOOK_INLINE_IDS);
+    EXPECT_EQ(book_get_genre_ids(&book)[BOOK_INLINE_IDS - 1], BOOK_INLINE_IDS);
+
+    EXPECT_EQ(book_remove_genre(&book, 1), 0);
+    EXPECT_EQ(book_get_genre_ids(&book)[0], 2);
+
+    book_free(&book);
+}
+
+TEST(BookInlineTest, LongListsSpillToHeap) {
+    Book book;
+    book_init(&book);
+
+    for (int i = 1; i <= BOOK_INLINE_IDS + 3; i++) {
+        EXPECT_EQ(book_add_author(&book, i), 0);
+    }
+
+    EXPECT_NE(book.author_ids, nullptr);
+    EXPECT_GT(book.author_capacity, BOOK_INLINE_IDS);
+    for (int i = 0; i < book.author_count; i++) {
+        EXPECT_EQ(book_get_author_ids(&book)[i], i + 1);
+    }
+
+    // Shrinks back inline once it fits again
+    for (int i = 1; i <= 3; i++) {
+        book_remove_author(&book, i);
+    }
+    EXPECT_EQ(book_pack_ids(&book), 0);
+    EXPECT_EQ(book.author_ids, nullptr);
+    EXPECT_EQ(book_get_author_ids(&book)[0], 4);
+
+    book_free(&book);
+}
+
 // ========== Book Update Tests ==========
 
 TEST_F(BookTest, UpdateTitleSuccess) {
@@ -170,6 +217,8 @@ TEST_F(BookTest, UpdateISBNNullPointer) {
 
 TEST_F(BookTest, UpdatePublicationYearSuccess) {
     EXPECT_EQ(book_update_publication_year(&book, 2021), 0);
+    EXPECT_EQ(book.publication_year, 2021);
+    EXPECT_EQ(book.id, 1);
 }
 
 TEST_F(BookTest, UpdatePublicationYearInvalid) {
@@ -186,6 +235,14 @@ TEST_F(BookTest, UpdateDescriptionSuccess) {
     EXPECT_STREQ(book.description, "New description");
 }
 
+TEST_F(BookTest, UpdateDescriptionLongerThanBuffer) {
+    std::string longer(2000, 'd');
+    EXPECT_EQ(book_update_description(&book, longer.c_str()), 0);
+    EXPECT_STREQ(book.description, longer.c_str());
+    EXPECT_EQ(book_update_description(&book, "short"), 0);
+    EXPECT_STREQ(book.description, "short");
+}
+
 TEST_F(BookTest, UpdateDescriptionNullPointer) {
     EXPECT_EQ(book_update_description(nullptr, "New description"), 1);
     EXPECT_EQ(book_update_description(&book, nullptr), 1);
@@ -0,0 +1,485 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+#include "../include/db/btree.h"
+#include "log_dir.h"
+
+static int collect(void *ctx, const char *key, const void *value, size_t size) {
+    auto *records = static_cast<std::vector<std::pair<std::string, std::string>> *>(ctx);
+    records->emplace_back(key, std::string(static_cast<const char *>(value), size));
+    return 0;
+}
+
+class BTreeTest : public ::testing::Test {
+protected:
+    BTree tree;
+    std::string path;
+    std::vector<std::pair<std::string, std::string>> records;
+
+    void SetUp() override {
+        path = ::testing::TempDir() + "btree_test_" +
+               ::testing::UnitTest::GetInstance()->current_test_info()->name() + ".tree";
+        std::remove(path.c_str());
+    }
+
+    void TearDown() override {
+        std::remove(path.c_str());
+    }
+
+    std::string get(const std::string &key) {
+        const void *value;
+        size_t size;
+        if (btree_get(&tree, key.c_str(), &value, &size) != 0) {
+            return "<missing>";
+        }
+        return std::string(static_cast<const char *>(value), size);
+    }
+
+    static std::string key_of(int i) {
+        char key[16];
+        std::snprintf(key, sizeof(key), "978-%08d", i);
+        return key;
+    }
+};
+
+// ========== Record Tests ==========
+
+TEST_F(BTreeTest, PutGetDelete) {
+    ASSERT_EQ(btree_open(&tree, path.c_str(), 0), 0);
+
+    ASSERT_EQ(btree_put(&tree, "b", "two", 3), 0);
+    ASSERT_EQ(btree_put(&tree, "a", "one", 3), 0);
+    ASSERT_EQ(btree_put(&tree, "c", "", 0), 0);
+    EXPECT_EQ(tree.meta.record_count, 3u);
+
+    EXPECT_EQ(get("a"), "one");
+    EXPECT_EQ(get("b"), "two");
+    EXPECT_EQ(get("c"), "");
+    EXPECT_EQ(get("d"), "<missing>");
+
+    // Replacing keeps a single record
+    ASSERT_EQ(btree_put(&tree, "a", "uno", 3), 0);
+    EXPECT_EQ(get("a"), "uno");
+    EXPECT_EQ(tree.meta.record_count, 3u);
+
+    ASSERT_EQ(btree_delete(&tree, "b"), 0);
+    EXPECT_EQ(get("b"), "<missing>");
+    EXPECT_EQ(btree_delete(&tree, "b"), 1);
+    EXPECT_EQ(tree.meta.record_count, 2u);
+
+    ASSERT_EQ(btree_close(&tree), 0);
+}
+
+TEST_F(BTreeTest, ManyRecordsSplitAndPersist) {
+    // A small pool forces evictions while the tree grows
+    ASSERT_EQ(btree_open(&tree, path.c_str(), 8), 0);
+
+    std::vector<int> order(20000);
+    for (int i = 0; i < (int)order.size(); i++) {
+        order[i] = i;
+    }
+    std::shuffle(order.begin(), order.end(), std::mt19937(42));
+
+    for (int i : order) {
+        std::string value = "value of " + std::to_string(i);
+        ASSERT_EQ(btree_put(&tree, key_of(i).c_str(), value.data(), value.size()), 0);
+    }
+
+    EXPECT_GT(tree.meta.depth, 1u);
+    EXPECT_GT(tree.pager.evictions, 0u);
+    EXPECT_EQ(tree.meta.record_count, 20000u);
+    ASSERT_EQ(btree_close(&tree), 0);
+
+    ASSERT_EQ(btree_open(&tree, path.c_str(), 16), 0);
+    EXPECT_EQ(tree.meta.record_count, 20000u);
+    for (int i = 0; i < 20000; i += 123) {
+        EXPECT_EQ(get(key_of(i)), "value of " + std::to_string(i));
+    }
+
+    ASSERT_EQ(btree_scan(&tree, nullptr, nullptr, collect, &records), 0);
+    ASSERT_EQ(records.size(), 20000u);
+    for (int i = 0; i < 20000; i++) {
+        ASSERT_EQ(records[i].first, key_of(i));
+    }
+
+    ASSERT_EQ(btree_close(&tree), 0);
+}
+
+TEST_F(BTreeTest, RangeScan) {
+    ASSERT_EQ(btree_open(&tree, path.c_str(), 0), 0);
+
+    for (int i = 0; i < 1000; i++) {
+        ASSERT_EQ(btree_put(&tree, key_of(i).c_str(), "x", 1), 0);
+    }
+
+    ASSERT_EQ(btree_scan(&tree, key_of(100).c_str(), key_of(150).c_str(), collect, &records), 0);
+    ASSERT_EQ(records.size(), 50u);
+    EXPECT_EQ(records.front().first, key_of(100));
+    EXPECT_EQ(records.back().first, key_of(149));
+
+    // Bounds need not be stored keys
+    records.clear();
+    ASSERT_EQ(btree_scan(&tree, "978-00000998x", nullptr, collect, &records), 0);
+    ASSERT_EQ(records.size(), 1u);
+    EXPECT_EQ(records[0].first, key_of(999));
+
+    // The callback can stop the scan
+    int seen = 0;
+    ASSERT_EQ(btree_scan(&tree, nullptr, nullptr,
+                         [](void *ctx, const char *, const void *, size_t) {
+                             return ++*static_cast<int *>(ctx) == 10 ? 1 : 0;
+                         },
+                         &seen), 0);
+    EXPECT_EQ(seen, 10);
+
+    ASSERT_EQ(btree_close(&tree), 0);
+}
+
+TEST_F(BTreeTest, MatchesReferenceMap) {
+    ASSERT_EQ(btree_open(&tree, path.c_str(), 8), 0);
+
+    std::map<std::string, std::string> reference;
+    std::mt19937 random(7);
+
+    for (int step = 0; step < 30000; step++) {
+        std::string key = key_of((int)(random() % 3000));
+
+        if (random() % 3 == 0) {
+            EXPECT_EQ(btree_delete(&tree, key.c_str()), reference.erase(key) ? 0 : 1);
+        } else {
+            // Sizes cross the overflow threshold
+            std::string value(random() % 3000, (char)('a' + step % 26));
+            ASSERT_EQ(btree_put(&tree, key.c_str(), value.data(), value.size()), 0);
+            reference[key] = value;
+        }
+    }
+
+    EXPECT_EQ(tree.meta.record_count, reference.size());
+    ASSERT_EQ(btree_scan(&tree, nullptr, nullptr, collect, &records), 0);
+    ASSERT_EQ(records.size(), reference.size());
+
+    auto expected = reference.begin();
+    for (const auto &record : records) {
+        ASSERT_EQ(record.first, expected->first);
+        ASSERT_EQ(record.second, expected->second);
+        ++expected;
+    }
+
+    ASSERT_EQ(btree_close(&tree), 0);
+}
+
+TEST_F(BTreeTest, OverflowPagesAreReused) {
+    ASSERT_EQ(btree_open(&tree, path.c_str(), 0), 0);
+
+    std::string big(20000, 'z');
+    ASSERT_EQ(btree_put(&tree, "big", big.data(), big.size()), 0);
+    EXPECT_EQ(get("big"), big);
+    uint32_t pages = tree.pager.page_count;
+
+    ASSERT_EQ(btree_delete(&tree, "big"), 0);
+    ASSERT_EQ(btree_put(&tree, "big", big.data(), big.size()), 0);
+    EXPECT_EQ(tree.pager.page_count, pages);
+
+    ASSERT_EQ(btree_clear(&tree), 0);
+    EXPECT_EQ(tree.meta.record_count, 0u);
+    EXPECT_EQ(tree.pager.page_count, 2u);
+    EXPECT_EQ(get("big"), "<missing>");
+
+    ASSERT_EQ(btree_close(&tree), 0);
+}
+
+TEST_F(BTreeTest, RejectsBadInput) {
+    EXPECT_EQ(btree_open(nullptr, path.c_str(), 0), 1);
+
+    ASSERT_EQ(btree_open(&tree, path.c_str(), 0), 0);
+    EXPECT_EQ(btree_put(&tree, "", "x", 1), 1);
+    EXPECT_EQ(btree_put(&tree, "this key is far too long", "x", 1), 1);
+    EXPECT_EQ(btree_put(&tree, "k", nullptr, 1), 1);
+    ASSERT_EQ(btree_close(&tree), 0);
+
+    FILE *file = std::fopen(path.c_str(), "r+b");
+    ASSERT_NE(file, nullptr);
+    std::fputs("garbage!", file);
+    std::fclose(file);
+    EXPECT_EQ(btree_open(&tree, path.c_str(), 0), 1);
+}
+
+// ========== Book Tests ==========
+
+class BTreeBookTest : public BTreeTest {
+protected:
+    Library lib;
+
+    void SetUp() override {
+        BTreeTest::SetUp();
+        ASSERT_EQ(lb_init(&lib), 0);
+        ASSERT_EQ(btree_open(&tree, path.c_str(), 0), 0);
+    }
+
+    void TearDown() override {
+        lb_free(&lib);
+        btree_close(&tree);
+        BTreeTest::TearDown();
+    }
+
+    void add_book(const char *isbn, const char *title, const char *description) {
+        Book book;
+        book_init(&book);
+        book.id = 1;
+        book.publication_year = 1999;
+        strcpy(book.isbn, isbn);
+        strcpy(book.title, title);
+        if (description) {
+            book_update_description(&book, description);
+        }
+        ASSERT_EQ(lb_add_book(&lib, &book), 0);
+    }
+};
+
+TEST_F(BTreeBookTest, BookRoundTrip) {
+    add_book("978-1", "Dune", "Spice");
+    ASSERT_EQ(lb_add_author(&lib, "Frank Herbert"), 0);
+    ASSERT_EQ(lb_add_book_author(&lib, "978-1", 1), 0);
+
+    ASSERT_EQ(btree_put_book(&tree, &lib, lb_find_book_by_isbn(&lib, "978-1")), 0);
+
+    Book book;
+    book_init(&book);
+    ASSERT_EQ(btree_get_book(&tree, "978-1", &book), 0);
+    EXPECT_STREQ(book.isbn, "978-1");
+    EXPECT_STREQ(book.title, "Dune");
+    EXPECT_EQ(book.publication_year, 1999);
+    EXPECT_STREQ(book.description, "Spice");
+    ASSERT_EQ(book.author_count, 1);
+    EXPECT_EQ(book_get_author_ids(&book)[0], 1);
+    book_free(&book);
+
+    book_init(&book);
+    EXPECT_EQ(btree_get_book(&tree, "978-2", &book), 1);
+    book_free(&book);
+}
+
+TEST_F(BTreeBookTest, BookChangesAreCopied) {
+    struct Mirror {
+        BTree *tree;
+        Library *lib;
+        int failures;
+    } state = { &tree, &lib, 0 };
+
+    ASSERT_EQ(lb_set_change_hook(&lib,
+                                 [](void *ctx, const LibraryChange *change) {
+                                     auto *mirror = static_cast<Mirror *>(ctx);
+                                     mirror->failures += btree_apply_change(mirror->tree, mirror->lib, change);
+                                 },
+                                 nullptr, &state), 0);
+
+    add_book("978-1", "One", nullptr);
+    add_book("978-2", "Two", "Second");
+    add_book("978-3", "Three", nullptr);
+    ASSERT_EQ(lb_update_book_title(&lib, "978-1", "Uno"), 0);
+    ASSERT_EQ(lb_update_book_isbn(&lib, "978-2", "978-9"), 0);
+    ASSERT_EQ(lb_remove_book(&lib, "978-3"), 0);
+    ASSERT_EQ(lb_update_book_year(&lib, "978-1", 1965), 0);
+    ASSERT_EQ(lb_update_book_description(&lib, "978-1", "First"), 0);
+    ASSERT_EQ(lb_add_book_genre(&lib, "978-9", 7), 0);
+    EXPECT_EQ(state.failures, 0);
+
+    ASSERT_EQ(lb_set_change_hook(&lib, nullptr, nullptr, nullptr), 0);
+    EXPECT_EQ(tree.meta.record_count, 2u);
+
+    // A fresh library loaded from the tree sees the same books
+    Library loaded;
+    ASSERT_EQ(lb_init(&loaded), 0);
+    ASSERT_EQ(btree_load_books(&tree, &loaded, nullptr, nullptr), 0);
+    ASSERT_EQ(loaded.book_count, 2);
+    EXPECT_STREQ(loaded.books[0].isbn, "978-1");
+    EXPECT_STREQ(loaded.books[0].title, "Uno");
+    EXPECT_EQ(loaded.books[0].publication_year, 1965);
+    EXPECT_STREQ(loaded.books[0].description, "First");
+    EXPECT_STREQ(loaded.books[1].isbn, "978-9");
+    EXPECT_STREQ(loaded.books[1].description, "Second");
+    ASSERT_EQ(loaded.books[1].genre_count, 1);
+    EXPECT_EQ(book_get_genre_ids(&loaded.books[1])[0], 7);
+    lb_free(&loaded);
+
+    // Only part of the catalog can be loaded
+    ASSERT_EQ(lb_init(&loaded), 0);
+    ASSERT_EQ(btree_load_books(&tree, &loaded, "978-5", nullptr), 0);
+    ASSERT_EQ(loaded.book_count, 1);
+    lb_free(&loaded);
+}
+
+TEST_F(BTreeBookTest, OnlyBooksAreStored) {
+    add_book("978-1", "Dune", nullptr);
+    ASSERT_EQ(lb_add_author(&lib, "Frank Herbert"), 0);
+    ASSERT_EQ(lb_add_genre(&lib, "Science Fiction"), 0);
+    ASSERT_EQ(lb_add_book_author(&lib, "978-1", 1), 0);
+    ASSERT_EQ(btree_put_book(&tree, &lib, lb_find_book_by_isbn(&lib, "978-1")), 0);
+
+    // Author and genre changes leave the tree as it was
+    LibraryChange change = {};
+    change.kind = LB_CHANGE_ADD_AUTHOR;
+    change.text = "Brian Herbert";
+    EXPECT_EQ(btree_apply_change(&tree, &lib, &change), 0);
+    EXPECT_EQ(tree.meta.record_count, 1u);
+
+    // The loaded book keeps the author id, not the author
+    Library loaded;
+    ASSERT_EQ(lb_init(&loaded), 0);
+    ASSERT_EQ(btree_load_books(&tree, &loaded, nullptr, nullptr), 0);
+    ASSERT_EQ(loaded.book_count, 1);
+    ASSERT_EQ(loaded.books[0].author_count, 1);
+    EXPECT_EQ(book_get_author_ids(&loaded.books[0])[0], 1);
+    EXPECT_EQ(loaded.author_count, 0);
+    lb_free(&loaded);
+}
+
+// ========== Backend Tests ==========
+
+class BTreeBackendTest : public BTreeBookTest {
+protected:
+    LibraryBackend backend;
+
+    void SetUp() override {
+        BTreeBookTest::SetUp();
+        ASSERT_EQ(btree_backend(&tree, &backend), 0);
+        ASSERT_EQ(lb_set_backend(&lib, &backend), 0);
+    }
+};
+
+TEST_F(BTreeBackendTest, BooksAreReadInWhenLookedUp) {
+    add_book("978-1", "One", nullptr);
+    add_book("978-2", "Two", "Second");
+    add_book("978-3", "Three", nullptr);
+    EXPECT_EQ(tree.meta.record_count, 3u);
+
+    ASSERT_EQ(lb_evict_books(&lib), 0);
+    EXPECT_EQ(lib.book_count, 0);
+
+    Book *book = lb_find_book_by_isbn(&lib, "978-2");
+    ASSERT_NE(book, nullptr);
+    EXPECT_STREQ(book->title, "Two");
+    EXPECT_STREQ(book->description, "Second");
+    EXPECT_EQ(lib.book_count, 1);
+
+    // Found in memory the second time, missing books are not read in
+    EXPECT_EQ(lb_find_book_by_isbn(&lib, "978-2"), book);
+    EXPECT_EQ(lb_find_book_by_isbn(&lib, "978-9"), nullptr);
+    EXPECT_EQ(lib.book_count, 1);
+
+    // Reading a book in is not a change
+    EXPECT_EQ(tree.meta.record_count, 3u);
+
+    BookHandle handle;
+    ASSERT_EQ(lb_get_book_handle(&lib, "978-3", &handle), 0);
+    ASSERT_NE(lb_get_book(&lib, handle), nullptr);
+    ASSERT_EQ(lb_evict_books(&lib), 0);
+    EXPECT_EQ(lb_get_book(&lib, handle), nullptr);
+}
+
+TEST_F(BTreeBackendTest, ChangesAreWrittenThrough) {
+    add_book("978-1", "One", nullptr);
+    add_book("978-2", "Two", nullptr);
+    add_book("978-3", "Three", nullptr);
+    ASSERT_EQ(lb_evict_books(&lib), 0);
+
+    // Changes of books left in the tree read them in first
+    ASSERT_EQ(lb_update_book_title(&lib, "978-1", "Uno"), 0);
+    ASSERT_EQ(lb_add_book_genre(&lib, "978-1", 7), 0);
+    ASSERT_EQ(lb_evict_books(&lib), 0);
+    ASSERT_EQ(lb_update_book_isbn(&lib, "978-2", "978-8"), 0);
+    ASSERT_EQ(lb_evict_books(&lib), 0);
+    ASSERT_EQ(lb_remove_book(&lib, "978-3"), 0);
+    ASSERT_EQ(lb_evict_books(&lib), 0);
+    EXPECT_EQ(tree.meta.record_count, 2u);
+
+    Book *book = lb_find_book_by_isbn(&lib, "978-1");
+    ASSERT_NE(book, nullptr);
+    EXPECT_STREQ(book->title, "Uno");
+    ASSERT_EQ(book->genre_count, 1);
+    EXPECT_EQ(book_get_genre_ids(book)[0], 7);
+    EXPECT_NE(lb_find_book_by_isbn(&lib, "978-8"), nullptr);
+    EXPECT_EQ(lb_find_book_by_isbn(&lib, "978-2"), nullptr);
+    EXPECT_EQ(lb_find_book_by_isbn(&lib, "978-3"), nullptr);
+    EXPECT_EQ(lb_remove_book(&lib, "978-3"), 1);
+
+    // The books outlive the library
+    lb_free(&lib);
+    ASSERT_EQ(btree_close(&tree), 0);
+    ASSERT_EQ(btree_open(&tree, path.c_str(), 0), 0);
+    ASSERT_EQ(lb_init(&lib), 0);
+    ASSERT_EQ(lb_set_backend(&lib, &backend), 0);
+    book = lb_find_book_by_isbn(&lib, "978-1");
+    ASSERT_NE(book, nullptr);
+    EXPECT_STREQ(book->title, "Uno");
+}
+
+TEST_F(BTreeBackendTest, DuplicatesLeftInTheTreeAreRefused) {
+    add_book("978-1", "One", nullptr);
+    add_book("978-2", "Two", nullptr);
+    ASSERT_EQ(lb_evict_books(&lib), 0);
+
+    Book book;
+    book_init(&book);
+    strcpy(book.isbn, "978-1");
+    strcpy(book.title, "Again");
+    EXPECT_EQ(lb_add_book(&lib, &book), 1);
+    EXPECT_EQ(lb_add_books_bulk(&lib, &book, 1), 1);
+    book_free(&book);
+
+    ASSERT_EQ(lb_evict_books(&lib), 0);
+    EXPECT_EQ(lb_update_book_isbn(&lib, "978-1", "978-2"), 1);
+    EXPECT_STREQ(lb_find_book_by_isbn(&lib, "978-1")->title, "One");
+}
+
+TEST_F(BTreeBackendTest, RangeIsReadIn) {
+    add_book("978-1", "One", nullptr);
+    add_book("978-2", "Two", nullptr);
+    add_book("978-3", "Three", nullptr);
+    ASSERT_EQ(lb_evict_books(&lib), 0);
+    ASSERT_NE(lb_find_book_by_isbn(&lib, "978-2"), nullptr);
+
+    // Books already in memory are kept as they are
+    ASSERT_EQ(btree_load_books(&tree, &lib, "978-2", nullptr), 0);
+    EXPECT_EQ(lib.book_count, 2);
+    EXPECT_EQ(tree.meta.record_count, 3u);
+
+    int results[4];
+    int count;
+    ASSERT_EQ(lb_search_books(&lib, "Three", results, 4, &count), 0);
+    EXPECT_EQ(count, 1);
+}
+
+TEST_F(BTreeBackendTest, ConcurrentOrFilledLibrariesAreRefused) {
+    EXPECT_EQ(lb_set_concurrent(&lib, 1), 1);
+    add_book("978-1", "One", nullptr);
+    EXPECT_EQ(lb_set_backend(&lib, &backend), 1);
+
+    Library other;
+    ASSERT_EQ(lb_init(&other), 0);
+    ASSERT_EQ(lb_set_concurrent(&other, 1), 0);
+    EXPECT_EQ(lb_set_backend(&other, &backend), 1);
+    ASSERT_EQ(lb_set_concurrent(&other, 0), 0);
+
+    // A failed write fails the change
+    LibraryBackend broken = backend;
+    broken.apply = [](void *, Library *, const LibraryChange *) { return 1; };
+    ASSERT_EQ(lb_set_backend(&other, &broken), 0);
+
+    Book book;
+    book_init(&book);
+    strcpy(book.isbn, "978-2");
+    EXPECT_EQ(lb_add_book(&other, &book), 1);
+    EXPECT_EQ(other.book_count, 0);
+    book_free(&book);
+
+    // The book of the tree is read in, its change is refused
+    EXPECT_EQ(lb_update_book_title(&other, "978-1", "Uno"), 1);
+    EXPECT_STREQ(lb_find_book_by_isbn(&other, "978-1")->title, "One");
+    lb_free(&other);
+}
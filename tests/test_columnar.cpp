@@ -0,0 +1,217 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <unistd.h>
+#include "../include/db/columnar.h"
+#include "log_dir.h"
+
+class ColumnarTest : public ::testing::Test {
+protected:
+    Library lib;
+    std::string path;
+
+    void SetUp() override {
+        ASSERT_EQ(lb_init(&lib), 0);
+        path = ::testing::TempDir() + "columnar_test_" +
+               ::testing::UnitTest::GetInstance()->current_test_info()->name() + ".col";
+        std::remove(path.c_str());
+    }
+
+    void TearDown() override {
+        lb_free(&lib);
+        std::remove(path.c_str());
+    }
+
+    // Books come in year order, so blocks cover narrow year ranges
+    void fill(int books) {
+        for (const char *name : { "Asimov", "Herbert", "Le Guin", "Tolkien" }) {
+            ASSERT_EQ(lb_add_author(&lib, name), 0);
+        }
+        for (const char *name : { "Fantasy", "Science Fiction", "Classic" }) {
+            ASSERT_EQ(lb_add_genre(&lib, name), 0);
+        }
+
+        for (int i = 0; i < books; i++) {
+            Book book;
+            book_init(&book);
+            book.id = i + 1;
+            book.publication_year = 1900 + i / 100;
+            std::snprintf(book.isbn, ISBN_SIZE, "978-%08d", i);
+            std::snprintf(book.title, MAX_TITLE, "Title %d", i);
+            if (i % 3 == 0) {
+                book_update_description(&book, ("About book " + std::to_string(i)).c_str());
+            }
+
+            book_add_author(&book, 1 + i % 4);
+            if (i % 5 == 0) {
+                book_add_author(&book, 1 + (i + 1) % 4);
+            }
+            book_add_genre(&book, 1 + i % 3);
+
+            // The library owns the description from now on
+            ASSERT_EQ(lb_add_book(&lib, &book), 0);
+        }
+    }
+};
+
+TEST_F(ColumnarTest, RoundTrip) {
+    fill(10000);
+    ASSERT_EQ(columnar_save(&lib, path.c_str()), 0);
+
+    Library loaded;
+    ASSERT_EQ(lb_init(&loaded), 0);
+    ASSERT_EQ(columnar_load(path.c_str(), &loaded), 0);
+
+    ASSERT_EQ(loaded.book_count, lib.book_count);
+    ASSERT_EQ(loaded.author_count, lib.author_count);
+    ASSERT_EQ(loaded.genre_count, lib.genre_count);
+    EXPECT_STREQ(loaded.authors[2].name, "Le Guin");
+    EXPECT_STREQ(loaded.genres[1].name, "Science Fiction");
+
+    for (int i = 0; i < lib.book_count; i++) {
+        const Book *expected = &lib.books[i];
+        const Book *book = &loaded.books[i];
+
+        ASSERT_EQ(book->id, expected->id);
+        ASSERT_EQ(book->publication_year, expected->publication_year);
+        ASSERT_STREQ(book->isbn, expected->isbn);
+        ASSERT_STREQ(book->title, expected->title);
+        if (expected->description) {
+            ASSERT_STREQ(book->description, expected->description);
+        } else {
+            ASSERT_EQ(book->description, nullptr);
+        }
+
+        ASSERT_EQ(book->author_count, expected->author_count);
+        for (int j = 0; j < book->author_count; j++) {
+            ASSERT_EQ(book_get_author_ids((Book *)book)[j], book_get_author_ids((Book *)expected)[j]);
+        }
+        ASSERT_EQ(book->genre_count, expected->genre_count);
+        ASSERT_EQ(book_get_genre_ids((Book *)book)[0], book_get_genre_ids((Book *)expected)[0]);
+    }
+
+    lb_free(&loaded);
+}
+
+TEST_F(ColumnarTest, SmallerThanTheCatalog) {
+    fill(10000);
+    ASSERT_EQ(columnar_save(&lib, path.c_str()), 0);
+
+    ColumnarFile file;
+    ASSERT_EQ(columnar_open(&file, path.c_str()), 0);
+
+    // Ids and years need a few bits each instead of two ints
+    size_t fixed = (size_t)lib.book_count * (sizeof(int) * 2 + ISBN_SIZE + MAX_TITLE);
+    EXPECT_LT(file.size, fixed / 4);
+    columnar_close(&file);
+}
+
+TEST_F(ColumnarTest, SummaryMatchesLibrary) {
+    fill(9000);
+    ASSERT_EQ(columnar_save(&lib, path.c_str()), 0);
+
+    long author_links = 0;
+    long genre_links = 0;
+    for (int i = 0; i < lib.book_count; i++) {
+        author_links += lib.books[i].author_count;
+        genre_links += lib.books[i].genre_count;
+    }
+
+    ColumnarFile file;
+    ColumnarSummary summary;
+    ASSERT_EQ(columnar_open(&file, path.c_str()), 0);
+    ASSERT_EQ(columnar_summary(&file, &summary), 0);
+
+    EXPECT_EQ(summary.books, 9000);
+    EXPECT_EQ(summary.authors, 4);
+    EXPECT_EQ(summary.genres, 3);
+    EXPECT_EQ(summary.author_links, author_links);
+    EXPECT_EQ(summary.genre_links, genre_links);
+    EXPECT_EQ(summary.year_min, 1900);
+    EXPECT_EQ(summary.year_max, 1989);
+    columnar_close(&file);
+}
+
+TEST_F(ColumnarTest, CountsSkipBlocks) {
+    fill(20000);
+    ASSERT_EQ(columnar_save(&lib, path.c_str()), 0);
+
+    ColumnarFile file;
+    ASSERT_EQ(columnar_open(&file, path.c_str()), 0);
+    ASSERT_EQ(file.header->block_count, 5u);
+
+    long count = 0;
+    ASSERT_EQ(columnar_count_by_year(&file, 1950, 1959, &count), 0);
+    EXPECT_EQ(count, 1000);
+    EXPECT_GT(file.blocks_skipped, 0u);
+    EXPECT_LT(file.blocks_read, 5u);
+
+    ASSERT_EQ(columnar_count_by_year(&file, 0, 3000, &count), 0);
+    EXPECT_EQ(count, 20000);
+
+    ASSERT_EQ(columnar_count_by_year(&file, 2150, 2160, &count), 0);
+    EXPECT_EQ(count, 0);
+
+    // Author 2 is the first author of every fourth book, and the second
+    // of the books i % 5 == 0 with i % 4 == 0
+    ASSERT_EQ(columnar_count_by_author(&file, 2, &count), 0);
+    EXPECT_EQ(count, 5000 + 1000);
+
+    ASSERT_EQ(columnar_count_by_genre(&file, 3, &count), 0);
+    EXPECT_EQ(count, 6666);
+
+    // Unknown ids match nothing
+    ASSERT_EQ(columnar_count_by_genre(&file, 42, &count), 0);
+    EXPECT_EQ(count, 0);
+
+    columnar_close(&file);
+}
+
+TEST_F(ColumnarTest, DanglingIdsAreDropped) {
+    fill(10);
+    ASSERT_EQ(lb_add_book_author(&lib, "978-00000000", 99), 0);
+    ASSERT_EQ(columnar_save(&lib, path.c_str()), 0);
+
+    ColumnarFile file;
+    ColumnarSummary summary;
+    ASSERT_EQ(columnar_open(&file, path.c_str()), 0);
+    ASSERT_EQ(columnar_summary(&file, &summary), 0);
+    EXPECT_EQ(summary.author_links, 12);
+    columnar_close(&file);
+}
+
+TEST_F(ColumnarTest, EmptyLibrary) {
+    ASSERT_EQ(columnar_save(&lib, path.c_str()), 0);
+
+    Library loaded;
+    ASSERT_EQ(lb_init(&loaded), 0);
+    ASSERT_EQ(columnar_load(path.c_str(), &loaded), 0);
+    EXPECT_EQ(loaded.book_count, 0);
+    lb_free(&loaded);
+}
+
+TEST_F(ColumnarTest, RejectsBadInput) {
+    ColumnarFile file;
+    EXPECT_EQ(columnar_save(nullptr, path.c_str()), 1);
+    EXPECT_EQ(columnar_open(&file, path.c_str()), 1);
+
+    fill(100);
+    ASSERT_EQ(columnar_save(&lib, path.c_str()), 0);
+
+    FILE *out = std::fopen(path.c_str(), "r+b");
+    ASSERT_NE(out, nullptr);
+    std::fputs("garbage!", out);
+    std::fclose(out);
+    EXPECT_EQ(columnar_open(&file, path.c_str()), 1);
+
+    // A truncated file is refused as well
+    ASSERT_EQ(columnar_save(&lib, path.c_str()), 0);
+    out = std::fopen(path.c_str(), "r+b");
+    ASSERT_NE(out, nullptr);
+    std::fseek(out, 0, SEEK_END);
+    long size = std::ftell(out);
+    std::fclose(out);
+    ASSERT_EQ(truncate(path.c_str(), size / 2), 0);
+    EXPECT_EQ(columnar_open(&file, path.c_str()), 1);
+}
@@ -0,0 +1,805 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include "../include/db/db.h"
+#include "../include/db/crc32.h"
+#include "log_dir.h"
+
+class DbTest : public ::testing::Test {
+protected:
+    Library lib;
+    Library loaded;
+    std::string path;
+
+    void SetUp() override {
+        ASSERT_EQ(lb_init(&lib), 0);
+        ASSERT_EQ(lb_init(&loaded), 0);
+        path = ::testing::TempDir() + "db_test_" +
+               ::testing::UnitTest::GetInstance()->current_test_info()->name() + ".db";
+    }
+
+    void TearDown() override {
+        lb_free(&loaded);
+        lb_free(&lib);
+        std::remove(path.c_str());
+    }
+
+    void fill(int n) {
+        lb_add_author(&lib, "Ursula K. Le Guin");
+        lb_add_author(&lib, "Frank Herbert");
+        lb_add_genre(&lib, "Fantasy");
+        lb_add_genre(&lib, "Science Fiction");
+
+        for (int i = 0; i < n; i++) {
+            Book book;
+            book_init(&book);
+            book.id = i + 1;
+            book.publication_year = 1960 + i;
+            snprintf(book.title, MAX_TITLE, "Title_%d", i);
+            snprintf(book.isbn, ISBN_SIZE, "978-%d", 1000000 + i);
+
+            book_add_author(&book, 1 + i % 2);
+            book_add_genre(&book, 1 + i % 2);
+            // Long lists live in the id table as views
+            if (i % 3 == 0) {
+                for (int g = 0; g < BOOK_INLINE_IDS + 2; g++) {
+                    book_add_genre(&book, 10 + g);
+                }
+            }
+
+            if (i % 2 == 0) {
+                std::string description = "Description of book " + std::to_string(i);
+                book_update_description(&book, description.c_str());
+            }
+
+            ASSERT_EQ(lb_add_book(&lib, &book), 0);
+        }
+    }
+};
+
+// ========== Snapshot Tests ==========
+
+TEST_F(DbTest, SaveAndOpenRoundTrip) {
+    fill(50);
+    ASSERT_EQ(db_save(&lib, path.c_str()), 0);
+    ASSERT_EQ(db_open_mmap(path.c_str(), &loaded), 0);
+
+    ASSERT_EQ(loaded.book_count, lib.book_count);
+    ASSERT_EQ(loaded.author_count, 2);
+    ASSERT_EQ(loaded.genre_count, 2);
+    EXPECT_STREQ(loaded.authors[1].name, "Frank Herbert");
+    EXPECT_NE(lb_find_genre_by_name(&loaded, "Fantasy"), nullptr);
+
+    for (int i = 0; i < lib.book_count; i++) {
+        Book *original = &lib.books[i];
+        Book *copy = lb_find_book_by_isbn(&loaded, original->isbn);
+        ASSERT_NE(copy, nullptr);
+
+        EXPECT_EQ(copy->id, original->id);
+        EXPECT_EQ(copy->publication_year, original->publication_year);
+        EXPECT_STREQ(copy->title, original->title);
+
+        ASSERT_EQ(copy->genre_count, original->genre_count);
+        for (int g = 0; g < copy->genre_count; g++) {
+            EXPECT_EQ(book_get_genre_ids(copy)[g], book_get_genre_ids(original)[g]);
+        }
+
+        if (original->description) {
+            EXPECT_STREQ(copy->description, original->description);
+        } else {
+            EXPECT_EQ(copy->description, nullptr);
+        }
+    }
+
+    int count = 0;
+    lb_books_by_genre(&loaded, 12, &count);
+    EXPECT_EQ(count, 17);
+
+    int results[4];
+    ASSERT_EQ(lb_search_books(&loaded, "book 42", results, 4, &count), 0);
+    EXPECT_EQ(count, 1);
+}
+
+TEST_F(DbTest, OpenedLibraryServesViewsAndCopiesOnWrite) {
+    fill(6);
+    ASSERT_EQ(db_save(&lib, path.c_str()), 0);
+    ASSERT_EQ(db_open_mmap(path.c_str(), &loaded), 0);
+
+    Book *book = lb_find_book_by_isbn(&loaded, "978-1000000");
+    ASSERT_NE(book, nullptr);
+    EXPECT_EQ(book->genre_capacity, 0);
+    EXPECT_GE((const char *)book->genre_ids, loaded.view);
+    EXPECT_GE(book->description, loaded.view);
+    EXPECT_LT(book->description, loaded.view + loaded.view_size);
+
+    EXPECT_EQ(lb_add_book_genre(&loaded, "978-1000000", 99), 0);
+    EXPECT_GT(book->genre_capacity, 0);
+    EXPECT_EQ(lb_update_book_description(&loaded, "978-1000000", "changed"), 0);
+    EXPECT_STREQ(book->description, "changed");
+
+    EXPECT_EQ(lb_remove_book(&loaded, "978-1000003"), 0);
+    EXPECT_EQ(loaded.book_count, 5);
+
+    // A changed snapshot can be saved over the mapped file
+    ASSERT_EQ(db_save(&loaded, path.c_str()), 0);
+    lb_clear(&loaded);
+    EXPECT_EQ(loaded.view, nullptr);
+
+    ASSERT_EQ(db_open_mmap(path.c_str(), &loaded), 0);
+    EXPECT_EQ(loaded.book_count, 5);
+    book = lb_find_book_by_isbn(&loaded, "978-1000000");
+    ASSERT_NE(book, nullptr);
+    EXPECT_STREQ(book->description, "changed");
+    EXPECT_EQ(book->genre_count, BOOK_INLINE_IDS + 4);
+}
+
+TEST_F(DbTest, EmptyLibraryRoundTrip) {
+    ASSERT_EQ(db_save(&lib, path.c_str()), 0);
+    ASSERT_EQ(db_open_mmap(path.c_str(), &loaded), 0);
+    EXPECT_EQ(loaded.book_count, 0);
+}
+
+TEST_F(DbTest, RejectsBadInput) {
+    EXPECT_EQ(db_save(nullptr, path.c_str()), 1);
+    EXPECT_EQ(db_open_mmap(nullptr, &loaded), 1);
+    EXPECT_EQ(db_open_mmap((path + ".missing").c_str(), &loaded), 1);
+
+    fill(3);
+    ASSERT_EQ(db_save(&lib, path.c_str()), 0);
+
+    // Only an empty library can be filled
+    EXPECT_EQ(db_open_mmap(path.c_str(), &lib), 1);
+
+    // Corrupt the magic
+    FILE *file = std::fopen(path.c_str(), "r+b");
+    ASSERT_NE(file, nullptr);
+    std::fputc('X', file);
+    std::fclose(file);
+    EXPECT_EQ(db_open_mmap(path.c_str(), &loaded), 1);
+    EXPECT_EQ(loaded.book_count, 0);
+}
+
+TEST_F(DbTest, RejectsTruncatedFile) {
+    fill(10);
+    ASSERT_EQ(db_save(&lib, path.c_str()), 0);
+
+    FILE *file = std::fopen(path.c_str(), "rb");
+    ASSERT_NE(file, nullptr);
+    std::string data(sizeof(DbHeader) + 64, '\0');
+    ASSERT_EQ(std::fread(&data[0], 1, data.size(), file), data.size());
+    std::fclose(file);
+
+    file = std::fopen(path.c_str(), "wb");
+    std::fwrite(data.data(), 1, data.size(), file);
+    std::fclose(file);
+
+    EXPECT_EQ(db_open_mmap(path.c_str(), &loaded), 1);
+    EXPECT_EQ(loaded.view, nullptr);
+}
+
+TEST_F(DbTest, SavedIndexesAreRestored) {
+    fill(50);
+    // Removals leave slots out of order and tombstones in the ISBN table
+    ASSERT_EQ(lb_remove_book(&lib, "978-1000003"), 0);
+    ASSERT_EQ(lb_remove_book(&lib, "978-1000010"), 0);
+    ASSERT_GT(lib.isbn_index.tombstones, 0);
+    ASSERT_EQ(db_save(&lib, path.c_str()), 0);
+    ASSERT_EQ(db_open_mmap(path.c_str(), &loaded), 0);
+
+    // A rebuild would drop the tombstones
+    EXPECT_EQ(loaded.isbn_index.capacity, lib.isbn_index.capacity);
+    EXPECT_EQ(loaded.isbn_index.tombstones, lib.isbn_index.tombstones);
+    EXPECT_EQ(loaded.index_deferred, 0);
+
+    for (int i = 0; i < lib.book_count; i++) {
+        Book *copy = lb_find_book_by_isbn(&loaded, lib.books[i].isbn);
+        ASSERT_NE(copy, nullptr);
+        EXPECT_EQ(copy->id, lib.books[i].id);
+    }
+    EXPECT_EQ(lb_find_book_by_isbn(&loaded, "978-1000003"), nullptr);
+
+    ASSERT_NE(lb_find_author_by_name(&loaded, "Frank Herbert"), nullptr);
+    EXPECT_EQ(lb_find_author_by_name(&loaded, "Frank Herbert")->id, 2);
+    ASSERT_NE(lb_find_genre_by_name(&loaded, "Science Fiction"), nullptr);
+
+    for (int key = 1; key <= 2; key++) {
+        int expected = 0;
+        int count = 0;
+        const int *expected_slots = lb_books_by_genre(&lib, key, &expected);
+        const int *slots = lb_books_by_genre(&loaded, key, &count);
+        ASSERT_EQ(count, expected);
+
+        // Slots do not survive a reload, the books they point at do
+        std::vector<std::string> expected_isbns;
+        std::vector<std::string> isbns;
+        for (int i = 0; i < count; i++) {
+            expected_isbns.push_back(lb_get_book_by_slot(&lib, expected_slots[i])->isbn);
+            isbns.push_back(lb_get_book_by_slot(&loaded, slots[i])->isbn);
+        }
+        std::sort(expected_isbns.begin(), expected_isbns.end());
+        std::sort(isbns.begin(), isbns.end());
+        EXPECT_EQ(isbns, expected_isbns);
+        for (int i = 1; i < count; i++) {
+            EXPECT_LT(slots[i - 1], slots[i]);
+        }
+
+        postings_get(&lib.author_postings, key, &expected);
+        postings_get(&loaded.author_postings, key, &count);
+        EXPECT_EQ(count, expected);
+    }
+
+    // Restored entries point at the new slots: changes keep working
+    ASSERT_EQ(lb_remove_book(&loaded, "978-1000004"), 0);
+    ASSERT_EQ(lb_update_book_title(&loaded, "978-1000049", "Renamed"), 0);
+    EXPECT_STREQ(lb_find_book_by_isbn(&loaded, "978-1000049")->title, "Renamed");
+}
+
+TEST_F(DbTest, DamagedIndexesAreRebuilt) {
+    fill(30);
+    ASSERT_EQ(lb_remove_book(&lib, "978-1000002"), 0);
+    ASSERT_EQ(db_save(&lib, path.c_str()), 0);
+
+    DbHeader header;
+    FILE *file = std::fopen(path.c_str(), "r+b");
+    ASSERT_NE(file, nullptr);
+    ASSERT_EQ(std::fread(&header, sizeof(header), 1, file), 1u);
+
+    // Flip a byte of the first saved table, the checksum no longer matches
+    std::fseek(file, (long)(header.index_offset + sizeof(DbIndexHeader)), SEEK_SET);
+    int byte = std::fgetc(file);
+    std::fseek(file, (long)(header.index_offset + sizeof(DbIndexHeader)), SEEK_SET);
+    std::fputc(byte ^ 0xff, file);
+    std::fclose(file);
+
+    ASSERT_EQ(db_open_mmap(path.c_str(), &loaded), 0);
+    EXPECT_EQ(loaded.isbn_index.tombstones, 0);
+
+    for (int i = 0; i < lib.book_count; i++) {
+        ASSERT_NE(lb_find_book_by_isbn(&loaded, lib.books[i].isbn), nullptr);
+    }
+    EXPECT_NE(lb_find_author_by_name(&loaded, "Ursula K. Le Guin"), nullptr);
+
+    int count = 0;
+    int expected = 0;
+    postings_get(&lib.genre_postings, 1, &expected);
+    postings_get(&loaded.genre_postings, 1, &count);
+    EXPECT_EQ(count, expected);
+}
+
+// ========== Journal Tests ==========
+
+class DbJournalTest : public DbTest {
+protected:
+    Db db;
+
+    void TearDown() override {
+        std::remove((path + ".wal").c_str());
+        DbTest::TearDown();
+    }
+
+    void reopen(const DbOptions *options = nullptr) {
+        lb_free(&loaded);
+        ASSERT_EQ(lb_init(&loaded), 0);
+        ASSERT_EQ(db_open(&db, &loaded, path.c_str(), options), 0);
+    }
+};
+
+TEST_F(DbJournalTest, ChangesSurviveReopen) {
+    ASSERT_EQ(db_open(&db, &lib, path.c_str(), nullptr), 0);
+    fill(10);
+
+    ASSERT_EQ(lb_remove_book(&lib, "978-1000003"), 0);
+    ASSERT_EQ(lb_update_book_title(&lib, "978-1000001", "Renamed"), 0);
+    ASSERT_EQ(lb_update_book_isbn(&lib, "978-1000002", "978-2000002"), 0);
+    ASSERT_EQ(lb_update_book_year(&lib, "978-1000004", 2001), 0);
+    ASSERT_EQ(lb_update_book_description(&lib, "978-1000005", "journaled"), 0);
+    ASSERT_EQ(lb_add_book_genre(&lib, "978-1000006", 2), 0);
+    ASSERT_EQ(lb_remove_book_author(&lib, "978-1000007", 2), 0);
+    ASSERT_EQ(lb_update_author_name(&lib, 1, "U. K. Le Guin"), 0);
+    ASSERT_EQ(db_close(&db), 0);
+
+    // No snapshot yet: everything comes from the journal
+    reopen();
+    ASSERT_EQ(loaded.book_count, 9);
+    EXPECT_EQ(lb_find_book_by_isbn(&loaded, "978-1000003"), nullptr);
+    EXPECT_EQ(lb_find_book_by_isbn(&loaded, "978-1000002"), nullptr);
+    ASSERT_NE(lb_find_book_by_isbn(&loaded, "978-2000002"), nullptr);
+    EXPECT_STREQ(lb_find_book_by_isbn(&loaded, "978-1000001")->title, "Renamed");
+    EXPECT_EQ(lb_find_book_by_isbn(&loaded, "978-1000004")->publication_year, 2001);
+    EXPECT_STREQ(lb_find_book_by_isbn(&loaded, "978-1000005")->description, "journaled");
+    EXPECT_EQ(lb_find_book_by_isbn(&loaded, "978-1000000")->genre_count, BOOK_INLINE_IDS + 3);
+    EXPECT_EQ(lb_find_book_by_isbn(&loaded, "978-1000007")->author_count, 0);
+    EXPECT_STREQ(loaded.authors[0].name, "U. K. Le Guin");
+
+    int count = 0;
+    lb_books_by_genre(&loaded, 2, &count);
+    EXPECT_EQ(count, 5);
+    ASSERT_EQ(db_close(&db), 0);
+}
+
+TEST_F(DbJournalTest, CheckpointFoldsJournalIntoSnapshot) {
+    ASSERT_EQ(db_open(&db, &lib, path.c_str(), nullptr), 0);
+    fill(20);
+    ASSERT_EQ(db_checkpoint(&db), 0);
+    EXPECT_EQ(db.journal.file_size, (uint64_t)JOURNAL_HEADER_SIZE);
+
+    ASSERT_EQ(lb_remove_book(&lib, "978-1000010"), 0);
+    ASSERT_EQ(db_close(&db), 0);
+
+    reopen();
+    EXPECT_EQ(db.sequence, 1u);
+    EXPECT_NE(loaded.view, nullptr);
+    EXPECT_EQ(loaded.book_count, 19);
+    EXPECT_EQ(lb_find_book_by_isbn(&loaded, "978-1000010"), nullptr);
+    ASSERT_EQ(db_close(&db), 0);
+}
+
+TEST_F(DbJournalTest, CrashBeforeJournalResetKeepsSnapshot) {
+    ASSERT_EQ(db_open(&db, &lib, path.c_str(), nullptr), 0);
+    fill(5);
+    ASSERT_EQ(db_close(&db), 0);
+
+    // Snapshot written for the next sequence, journal left behind
+    std::string wal = path + ".wal";
+    std::string saved = wal + ".saved";
+    ASSERT_EQ(std::rename(wal.c_str(), saved.c_str()), 0);
+    reopen();
+    ASSERT_EQ(db_checkpoint(&db), 0);
+    ASSERT_EQ(db_close(&db), 0);
+    ASSERT_EQ(std::rename(saved.c_str(), wal.c_str()), 0);
+
+    // The stale journal must not be applied twice
+    reopen();
+    EXPECT_EQ(loaded.book_count, 0);
+    ASSERT_EQ(db_close(&db), 0);
+}
+
+TEST_F(DbJournalTest, ClearIsJournaled) {
+    ASSERT_EQ(db_open(&db, &lib, path.c_str(), nullptr), 0);
+    fill(4);
+    lb_clear(&lib);
+    lb_add_genre(&lib, "Poetry");
+    ASSERT_EQ(db_close(&db), 0);
+
+    reopen();
+    EXPECT_EQ(loaded.book_count, 0);
+    ASSERT_EQ(loaded.genre_count, 1);
+    EXPECT_STREQ(loaded.genres[0].name, "Poetry");
+    ASSERT_EQ(db_close(&db), 0);
+}
+
+TEST_F(DbJournalTest, IntervalModeSyncsOnClose) {
+    DbOptions options = { JOURNAL_SYNC_INTERVAL, 20, 0 };
+    ASSERT_EQ(db_open(&db, &lib, path.c_str(), &options), 0);
+    fill(30);
+    ASSERT_EQ(db_sync(&db), 0);
+    ASSERT_EQ(db_close(&db), 0);
+
+    reopen(&options);
+    EXPECT_EQ(loaded.book_count, 30);
+    ASSERT_EQ(db_close(&db), 0);
+}
+
+TEST_F(DbJournalTest, RejectsBadInput) {
+    EXPECT_EQ(db_open(nullptr, &lib, path.c_str(), nullptr), 1);
+    EXPECT_EQ(db_open(&db, &lib, nullptr, nullptr), 1);
+    EXPECT_EQ(db_checkpoint(nullptr), 1);
+    EXPECT_EQ(db_close(nullptr), 1);
+}
+
+// ========== Incremental Checkpoint Tests ==========
+
+TEST_F(DbJournalTest, CheckpointWritesOnlyChangedRecords) {
+    ASSERT_EQ(db_open(&db, &lib, path.c_str(), nullptr), 0);
+    fill(400);
+    ASSERT_EQ(db_checkpoint(&db), 0);
+    uint64_t full_bytes = db.checkpoint_bytes;
+    uint64_t file_size = db.header.file_size;
+
+    ASSERT_EQ(lb_update_book_title(&lib, "978-1000001", "Retitled"), 0);
+    ASSERT_EQ(lb_remove_book(&lib, "978-1000002"), 0);
+    ASSERT_EQ(lb_update_author_name(&lib, 2, "F. Herbert"), 0);
+    lb_add_genre(&lib, "Horror");
+    EXPECT_GT(lib.dirty_books.count, 0);
+
+    ASSERT_EQ(db_checkpoint(&db), 0);
+    EXPECT_LT(db.checkpoint_bytes, 4096u);
+    EXPECT_LT(db.checkpoint_bytes * 20, full_bytes);
+    EXPECT_EQ(db.header.file_size, file_size);
+    EXPECT_EQ(lib.dirty_books.count, 0);
+    EXPECT_EQ(db.free_record_count, 1);
+
+    // A new book takes the removed record
+    Book book;
+    book_init(&book);
+    snprintf(book.title, MAX_TITLE, "Replacement");
+    snprintf(book.isbn, ISBN_SIZE, "978-9999999");
+    book_update_description(&book, "fills the hole");
+    ASSERT_EQ(lb_add_book(&lib, &book), 0);
+    ASSERT_EQ(db_checkpoint(&db), 0);
+    EXPECT_EQ(db.free_record_count, 0);
+    EXPECT_EQ(db.header.book_count, 400u);
+    ASSERT_EQ(db_close(&db), 0);
+
+    reopen();
+    EXPECT_EQ(loaded.book_count, 400);
+    EXPECT_STREQ(lb_find_book_by_isbn(&loaded, "978-1000001")->title, "Retitled");
+    EXPECT_EQ(lb_find_book_by_isbn(&loaded, "978-1000002"), nullptr);
+    ASSERT_NE(lb_find_book_by_isbn(&loaded, "978-9999999"), nullptr);
+    EXPECT_STREQ(lb_find_book_by_isbn(&loaded, "978-9999999")->description, "fills the hole");
+    EXPECT_STREQ(loaded.authors[1].name, "F. Herbert");
+    EXPECT_NE(lb_find_genre_by_name(&loaded, "Horror"), nullptr);
+
+    // Records changed after a reopen map back to the right place
+    ASSERT_EQ(lb_update_book_year(&loaded, "978-1000300", 1234), 0);
+    ASSERT_EQ(db_checkpoint(&db), 0);
+    EXPECT_LT(db.checkpoint_bytes, 4096u);
+    ASSERT_EQ(db_close(&db), 0);
+
+    reopen();
+    EXPECT_EQ(lb_find_book_by_isbn(&loaded, "978-1000300")->publication_year, 1234);
+    EXPECT_EQ(lb_find_book_by_isbn(&loaded, "978-1000299")->publication_year, 1960 + 299);
+    ASSERT_EQ(db_close(&db), 0);
+}
+
+TEST_F(DbJournalTest, FullSectionRewritesSnapshot) {
+    ASSERT_EQ(db_open(&db, &lib, path.c_str(), nullptr), 0);
+    fill(10);
+    ASSERT_EQ(db_checkpoint(&db), 0);
+    uint64_t capacity = db.header.book_capacity;
+
+    for (int i = 0; i < (int)capacity; i++) {
+        Book book;
+        book_init(&book);
+        snprintf(book.isbn, ISBN_SIZE, "979-%d", i);
+        ASSERT_EQ(lb_add_book(&lib, &book), 0);
+    }
+
+    ASSERT_EQ(db_checkpoint(&db), 0);
+    EXPECT_GT(db.header.book_capacity, capacity);
+    ASSERT_EQ(db_close(&db), 0);
+
+    reopen();
+    EXPECT_EQ(loaded.book_count, 10 + (int)capacity);
+    ASSERT_EQ(db_close(&db), 0);
+}
+
+TEST_F(DbJournalTest, ClearForcesFullCheckpoint) {
+    ASSERT_EQ(db_open(&db, &lib, path.c_str(), nullptr), 0);
+    fill(10);
+    ASSERT_EQ(db_checkpoint(&db), 0);
+
+    lb_clear(&lib);
+    EXPECT_EQ(lib.dirty_all, 1);
+    ASSERT_EQ(db_checkpoint(&db), 0);
+    EXPECT_EQ(db.header.book_count, 0u);
+    ASSERT_EQ(db_close(&db), 0);
+
+    reopen();
+    EXPECT_EQ(loaded.book_count, 0);
+    ASSERT_EQ(db_close(&db), 0);
+}
+
+TEST_F(DbJournalTest, OpenRedoesInterruptedCheckpoint) {
+    ASSERT_EQ(db_open(&db, &lib, path.c_str(), nullptr), 0);
+    fill(5);
+    ASSERT_EQ(db_checkpoint(&db), 0);
+    DbHeader header = db.header;
+    ASSERT_EQ(db_close(&db), 0);
+
+    // Intent of a checkpoint that crashed before touching the snapshot:
+    // rename the first book and move to the next sequence
+    FILE *file = std::fopen(path.c_str(), "rb");
+    ASSERT_NE(file, nullptr);
+    DbBookRecord record;
+    std::fseek(file, (long)header.book_offset, SEEK_SET);
+    ASSERT_EQ(std::fread(&record, sizeof(record), 1, file), 1u);
+    std::fclose(file);
+
+    snprintf(record.title, MAX_TITLE, "Redone");
+    header.journal_sequence++;
+
+    std::string payload;
+    auto put = [&payload](uint64_t offset, const void *data, uint32_t size) {
+        payload.append(reinterpret_cast<const char *>(&offset), sizeof(offset));
+        payload.append(reinterpret_cast<const char *>(&size), sizeof(size));
+        payload.append(static_cast<const char *>(data), size);
+    };
+    put(header.book_offset, &record, sizeof(record));
+    put(0, &header, sizeof(header));
+
+    DbIntentHeader intent;
+    memset(&intent, 0, sizeof(intent));
+    memcpy(intent.magic, DB_CHECKPOINT_MAGIC, sizeof(intent.magic));
+    intent.base_sequence = header.journal_sequence - 1;
+    intent.target_sequence = header.journal_sequence;
+    intent.payload_size = payload.size();
+    intent.crc = crc32_update(0, payload.data(), payload.size());
+
+    std::string intent_path = path + ".ckpt";
+    file = std::fopen(intent_path.c_str(), "wb");
+    ASSERT_NE(file, nullptr);
+    std::fwrite(&intent, sizeof(intent), 1, file);
+    std::fwrite(payload.data(), 1, payload.size(), file);
+    std::fclose(file);
+
+    reopen();
+    EXPECT_EQ(db.sequence, header.journal_sequence);
+    EXPECT_STREQ(loaded.books[0].title, "Redone");
+    EXPECT_NE(access(intent_path.c_str(), F_OK), 0);
+    ASSERT_EQ(db_close(&db), 0);
+
+    // A torn intent is dropped without touching the snapshot
+    file = std::fopen(intent_path.c_str(), "wb");
+    std::fwrite(&intent, sizeof(intent), 1, file);
+    std::fwrite(payload.data(), 1, payload.size() / 2, file);
+    std::fclose(file);
+
+    reopen();
+    EXPECT_EQ(loaded.book_count, 5);
+    EXPECT_NE(access(intent_path.c_str(), F_OK), 0);
+    ASSERT_EQ(db_close(&db), 0);
+}
+
+// ========== Lazy Description Tests ==========
+
+TEST_F(DbTest, LazyOpenReadsDescriptionsOnDemand) {
+    fill(300);
+    ASSERT_EQ(db_save(&lib, path.c_str()), 0);
+    ASSERT_EQ(db_open_lazy(path.c_str(), &loaded, 8), 0);
+    ASSERT_NE(loaded.descriptions, nullptr);
+
+    // Only the sections before the string heap are in memory
+    DbHeader header;
+    FILE *file = std::fopen(path.c_str(), "rb");
+    ASSERT_NE(file, nullptr);
+    ASSERT_EQ(std::fread(&header, sizeof(header), 1, file), 1u);
+    std::fclose(file);
+    EXPECT_EQ(loaded.view_size, header.string_offset);
+    EXPECT_EQ(loaded.descriptions->misses, 0u);
+
+    for (int i = 0; i < lib.book_count; i++) {
+        Book *original = &lib.books[i];
+        Book *copy = lb_find_book_by_isbn(&loaded, original->isbn);
+        ASSERT_NE(copy, nullptr);
+        EXPECT_EQ(copy->description, nullptr);
+
+        if (original->description) {
+            EXPECT_GE(book_description_ref(copy), 0);
+            EXPECT_STREQ(lb_get_book_description(&loaded, copy), original->description);
+        } else {
+            EXPECT_EQ(lb_get_book_description(&loaded, copy), nullptr);
+        }
+    }
+
+    EXPECT_EQ(loaded.descriptions->misses, 150u);
+    const char *first = lb_get_book_description(&loaded, &loaded.books[298]);
+    EXPECT_EQ(lb_get_book_description(&loaded, &loaded.books[298]), first);
+    EXPECT_GT(loaded.descriptions->hits, 0u);
+
+    int results[4];
+    int count = 0;
+    ASSERT_EQ(lb_search_books(&loaded, "book 42", results, 4, &count), 0);
+    EXPECT_EQ(count, 1);
+
+    // A changed description is held in memory like any other
+    ASSERT_EQ(lb_update_book_description(&loaded, "978-1000000", "changed"), 0);
+    Book *book = lb_find_book_by_isbn(&loaded, "978-1000000");
+    EXPECT_EQ(book_description_ref(book), -1);
+    EXPECT_STREQ(lb_get_book_description(&loaded, book), "changed");
+
+    // Saving over the open file keeps the other texts readable
+    ASSERT_EQ(db_save(&loaded, path.c_str()), 0);
+    EXPECT_STREQ(lb_get_book_description(&loaded, lb_find_book_by_isbn(&loaded, "978-1000002")),
+                 "Description of book 2");
+
+    lb_clear(&loaded);
+    EXPECT_EQ(loaded.descriptions, nullptr);
+    ASSERT_EQ(db_open_mmap(path.c_str(), &loaded), 0);
+    EXPECT_STREQ(lb_find_book_by_isbn(&loaded, "978-1000000")->description, "changed");
+    EXPECT_STREQ(lb_find_book_by_isbn(&loaded, "978-1000298")->description, "Description of book 298");
+}
+
+TEST_F(DbTest, ConcurrentLazyIndexingCopiesDescriptions) {
+    fill(300);
+    ASSERT_EQ(db_save(&lib, path.c_str()), 0);
+    ASSERT_EQ(db_open_lazy(path.c_str(), &loaded, 2), 0);
+    ASSERT_EQ(lb_set_concurrent(&loaded, 1), 0);
+
+    // Title changes read the description back for the text index while
+    // readers of other shards keep evicting the two cached texts
+    std::atomic<bool> done(false);
+    std::atomic<int> errors(0);
+    std::thread reader([&]() {
+        char *buffer = nullptr;
+        size_t capacity = 0;
+        char isbn[ISBN_SIZE];
+        for (int n = 0; !done.load(); n++) {
+            snprintf(isbn, sizeof(isbn), "978-%d", 1000000 + (n * 7 % 150) * 2);
+            lb_read_lock(&loaded, isbn);
+            const Book *book = lb_find_book_by_isbn(&loaded, isbn);
+            errors += !book || !lb_read_book_description(&loaded, book, &buffer, &capacity);
+            lb_read_unlock(&loaded, isbn);
+        }
+        free(buffer);
+    });
+
+    char isbn[ISBN_SIZE];
+    char title[32];
+    for (int n = 0; n < 600; n++) {
+        snprintf(isbn, sizeof(isbn), "978-%d", 1000000 + (n % 150) * 2);
+        snprintf(title, sizeof(title), "Title_%d", n);
+        errors += lb_update_book_title(&loaded, isbn, title) != 0;
+    }
+
+    done = true;
+    reader.join();
+    EXPECT_EQ(errors.load(), 0);
+
+    int results[4];
+    int count = 0;
+    ASSERT_EQ(lb_search_books(&loaded, "Description of book 298", results, 4, &count), 0);
+    ASSERT_EQ(count, 1);
+    EXPECT_STREQ(loaded.books[results[0]].title, "Title_599");
+}
+
+TEST_F(DbJournalTest, LazyDatabaseCheckpoints) {
+    ASSERT_EQ(db_open(&db, &lib, path.c_str(), nullptr), 0);
+    fill(40);
+    ASSERT_EQ(db_checkpoint(&db), 0);
+    ASSERT_EQ(db_close(&db), 0);
+
+    DbOptions options = { JOURNAL_SYNC_ALWAYS, 0, 4 };
+    reopen(&options);
+    ASSERT_NE(loaded.descriptions, nullptr);
+
+    // The rewritten record carries its description read back from the file
+    ASSERT_EQ(lb_update_book_title(&loaded, "978-1000010", "Retitled"), 0);
+    ASSERT_EQ(db_checkpoint(&db), 0);
+    ASSERT_EQ(db_close(&db), 0);
+
+    reopen();
+    Book *book = lb_find_book_by_isbn(&loaded, "978-1000010");
+    ASSERT_NE(book, nullptr);
+    EXPECT_STREQ(book->title, "Retitled");
+    EXPECT_STREQ(book->description, "Description of book 10");
+    ASSERT_EQ(db_close(&db), 0);
+}
+
+// ========== Background Snapshot Tests ==========
+
+TEST_F(DbTest, AsyncSnapshotSavesTheForkedImage) {
+    fill(2000);
+
+    DbSnapshotJob job;
+    ASSERT_EQ(db_snapshot_async(&lib, path.c_str(), &job), 0);
+    EXPECT_TRUE(job.running);
+
+    // Changes made while the child writes are not in the snapshot
+    ASSERT_EQ(lb_remove_book(&lib, "978-1000000"), 0);
+    ASSERT_EQ(lb_update_book_title(&lib, "978-1000001", "Changed"), 0);
+
+    ASSERT_EQ(db_snapshot_poll(&job, 1), 0);
+    EXPECT_FALSE(job.running);
+    EXPECT_EQ(job.status, 0);
+    EXPECT_GE(job.seconds, 0.0);
+
+    // Polling a finished job changes nothing
+    ASSERT_EQ(db_snapshot_poll(&job, 0), 0);
+    EXPECT_EQ(job.status, 0);
+
+    ASSERT_EQ(db_open_mmap(path.c_str(), &loaded), 0);
+    EXPECT_EQ(loaded.book_count, 2000);
+    ASSERT_NE(lb_find_book_by_isbn(&loaded, "978-1000000"), nullptr);
+    EXPECT_STREQ(lb_find_book_by_isbn(&loaded, "978-1000001")->title, "Title_1");
+}
+
+struct ParkedChange {
+    std::atomic<bool> inside{false};
+    std::atomic<bool> release{false};
+};
+
+// Holds a title change halfway, with the locks of the change taken
+static void park_change(void *ctx, const LibraryChange *change) {
+    auto *parked = static_cast<ParkedChange *>(ctx);
+
+    if (change->kind == LB_CHANGE_BOOK_TITLE) {
+        parked->inside = true;
+        while (!parked->release) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+TEST_F(DbTest, AsyncSnapshotWaitsForConcurrentChanges) {
+    fill(100);
+    ASSERT_EQ(lb_set_concurrent(&lib, 1), 0);
+
+    ParkedChange parked;
+    ASSERT_EQ(lb_set_change_hook(&lib, park_change, nullptr, &parked), 0);
+
+    std::thread writer([&]() {
+        EXPECT_EQ(lb_update_book_title(&lib, "978-1000001", "Changed"), 0);
+    });
+
+    while (!parked.inside) {
+        std::this_thread::yield();
+    }
+
+    DbSnapshotJob job;
+    std::atomic<bool> forked(false);
+    std::thread snapshot([&]() {
+        EXPECT_EQ(db_snapshot_async(&lib, path.c_str(), &job), 0);
+        forked = true;
+    });
+
+    // The fork must not copy the library while the change is halfway
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    EXPECT_FALSE(forked.load());
+
+    parked.release = true;
+    writer.join();
+    snapshot.join();
+
+    ASSERT_EQ(db_snapshot_poll(&job, 1), 0);
+    ASSERT_EQ(job.status, 0);
+    ASSERT_EQ(lb_set_change_hook(&lib, nullptr, nullptr, nullptr), 0);
+
+    ASSERT_EQ(db_open_mmap(path.c_str(), &loaded), 0);
+    EXPECT_EQ(loaded.book_count, 100);
+    ASSERT_NE(lb_find_book_by_isbn(&loaded, "978-1000001"), nullptr);
+    EXPECT_STREQ(lb_find_book_by_isbn(&loaded, "978-1000001")->title, "Changed");
+}
+
+TEST_F(DbTest, AsyncSnapshotReportsFailure) {
+    fill(10);
+
+    DbSnapshotJob job;
+    ASSERT_EQ(db_snapshot_async(&lib, "/nonexistent/dir/snapshot.db", &job), 0);
+
+    // Not waiting returns at once, the job finishes eventually
+    ASSERT_EQ(db_snapshot_poll(&job, 0), 0);
+    ASSERT_EQ(db_snapshot_poll(&job, 1), 0);
+    EXPECT_FALSE(job.running);
+    EXPECT_EQ(job.status, 1);
+
+    EXPECT_EQ(db_snapshot_async(nullptr, path.c_str(), &job), 1);
+}
+
+TEST_F(DbJournalTest, AsyncSnapshotKeepsOffTheDatabaseFile) {
+    ASSERT_EQ(db_open(&db, &lib, path.c_str(), nullptr), 0);
+    fill(20);
+    ASSERT_EQ(db_checkpoint(&db), 0);
+
+    // The snapshot checkpoints write into is refused, another file is not
+    DbSnapshotJob job;
+    EXPECT_EQ(db_snapshot_async(&lib, path.c_str(), &job), 1);
+
+    std::string copy = path + ".copy";
+    ASSERT_EQ(db_snapshot_async(&lib, copy.c_str(), &job), 0);
+    ASSERT_EQ(lb_update_book_title(&lib, "978-1000003", "Renamed"), 0);
+    ASSERT_EQ(db_checkpoint(&db), 0);
+    ASSERT_EQ(db_snapshot_poll(&job, 1), 0);
+    EXPECT_EQ(job.status, 0);
+    ASSERT_EQ(db_close(&db), 0);
+
+    reopen();
+    EXPECT_EQ(loaded.book_count, 20);
+    EXPECT_STREQ(lb_find_book_by_isbn(&loaded, "978-1000003")->title, "Renamed");
+    ASSERT_EQ(db_close(&db), 0);
+
+    Library copied;
+    ASSERT_EQ(lb_init(&copied), 0);
+    ASSERT_EQ(db_open_mmap(copy.c_str(), &copied), 0);
+    EXPECT_EQ(copied.book_count, 20);
+    EXPECT_STREQ(lb_find_book_by_isbn(&copied, "978-1000003")->title, "Title_3");
+    lb_free(&copied);
+    std::remove(copy.c_str());
+}
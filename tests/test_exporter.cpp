@@ -0,0 +1,187 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include "../include/io/exporter.h"
+#include "../include/io/importer.h"
+#include "log_dir.h"
+
+class ExporterTest : public ::testing::Test {
+protected:
+    Library lib;
+    Library loaded;
+    ExportStats stats;
+    std::string path;
+
+    void SetUp() override {
+        ASSERT_EQ(lb_init(&lib), 0);
+        ASSERT_EQ(lb_init(&loaded), 0);
+        path = ::testing::TempDir() + "exporter_test_" +
+               ::testing::UnitTest::GetInstance()->current_test_info()->name();
+    }
+
+    void TearDown() override {
+        lb_free(&lib);
+        lb_free(&loaded);
+        std::remove(path.c_str());
+        for (int i = 0; i < 8; i++) {
+            std::remove((path + "." + std::to_string(i)).c_str());
+        }
+    }
+
+    void add_book(const char *isbn, const char *title, int id, int year, const char *description) {
+        Book book;
+        book_init(&book);
+        book.id = id;
+        book.publication_year = year;
+        strcpy(book.isbn, isbn);
+        strcpy(book.title, title);
+        if (description) {
+            book_update_description(&book, description);
+        }
+        // The library takes over the description
+        ASSERT_EQ(lb_add_book(&lib, &book), 0);
+    }
+
+    static std::string read_file(const std::string &file) {
+        std::ifstream in(file, std::ios::binary);
+        std::stringstream content;
+        content << in.rdbuf();
+        return content.str();
+    }
+
+    // Every book of lib is in loaded with the same fields and names
+    void expect_same_books() {
+        ASSERT_EQ(loaded.book_count, lib.book_count);
+
+        for (int i = 0; i < lib.book_count; i++) {
+            Book *original = &lib.books[i];
+            Book *copy = lb_find_book_by_isbn(&loaded, original->isbn);
+            ASSERT_NE(copy, nullptr) << original->isbn;
+            EXPECT_STREQ(copy->title, original->title);
+            EXPECT_EQ(copy->id, original->id);
+            EXPECT_EQ(copy->publication_year, original->publication_year);
+            EXPECT_STREQ(copy->description ? copy->description : "",
+                         original->description ? original->description : "");
+
+            ASSERT_EQ(copy->author_count, original->author_count);
+            for (int a = 0; a < original->author_count; a++) {
+                EXPECT_STREQ(loaded.authors[book_get_author_ids(copy)[a] - 1].name,
+                             lib.authors[book_get_author_ids(original)[a] - 1].name);
+            }
+
+            ASSERT_EQ(copy->genre_count, original->genre_count);
+        }
+    }
+
+    void fill_tricky_catalog() {
+        ASSERT_EQ(lb_add_author(&lib, "Plain Author"), 0);
+        ASSERT_EQ(lb_add_author(&lib, "Comma, Author"), 0);
+        ASSERT_EQ(lb_add_genre(&lib, "Quote \"Genre\""), 0);
+
+        add_book("978-1", "Plain", 1, 1999, "Simple text");
+        add_book("978-2", "Comma, \"Quoted\"\nTitle", 2, -300, "Tab\there\r\nand \\ slash");
+        add_book("978-3", "No Description", 3, 0, nullptr);
+
+        ASSERT_EQ(lb_add_book_author(&lib, "978-1", 1), 0);
+        ASSERT_EQ(lb_add_book_author(&lib, "978-2", 2), 0);
+        ASSERT_EQ(lb_add_book_author(&lib, "978-2", 1), 0);
+        ASSERT_EQ(lb_add_book_genre(&lib, "978-2", 1), 0);
+    }
+};
+
+// ========== Round Trip Tests ==========
+
+TEST_F(ExporterTest, CsvRoundTrip) {
+    fill_tricky_catalog();
+
+    ASSERT_EQ(export_csv(&lib, path.c_str(), nullptr, &stats), 0);
+    EXPECT_EQ(stats.records, 3);
+
+    std::string text = read_file(path);
+    EXPECT_EQ(stats.bytes, text.size());
+    EXPECT_EQ(text.rfind("isbn,title,id,year,authors,genres,description\n978-1,Plain,1,1999,Plain Author,,", 0), 0u);
+
+    ImportStats imported;
+    ASSERT_EQ(import_file(&loaded, path.c_str(), nullptr, &imported), 0);
+    EXPECT_EQ(imported.errors, 0);
+    expect_same_books();
+    EXPECT_STREQ(loaded.genres[0].name, "Quote \"Genre\"");
+}
+
+TEST_F(ExporterTest, JsonLinesRoundTrip) {
+    fill_tricky_catalog();
+
+    ASSERT_EQ(export_jsonl(&lib, path.c_str(), nullptr, &stats), 0);
+    EXPECT_EQ(stats.records, 3);
+
+    std::string text = read_file(path);
+    EXPECT_NE(text.find("\"title\":\"Comma, \\\"Quoted\\\"\\nTitle\""), std::string::npos);
+    EXPECT_NE(text.find("\"authors\":[\"Comma, Author\",\"Plain Author\"]"), std::string::npos);
+
+    ImportStats imported;
+    ASSERT_EQ(import_file(&loaded, path.c_str(), nullptr, &imported), 0);
+    EXPECT_EQ(imported.errors, 0);
+    expect_same_books();
+}
+
+TEST_F(ExporterTest, EmptyLibraryWritesHeaderOnly) {
+    ASSERT_EQ(export_csv(&lib, path.c_str(), nullptr, &stats), 0);
+    EXPECT_EQ(stats.records, 0);
+    EXPECT_EQ(read_file(path), "isbn,title,id,year,authors,genres,description\n");
+
+    ASSERT_EQ(export_jsonl(&lib, path.c_str(), nullptr, &stats), 0);
+    EXPECT_EQ(read_file(path), "");
+}
+
+// ========== Parts Tests ==========
+
+TEST_F(ExporterTest, PartsSplitTheCatalog) {
+    ASSERT_EQ(lb_add_author(&lib, "Author"), 0);
+    for (int i = 0; i < 5000; i++) {
+        std::string isbn = "isbn-" + std::to_string(i);
+        add_book(isbn.c_str(), "A title long enough to span several write buffers", i, 2000, "Description");
+    }
+
+    ExportOptions options = { 4 };
+    ASSERT_EQ(export_jsonl(&lib, path.c_str(), &options, &stats), 0);
+    EXPECT_EQ(stats.records, 5000);
+
+    // Parts hold contiguous ranges in order
+    std::string all;
+    size_t bytes = 0;
+    for (int i = 0; i < 4; i++) {
+        std::string part = read_file(path + "." + std::to_string(i));
+        EXPECT_FALSE(part.empty());
+        bytes += part.size();
+        all += part;
+    }
+    EXPECT_EQ(stats.bytes, bytes);
+    EXPECT_LT(all.find("\"isbn-1249\""), all.find("\"isbn-1250\""));
+
+    ImportStats imported;
+    ASSERT_EQ(import_buffer(&loaded, all.data(), all.size(), nullptr, &imported), 0);
+    EXPECT_EQ(imported.records, 5000);
+    expect_same_books();
+}
+
+TEST_F(ExporterTest, CsvPartsEachHaveAHeader) {
+    add_book("978-1", "One", 1, 2001, nullptr);
+
+    ExportOptions options = { 3 };
+    ASSERT_EQ(export_csv(&lib, path.c_str(), &options, &stats), 0);
+
+    for (int i = 0; i < 3; i++) {
+        ImportStats imported;
+        ASSERT_EQ(import_file(&loaded, (path + "." + std::to_string(i)).c_str(), nullptr, &imported), 0);
+    }
+    EXPECT_EQ(loaded.book_count, 1);
+}
+
+TEST_F(ExporterTest, RejectsBadInput) {
+    EXPECT_EQ(export_csv(nullptr, path.c_str(), nullptr, nullptr), 1);
+    EXPECT_EQ(export_jsonl(&lib, nullptr, nullptr, nullptr), 1);
+    EXPECT_EQ(export_csv(&lib, "/nonexistent-dir/out.csv", nullptr, nullptr), 1);
+}
@@ -2,6 +2,7 @@
 #include <cstring>
 #include <vector>
 #include "../include/core/library.h"
+#include "log_dir.h"
 
 class GenreTest : public ::testing::Test {
 protected:
@@ -171,6 +172,60 @@ TEST_F(GenreTest, FindGenreByName) {
     EXPECT_EQ(lib.genres[found_index].id, 2);
 }
 
+TEST_F(GenreTest, FindOrAddGenreDeduplicates) {
+    int first = 0, second = 0, other = 0;
+
+    EXPECT_EQ(lb_find_or_add_genre(&lib, "Mistério", &first), 0);
+    EXPECT_EQ(lb_find_or_add_genre(&lib, "Romance", &other), 0);
+    EXPECT_EQ(lb_find_or_add_genre(&lib, "Mistério", &second), 0);
+
+    EXPECT_EQ(first, second);
+    EXPECT_NE(first, other);
+    EXPECT_EQ(lib.genre_count, 2);
+}
+
+TEST_F(GenreTest, UpdateGenreNameKeepsIndex) {
+    lb_add_genre(&lib, "Mistério");
+
+    EXPECT_EQ(lb_update_genre_name(&lib, 1, "Suspense"), 0);
+    EXPECT_EQ(lb_find_genre_by_name(&lib, "Mistério"), nullptr);
+    ASSERT_NE(lb_find_genre_by_name(&lib, "Suspense"), nullptr);
+    EXPECT_STREQ(lib.genres[0].name, "Suspense");
+}
+
+TEST_F(GenreTest, AddGenresBulkRejectsBadBatch) {
+    Genre genres[2];
+    memset(genres, 0, sizeof(genres));
+    genres[0].id = 1;
+    strcpy(genres[0].name, "Romance");
+    genres[1].id = 5;
+    strcpy(genres[1].name, "Mistério");
+
+    EXPECT_EQ(lb_add_genres_bulk(&lib, genres, 2), 1);
+
+    genres[1].id = 2;
+    strcpy(genres[1].name, "Romance");
+    EXPECT_EQ(lb_add_genres_bulk(&lib, genres, 2), 1);
+    EXPECT_EQ(lib.genre_count, 0);
+
+    strcpy(genres[1].name, "Mistério");
+    ASSERT_EQ(lb_add_genres_bulk(&lib, genres, 2), 0);
+    EXPECT_EQ(lb_add_genre(&lib, "Romance"), 1);
+    EXPECT_EQ(lb_update_genre_name(&lib, 2, "Suspense"), 0);
+    EXPECT_STREQ(lib.genres[1].name, "Suspense");
+}
+
+TEST_F(GenreTest, ClearResetsGenreIndex) {
+    lb_add_genre(&lib, "Mistério");
+    lb_clear(&lib);
+
+    EXPECT_EQ(lb_find_genre_by_name(&lib, "Mistério"), nullptr);
+
+    int genre_id = 0;
+    EXPECT_EQ(lb_find_or_add_genre(&lib, "Mistério", &genre_id), 0);
+    EXPECT_EQ(genre_id, 1);
+}
+
 // ========== Genre Clear Tests ==========
 
 TEST_F(GenreTest, ClearLibraryGenres) {
@@ -0,0 +1,184 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include "../include/io/importer.h"
+#include "log_dir.h"
+
+class ImporterTest : public ::testing::Test {
+protected:
+    Library lib;
+    ImportStats stats;
+
+    void SetUp() override {
+        ASSERT_EQ(lb_init(&lib), 0);
+    }
+
+    void TearDown() override {
+        lb_free(&lib);
+    }
+
+    int import(const std::string &text, int format = IMPORT_AUTO, int threads = 2, size_t chunk = 0) {
+        ImportOptions options = { format, threads, chunk };
+        return import_buffer(&lib, text.data(), text.size(), &options, &stats);
+    }
+
+    std::string author_of(const Book *book, int i) {
+        int id = book_get_author_ids(const_cast<Book *>(book))[i];
+        for (int a = 0; a < lib.author_count; a++) {
+            if (lib.authors[a].id == id) {
+                return lib.authors[a].name;
+            }
+        }
+        return "";
+    }
+};
+
+// ========== CSV Tests ==========
+
+TEST_F(ImporterTest, CsvRowsWithHeaderAndQuoting) {
+    std::string csv =
+        "isbn,title,id,year,authors,genres,description\n"
+        "978-1,Dune,1,1965,Frank Herbert,Science Fiction,\"Spice, sand\"\"worms\"\"\"\n"
+        "978-2,\"Multi\nLine\",2,1969,Ursula K. Le Guin; Frank Herbert,Fantasy;Science Fiction,\r\n"
+        "978-3,No Description,3,1970,,,\n";
+
+    ASSERT_EQ(import(csv), 0);
+    EXPECT_EQ(stats.records, 3);
+    EXPECT_EQ(stats.errors, 0);
+    ASSERT_EQ(lib.book_count, 3);
+    EXPECT_EQ(lib.author_count, 2);
+    EXPECT_EQ(lib.genre_count, 2);
+
+    Book *dune = lb_find_book_by_isbn(&lib, "978-1");
+    ASSERT_NE(dune, nullptr);
+    EXPECT_STREQ(dune->title, "Dune");
+    EXPECT_EQ(dune->publication_year, 1965);
+    EXPECT_STREQ(dune->description, "Spice, sand\"worms\"");
+
+    Book *multi = lb_find_book_by_isbn(&lib, "978-2");
+    ASSERT_NE(multi, nullptr);
+    EXPECT_STREQ(multi->title, "Multi\nLine");
+    ASSERT_EQ(multi->author_count, 2);
+    EXPECT_EQ(author_of(multi, 0), "Ursula K. Le Guin");
+    EXPECT_EQ(author_of(multi, 1), "Frank Herbert");
+    EXPECT_EQ(multi->genre_count, 2);
+    EXPECT_EQ(multi->description, nullptr);
+
+    EXPECT_EQ(lb_find_book_by_isbn(&lib, "978-3")->author_count, 0);
+}
+
+TEST_F(ImporterTest, CsvErrorRowsAreReportedBySourceLine) {
+    std::string csv =
+        "isbn,title,id,year\n"
+        "978-1,Good,1,2000\n"
+        ",Missing ISBN,2,2000\n"
+        "978-3,Bad Year,3,two thousand\n"
+        "\n"
+        "978-1,Duplicate,4,2000\n"
+        "978-5,Good Again,5,2001\n";
+
+    ASSERT_EQ(import(csv), 0);
+    EXPECT_EQ(stats.records, 2);
+    ASSERT_EQ(stats.errors, 3);
+    EXPECT_EQ(stats.error_rows[0], 3);
+    EXPECT_EQ(stats.error_rows[1], 4);
+    EXPECT_EQ(stats.error_rows[2], 6);
+    EXPECT_STREQ(lb_find_book_by_isbn(&lib, "978-1")->title, "Good");
+}
+
+// ========== JSON Lines Tests ==========
+
+TEST_F(ImporterTest, JsonLinesWithEscapesAndUnknownKeys) {
+    std::string jsonl =
+        "{\"isbn\":\"978-1\",\"title\":\"Caf\\u00e9 \\\"Noir\\\"\",\"id\":7,\"year\":1999,"
+        "\"authors\":[\"A. Writer\",\"B. Writer\"],\"genres\":\"Mystery\",\"description\":\"line\\nbreak\"}\n"
+        "{\"isbn\":\"978-2\",\"extra\":{\"nested\":[1,2,{\"x\":\"}\"}]},\"title\":null,\"year\":-5}\n"
+        "{\"isbn\":\"978-3\",\"title\":\"unterminated}\n"
+        "{\"title\":\"no isbn\"}\n"
+        "{\"isbn\":\"978-5\",\"year\":1.5}\n";
+
+    ASSERT_EQ(import(jsonl), 0);
+    EXPECT_EQ(stats.records, 2);
+    ASSERT_EQ(stats.errors, 3);
+    EXPECT_EQ(stats.error_rows[0], 3);
+    EXPECT_EQ(stats.error_rows[1], 4);
+    EXPECT_EQ(stats.error_rows[2], 5);
+
+    Book *first = lb_find_book_by_isbn(&lib, "978-1");
+    ASSERT_NE(first, nullptr);
+    EXPECT_STREQ(first->title, "Caf\xc3\xa9 \"Noir\"");
+    EXPECT_EQ(first->id, 7);
+    EXPECT_STREQ(first->description, "line\nbreak");
+    EXPECT_EQ(first->author_count, 2);
+    EXPECT_EQ(first->genre_count, 1);
+
+    Book *second = lb_find_book_by_isbn(&lib, "978-2");
+    ASSERT_NE(second, nullptr);
+    EXPECT_STREQ(second->title, "");
+    EXPECT_EQ(second->publication_year, -5);
+}
+
+// ========== Chunking Tests ==========
+
+TEST_F(ImporterTest, SmallChunksKeepOrderAndLineNumbers) {
+    std::string csv;
+    for (int i = 0; i < 2000; i++) {
+        // Quoted newlines must never be taken as a chunk boundary
+        csv += "978-" + std::to_string(i) + ",\"Title\n" + std::to_string(i) + "\",," +
+               std::to_string(1900 + i % 100) + ",Author " + std::to_string(i % 7) + ",Genre " +
+               std::to_string(i % 3) + ",\n";
+    }
+    csv += "978-bad,x,notanumber\n";
+
+    ASSERT_EQ(import(csv, IMPORT_CSV, 4, 512), 0);
+    EXPECT_EQ(stats.records, 2000);
+    ASSERT_EQ(stats.errors, 1);
+    EXPECT_EQ(stats.error_rows[0], 4001);
+    EXPECT_EQ(lib.author_count, 7);
+    EXPECT_EQ(lib.genre_count, 3);
+
+    // Books are added in input order
+    for (int i = 0; i < 2000; i += 97) {
+        std::string isbn = "978-" + std::to_string(i);
+        EXPECT_STREQ(lib.books[i].isbn, isbn.c_str());
+        EXPECT_EQ(lib.books[i].publication_year, 1900 + i % 100);
+    }
+}
+
+TEST_F(ImporterTest, SingleThreadMatchesParallel) {
+    std::string jsonl;
+    for (int i = 0; i < 500; i++) {
+        jsonl += "{\"isbn\":\"isbn-" + std::to_string(i) + "\",\"authors\":[\"Author " +
+                 std::to_string(i % 11) + "\"]}\n";
+    }
+
+    ASSERT_EQ(import(jsonl, IMPORT_AUTO, 1, 256), 0);
+    EXPECT_EQ(stats.records, 500);
+    EXPECT_EQ(lib.author_count, 11);
+    EXPECT_GT(stats.records_per_sec, 0.0);
+}
+
+TEST_F(ImporterTest, FileImport) {
+    std::string path = ::testing::TempDir() + "importer_test.csv";
+    FILE *file = std::fopen(path.c_str(), "w");
+    ASSERT_NE(file, nullptr);
+    std::fputs("978-1,From File,1,2020,Someone,Something,Text\n", file);
+    std::fclose(file);
+
+    ASSERT_EQ(import_file(&lib, path.c_str(), nullptr, &stats), 0);
+    EXPECT_EQ(stats.records, 1);
+    EXPECT_STREQ(lb_find_book_by_isbn(&lib, "978-1")->title, "From File");
+    std::remove(path.c_str());
+
+    EXPECT_EQ(import_file(&lib, path.c_str(), nullptr, &stats), 1);
+}
+
+TEST_F(ImporterTest, RejectsBadInput) {
+    EXPECT_EQ(import_buffer(nullptr, "x", 1, nullptr, nullptr), 1);
+    EXPECT_EQ(import_buffer(&lib, nullptr, 1, nullptr, nullptr), 1);
+    EXPECT_EQ(import_file(&lib, nullptr, nullptr, nullptr), 1);
+
+    EXPECT_EQ(import(""), 0);
+    EXPECT_EQ(stats.records, 0);
+}
@@ -0,0 +1,227 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include "../include/db/journal.h"
+#include "../include/db/crc32.h"
+#include "log_dir.h"
+
+static void collect(void *ctx, const void *data, size_t size) {
+    auto *entries = static_cast<std::vector<std::string> *>(ctx);
+    entries->emplace_back(static_cast<const char *>(data), size);
+}
+
+class JournalTest : public ::testing::Test {
+protected:
+    Journal journal;
+    std::string path;
+    std::vector<std::string> entries;
+
+    void SetUp() override {
+        path = ::testing::TempDir() + "journal_test_" +
+               ::testing::UnitTest::GetInstance()->current_test_info()->name() + ".wal";
+        std::remove(path.c_str());
+    }
+
+    void TearDown() override {
+        std::remove(path.c_str());
+    }
+
+    void append(const std::string &entry) {
+        uint64_t lsn = 0;
+        ASSERT_EQ(journal_append(&journal, entry.data(), entry.size(), &lsn), 0);
+        ASSERT_EQ(journal_wait(&journal, lsn), 0);
+    }
+
+    long file_size() {
+        FILE *file = std::fopen(path.c_str(), "rb");
+        if (!file) {
+            return -1;
+        }
+        std::fseek(file, 0, SEEK_END);
+        long size = std::ftell(file);
+        std::fclose(file);
+        return size;
+    }
+};
+
+// ========== CRC Tests ==========
+
+TEST(Crc32Test, KnownValue) {
+    EXPECT_EQ(crc32_update(0, "123456789", 9), 0xCBF43926u);
+    // Incremental updates match a single pass
+    EXPECT_EQ(crc32_update(crc32_update(0, "1234", 4), "56789", 5), 0xCBF43926u);
+}
+
+// ========== Append and Replay Tests ==========
+
+TEST_F(JournalTest, AppendAndReplay) {
+    ASSERT_EQ(journal_open(&journal, path.c_str(), 7, JOURNAL_SYNC_ALWAYS, 0), 0);
+    append("first");
+    append("");
+    append(std::string(5000, 'x'));
+    ASSERT_EQ(journal_close(&journal), 0);
+
+    int replayed = 0;
+    ASSERT_EQ(journal_replay(path.c_str(), 7, collect, &entries, &replayed), 0);
+    ASSERT_EQ(replayed, 3);
+    EXPECT_EQ(entries[0], "first");
+    EXPECT_EQ(entries[1], "");
+    EXPECT_EQ(entries[2].size(), 5000u);
+}
+
+TEST_F(JournalTest, ReopenKeepsEntriesOfSameSequence) {
+    ASSERT_EQ(journal_open(&journal, path.c_str(), 1, JOURNAL_SYNC_ALWAYS, 0), 0);
+    append("a");
+    ASSERT_EQ(journal_close(&journal), 0);
+
+    ASSERT_EQ(journal_open(&journal, path.c_str(), 1, JOURNAL_SYNC_ALWAYS, 0), 0);
+    append("b");
+    ASSERT_EQ(journal_close(&journal), 0);
+
+    ASSERT_EQ(journal_replay(path.c_str(), 1, collect, &entries, nullptr), 0);
+    ASSERT_EQ(entries.size(), 2u);
+    EXPECT_EQ(entries[1], "b");
+}
+
+TEST_F(JournalTest, MissingFileReplaysNothing) {
+    int replayed = -1;
+    EXPECT_EQ(journal_replay(path.c_str(), 0, collect, &entries, &replayed), 0);
+    EXPECT_EQ(replayed, 0);
+}
+
+TEST_F(JournalTest, TornTailIsCutOff) {
+    ASSERT_EQ(journal_open(&journal, path.c_str(), 0, JOURNAL_SYNC_ALWAYS, 0), 0);
+    append("kept");
+    append("torn entry");
+    ASSERT_EQ(journal_close(&journal), 0);
+
+    // Crash in the middle of the second entry
+    long full = file_size();
+    ASSERT_EQ(truncate(path.c_str(), full - 3), 0);
+
+    ASSERT_EQ(journal_replay(path.c_str(), 0, collect, &entries, nullptr), 0);
+    ASSERT_EQ(entries.size(), 1u);
+    EXPECT_EQ(entries[0], "kept");
+    EXPECT_EQ(file_size(), JOURNAL_HEADER_SIZE + JOURNAL_ENTRY_HEADER + 4);
+
+    // Appends continue after the last valid entry
+    ASSERT_EQ(journal_open(&journal, path.c_str(), 0, JOURNAL_SYNC_ALWAYS, 0), 0);
+    append("next");
+    ASSERT_EQ(journal_close(&journal), 0);
+
+    entries.clear();
+    ASSERT_EQ(journal_replay(path.c_str(), 0, collect, &entries, nullptr), 0);
+    ASSERT_EQ(entries.size(), 2u);
+    EXPECT_EQ(entries[1], "next");
+}
+
+TEST_F(JournalTest, CorruptedEntryStopsReplay) {
+    ASSERT_EQ(journal_open(&journal, path.c_str(), 0, JOURNAL_SYNC_ALWAYS, 0), 0);
+    append("good");
+    append("flipped");
+    append("after");
+    ASSERT_EQ(journal_close(&journal), 0);
+
+    FILE *file = std::fopen(path.c_str(), "r+b");
+    ASSERT_NE(file, nullptr);
+    std::fseek(file, JOURNAL_HEADER_SIZE + 2 * JOURNAL_ENTRY_HEADER + 4, SEEK_SET);
+    std::fputc('F', file);
+    std::fclose(file);
+
+    ASSERT_EQ(journal_replay(path.c_str(), 0, collect, &entries, nullptr), 0);
+    ASSERT_EQ(entries.size(), 1u);
+    EXPECT_EQ(entries[0], "good");
+}
+
+// ========== Sequence Tests ==========
+
+TEST_F(JournalTest, OtherSequenceIsNotReplayedAndReset) {
+    ASSERT_EQ(journal_open(&journal, path.c_str(), 3, JOURNAL_SYNC_ALWAYS, 0), 0);
+    append("old");
+    ASSERT_EQ(journal_close(&journal), 0);
+
+    ASSERT_EQ(journal_replay(path.c_str(), 4, collect, &entries, nullptr), 0);
+    EXPECT_TRUE(entries.empty());
+
+    ASSERT_EQ(journal_open(&journal, path.c_str(), 4, JOURNAL_SYNC_ALWAYS, 0), 0);
+    EXPECT_EQ(journal.file_size, (uint64_t)JOURNAL_HEADER_SIZE);
+    ASSERT_EQ(journal_close(&journal), 0);
+}
+
+TEST_F(JournalTest, ResetDropsEntries) {
+    ASSERT_EQ(journal_open(&journal, path.c_str(), 0, JOURNAL_SYNC_ALWAYS, 0), 0);
+    append("before");
+    ASSERT_EQ(journal_reset(&journal, 1), 0);
+    append("after");
+    ASSERT_EQ(journal_close(&journal), 0);
+
+    ASSERT_EQ(journal_replay(path.c_str(), 0, collect, &entries, nullptr), 0);
+    EXPECT_TRUE(entries.empty());
+
+    ASSERT_EQ(journal_replay(path.c_str(), 1, collect, &entries, nullptr), 0);
+    ASSERT_EQ(entries.size(), 1u);
+    EXPECT_EQ(entries[0], "after");
+}
+
+// ========== Group Commit Tests ==========
+
+TEST_F(JournalTest, ConcurrentCommitsShareSyncs) {
+    ASSERT_EQ(journal_open(&journal, path.c_str(), 0, JOURNAL_SYNC_ALWAYS, 0), 0);
+
+    const int threads = 8;
+    const int per_thread = 50;
+    std::vector<std::thread> workers;
+
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([this, t]() {
+            for (int i = 0; i < per_thread; i++) {
+                std::string entry = std::to_string(t) + ":" + std::to_string(i);
+                uint64_t lsn = 0;
+                EXPECT_EQ(journal_append(&journal, entry.data(), entry.size(), &lsn), 0);
+                EXPECT_EQ(journal_wait(&journal, lsn), 0);
+            }
+        });
+    }
+
+    for (auto &worker : workers) {
+        worker.join();
+    }
+
+    EXPECT_EQ(journal.durable_lsn, (uint64_t)(threads * per_thread));
+    EXPECT_LE(journal.sync_count, (uint64_t)(threads * per_thread));
+    ASSERT_EQ(journal_close(&journal), 0);
+
+    int replayed = 0;
+    ASSERT_EQ(journal_replay(path.c_str(), 0, collect, &entries, &replayed), 0);
+    EXPECT_EQ(replayed, threads * per_thread);
+}
+
+TEST_F(JournalTest, IntervalModeFlushesInBackground) {
+    ASSERT_EQ(journal_open(&journal, path.c_str(), 0, JOURNAL_SYNC_INTERVAL, 5), 0);
+
+    for (int i = 0; i < 100; i++) {
+        std::string entry = "entry " + std::to_string(i);
+        ASSERT_EQ(journal_append(&journal, entry.data(), entry.size(), nullptr), 0);
+    }
+
+    // Appends are batched: far fewer syncs than entries
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_GE(journal.sync_count, 1u);
+    EXPECT_LT(journal.sync_count, 100u);
+
+    ASSERT_EQ(journal_close(&journal), 0);
+    ASSERT_EQ(journal_replay(path.c_str(), 0, collect, &entries, nullptr), 0);
+    EXPECT_EQ(entries.size(), 100u);
+}
+
+TEST_F(JournalTest, RejectsBadInput) {
+    EXPECT_EQ(journal_open(nullptr, path.c_str(), 0, JOURNAL_SYNC_ALWAYS, 0), 1);
+    EXPECT_EQ(journal_open(&journal, nullptr, 0, JOURNAL_SYNC_ALWAYS, 0), 1);
+    EXPECT_EQ(journal_open(&journal, path.c_str(), 0, JOURNAL_SYNC_INTERVAL, 0), 1);
+    EXPECT_EQ(journal_replay(nullptr, 0, collect, &entries, nullptr), 1);
+    EXPECT_EQ(journal_replay(path.c_str(), 0, nullptr, nullptr, nullptr), 1);
+}
@@ -1,6 +1,12 @@
 #include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
 #include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
 #include "../include/core/library.h"
+#include "log_dir.h"
 
 class LibraryTest : public ::testing::Test {
 protected:
@@ -110,11 +116,12 @@ TEST_F(LibraryTest, AddAuthorNullPointer) {
 
 TEST_F(LibraryTest, AddBookSuccess) {
     Book book;
+    book_init(&book);
     book.id = 1;
     strcpy(book.title, "Foundation");
     strcpy(book.isbn, "978-8532511010");
     book.publication_year = 1951;
-    strcpy(book.description, "A masterpiece of science fiction");
+    book_update_description(&book, "A masterpiece of science fiction");
     book.genre_ids = nullptr;
     book.author_ids = nullptr;
     book.genre_count = 0;
@@ -142,11 +149,12 @@ TEST_F(LibraryTest, RemoveBookSuccess) {
     lb_add_genre(&lib, "Sci-Fi");
     
     Book book;
+    book_init(&book);
     book.id = 1;
     strcpy(book.title, "Foundation");
     strcpy(book.isbn, "978-8532511010");
     book.publication_year = 1951;
-    strcpy(book.description, "Test");
+    book_update_description(&book, "Test");
     book.genre_ids = (int*)malloc(2 * sizeof(int));
     book.author_ids = (int*)malloc(2 * sizeof(int));
     book.genre_capacity = 2;
@@ -170,11 +178,12 @@ TEST_F(LibraryTest, BookCapacityExpansion) {
     
     for (int i = 0; i < initial_capacity + 2; i++) {
         Book book;
+        book_init(&book);
         book.id = i + 1;
         snprintf(book.title, sizeof(book.title), "Book_%d", i);
         snprintf(book.isbn, sizeof(book.isbn), "978-%d", 1000000 + i);
         book.publication_year = 2020 + i;
-        strcpy(book.description, "Test book");
+        book_update_description(&book, "Test book");
         book.genre_ids = nullptr;
         book.author_ids = nullptr;
         book.genre_count = 0;
@@ -189,6 +198,1123 @@ TEST_F(LibraryTest, BookCapacityExpansion) {
     EXPECT_EQ(lib.book_count, initial_capacity + 2);
 }
 
+// ========== ISBN Index Tests ==========
+
+static void fill_book(Book *book, int i) {
+    memset(book, 0, sizeof(*book));
+    book->id = i + 1;
+    snprintf(book->title, sizeof(book->title), "Book_%d", i);
+    snprintf(book->isbn, sizeof(book->isbn), "978-%d", 1000000 + i);
+    book->publication_year = 2000 + i;
+}
+
+TEST_F(LibraryTest, FindBookByISBN) {
+    Book book;
+    for (int i = 0; i < 100; i++) {
+        fill_book(&book, i);
+        ASSERT_EQ(lb_add_book(&lib, &book), 0);
+    }
+
+    Book *found = lb_find_book_by_isbn(&lib, "978-1000042");
+    ASSERT_NE(found, nullptr);
+    EXPECT_STREQ(found->title, "Book_42");
+    EXPECT_EQ(lb_find_book_by_isbn(&lib, "978-9999999"), nullptr);
+}
+
+TEST_F(LibraryTest, AddBookDuplicatedISBN) {
+    Book book;
+    fill_book(&book, 0);
+    EXPECT_EQ(lb_add_book(&lib, &book), 0);
+    EXPECT_EQ(lb_add_book(&lib, &book), 1);
+    EXPECT_EQ(lib.book_count, 1);
+}
+
+TEST_F(LibraryTest, RemoveBookKeepsIndexConsistent) {
+    Book book;
+    for (int i = 0; i < 10; i++) {
+        fill_book(&book, i);
+        lb_add_book(&lib, &book);
+    }
+
+    EXPECT_EQ(lb_remove_book(&lib, "978-1000003"), 0);
+    EXPECT_EQ(lb_find_book_by_isbn(&lib, "978-1000003"), nullptr);
+
+    for (int i = 0; i < 10; i++) {
+        if (i == 3) continue;
+        fill_book(&book, i);
+        Book *found = lb_find_book_by_isbn(&lib, book.isbn);
+        ASSERT_NE(found, nullptr);
+        EXPECT_STREQ(found->title, book.title);
+    }
+}
+
+TEST_F(LibraryTest, UpdateBookISBN) {
+    Book book;
+    fill_book(&book, 0);
+    lb_add_book(&lib, &book);
+    fill_book(&book, 1);
+    lb_add_book(&lib, &book);
+
+    EXPECT_EQ(lb_update_book_isbn(&lib, "978-1000000", "978-2000000"), 0);
+    EXPECT_EQ(lb_find_book_by_isbn(&lib, "978-1000000"), nullptr);
+    ASSERT_NE(lb_find_book_by_isbn(&lib, "978-2000000"), nullptr);
+    EXPECT_EQ(lb_update_book_isbn(&lib, "978-2000000", "978-1000001"), 1);
+}
+
+TEST_F(LibraryTest, ClearResetsISBNIndex) {
+    Book book;
+    fill_book(&book, 0);
+    lb_add_book(&lib, &book);
+
+    lb_clear(&lib);
+    EXPECT_EQ(lb_find_book_by_isbn(&lib, book.isbn), nullptr);
+    EXPECT_EQ(lb_add_book(&lib, &book), 0);
+}
+
+// ========== Slot Map Tests ==========
+
+TEST_F(LibraryTest, HandleSurvivesOtherRemovals) {
+    Book book;
+    for (int i = 0; i < 10; i++) {
+        fill_book(&book, i);
+        lb_add_book(&lib, &book);
+    }
+
+    BookHandle handle;
+    ASSERT_EQ(lb_get_book_handle(&lib, "978-1000009", &handle), 0);
+
+    EXPECT_EQ(lb_remove_book(&lib, "978-1000000"), 0);
+    EXPECT_EQ(lb_remove_book(&lib, "978-1000005"), 0);
+    fill_book(&book, 20);
+    lb_add_book(&lib, &book);
+
+    Book *found = lb_get_book(&lib, handle);
+    ASSERT_NE(found, nullptr);
+    EXPECT_STREQ(found->isbn, "978-1000009");
+}
+
+TEST_F(LibraryTest, RemovedHandleIsStale) {
+    Book book;
+    fill_book(&book, 0);
+    lb_add_book(&lib, &book);
+
+    BookHandle handle;
+    ASSERT_EQ(lb_get_book_handle(&lib, book.isbn, &handle), 0);
+    EXPECT_EQ(lb_remove_book_by_handle(&lib, handle), 0);
+    EXPECT_EQ(lb_get_book(&lib, handle), nullptr);
+    EXPECT_EQ(lb_remove_book_by_handle(&lib, handle), 1);
+
+    // The slot is reused with a new generation
+    fill_book(&book, 1);
+    lb_add_book(&lib, &book);
+    BookHandle reused;
+    ASSERT_EQ(lb_get_book_handle(&lib, book.isbn, &reused), 0);
+    EXPECT_EQ(reused.slot, handle.slot);
+    EXPECT_NE(reused.generation, handle.generation);
+    EXPECT_EQ(lb_get_book(&lib, handle), nullptr);
+}
+
+TEST_F(LibraryTest, BooksStayDenseAfterRemoval) {
+    Book book;
+    for (int i = 0; i < 5; i++) {
+        fill_book(&book, i);
+        lb_add_book(&lib, &book);
+    }
+
+    EXPECT_EQ(lb_remove_book(&lib, "978-1000001"), 0);
+    ASSERT_EQ(lib.book_count, 4);
+
+    for (int i = 0; i < lib.book_count; i++) {
+        EXPECT_NE(lib.books[i].isbn[0], '\0');
+        EXPECT_EQ(lb_find_book_by_isbn(&lib, lib.books[i].isbn), &lib.books[i]);
+    }
+}
+
+TEST_F(LibraryTest, ClearInvalidatesHandles) {
+    Book book;
+    fill_book(&book, 0);
+    lb_add_book(&lib, &book);
+
+    BookHandle handle;
+    ASSERT_EQ(lb_get_book_handle(&lib, book.isbn, &handle), 0);
+    lb_clear(&lib);
+    EXPECT_EQ(lb_get_book(&lib, handle), nullptr);
+}
+
+// ========== String Arena Tests ==========
+
+TEST_F(LibraryTest, DescriptionMovedIntoArena) {
+    Book book;
+    fill_book(&book, 0);
+    book_update_description(&book, "A masterpiece of science fiction");
+
+    ASSERT_EQ(lb_add_book(&lib, &book), 0);
+    EXPECT_STREQ(lib.books[0].description, "A masterpiece of science fiction");
+    EXPECT_EQ(lib.books[0].description_capacity, 0);
+
+    EXPECT_EQ(lb_update_book_description(&lib, book.isbn, "Revised"), 0);
+    EXPECT_STREQ(lib.books[0].description, "Revised");
+    EXPECT_EQ(lb_update_book_description(&lib, "978-0", "Missing"), 1);
+}
+
+TEST_F(LibraryTest, RemovalCompactsArena) {
+    std::string text(1000, 'x');
+    Book book;
+
+    for (int i = 0; i < 200; i++) {
+        fill_book(&book, i);
+        text[0] = (char)('a' + i % 26);
+        book_update_description(&book, text.c_str());
+        ASSERT_EQ(lb_add_book(&lib, &book), 0);
+    }
+
+    size_t used_before = lib.strings.bytes_used;
+
+    for (int i = 0; i < 150; i++) {
+        fill_book(&book, i);
+        ASSERT_EQ(lb_remove_book(&lib, book.isbn), 0);
+    }
+
+    EXPECT_LT(lib.strings.bytes_used, used_before);
+
+    for (int i = 150; i < 200; i++) {
+        fill_book(&book, i);
+        Book *found = lb_find_book_by_isbn(&lib, book.isbn);
+        ASSERT_NE(found, nullptr);
+        text[0] = (char)('a' + i % 26);
+        EXPECT_STREQ(found->description, text.c_str());
+    }
+}
+
+// ========== ID Pool Tests ==========
+
+TEST_F(LibraryTest, AddBookPacksShortListsInline) {
+    Book book;
+    fill_book(&book, 0);
+    book.genre_ids = (int*)malloc(2 * sizeof(int));
+    book.genre_capacity = 2;
+    book_add_genre(&book, 7);
+
+    ASSERT_EQ(lb_add_book(&lib, &book), 0);
+    EXPECT_EQ(lib.books[0].genre_ids, nullptr);
+    EXPECT_EQ(book_get_genre_ids(&lib.books[0])[0], 7);
+}
+
+TEST_F(LibraryTest, CompactIdsIntoPool) {
+    Book book;
+    for (int i = 0; i < 10; i++) {
+        fill_book(&book, i);
+        for (int g = 1; g <= BOOK_INLINE_IDS + 2; g++) {
+            book_add_genre(&book, g + i);
+        }
+        book_add_author(&book, 1);
+        ASSERT_EQ(lb_add_book(&lib, &book), 0);
+    }
+
+    ASSERT_EQ(lb_compact_ids(&lib), 0);
+    EXPECT_EQ(lib.id_pool_size, 10 * (BOOK_INLINE_IDS + 2));
+
+    for (int i = 0; i < lib.book_count; i++) {
+        Book *stored = &lib.books[i];
+        EXPECT_EQ(stored->genre_capacity, 0);
+        EXPECT_GE(stored->genre_ids, lib.id_pool);
+        EXPECT_LT(stored->genre_ids, lib.id_pool + lib.id_pool_size);
+        EXPECT_EQ(book_get_author_ids(stored)[0], 1);
+    }
+
+    // Changing a pooled list copies it out first
+    Book *first = lb_find_book_by_isbn(&lib, "978-1000000");
+    ASSERT_NE(first, nullptr);
+    EXPECT_EQ(book_add_genre(first, 99), 0);
+    EXPECT_GT(first->genre_capacity, 0);
+    EXPECT_EQ(book_get_genre_ids(first)[BOOK_INLINE_IDS + 2], 99);
+    EXPECT_EQ(book_remove_genre(&lib.books[1], lib.books[1].genre_ids[0]), 0);
+
+    EXPECT_EQ(lb_remove_book(&lib, "978-1000005"), 0);
+}
+
+// ========== Postings Tests ==========
+
+TEST_F(LibraryTest, BooksByGenreAndAuthor) {
+    Book book;
+    for (int i = 4; i >= 0; i--) {
+        fill_book(&book, i);
+        book_add_genre(&book, 1 + i % 2);
+        book_add_author(&book, 3);
+        ASSERT_EQ(lb_add_book(&lib, &book), 0);
+    }
+
+    // Slots follow insertion: 978-1000004 got slot 0
+    int count = 0;
+    const int *slots = lb_books_by_genre(&lib, 1, &count);
+    ASSERT_EQ(count, 3);
+    EXPECT_STREQ(lb_get_book_by_slot(&lib, slots[0])->isbn, "978-1000004");
+    EXPECT_STREQ(lb_get_book_by_slot(&lib, slots[1])->isbn, "978-1000002");
+    EXPECT_STREQ(lb_get_book_by_slot(&lib, slots[2])->isbn, "978-1000000");
+
+    slots = lb_books_by_author(&lib, 3, &count);
+    ASSERT_EQ(count, 5);
+    for (int i = 0; i < count; i++) {
+        EXPECT_EQ(slots[i], i);
+    }
+
+    EXPECT_EQ(lb_books_by_genre(&lib, 42, &count), nullptr);
+    EXPECT_EQ(count, 0);
+    EXPECT_EQ(lb_get_book_by_slot(&lib, 5), nullptr);
+}
+
+TEST_F(LibraryTest, PostingsFollowBookChanges) {
+    Book book;
+    for (int i = 0; i < 3; i++) {
+        fill_book(&book, i);
+        book_add_genre(&book, 1);
+        ASSERT_EQ(lb_add_book(&lib, &book), 0);
+    }
+
+    int count = 0;
+    EXPECT_EQ(lb_remove_book(&lib, "978-1000001"), 0);
+    const int *slots = lb_books_by_genre(&lib, 1, &count);
+    ASSERT_EQ(count, 2);
+    EXPECT_STREQ(lb_get_book_by_slot(&lib, slots[0])->isbn, "978-1000000");
+    EXPECT_STREQ(lb_get_book_by_slot(&lib, slots[1])->isbn, "978-1000002");
+
+    EXPECT_EQ(lb_add_book_genre(&lib, "978-1000000", 2), 0);
+    EXPECT_EQ(lb_remove_book_genre(&lib, "978-1000002", 1), 0);
+    EXPECT_EQ(lb_add_book_author(&lib, "978-1000002", 5), 0);
+
+    slots = lb_books_by_genre(&lib, 1, &count);
+    ASSERT_EQ(count, 1);
+    EXPECT_STREQ(lb_get_book_by_slot(&lib, slots[0])->isbn, "978-1000000");
+    slots = lb_books_by_genre(&lib, 2, &count);
+    ASSERT_EQ(count, 1);
+    EXPECT_STREQ(lb_get_book_by_slot(&lib, slots[0])->isbn, "978-1000000");
+
+    // The id is not part of the postings
+    EXPECT_EQ(lb_update_book_id(&lib, "978-1000002", 10), 0);
+    slots = lb_books_by_author(&lib, 5, &count);
+    ASSERT_EQ(count, 1);
+    EXPECT_EQ(lb_get_book_by_slot(&lib, slots[0])->id, 10);
+
+    EXPECT_EQ(lb_remove_book_author(&lib, "978-1000002", 5), 0);
+    lb_books_by_author(&lib, 5, &count);
+    EXPECT_EQ(count, 0);
+
+    lb_clear(&lib);
+    lb_books_by_genre(&lib, 2, &count);
+    EXPECT_EQ(count, 0);
+}
+
+TEST_F(LibraryTest, PostingsTellBooksWithoutIdApart) {
+    // Books added from the CLI or an import row without id all have id 0
+    Book book;
+    for (int i = 0; i < 3; i++) {
+        fill_book(&book, i);
+        book.id = 0;
+        book_add_genre(&book, 1);
+        ASSERT_EQ(lb_add_book(&lib, &book), 0);
+    }
+
+    int count = 0;
+    const int *slots = lb_books_by_genre(&lib, 1, &count);
+    ASSERT_EQ(count, 3);
+    EXPECT_NE(slots[0], slots[1]);
+    EXPECT_NE(slots[1], slots[2]);
+
+    EXPECT_EQ(lb_remove_book(&lib, "978-1000000"), 0);
+    slots = lb_books_by_genre(&lib, 1, &count);
+    ASSERT_EQ(count, 2);
+    EXPECT_STREQ(lb_get_book_by_slot(&lib, slots[0])->isbn, "978-1000001");
+    EXPECT_STREQ(lb_get_book_by_slot(&lib, slots[1])->isbn, "978-1000002");
+}
+
+// ========== Text Search Tests ==========
+
+TEST_F(LibraryTest, SearchTitleIsbnAndDescription) {
+    Book book;
+    for (int i = 0; i < 50; i++) {
+        fill_book(&book, i);
+        if (i % 10 == 3) {
+            book_update_description(&book, "a story about dragons");
+        }
+        ASSERT_EQ(lb_add_book(&lib, &book), 0);
+    }
+
+    int results[64];
+    int count = 0;
+
+    ASSERT_EQ(lb_search_books(&lib, "dragon", results, 64, &count), 0);
+    ASSERT_EQ(count, 5);
+    for (int i = 0; i < count; i++) {
+        EXPECT_STREQ(lib.books[results[i]].description, "a story about dragons");
+    }
+
+    ASSERT_EQ(lb_search_books(&lib, "Book_42", results, 64, &count), 0);
+    ASSERT_EQ(count, 1);
+    EXPECT_STREQ(lb_book_title_at(&lib, results[0]), "Book_42");
+
+    ASSERT_EQ(lb_search_books(&lib, "978-1000007", results, 64, &count), 0);
+    ASSERT_EQ(count, 1);
+
+    // Short terms scan, results are capped
+    ASSERT_EQ(lb_search_books(&lib, "_4", results, 3, &count), 0);
+    EXPECT_EQ(count, 3);
+
+    ASSERT_EQ(lb_search_books(&lib, "unicorn", results, 64, &count), 0);
+    EXPECT_EQ(count, 0);
+}
+
+TEST_F(LibraryTest, SearchFollowsUpdatesAndRemoval) {
+    Book book;
+    for (int i = 0; i < 3; i++) {
+        fill_book(&book, i);
+        ASSERT_EQ(lb_add_book(&lib, &book), 0);
+    }
+
+    int results[8];
+    int count = 0;
+
+    EXPECT_EQ(lb_update_book_title(&lib, "978-1000000", "The Hobbit"), 0);
+    EXPECT_EQ(lb_update_book_description(&lib, "978-1000001", "hobbits everywhere"), 0);
+    EXPECT_EQ(lb_update_book_isbn(&lib, "978-1000002", "hob-1"), 0);
+
+    ASSERT_EQ(lb_search_books(&lib, "obbit", results, 8, &count), 0);
+    EXPECT_EQ(count, 2);
+    ASSERT_EQ(lb_search_books(&lib, "hob", results, 8, &count), 0);
+    EXPECT_EQ(count, 2);
+    ASSERT_EQ(lb_search_books(&lib, "Book_0", results, 8, &count), 0);
+    EXPECT_EQ(count, 0);
+
+    EXPECT_EQ(lb_remove_book(&lib, "978-1000001"), 0);
+    ASSERT_EQ(lb_search_books(&lib, "hobbits", results, 8, &count), 0);
+    EXPECT_EQ(count, 0);
+
+    // A reused slot must not inherit the old trigrams
+    fill_book(&book, 7);
+    ASSERT_EQ(lb_add_book(&lib, &book), 0);
+    ASSERT_EQ(lb_search_books(&lib, "Hobbit", results, 8, &count), 0);
+    ASSERT_EQ(count, 1);
+    EXPECT_STREQ(lb_book_title_at(&lib, results[0]), "The Hobbit");
+}
+
+// ========== Prefix Search Tests ==========
+
+TEST_F(LibraryTest, PrefixSearchTitlesAndAuthors) {
+    const char *titles[] = {"Dune", "Dracula", "the hobbit", "The Hunger Games", "Emma"};
+    Book book;
+    for (int i = 0; i < 5; i++) {
+        fill_book(&book, i);
+        strcpy(book.title, titles[i]);
+        ASSERT_EQ(lb_add_book(&lib, &book), 0);
+    }
+    lb_add_author(&lib, "Tolkien");
+    lb_add_author(&lib, "Dumas");
+
+    PrefixMatch results[8];
+    int count = 0;
+
+    ASSERT_EQ(lb_prefix_search(&lib, "th", 8, PREFIX_TITLES, results, &count), 0);
+    ASSERT_EQ(count, 2);
+    EXPECT_STREQ(results[0].text, "the hobbit");
+    EXPECT_STREQ(lb_book_title_at(&lib, results[1].index), "The Hunger Games");
+
+    ASSERT_EQ(lb_prefix_search(&lib, "du", 8, PREFIX_TITLES | PREFIX_AUTHORS, results, &count), 0);
+    ASSERT_EQ(count, 2);
+    EXPECT_EQ(results[0].kind, PREFIX_AUTHORS);
+    EXPECT_STREQ(results[0].text, "Dumas");
+    EXPECT_EQ(results[1].kind, PREFIX_TITLES);
+    EXPECT_STREQ(results[1].text, "Dune");
+
+    ASSERT_EQ(lb_prefix_search(&lib, "", 3, PREFIX_TITLES | PREFIX_AUTHORS, results, &count), 0);
+    EXPECT_EQ(count, 3);
+
+    ASSERT_EQ(lb_prefix_search(&lib, "x", 8, PREFIX_TITLES | PREFIX_AUTHORS, results, &count), 0);
+    EXPECT_EQ(count, 0);
+}
+
+TEST_F(LibraryTest, PrefixSearchSeesChanges) {
+    Book book;
+    fill_book(&book, 0);
+    ASSERT_EQ(lb_add_book(&lib, &book), 0);
+
+    PrefixMatch results[4];
+    int count = 0;
+
+    ASSERT_EQ(lb_prefix_search(&lib, "book", 4, PREFIX_TITLES, results, &count), 0);
+    EXPECT_EQ(count, 1);
+
+    EXPECT_EQ(lb_update_book_title(&lib, "978-1000000", "Anathem"), 0);
+    ASSERT_EQ(lb_prefix_search(&lib, "book", 4, PREFIX_TITLES, results, &count), 0);
+    EXPECT_EQ(count, 0);
+    ASSERT_EQ(lb_prefix_search(&lib, "ana", 4, PREFIX_TITLES, results, &count), 0);
+    EXPECT_EQ(count, 1);
+
+    lb_add_author(&lib, "Stephenson");
+    ASSERT_EQ(lb_prefix_search(&lib, "st", 4, PREFIX_AUTHORS, results, &count), 0);
+    EXPECT_EQ(count, 1);
+    lb_update_author_name(&lib, 1, "Neal Stephenson");
+    ASSERT_EQ(lb_prefix_search(&lib, "ne", 4, PREFIX_AUTHORS, results, &count), 0);
+    EXPECT_EQ(count, 1);
+
+    EXPECT_EQ(lb_remove_book(&lib, "978-1000000"), 0);
+    ASSERT_EQ(lb_prefix_search(&lib, "ana", 4, PREFIX_TITLES, results, &count), 0);
+    EXPECT_EQ(count, 0);
+}
+
+TEST_F(LibraryTest, PrefixIndexIsKeptSortedInPlace) {
+    Book book;
+    for (int i = 0; i < 200; i++) {
+        fill_book(&book, i);
+        ASSERT_EQ(lb_add_book(&lib, &book), 0);
+    }
+
+    PrefixMatch results[256];
+    int count = 0;
+    ASSERT_EQ(lb_prefix_search(&lib, "", 256, PREFIX_TITLES, results, &count), 0);
+
+    // Removals move the last book into the hole, retitles and adds land in
+    // the middle of the sorted run
+    for (int i = 0; i < 200; i += 3) {
+        ASSERT_EQ(lb_remove_book(&lib, ("978-" + std::to_string(1000000 + i)).c_str()), 0);
+    }
+    for (int i = 1; i < 200; i += 7) {
+        if (i % 3 == 0) {
+            continue;
+        }
+
+        std::string title = "Book_" + std::to_string(i % 10) + "_retitled";
+        ASSERT_EQ(lb_update_book_title(&lib, ("978-" + std::to_string(1000000 + i)).c_str(), title.c_str()), 0);
+    }
+    for (int i = 200; i < 230; i++) {
+        fill_book(&book, i);
+        ASSERT_EQ(lb_add_book(&lib, &book), 0);
+    }
+
+    EXPECT_EQ(lib.title_prefix.dirty, 0);
+
+    ASSERT_EQ(lb_prefix_search(&lib, "book_1", 256, PREFIX_TITLES, results, &count), 0);
+    int expected = 0;
+    for (int i = 0; i < lib.book_count; i++) {
+        expected += strncmp(lib.books[i].title, "Book_1", 6) == 0;
+    }
+    ASSERT_EQ(count, expected);
+
+    for (int i = 0; i < count; i++) {
+        EXPECT_EQ(results[i].text, lib.books[results[i].index].title);
+        if (i > 0) {
+            EXPECT_LE(strcmp(results[i - 1].text, results[i].text), 0);
+        }
+    }
+}
+
+TEST_F(LibraryTest, PrefixSearchSurvivesReserve) {
+    Book book;
+    fill_book(&book, 0);
+    ASSERT_EQ(lb_add_book(&lib, &book), 0);
+    lb_add_author(&lib, "Borges");
+
+    PrefixMatch results[4];
+    int count = 0;
+
+    ASSERT_EQ(lb_prefix_search(&lib, "b", 4, PREFIX_TITLES | PREFIX_AUTHORS, results, &count), 0);
+    EXPECT_EQ(count, 2);
+
+    // Books and authors move, the built index must not point at the old arrays
+    ASSERT_EQ(lb_reserve(&lib, 1000, 1000, 0), 0);
+    ASSERT_EQ(lb_prefix_search(&lib, "b", 4, PREFIX_TITLES | PREFIX_AUTHORS, results, &count), 0);
+    ASSERT_EQ(count, 2);
+    EXPECT_STREQ(results[0].text, "Book_0");
+    EXPECT_EQ(results[0].text, lib.books[0].title);
+    EXPECT_STREQ(results[1].text, "Borges");
+    EXPECT_EQ(results[1].text, lib.authors[0].name);
+}
+
+// ========== Bulk Insert Tests ==========
+
+TEST_F(LibraryTest, ReserveSizesExactly) {
+    ASSERT_EQ(lb_reserve(&lib, 100, 10, 5), 0);
+    EXPECT_EQ(lib.book_capacity, 100);
+    EXPECT_EQ(lib.author_capacity, 10);
+    EXPECT_EQ(lib.genre_capacity, 5);
+
+    // Never shrinks
+    ASSERT_EQ(lb_reserve(&lib, 1, 0, 0), 0);
+    EXPECT_EQ(lib.book_capacity, 100);
+
+    EXPECT_EQ(lb_reserve(&lib, -1, 0, 0), 1);
+}
+
+TEST_F(LibraryTest, AddBooksBulk) {
+    const int n = 1000;
+    std::vector<Book> books(n);
+    for (int i = 0; i < n; i++) {
+        fill_book(&books[i], i);
+        book_add_genre(&books[i], 1 + i % 3);
+        if (i % 100 == 0) {
+            book_update_description(&books[i], "bulk loaded");
+        }
+    }
+
+    ASSERT_EQ(lb_add_books_bulk(&lib, books.data(), n), 0);
+    EXPECT_EQ(lib.book_count, n);
+    EXPECT_EQ(lib.book_capacity, n);
+
+    Book *found = lb_find_book_by_isbn(&lib, "978-1000500");
+    ASSERT_NE(found, nullptr);
+    EXPECT_EQ(found->id, 501);
+    EXPECT_STREQ(found->description, "bulk loaded");
+
+    int count = 0;
+    lb_books_by_genre(&lib, 1, &count);
+    EXPECT_EQ(count, 334);
+
+    int results[16];
+    ASSERT_EQ(lb_search_books(&lib, "bulk", results, 16, &count), 0);
+    EXPECT_EQ(count, 10);
+}
+
+TEST_F(LibraryTest, AddBooksBulkRejectsBadBatch) {
+    Book books[3];
+    for (int i = 0; i < 3; i++) {
+        fill_book(&books[i], i);
+    }
+
+    // Duplicate inside the batch
+    strcpy(books[2].isbn, books[0].isbn);
+    EXPECT_EQ(lb_add_books_bulk(&lib, books, 3), 1);
+    EXPECT_EQ(lib.book_count, 0);
+
+    // Duplicate of a stored book
+    fill_book(&books[2], 2);
+    ASSERT_EQ(lb_add_book(&lib, &books[1]), 0);
+    EXPECT_EQ(lb_add_books_bulk(&lib, books, 3), 1);
+    EXPECT_EQ(lib.book_count, 1);
+
+    EXPECT_EQ(lb_add_books_bulk(&lib, books, 0), 0);
+    EXPECT_EQ(lb_add_books_bulk(&lib, nullptr, 2), 1);
+}
+
+// ========== Columnar Layout Tests ==========
+
+TEST_F(LibraryTest, ColumnarAccessorsMatchRows) {
+    Book book;
+    for (int i = 0; i < 20; i++) {
+        fill_book(&book, i);
+        lb_add_book(&lib, &book);
+    }
+
+    ASSERT_EQ(lb_set_columnar(&lib, 1), 0);
+
+    // Growth and removal after the columns are built
+    for (int i = 20; i < 40; i++) {
+        fill_book(&book, i);
+        lb_add_book(&lib, &book);
+    }
+    lb_remove_book(&lib, "978-1000003");
+    lb_update_book_isbn(&lib, "978-1000010", "978-3000000");
+    lb_update_book_year(&lib, "978-1000011", 1999);
+
+    for (int i = 0; i < lib.book_count; i++) {
+        EXPECT_EQ(lb_book_id_at(&lib, i), lib.books[i].id);
+        EXPECT_EQ(lb_book_year_at(&lib, i), lib.books[i].publication_year);
+        EXPECT_STREQ(lb_book_isbn_at(&lib, i), lib.books[i].isbn);
+        EXPECT_STREQ(lb_book_title_at(&lib, i), lib.books[i].title);
+    }
+}
+
+TEST_F(LibraryTest, CountBooksByYear) {
+    Book book;
+    for (int i = 0; i < 30; i++) {
+        fill_book(&book, i);
+        lb_add_book(&lib, &book);
+    }
+
+    EXPECT_EQ(lb_count_books_by_year(&lib, 2010, 2019), 10);
+
+    lb_set_columnar(&lib, 1);
+    EXPECT_EQ(lb_count_books_by_year(&lib, 2010, 2019), 10);
+    EXPECT_EQ(lb_count_books_by_year(&lib, 1900, 1950), 0);
+
+    lb_set_columnar(&lib, 0);
+    EXPECT_EQ(lb_count_books_by_year(&lib, 2000, 2029), 30);
+}
+
+// ========== Change Hook Tests ==========
+
+static void record_change(void *ctx, const LibraryChange *change) {
+    auto *kinds = static_cast<std::vector<int> *>(ctx);
+    kinds->push_back(change->kind);
+}
+
+TEST_F(LibraryTest, ChangeHookSeesSuccessfulChanges) {
+    std::vector<int> kinds;
+    ASSERT_EQ(lb_set_change_hook(&lib, record_change, nullptr, &kinds), 0);
+
+    Book book;
+    book_init(&book);
+    strcpy(book.title, "Hooked");
+    strcpy(book.isbn, "978-0000000001");
+    ASSERT_EQ(lb_add_book(&lib, &book), 0);
+    lb_add_genre(&lib, "Drama");
+    ASSERT_EQ(lb_update_book_year(&lib, "978-0000000001", 1999), 0);
+
+    // Failed changes are not reported
+    EXPECT_EQ(lb_remove_book(&lib, "missing"), 1);
+    ASSERT_EQ(lb_remove_book(&lib, "978-0000000001"), 0);
+
+    std::vector<int> expected = { LB_CHANGE_ADD_BOOK, LB_CHANGE_ADD_GENRE, LB_CHANGE_BOOK_YEAR,
+                                  LB_CHANGE_REMOVE_BOOK };
+    EXPECT_EQ(kinds, expected);
+
+    ASSERT_EQ(lb_set_change_hook(&lib, nullptr, nullptr, nullptr), 0);
+    lb_clear(&lib);
+    EXPECT_EQ(kinds.size(), expected.size());
+}
+
+struct CommitOrder {
+    Library *lib;
+    std::vector<std::string> seen;
+    int commits;
+};
+
+TEST_F(LibraryTest, ChangeHookRunsBeforeTheChangeAndCommitsAfter) {
+    Book book;
+    book_init(&book);
+    strcpy(book.title, "Before");
+    strcpy(book.isbn, "978-0000000001");
+    ASSERT_EQ(lb_add_book(&lib, &book), 0);
+
+    CommitOrder order = { &lib, {}, 0 };
+    ASSERT_EQ(lb_set_change_hook(&lib,
+                                 [](void *ctx, const LibraryChange *change) {
+                                     auto *o = static_cast<CommitOrder *>(ctx);
+                                     o->seen.push_back(lb_find_book_by_isbn(o->lib, change->isbn)->title);
+                                 },
+                                 [](void *ctx) { static_cast<CommitOrder *>(ctx)->commits++; }, &order), 0);
+
+    ASSERT_EQ(lb_update_book_title(&lib, "978-0000000001", "After"), 0);
+    ASSERT_EQ(lb_update_book_year(&lib, "978-0000000001", 2001), 0);
+
+    // The hook saw the library as it was, each call committed once
+    std::vector<std::string> expected = { "Before", "After" };
+    EXPECT_EQ(order.seen, expected);
+    EXPECT_EQ(order.commits, 2);
+
+    // Failed changes are neither reported nor committed
+    EXPECT_EQ(lb_update_book_year(&lib, "978-0000000001", 0), 1);
+    EXPECT_EQ(order.seen.size(), 2u);
+    EXPECT_EQ(order.commits, 2);
+
+    ASSERT_EQ(lb_set_change_hook(&lib, nullptr, nullptr, nullptr), 0);
+}
+
+// ========== Dirty Tracking Tests ==========
+
+TEST_F(LibraryTest, DirtySetsFollowChanges) {
+    lb_add_author(&lib, "Author");
+    Book book;
+    book_init(&book);
+    strcpy(book.isbn, "978-0000000001");
+    ASSERT_EQ(lb_add_book(&lib, &book), 0);
+    book_init(&book);
+    strcpy(book.isbn, "978-0000000002");
+    ASSERT_EQ(lb_add_book(&lib, &book), 0);
+
+    EXPECT_EQ(lib.dirty_books.count, 2);
+    EXPECT_EQ(lib.dirty_authors.count, 1);
+
+    lb_clear_dirty(&lib);
+    EXPECT_EQ(lib.dirty_books.count, 0);
+    EXPECT_FALSE(dirty_set_contains(&lib.dirty_books, 0));
+
+    // A book changed twice is listed once
+    ASSERT_EQ(lb_update_book_title(&lib, "978-0000000002", "One"), 0);
+    ASSERT_EQ(lb_add_book_author(&lib, "978-0000000002", 1), 0);
+    EXPECT_EQ(lib.dirty_books.count, 1);
+    EXPECT_TRUE(dirty_set_contains(&lib.dirty_books, 1));
+
+    // Removed books stay dirty so the checkpoint can drop their record
+    ASSERT_EQ(lb_remove_book(&lib, "978-0000000001"), 0);
+    EXPECT_TRUE(dirty_set_contains(&lib.dirty_books, 0));
+    EXPECT_EQ(lib.dirty_all, 0);
+
+    lb_clear(&lib);
+    EXPECT_EQ(lib.dirty_all, 1);
+    EXPECT_EQ(lib.dirty_books.count, 0);
+}
+
+// ========== Concurrent Mode Tests ==========
+
+TEST_F(LibraryTest, ConcurrentModeKeepsNestedChanges) {
+    EXPECT_EQ(lb_set_concurrent(nullptr, 1), 1);
+    ASSERT_EQ(lb_set_concurrent(&lib, 1), 0);
+    ASSERT_NE(lib.locks, nullptr);
+    EXPECT_EQ(lb_set_concurrent(&lib, 1), 0);
+
+    // Changes calling other lb_* changes run under the locks they hold
+    int first;
+    int second;
+    ASSERT_EQ(lb_find_or_add_author(&lib, "Asimov", &first), 0);
+    ASSERT_EQ(lb_find_or_add_author(&lib, "Asimov", &second), 0);
+    EXPECT_EQ(first, second);
+
+    Book books[40];
+    for (int i = 0; i < 40; i++) {
+        fill_book(&books[i], i);
+    }
+    ASSERT_EQ(lb_add_books_bulk(&lib, books, 20), 0);
+    for (int i = 20; i < 40; i++) {
+        ASSERT_EQ(lb_add_book(&lib, &books[i]), 0);
+    }
+
+    ASSERT_EQ(lb_update_book_description(&lib, "978-1000003", "Revised"), 0);
+    ASSERT_EQ(lb_remove_book(&lib, "978-1000004"), 0);
+    EXPECT_EQ(lib.book_count, 39);
+
+    int results[4];
+    int count;
+    lb_read_lock(&lib, nullptr);
+    ASSERT_EQ(lb_search_books(&lib, "Revised", results, 4, &count), 0);
+    ASSERT_EQ(count, 1);
+    EXPECT_STREQ(lib.books[results[0]].isbn, "978-1000003");
+    lb_read_unlock(&lib, nullptr);
+
+    lb_clear(&lib);
+    EXPECT_NE(lib.locks, nullptr);
+    ASSERT_EQ(lb_set_concurrent(&lib, 0), 0);
+    EXPECT_EQ(lib.locks, nullptr);
+}
+
+TEST_F(LibraryTest, ConcurrentReadersAndWriters) {
+    ASSERT_EQ(lb_set_concurrent(&lib, 1), 0);
+    lb_add_genre(&lib, "Drama");
+    lb_add_author(&lib, "Author");
+
+    Book book;
+    for (int i = 0; i < 200; i++) {
+        fill_book(&book, i);
+        ASSERT_EQ(lb_add_book(&lib, &book), 0);
+    }
+
+    std::atomic<bool> done(false);
+    std::atomic<int> errors(0);
+    std::vector<std::thread> readers;
+
+    // 95% reads of one book, 5% reads of the whole library
+    for (int t = 0; t < 4; t++) {
+        readers.emplace_back([&, t]() {
+            char isbn[ISBN_SIZE];
+            char title[32];
+            int results[16];
+            PrefixMatch matches[8];
+            int count;
+
+            for (int n = 0; !done.load(); n++) {
+                if (n % 20 == 0) {
+                    lb_read_lock(&lib, nullptr);
+                    lb_search_books(&lib, "Book_1", results, 16, &count);
+                    for (int k = 0; k < count; k++) {
+                        errors += strncmp(lib.books[results[k]].title, "Book_1", 6) != 0;
+                    }
+                    lb_prefix_search(&lib, "book_", 8, PREFIX_TITLES | PREFIX_AUTHORS, matches, &count);
+                    lb_books_by_genre(&lib, 1, &count);
+                    errors += lb_count_books_by_year(&lib, 0, 9999) != lib.book_count;
+                    lb_read_unlock(&lib, nullptr);
+                    continue;
+                }
+
+                int i = (n * 7 + t) % 400;
+                snprintf(isbn, sizeof(isbn), "978-%d", 1000000 + i);
+                snprintf(title, sizeof(title), "Book_%d", i);
+
+                lb_read_lock(&lib, isbn);
+                const Book *found = lb_find_book_by_isbn(&lib, isbn);
+                if (found) {
+                    errors += strcmp(found->isbn, isbn) != 0 || strncmp(found->title, title, strlen(title)) != 0;
+                }
+                lb_read_unlock(&lib, isbn);
+            }
+        });
+    }
+
+    // Books moving (adds and removes) and changes of single books at once
+    std::thread importer([&]() {
+        Book added;
+        for (int i = 200; i < 400; i++) {
+            fill_book(&added, i);
+            errors += lb_add_book(&lib, &added) != 0;
+
+            if (i % 4 == 0) {
+                char isbn[ISBN_SIZE];
+                snprintf(isbn, sizeof(isbn), "978-%d", 1000000 + (i - 200) / 4);
+                errors += lb_remove_book(&lib, isbn) != 0;
+            }
+        }
+    });
+
+    std::thread editor([&]() {
+        char isbn[ISBN_SIZE];
+        char text[32];
+        for (int n = 0; n < 1000; n++) {
+            int i = 50 + n % 150;
+            snprintf(isbn, sizeof(isbn), "978-%d", 1000000 + i);
+            snprintf(text, sizeof(text), "Book_%d v%d", i, n);
+
+            errors += lb_update_book_title(&lib, isbn, text) != 0;
+            errors += lb_update_book_year(&lib, isbn, 2000 + n) != 0;
+            errors += lb_update_book_description(&lib, isbn, "Revised") != 0;
+            if (n < 150) {
+                errors += lb_add_book_genre(&lib, isbn, 1) != 0;
+                errors += lb_add_book_author(&lib, isbn, 1) != 0;
+            }
+        }
+    });
+
+    importer.join();
+    editor.join();
+    done = true;
+    for (std::thread &reader : readers) {
+        reader.join();
+    }
+
+    EXPECT_EQ(errors.load(), 0);
+    EXPECT_EQ(lib.book_count, 350);
+
+    int count;
+    ASSERT_NE(lb_books_by_genre(&lib, 1, &count), nullptr);
+    EXPECT_EQ(count, 150);
+    EXPECT_EQ(lb_find_book_by_isbn(&lib, "978-1000049"), nullptr);
+    ASSERT_NE(lb_find_book_by_isbn(&lib, "978-1000199"), nullptr);
+    EXPECT_STREQ(lb_find_book_by_isbn(&lib, "978-1000199")->title, "Book_199 v899");
+}
+
+TEST_F(LibraryTest, ConcurrentAuthorsAreAddedOnce) {
+    ASSERT_EQ(lb_set_concurrent(&lib, 1), 0);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&, t]() {
+            char name[32];
+            for (int n = 0; n < 100; n++) {
+                int id;
+                snprintf(name, sizeof(name), "Author %d", n % 50);
+                EXPECT_EQ(lb_find_or_add_author(&lib, name, &id), 0);
+                snprintf(name, sizeof(name), "Genre %d", t);
+                EXPECT_EQ(lb_find_or_add_genre(&lib, name, &id), 0);
+            }
+        });
+    }
+
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_EQ(lib.author_count, 50);
+    EXPECT_EQ(lib.genre_count, 4);
+}
+
+TEST_F(LibraryTest, ConcurrentWritersOfOtherShardsRunTogether) {
+    ASSERT_EQ(lb_set_concurrent(&lib, 1), 0);
+
+    Book book;
+    for (int i = 0; i < 64; i++) {
+        fill_book(&book, i);
+        ASSERT_EQ(lb_add_book(&lib, &book), 0);
+    }
+
+    // Two books of different shards, picked as library.c shards ISBNs
+    auto shard_of = [](const char *isbn) { return (hash_index_hash(isbn) >> 16) % LB_LOCK_SHARDS; };
+    std::string first = lib.books[0].isbn;
+    std::string second;
+    for (int i = 1; i < lib.book_count && second.empty(); i++) {
+        if (shard_of(lib.books[i].isbn) != shard_of(first.c_str())) {
+            second = lib.books[i].isbn;
+        }
+    }
+    ASSERT_FALSE(second.empty());
+
+    // Each change waits in the hook (still holding its shard) for the
+    // other one to get there too
+    struct Meeting {
+        std::atomic<int> inside;
+        std::atomic<int> met;
+    } meeting;
+    meeting.inside = 0;
+    meeting.met = 0;
+
+    ASSERT_EQ(lb_set_change_hook(&lib,
+                                 [](void *ctx, const LibraryChange *) {
+                                     auto *m = static_cast<Meeting *>(ctx);
+                                     m->inside++;
+                                     for (int n = 0; n < 2000 && m->inside.load() < 2; n++) {
+                                         std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                                     }
+                                     m->met += m->inside.load() >= 2;
+                                 },
+                                 nullptr, &meeting), 0);
+
+    std::thread year([&]() { EXPECT_EQ(lb_update_book_year(&lib, first.c_str(), 1999), 0); });
+    std::thread title([&]() { EXPECT_EQ(lb_update_book_title(&lib, second.c_str(), "Met"), 0); });
+    year.join();
+    title.join();
+
+    EXPECT_EQ(meeting.met.load(), 2);
+    ASSERT_EQ(lb_set_change_hook(&lib, nullptr, nullptr, nullptr), 0);
+    EXPECT_EQ(lb_find_book_by_isbn(&lib, first.c_str())->publication_year, 1999);
+    EXPECT_STREQ(lb_find_book_by_isbn(&lib, second.c_str())->title, "Met");
+}
+
+TEST_F(LibraryTest, ConcurrentReadsNestPastAQueuedWriter) {
+    ASSERT_EQ(lb_set_concurrent(&lib, 1), 0);
+
+    Book book;
+    for (int i = 0; i < 8; i++) {
+        fill_book(&book, i);
+        ASSERT_EQ(lb_add_book(&lib, &book), 0);
+    }
+
+    // The writer queues on the shard the reader holds; the nested reads
+    // must not wait behind it
+    lb_read_lock(&lib, nullptr);
+    lb_read_lock(&lib, "978-1000003");
+
+    std::atomic<bool> written(false);
+    std::thread writer([&]() {
+        EXPECT_EQ(lb_update_book_title(&lib, "978-1000003", "Written"), 0);
+        written = true;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    lb_read_lock(&lib, "978-1000003");
+    lb_read_lock(&lib, nullptr);
+    EXPECT_STREQ(lb_find_book_by_isbn(&lib, "978-1000003")->title, "Book_3");
+    lb_read_unlock(&lib, nullptr);
+    lb_read_unlock(&lib, "978-1000003");
+
+    // Released out of order, the writer gets in after the last one
+    lb_read_unlock(&lib, nullptr);
+    EXPECT_FALSE(written.load());
+    lb_read_unlock(&lib, "978-1000003");
+
+    writer.join();
+    EXPECT_TRUE(written.load());
+    lb_read_lock(&lib, "978-1000003");
+    EXPECT_STREQ(lb_find_book_by_isbn(&lib, "978-1000003")->title, "Written");
+    lb_read_unlock(&lib, "978-1000003");
+}
+
+TEST_F(LibraryTest, ConcurrentDescriptionEditsCompactTheArena) {
+    ASSERT_EQ(lb_set_concurrent(&lib, 1), 0);
+
+    Book book;
+    for (int i = 0; i < 4; i++) {
+        fill_book(&book, i);
+        ASSERT_EQ(lb_add_book(&lib, &book), 0);
+    }
+
+    // Each edit leaves the old text behind as garbage
+    std::string text(1000, 'x');
+    for (int n = 0; n < 400; n++) {
+        text[0] = (char)('a' + n % 26);
+        ASSERT_EQ(lb_update_book_description(&lib, "978-1000001", text.c_str()), 0);
+    }
+
+    EXPECT_LT(string_arena_garbage(&lib.strings), (size_t)STRING_ARENA_BLOCK_SIZE + text.size() + 1);
+    EXPECT_STREQ(lb_find_book_by_isbn(&lib, "978-1000001")->description, text.c_str());
+}
+
+struct CommitWriter {
+    Library *lib;
+    std::thread writer;
+    std::atomic<bool> started{false};
+    std::atomic<bool> done{false};
+    bool waited_alone = false;
+};
+
+TEST_F(LibraryTest, ConcurrentCommitRunsWithoutLocks) {
+    ASSERT_EQ(lb_set_concurrent(&lib, 1), 0);
+
+    Book book;
+    fill_book(&book, 1);
+    ASSERT_EQ(lb_add_book(&lib, &book), 0);
+
+    // The commit hook starts a change of the same book and waits for it,
+    // which only gets through if the shard was released
+    CommitWriter commit;
+    commit.lib = &lib;
+    ASSERT_EQ(lb_set_change_hook(&lib, [](void *, const LibraryChange *) {},
+                                 [](void *ctx) {
+                                     auto *c = static_cast<CommitWriter *>(ctx);
+                                     if (c->started.exchange(true)) {
+                                         return;
+                                     }
+
+                                     c->writer = std::thread([c]() {
+                                         EXPECT_EQ(lb_update_book_id(c->lib, "978-1000001", 7), 0);
+                                         c->done = true;
+                                     });
+
+                                     for (int n = 0; n < 2000 && !c->done; n++) {
+                                         std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                                     }
+                                     c->waited_alone = c->done;
+                                 },
+                                 &commit), 0);
+
+    ASSERT_EQ(lb_update_book_year(&lib, "978-1000001", 1999), 0);
+    commit.writer.join();
+
+    EXPECT_TRUE(commit.waited_alone);
+    ASSERT_EQ(lb_set_change_hook(&lib, nullptr, nullptr, nullptr), 0);
+    EXPECT_EQ(lb_find_book_by_isbn(&lib, "978-1000001")->id, 7);
+}
+
+TEST_F(LibraryTest, ConcurrentBulkAddLetsReadersIn) {
+    ASSERT_EQ(lb_set_concurrent(&lib, 1), 0);
+
+    const int count = 5000;
+    std::vector<Book> books(count);
+    for (int i = 0; i < count; i++) {
+        fill_book(&books[i], i);
+    }
+
+    // A repeated ISBN anywhere in the batch still adds nothing
+    Book repeated = books[count - 1];
+    books[count - 1] = books[0];
+    EXPECT_EQ(lb_add_books_bulk(&lib, books.data(), count), 1);
+    EXPECT_EQ(lib.book_count, 0);
+    books[count - 1] = repeated;
+
+    std::atomic<bool> done(false);
+    std::atomic<int> errors(0);
+    std::thread reader([&]() {
+        int results[4];
+        int found;
+        while (!done.load()) {
+            lb_read_lock(&lib, nullptr);
+            // Chunks of 1024 books land whole
+            int seen = lib.book_count;
+            errors += seen % 1024 != 0 && seen != count;
+            errors += lb_search_books(&lib, "Book_1", results, 4, &found) != 0;
+            lb_read_unlock(&lib, nullptr);
+        }
+    });
+
+    EXPECT_EQ(lb_add_books_bulk(&lib, books.data(), count), 0);
+    done = true;
+    reader.join();
+
+    EXPECT_EQ(errors.load(), 0);
+    EXPECT_EQ(lib.book_count, count);
+
+    int results[4];
+    int found;
+    lb_read_lock(&lib, nullptr);
+    ASSERT_EQ(lb_search_books(&lib, "Book_4999", results, 4, &found), 0);
+    ASSERT_EQ(found, 1);
+    EXPECT_STREQ(lib.books[results[0]].isbn, "978-1004999");
+    lb_read_unlock(&lib, nullptr);
+}
+
 // ========== Library State Tests ==========
 
 TEST_F(LibraryTest, CompleteWorkflow) {
@@ -202,11 +1328,12 @@ TEST_F(LibraryTest, CompleteWorkflow) {
     
     // Add book
     Book book;
+    book_init(&book);
     book.id = 1;
     strcpy(book.title, "Foundation");
     strcpy(book.isbn, "978-8532511010");
     book.publication_year = 1951;
-    strcpy(book.description, "Masterpiece");
+    book_update_description(&book, "Masterpiece");
     book.genre_ids = (int*)malloc(2 * sizeof(int));
     book.author_ids = (int*)malloc(2 * sizeof(int));
     book.genre_capacity = 2;
@@ -220,9 +1347,6 @@ TEST_F(LibraryTest, CompleteWorkflow) {
     EXPECT_EQ(lib.genre_count, 2);
     EXPECT_EQ(lib.author_count, 2);
     EXPECT_EQ(lib.book_count, 1);
-    
-    free(book.genre_ids);
-    free(book.author_ids);
 }
 
 // ========== Memory Management Tests ==========
@@ -0,0 +1,513 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "../include/utils/log.h"
+#include "../include/utils/log_binary.h"
+#include "../include/utils/log_reader.h"
+#include "log_dir.h"
+
+class LogTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        log_reset();
+    }
+
+    void TearDown() override {
+        log_set_binary(0);
+    }
+
+    // The binary log rendered as text
+    static std::vector<std::string> decoded() {
+        log_flush();
+
+        std::vector<std::string> lines;
+        FILE *in = std::fopen(LOG_BINARY_FILE, "rb");
+        FILE *out = std::tmpfile();
+        if (!in || !out) {
+            ADD_FAILURE() << "cannot open the binary log";
+        } else {
+            EXPECT_EQ(log_decode(in, out), 0);
+            std::rewind(out);
+
+            char line[4096];
+            while (std::fgets(line, sizeof(line), out)) {
+                lines.push_back(std::string(line, std::strcspn(line, "\n")));
+            }
+        }
+
+        if (in) {
+            std::fclose(in);
+        }
+        if (out) {
+            std::fclose(out);
+        }
+        return lines;
+    }
+
+    // Lines of library.log holding marker
+    static std::vector<std::string> lines_with(const std::string &marker) {
+        log_flush();
+
+        std::vector<std::string> lines;
+        std::ifstream file("library.log");
+        std::string line;
+        while (std::getline(file, line)) {
+            if (line.find(marker) != std::string::npos) {
+                lines.push_back(line);
+            }
+        }
+        return lines;
+    }
+
+    // Lines printed by log_query
+    static std::vector<std::string> query(const char *path, const LogFilter *filter) {
+        std::vector<std::string> lines;
+        FILE *out = std::tmpfile();
+        if (!out) {
+            ADD_FAILURE() << "cannot create the output";
+            return lines;
+        }
+
+        long count = log_query(path, filter, out);
+        std::rewind(out);
+
+        char line[4096];
+        while (std::fgets(line, sizeof(line), out)) {
+            lines.push_back(std::string(line, std::strcspn(line, "\n")));
+        }
+
+        std::fclose(out);
+        EXPECT_EQ(count, (long)lines.size());
+        return lines;
+    }
+};
+
+// Log of `lines` lines, one per second from 10:00:00, with an index entry
+// every `stride` lines
+static void write_synthetic_log(const std::string &path, int lines, int stride) {
+    FILE *log = std::fopen(path.c_str(), "w");
+    FILE *index = std::fopen((path + LOG_INDEX_SUFFIX).c_str(), "wb");
+    ASSERT_NE(log, nullptr);
+    ASSERT_NE(index, nullptr);
+
+    time_t start;
+    ASSERT_EQ(log_parse_time("2026-01-01 10:00:00", &start), 0);
+
+    for (int i = 0; i < lines; i++) {
+        if (i > 0 && i % stride == 0) {
+            LogIndexEntry entry = { (int64_t)start + i - 1, (uint64_t)std::ftell(log) };
+            std::fwrite(&entry, sizeof(entry), 1, index);
+        }
+
+        std::fprintf(log, "2026-01-01 10:%02d:%02d | %s | src/%s:%d (f) | line %d\n", i / 60, i % 60,
+                     i % 10 == 0 ? "ERROR" : "INFO", i % 2 ? "core/library.c" : "db/db.c", i, i);
+    }
+
+    std::fclose(log);
+    std::fclose(index);
+}
+
+static void remove_synthetic_log(const std::string &path) {
+    std::remove(path.c_str());
+    std::remove((path + LOG_INDEX_SUFFIX).c_str());
+}
+
+TEST_F(LogTest, LinesKeepFormatAndOrder) {
+    for (int i = 0; i < 100; i++) {
+        LOG_INFO("ordered %d", i);
+    }
+    LOG_ERROR("failure %s", "here");
+
+    std::vector<std::string> lines = lines_with("ordered ");
+    ASSERT_EQ(lines.size(), 100u);
+    for (int i = 0; i < 100; i++) {
+        EXPECT_NE(lines[i].find("ordered " + std::to_string(i)), std::string::npos);
+    }
+
+    // YYYY-MM-DD HH:MM:SS | LEVEL | file:line (func) | message
+    const std::string &line = lines[0];
+    ASSERT_GT(line.size(), 22u);
+    EXPECT_EQ(line[4], '-');
+    EXPECT_EQ(line[13], ':');
+    EXPECT_EQ(line.substr(19, 10), " | INFO | ");
+    EXPECT_NE(line.find("test_log.cpp:"), std::string::npos);
+    EXPECT_NE(line.find("TestBody) | ordered 0"), std::string::npos);
+
+    std::vector<std::string> errors = lines_with("failure here");
+    ASSERT_EQ(errors.size(), 1u);
+    EXPECT_NE(errors[0].find(" | ERROR | "), std::string::npos);
+}
+
+TEST_F(LogTest, LongLinesAreCut) {
+    std::string text(4000, 'x');
+    LOG_INFO("long %s", text.c_str());
+
+    std::vector<std::string> lines = lines_with("long xxx");
+    ASSERT_EQ(lines.size(), 1u);
+    EXPECT_LT(lines[0].size(), 1024u);
+}
+
+TEST_F(LogTest, ConcurrentWritersKeepEveryLine) {
+    const int threads = 4;
+    const int per_thread = 5000;
+    unsigned long dropped = log_dropped();
+
+    std::vector<std::thread> writers;
+    for (int t = 0; t < threads; t++) {
+        writers.emplace_back([t]() {
+            for (int i = 0; i < per_thread; i++) {
+                LOG_INFO("concurrent %d %d", t, i);
+            }
+        });
+    }
+    for (std::thread &writer : writers) {
+        writer.join();
+    }
+
+    // Every line is either written whole or counted as dropped
+    std::vector<std::string> lines = lines_with("concurrent ");
+    EXPECT_EQ(lines.size() + (log_dropped() - dropped), (size_t)(threads * per_thread));
+    for (const std::string &line : lines) {
+        EXPECT_EQ(line.find("concurrent "), line.rfind("concurrent "));
+    }
+}
+
+TEST_F(LogTest, ForkedChildLogsSynchronously) {
+    LOG_INFO("before %s", "fork");
+
+    pid_t pid = fork();
+    ASSERT_GE(pid, 0);
+    if (pid == 0) {
+        // No writer thread here and no exit handlers after _exit
+        LOG_INFO("from %s", "child");
+        _exit(0);
+    }
+
+    int status = 0;
+    ASSERT_EQ(waitpid(pid, &status, 0), pid);
+    EXPECT_EQ(lines_with("from child").size(), 1u);
+    EXPECT_EQ(lines_with("before fork").size(), 1u);
+}
+
+TEST_F(LogTest, ResetEmptiesTheFile) {
+    LOG_INFO("stale %d", 1);
+    log_reset();
+    LOG_INFO("fresh %d", 2);
+
+    EXPECT_TRUE(lines_with("stale 1").empty());
+    EXPECT_EQ(lines_with("fresh 2").size(), 1u);
+}
+
+static int evaluated = 0;
+
+static int count_evaluation() {
+    return ++evaluated;
+}
+
+TEST_F(LogTest, RuntimeLevelSkipsArguments) {
+    EXPECT_EQ(log_get_level(LOG_MODULE_OTHER), LOG_DEFAULT_LEVEL);
+    ASSERT_EQ(log_set_level(LOG_MODULE_OTHER, LOG_LEVEL_WARN), 0);
+
+    evaluated = 0;
+    LOG_INFO("quiet %d", count_evaluation());
+    LOG_WARN("loud %d", count_evaluation());
+    EXPECT_EQ(evaluated, 1);
+    EXPECT_TRUE(lines_with("quiet ").empty());
+    ASSERT_EQ(lines_with("loud ").size(), 1u);
+    EXPECT_NE(lines_with("loud ")[0].find(" | WARN | "), std::string::npos);
+
+    // Other modules keep their own level
+    EXPECT_EQ(log_get_level(LOG_MODULE_CORE), LOG_DEFAULT_LEVEL);
+
+    ASSERT_EQ(log_set_level(LOG_MODULE_ALL, LOG_LEVEL_TRACE), 0);
+    LOG_TRACE("trace %d", 1);
+    EXPECT_EQ(lines_with("trace 1").size(), 1u);
+    EXPECT_EQ(log_get_level(LOG_MODULE_DB), LOG_LEVEL_TRACE);
+
+    EXPECT_EQ(log_set_level(LOG_MODULE_COUNT, LOG_LEVEL_INFO), 1);
+    EXPECT_EQ(log_set_level(LOG_MODULE_CORE, LOG_LEVEL_OFF + 1), 1);
+    EXPECT_EQ(log_get_level(LOG_MODULE_COUNT), -1);
+    ASSERT_EQ(log_set_level(LOG_MODULE_ALL, LOG_DEFAULT_LEVEL), 0);
+}
+
+// Message part of a rendered line
+static std::string message_of(const std::string &line) {
+    size_t at = line.find(") | ");
+    return at == std::string::npos ? "" : line.substr(at + 4);
+}
+
+TEST_F(LogTest, BinaryLogDecodesToText) {
+    ASSERT_EQ(log_set_binary(1), 0);
+
+    size_t size = 12345;
+    long long big = -9000000000LL;
+    const char *missing = nullptr;
+    LOG_INFO("Book Added - %s", "978-0441013593");
+    LOG_INFO("ints %d %u %x %05d %-4d| %hhu", -7, 7u, 255, 42, 3, 300);
+    LOG_WARN("wide %ld %lld %zu %jd", -5L, big, size, (intmax_t)77);
+    LOG_ERROR("real %.2f %e %% %c", 3.14159, 0.5, 'z');
+    LOG_INFO("stars %*d|%-*s|%.*s", 6, 9, 4, "ab", 3, "abcdef");
+    LOG_INFO("null %s", missing);
+    LOG_INFO("plain");
+
+    std::vector<std::string> lines = decoded();
+    ASSERT_EQ(lines.size(), 7u);
+    EXPECT_EQ(message_of(lines[0]), "Book Added - 978-0441013593");
+    EXPECT_EQ(message_of(lines[1]), "ints -7 7 ff 00042 3   | 44");
+    EXPECT_EQ(message_of(lines[2]), "wide -5 -9000000000 12345 77");
+
+    char expected[128];
+    std::snprintf(expected, sizeof(expected), "real %.2f %e %% %c", 3.14159, 0.5, 'z');
+    EXPECT_EQ(message_of(lines[3]), expected);
+    EXPECT_EQ(message_of(lines[4]), "stars      9|ab  |abc");
+    EXPECT_EQ(message_of(lines[5]), "null (null)");
+    EXPECT_EQ(message_of(lines[6]), "plain");
+
+    // Same layout as library.log
+    EXPECT_EQ(lines[0].substr(19, 10), " | INFO | ");
+    EXPECT_NE(lines[0].find("test_log.cpp:"), std::string::npos);
+    EXPECT_NE(lines[3].find(" | ERROR | "), std::string::npos);
+
+    // Nothing went to the text log
+    EXPECT_TRUE(lines_with("Book Added").empty());
+}
+
+TEST_F(LogTest, BinaryLogKeepsEveryThread) {
+    ASSERT_EQ(log_set_binary(1), 0);
+
+    std::vector<std::thread> writers;
+    for (int t = 0; t < 4; t++) {
+        writers.emplace_back([t]() {
+            for (int i = 0; i < 3000; i++) {
+                LOG_INFO("binary %d %d %s", t, i, "payload");
+            }
+        });
+    }
+    for (std::thread &writer : writers) {
+        writer.join();
+    }
+
+    // Thread buffers are written as threads exit, the rest on flush
+    LOG_INFO("binary main %d", 1);
+    std::vector<std::string> lines = decoded();
+    EXPECT_EQ(lines.size(), 4u * 3000u + 1u);
+    EXPECT_EQ(message_of(lines.back()), "binary main 1");
+}
+
+TEST_F(LogTest, BinaryLogSurvivesReset) {
+    ASSERT_EQ(log_set_binary(1), 0);
+    for (int i = 0; i < 3; i++) {
+        LOG_INFO("before reset %d", i);
+    }
+
+    // Sites are declared again in the restarted file
+    log_reset();
+    for (int i = 0; i < 3; i++) {
+        LOG_INFO("before reset %d", i);
+    }
+
+    std::vector<std::string> lines = decoded();
+    ASSERT_EQ(lines.size(), 3u);
+    EXPECT_EQ(message_of(lines[2]), "before reset 2");
+}
+
+TEST_F(LogTest, DecoderRejectsDamagedLogs) {
+    FILE *in = std::tmpfile();
+    FILE *out = std::tmpfile();
+    ASSERT_NE(in, nullptr);
+    ASSERT_NE(out, nullptr);
+
+    std::fputs("not a log", in);
+    std::rewind(in);
+    EXPECT_EQ(log_decode(in, out), 1);
+
+    // An entry of a site never declared
+    std::rewind(in);
+    std::fwrite(LOG_BINARY_MAGIC, 1, LOG_BINARY_MAGIC_SIZE, in);
+    const unsigned char entry[15] = { LOG_RECORD_ENTRY, 7, 0, 0, 0 };
+    std::fwrite(entry, 1, sizeof(entry), in);
+    std::rewind(in);
+    EXPECT_EQ(log_decode(in, out), 1);
+
+    std::fclose(in);
+    std::fclose(out);
+    EXPECT_EQ(log_decode(nullptr, nullptr), 1);
+}
+
+TEST_F(LogTest, FormatKinds) {
+    unsigned char kinds[LOG_MAX_ARGS];
+    ASSERT_EQ(log_format_kinds("%d %s %zu %*.*f %p %%", kinds, LOG_MAX_ARGS), 7);
+    EXPECT_EQ(kinds[0], LOG_ARG_INT);
+    EXPECT_EQ(kinds[1], LOG_ARG_STRING);
+    EXPECT_EQ(kinds[2], LOG_ARG_SIZE);
+    EXPECT_EQ(kinds[3], LOG_ARG_INT);
+    EXPECT_EQ(kinds[5], LOG_ARG_DOUBLE);
+    EXPECT_EQ(kinds[6], LOG_ARG_POINTER);
+
+    EXPECT_EQ(log_format_kinds("%n", kinds, LOG_MAX_ARGS), -1);
+    EXPECT_EQ(log_format_kinds("%Lf", kinds, LOG_MAX_ARGS), -1);
+    EXPECT_EQ(log_format_kinds("%1$d", kinds, LOG_MAX_ARGS), -1);
+    EXPECT_EQ(log_format_kinds("%d %d", kinds, 1), -1);
+}
+
+TEST_F(LogTest, ParseTime) {
+    time_t second;
+    time_t day;
+    ASSERT_EQ(log_parse_time("2026-03-04 05:06:07", &second), 0);
+    ASSERT_EQ(log_parse_time("2026-03-04", &day), 0);
+    EXPECT_EQ(second - day, 5 * 3600 + 6 * 60 + 7);
+
+    EXPECT_EQ(log_parse_time("2026-13-01", &second), 1);
+    EXPECT_EQ(log_parse_time("2026-03-04 05:06", &second), 1);
+    EXPECT_EQ(log_parse_time("2026-03-04 05:06:07 trailing", &second), 1);
+    EXPECT_EQ(log_parse_time("yesterday", &second), 1);
+    EXPECT_EQ(log_parse_time(nullptr, &second), 1);
+}
+
+TEST_F(LogTest, QueryFiltersLevelAndFile) {
+    LOG_INFO("query info %d", 1);
+    LOG_WARN("query warn %d", 2);
+    LOG_ERROR("query error %d", 3);
+    log_flush();
+
+    LogFilter filter = { LOG_LEVEL_WARN, 0, 0, nullptr, 0 };
+    std::vector<std::string> lines = query(LOG_FILE, &filter);
+    ASSERT_EQ(lines.size(), 2u);
+    EXPECT_EQ(message_of(lines[0]), "query warn 2");
+    EXPECT_EQ(message_of(lines[1]), "query error 3");
+
+    // Source files match by base name or whole path
+    filter = { LOG_LEVEL_TRACE, 0, 0, "test_log.cpp", 0 };
+    EXPECT_EQ(query(LOG_FILE, &filter).size(), 3u);
+    filter.file = __FILE__;
+    EXPECT_EQ(query(LOG_FILE, &filter).size(), 3u);
+    filter.file = "log.cpp";
+    EXPECT_TRUE(query(LOG_FILE, &filter).empty());
+
+    EXPECT_EQ(query(LOG_FILE, nullptr).size(), 3u);
+    EXPECT_EQ(log_query("missing.log", nullptr, stdout), -1);
+}
+
+TEST_F(LogTest, QueryTimeWindowFollowsTheIndex) {
+    const std::string path = "query_window.log";
+    write_synthetic_log(path, 600, 50);
+
+    LogFilter filter = { LOG_LEVEL_TRACE, 0, 0, nullptr, 0 };
+    ASSERT_EQ(log_parse_time("2026-01-01 10:05:00", &filter.from), 0);
+    ASSERT_EQ(log_parse_time("2026-01-01 10:05:09", &filter.to), 0);
+
+    std::vector<std::string> lines = query(path.c_str(), &filter);
+    ASSERT_EQ(lines.size(), 10u);
+    EXPECT_EQ(message_of(lines[0]), "line 300");
+    EXPECT_EQ(message_of(lines[9]), "line 309");
+
+    filter.level = LOG_LEVEL_ERROR;
+    filter.file = "db.c";
+    lines = query(path.c_str(), &filter);
+    ASSERT_EQ(lines.size(), 1u);
+    EXPECT_EQ(message_of(lines[0]), "line 300");
+
+    // Lines before the indexed offset are not read: an out of order line
+    // there is never found
+    FILE *log = std::fopen(path.c_str(), "r+");
+    ASSERT_NE(log, nullptr);
+    std::fputs("2026-01-01 10:05:05", log);
+    std::fclose(log);
+
+    filter = { LOG_LEVEL_TRACE, 0, 0, nullptr, 0 };
+    ASSERT_EQ(log_parse_time("2026-01-01 10:05:05", &filter.from), 0);
+    filter.to = filter.from;
+    lines = query(path.c_str(), &filter);
+    ASSERT_EQ(lines.size(), 1u);
+    EXPECT_EQ(message_of(lines[0]), "line 305");
+
+    remove_synthetic_log(path);
+}
+
+TEST_F(LogTest, QueryTailSpansRotatedFiles) {
+    const std::string path = "query_tail.log";
+    write_synthetic_log(path + ".1", 100, 50);
+    write_synthetic_log(path, 3, 50);
+
+    LogFilter filter = { LOG_LEVEL_TRACE, 0, 0, nullptr, 5 };
+    std::vector<std::string> lines = query(path.c_str(), &filter);
+    ASSERT_EQ(lines.size(), 5u);
+    EXPECT_EQ(message_of(lines[0]), "line 98");
+    EXPECT_EQ(message_of(lines[1]), "line 99");
+    EXPECT_EQ(message_of(lines[4]), "line 2");
+
+    // Oldest first without a tail
+    lines = query(path.c_str(), nullptr);
+    ASSERT_EQ(lines.size(), 103u);
+    EXPECT_EQ(message_of(lines[0]), "line 0");
+    EXPECT_EQ(message_of(lines[100]), "line 0");
+
+    filter = { LOG_LEVEL_ERROR, 0, 0, nullptr, 3 };
+    lines = query(path.c_str(), &filter);
+    ASSERT_EQ(lines.size(), 3u);
+    EXPECT_EQ(message_of(lines[0]), "line 80");
+    EXPECT_EQ(message_of(lines[1]), "line 90");
+    EXPECT_EQ(message_of(lines[2]), "line 0");
+
+    remove_synthetic_log(path + ".1");
+    remove_synthetic_log(path);
+}
+
+TEST_F(LogTest, LogRotatesBySize) {
+    ASSERT_EQ(log_set_rotation(LOG_INDEX_STRIDE, 2), 0);
+    EXPECT_EQ(log_set_rotation(LOG_INDEX_STRIDE, LOG_ROTATE_MAX_KEEP + 1), 1);
+
+    const std::string padding(200, 'x');
+    for (int i = 0; i < 3000; i++) {
+        LOG_INFO("rotated %d %s", i, padding.c_str());
+        if (i % 100 == 0) {
+            log_flush();
+        }
+    }
+    log_flush();
+
+    ASSERT_EQ(access(LOG_FILE ".1", F_OK), 0);
+    ASSERT_EQ(access(LOG_FILE ".2", F_OK), 0);
+    EXPECT_NE(access(LOG_FILE ".3", F_OK), 0);
+    EXPECT_EQ(access(LOG_FILE ".1" LOG_INDEX_SUFFIX, F_OK), 0);
+
+    // Older lines were dropped with the oldest file, the rest is in order
+    std::vector<std::string> lines = query(LOG_FILE, nullptr);
+    ASSERT_GT(lines.size(), 100u);
+    ASSERT_LT(lines.size(), 3000u);
+    EXPECT_EQ(message_of(lines.back()), "rotated 2999 " + padding);
+
+    // Everything logged is from the last minutes, the index agrees
+    LogFilter filter = { LOG_LEVEL_TRACE, time(nullptr) - 120, 0, nullptr, 0 };
+    EXPECT_EQ(query(LOG_FILE, &filter).size(), lines.size());
+    filter.tail = 10;
+    EXPECT_EQ(query(LOG_FILE, &filter).back(), lines.back());
+
+    ASSERT_EQ(log_set_rotation(LOG_ROTATE_SIZE, LOG_ROTATE_KEEP), 0);
+    log_reset();
+    EXPECT_NE(access(LOG_FILE ".1", F_OK), 0);
+    EXPECT_NE(access(LOG_FILE ".2", F_OK), 0);
+}
+
+// Everything below is compiled as a module built with LOG_LEVEL=WARN
+#undef LOG_COMPILE_LEVEL
+#define LOG_COMPILE_LEVEL LOG_LEVEL_WARN
+
+TEST_F(LogTest, CompileLevelRemovesCalls) {
+    ASSERT_EQ(log_set_level(LOG_MODULE_ALL, LOG_LEVEL_TRACE), 0);
+
+    evaluated = 0;
+    LOG_DEBUG("compiled out %d", count_evaluation());
+    LOG_ERROR("compiled in %d", count_evaluation());
+    EXPECT_EQ(evaluated, 1);
+    EXPECT_TRUE(lines_with("compiled out").empty());
+    EXPECT_EQ(lines_with("compiled in").size(), 1u);
+
+    ASSERT_EQ(log_set_level(LOG_MODULE_ALL, LOG_DEFAULT_LEVEL), 0);
+}